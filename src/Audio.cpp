@@ -8,12 +8,24 @@
  * - Generates dial tone, ringback tone, and ring tone
  * - Uses sine wave generation for pure tones
  * - Digital microphone input via I2S for crystal-clear voice transmission
+ * - Per-speaker EQ and master volume on the final output block
+ *
+ * Tones are always generated at TONE_LEVEL; the volume is applied after
+ * the EQ, so nothing needs to be regenerated when it changes.
  */
 
 #include "Audio.h"
 #include "Pins.h"
+#include "Equalizer.h"
+#include "Metrics.h"
+#include "Log.h"
+#include "Trace.h"
+#include "AudioMonitor.h"
+#include "FramePool.h"
 #include <Arduino.h>
 #include <driver/i2s.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <math.h>
 
 // Audio settings
@@ -22,11 +34,25 @@
 #define SAMPLE_RATE 16000
 #define BITS_PER_SAMPLE I2S_BITS_PER_SAMPLE_16BIT
 #define BUFFER_SIZE 256
+static_assert(BUFFER_SIZE <= SCRATCH_FRAME_SAMPLES, "tone buffers are scratch frames");
+#define TONE_LEVEL 8000        // Reference amplitude of all call progress tones
+#define TEST_TONE_LEVEL 12000  // Louder for hardware tests
+#define GAIN_UNITY 32768       // Q15
+#define GAIN_RAMP_STEP 256     // Max gain change per sample: full scale in ~16ms, no zipper noise
+#define DMA_QUEUE_US (8 * 64 * 1000000UL / SAMPLE_RATE)   // Audio the I2S DMA buffers hold (32ms)
+#define UNDERRUN_MARGIN_US 1000    // Later than this = the DMA ran dry
+#define UNDERRUN_PAUSE_US 50000    // Later than this = a deliberate pause (cadence, end of call)
+
+// Q15 gain per volume level: mute, then -21dB .. +6dB in 3dB steps
+static const int32_t volumeGain[VOLUME_MAX + 1] = {
+  0, 2920, 4125, 5827, 8231, 11627, 16423, 23198, 32768, 46286, 65381
+};
 
 // Tone generation state
 enum ToneType {
   TONE_NONE,
   TONE_DIAL,
+  TONE_STUTTER_DIAL,  // 10 x 100ms bursts, then steady dial tone
   TONE_RINGBACK,
   TONE_RING,
   TONE_ERROR,  // Fast busy tone for errors (250ms cadence)
@@ -49,6 +75,26 @@ static bool handsetAudioReady = false;
 static bool ringerAudioReady = false;
 static bool microphoneReady = false;
 
+// Final output stage per speaker (EQ, then master volume)
+struct OutputStage {
+  i2s_port_t port;
+  EqOutput eq;
+  int32_t gain;                  // Q15, where the ramp currently is
+  volatile int32_t targetGain;   // Q15, set by setHandsetVolume()/setRingerVolume()
+  CounterMetric underrunMetric;
+  uint32_t playedUntilUs;        // When the audio written so far runs out (estimate)
+  uint32_t writtenAtUs;          // When the last write returned
+  SemaphoreHandle_t lock;        // One writer at a time: EQ state, gain ramp, i2s_write
+};
+
+static OutputStage handsetStage = {I2S_HANDSET_PORT, EQ_HANDSET, GAIN_UNITY, GAIN_UNITY, METRIC_I2S_UNDERRUN_HANDSET, 0, 0, NULL};
+static OutputStage ringerStage = {I2S_RINGER_PORT, EQ_RINGER, GAIN_UNITY, GAIN_UNITY, METRIC_I2S_UNDERRUN_RINGER, 0, 0, NULL};
+static volatile bool handsetToRinger = false;   // Speakerphone
+
+// inPlace: the buffer is the caller's scratch, EQ and volume may overwrite it
+static void writeHandset(const int16_t* buffer, size_t samples, bool inPlace);
+static void writeRinger(const int16_t* buffer, size_t samples, bool inPlace);
+
 /*
  * Generate Sine Wave Tone
  * 
@@ -60,17 +106,20 @@ static bool microphoneReady = false;
  * - frequency: Tone frequency in Hz (e.g., 350, 440, 480)
  * - handsetChannel: true = output to handset amplifier (I2S0)
  * - ringerChannel: true = output to ringer amplifier (I2S1)
+ * - scratch: true = the caller is done with the buffer afterwards, so a
+ *   single output runs its EQ and volume in place instead of on a copy
  * 
  * Sine Wave Formula:
  * sample = sin(phase) * amplitude
  * phase += (2π * frequency) / sampleRate
  */
-void generateTone(int16_t* buffer, size_t samples, float frequency, bool handsetChannel, bool ringerChannel) {
+void generateTone(int16_t* buffer, size_t samples, float frequency, bool handsetChannel, bool ringerChannel,
+                  bool scratch) {
   static float phase = 0.0;
   float phaseIncrement = (2.0 * PI * frequency) / SAMPLE_RATE;
   
   for (size_t i = 0; i < samples; i++) {
-    int16_t sample = (int16_t)(sin(phase) * 8000); // Amplitude of 8000 (adjust for volume)
+    int16_t sample = (int16_t)(sin(phase) * TONE_LEVEL); // Volume is applied on output
     phase += phaseIncrement;
     if (phase >= 2.0 * PI) {
       phase -= 2.0 * PI;
@@ -79,12 +128,13 @@ void generateTone(int16_t* buffer, size_t samples, float frequency, bool handset
     buffer[i] = sample;
   }
   
-  // Output to requested channels
+  // Output to requested channels (in place only if nobody reads the buffer after)
+  bool inPlace = scratch && handsetChannel != ringerChannel;
   if (handsetChannel && handsetAudioReady) {
-    writeHandsetAudioBuffer(buffer, samples);
+    writeHandset(buffer, samples, inPlace);
   }
   if (ringerChannel && ringerAudioReady) {
-    writeRingerAudioBuffer(buffer, samples);
+    writeRinger(buffer, samples, inPlace);
   }
 }
 
@@ -108,6 +158,11 @@ void generateTone(int16_t* buffer, size_t samples, float frequency, bool handset
 void setupAudio() {
   Serial.println("Configuring Dual I2S Audio System...");
 
+  // Output stages are written from the main loop, the ESP-NOW callback and
+  // the player/ringtone paths
+  handsetStage.lock = xSemaphoreCreateMutex();
+  ringerStage.lock = xSemaphoreCreateMutex();
+
   // Initialize amplifier control pins
   pinMode(AMP_HANDSET_SD_PIN, OUTPUT);
   pinMode(AMP_RINGER_SD_PIN, OUTPUT);
@@ -262,14 +317,19 @@ void setupMicrophone() {
  */
 bool readMicrophoneBuffer(int16_t* buffer, size_t samples) {
   if (!buffer || !microphoneReady) return false;
+  TRACE_SCOPE(i2s_read_mic);
   
   size_t bytes_read = 0;
   size_t bytes_to_read = samples * sizeof(int16_t);
   
   // Read digital audio samples directly from ICS-43434 via I2S0 RX
+  uint32_t startUs = micros();
   esp_err_t result = i2s_read(I2S_HANDSET_PORT, buffer, bytes_to_read, &bytes_read, pdMS_TO_TICKS(100));
+  countAudioCopy(AUDIO_COPY_MIC, bytes_read);
+  bool complete = result == ESP_OK && bytes_read == bytes_to_read;
+  monitorCapture(startUs, micros(), samples * 1000000UL / SAMPLE_RATE, DMA_QUEUE_US, complete);
   
-  if (result == ESP_OK && bytes_read == bytes_to_read) {
+  if (complete) {
     // ICS-43434 provides clean digital audio - no processing needed!
     // The microphone has built-in:
     // - Automatic gain control
@@ -300,28 +360,184 @@ void writeAudioBuffer(const int16_t* buffer, size_t samples) {
   writeHandsetAudioBuffer(buffer, samples);
 }
 
+/*
+ * Apply Gain (Q15)
+ * 
+ * Scales a block by the stage's master volume with saturation. While the
+ * volume is changing the gain moves towards the target by at most
+ * GAIN_RAMP_STEP per sample, so a button press fades instead of clicking.
+ * Called with the stage lock held: the ramp position is shared by every
+ * writer of the stage.
+ */
+static void applyGain(OutputStage& stage, int16_t* samples, size_t count) {
+  int32_t gain = stage.gain;
+  int32_t target = stage.targetGain;
+  
+  for (size_t i = 0; i < count; i++) {
+    if (gain != target) {
+      int32_t delta = target - gain;
+      if (delta > GAIN_RAMP_STEP) delta = GAIN_RAMP_STEP;
+      if (delta < -GAIN_RAMP_STEP) delta = -GAIN_RAMP_STEP;
+      gain += delta;
+    }
+    int32_t sample = (samples[i] * gain) >> 15;
+    if (sample > 32767) sample = 32767;
+    if (sample < -32768) sample = -32768;
+    samples[i] = (int16_t)sample;
+  }
+  
+  stage.gain = gain;
+}
+
+/*
+ * Track Underruns
+ * The legacy I2S driver doesn't report underruns reliably, so estimate:
+ * the DMA ran dry if the previous audio had already finished playing
+ * when this write started. Long gaps are pauses, not underruns.
+ */
+static void trackUnderrun(OutputStage& stage, uint32_t startUs, size_t samples) {
+  uint32_t late = startUs - stage.playedUntilUs;
+  if ((int32_t)late > UNDERRUN_MARGIN_US && late < UNDERRUN_PAUSE_US) {
+    countMetric(stage.underrunMetric);
+    TRACE_MARK(i2s_underrun);
+    monitorUnderrun(stage.port, stage.writtenAtUs, startUs);
+  }
+  uint32_t endUs = micros();
+  stage.writtenAtUs = endUs;
+  uint32_t from = (int32_t)(startUs - stage.playedUntilUs) > 0 ? startUs : stage.playedUntilUs;
+  uint32_t playedUntil = from + samples * 1000000UL / SAMPLE_RATE;
+  // i2s_write() returns once the rest fits, so at most a full queue is pending
+  if ((int32_t)(playedUntil - (endUs + DMA_QUEUE_US)) > 0) playedUntil = endUs + DMA_QUEUE_US;
+  stage.playedUntilUs = playedUntil;
+}
+
+// i2s_write() that gave up before everything was queued
+static void writeI2s(OutputStage& stage, const int16_t* samples, size_t count) {
+  size_t bytes_written = 0;
+  esp_err_t result = i2s_write(stage.port, samples, count * sizeof(int16_t), &bytes_written, pdMS_TO_TICKS(100));
+  countAudioCopy(AUDIO_COPY_SPEAKER, bytes_written);
+  if (result != ESP_OK || bytes_written != count * sizeof(int16_t)) {
+    monitorShortWrite(stage.port);
+  }
+}
+
+/*
+ * Write Output Stage
+ * 
+ * Copies the samples in SCRATCH_FRAME_SAMPLES chunks (or works in place on
+ * the caller's scratch), runs the speaker's EQ cascade and master volume,
+ * and writes them. At the default volume with no EQ bands the caller's
+ * buffer goes straight out. One writer at a time per stage.
+ */
+static void writeOutputStageLocked(OutputStage& stage, const int16_t* buffer, size_t samples, bool inPlace,
+                                   uint32_t startUs) {
+  bool equalize = isEqualizerActive(stage.eq);
+  if (!equalize && stage.gain == GAIN_UNITY && stage.targetGain == GAIN_UNITY) {
+    writeI2s(stage, buffer, samples);
+    trackUnderrun(stage, startUs, samples);
+    return;
+  }
+  size_t total = samples;
+  
+  // The caller's own scratch buffer: process it where it is
+  if (inPlace) {
+    int16_t* writable = const_cast<int16_t*>(buffer);
+    if (equalize) processEqualizer(stage.eq, writable, samples);
+    applyGain(stage, writable, samples);
+    writeI2s(stage, writable, samples);
+    trackUnderrun(stage, startUs, total);
+    return;
+  }
+  
+  // Scratch from the frame pool: this runs in the main loop, the ESP-NOW
+  // callback and the player/ringtone tasks. Pool empty (counted there):
+  // drop the audio rather than play it unprocessed at full volume.
+  int16_t* processed = acquireScratchFrame();
+  if (!processed) return;
+  while (samples > 0) {
+    size_t chunk = samples < SCRATCH_FRAME_SAMPLES ? samples : SCRATCH_FRAME_SAMPLES;
+    memcpy(processed, buffer, chunk * sizeof(int16_t));
+    countAudioCopy(AUDIO_COPY_STAGE, chunk * sizeof(int16_t));
+    if (equalize) processEqualizer(stage.eq, processed, chunk);
+    applyGain(stage, processed, chunk);
+    writeI2s(stage, processed, chunk);
+    buffer += chunk;
+    samples -= chunk;
+  }
+  releaseScratchFrame(processed);
+  trackUnderrun(stage, startUs, total);
+}
+
+static void writeOutputStage(OutputStage& stage, const int16_t* buffer, size_t samples, bool inPlace) {
+  xSemaphoreTake(stage.lock, portMAX_DELAY);
+  writeOutputStageLocked(stage, buffer, samples, inPlace, micros());
+  xSemaphoreGive(stage.lock);
+}
+
 /*
  * Write Handset Audio Buffer (I2S0 TX)
  * 
- * Writes mono audio samples directly to the handset amplifier.
+ * Writes mono audio samples to the handset amplifier (through the handset
+ * EQ and volume), or to the ringer while the speakerphone is on.
  */
+static void writeHandset(const int16_t* buffer, size_t samples, bool inPlace) {
+  if (!buffer) return;
+  TRACE_SCOPE(i2s_write_handset);
+  if (handsetToRinger) {
+    writeRinger(buffer, samples, inPlace);
+    return;
+  }
+  if (!handsetAudioReady) return;
+  writeOutputStage(handsetStage, buffer, samples, inPlace);
+}
+
 void writeHandsetAudioBuffer(const int16_t* buffer, size_t samples) {
-  if (!buffer || !handsetAudioReady) return;
-  
-  size_t bytes_written;
-  i2s_write(I2S_HANDSET_PORT, buffer, samples * sizeof(int16_t), &bytes_written, pdMS_TO_TICKS(100));
+  writeHandset(buffer, samples, false);
 }
 
 /*
  * Write Ringer Audio Buffer (I2S1 TX)
  * 
- * Writes mono audio samples directly to the base ringer amplifier.
+ * Writes mono audio samples to the base ringer amplifier (through the
+ * ringer EQ and volume).
  */
-void writeRingerAudioBuffer(const int16_t* buffer, size_t samples) {
+static void writeRinger(const int16_t* buffer, size_t samples, bool inPlace) {
   if (!buffer || !ringerAudioReady) return;
-  
-  size_t bytes_written;
-  i2s_write(I2S_RINGER_PORT, buffer, samples * sizeof(int16_t), &bytes_written, pdMS_TO_TICKS(100));
+  TRACE_SCOPE(i2s_write_ringer);
+  writeOutputStage(ringerStage, buffer, samples, inPlace);
+}
+
+void writeRingerAudioBuffer(const int16_t* buffer, size_t samples) {
+  writeRinger(buffer, samples, false);
+}
+
+/*
+ * Set Volume
+ * 
+ * Only moves the target; the output stage ramps to it over the next
+ * blocks. While nothing is playing the new gain simply takes effect with
+ * the next sound.
+ */
+void setHandsetVolume(int level) {
+  handsetStage.targetGain = volumeGain[constrain(level, 0, VOLUME_MAX)];
+}
+
+void setRingerVolume(int level) {
+  ringerStage.targetGain = volumeGain[constrain(level, 0, VOLUME_MAX)];
+}
+
+void setSpeakerphoneRouting(bool toRinger) {
+  handsetToRinger = toRinger;
+}
+
+/*
+ * Clear Ringer Audio (I2S1)
+ * 
+ * Zeroes the ringer DMA buffers so whatever was queued stops immediately.
+ * Used when a paging broadcast ends.
+ */
+void clearRingerAudio() {
+  if (ringerAudioReady) i2s_zero_dma_buffer(I2S_RINGER_PORT);
 }
 
 /*
@@ -333,7 +549,21 @@ void playDialTone() {
   if (currentTone != TONE_DIAL) {
     currentTone = TONE_DIAL;
     toneStartTime = millis();
-    Serial.println("Playing dial tone (350Hz on handset)");
+    LOG_INFO("Playing dial tone (350Hz on handset)");
+  }
+}
+
+/*
+ * Play Stutter Dial Tone
+ * Message-waiting indication: 350Hz, ten 100ms bursts with 100ms gaps,
+ * then a steady dial tone.
+ * Output: Handset amplifier (I2S0)
+ */
+void playStutterDialTone() {
+  if (currentTone != TONE_STUTTER_DIAL) {
+    currentTone = TONE_STUTTER_DIAL;
+    toneStartTime = millis();
+    LOG_INFO("Playing stutter dial tone (messages waiting)");
   }
 }
 
@@ -349,7 +579,7 @@ void playRingbackTone() {
     toneStartTime = millis();
     lastCadenceTime = millis();
     cadenceOn = true;
-    Serial.println("Playing ringback tone");
+    LOG_INFO("Playing ringback tone");
   }
 }
 
@@ -381,7 +611,7 @@ void playRingTone() {
     toneStartTime = millis();
     lastCadenceTime = millis();
     cadenceOn = true;
-    Serial.println("Playing ring tone (440Hz on base ringer)");
+    LOG_INFO("Playing ring tone (440Hz on base ringer)");
   }
 }
 
@@ -400,7 +630,7 @@ void playErrorTone() {
     toneStartTime = millis();
     lastCadenceTime = millis();
     cadenceOn = true;
-    Serial.println("Playing error tone (fast busy on handset)");
+    LOG_INFO("Playing error tone (fast busy on handset)");
   }
 }
 
@@ -419,7 +649,7 @@ void playBusyTone() {
     toneStartTime = millis();
     lastCadenceTime = millis();
     cadenceOn = true;
-    Serial.println("Playing busy tone");
+    LOG_INFO("Playing busy tone");
   }
 }
 
@@ -433,7 +663,7 @@ void stopTone() {
     // Clear both I2S buffers to stop audio
     if (handsetAudioReady) i2s_zero_dma_buffer(I2S_HANDSET_PORT);
     if (ringerAudioReady) i2s_zero_dma_buffer(I2S_RINGER_PORT);
-    Serial.println("All tones stopped");
+    LOG_INFO("All tones stopped");
   }
 }
 
@@ -443,6 +673,7 @@ void stopTone() {
  * Called continuously from main loop to generate audio output.
  * Handles:
  * - TONE_DIAL: Continuous tone on handset (I2S0)
+ * - TONE_STUTTER_DIAL: 2s of 100ms on/off bursts, then continuous (I2S0)
  * - TONE_RINGBACK: Cadenced tone on handset (I2S0) - 2s on, 4s off
  * - TONE_RING: Cadenced tone on ringer (I2S1) - 2s on, 4s off  
  * - TONE_ERROR/BUSY: Fast/normal busy on handset (I2S0)
@@ -455,13 +686,25 @@ void updateToneGeneration() {
     return;
   }
   
-  int16_t buffer[BUFFER_SIZE];
+  // One scratch frame for every tone (FramePool.h), not BUFFER_SIZE samples of
+  // stack; it is regenerated each pass, so the output stage may work in place
+  int16_t* buffer = acquireScratchFrame();
+  if (!buffer) return;
   unsigned long currentTime = millis();
   
   switch (currentTone) {
     case TONE_DIAL:
       // Continuous 350Hz dial tone on handset amplifier (I2S0)
-      generateTone(buffer, BUFFER_SIZE, 350.0, true, false); // handset=true, ringer=false
+      generateTone(buffer, BUFFER_SIZE, 350.0, true, false, true); // handset=true, ringer=false
+      break;
+      
+    case TONE_STUTTER_DIAL:
+      // Stutter for the first 2 seconds (100ms on, 100ms off), then steady 350Hz
+      if (currentTime - toneStartTime >= 2000 || ((currentTime - toneStartTime) / 100) % 2 == 0) {
+        generateTone(buffer, BUFFER_SIZE, 350.0, true, false, true);
+      } else {
+        // Silence gap - no output needed
+      }
       break;
       
     case TONE_RINGBACK:
@@ -478,7 +721,7 @@ void updateToneGeneration() {
       }
       
       if (cadenceOn) {
-        generateTone(buffer, BUFFER_SIZE, 440.0, true, false); // handset only
+        generateTone(buffer, BUFFER_SIZE, 440.0, true, false, true); // handset only
       } else {
         // Silence period - no output needed
       }
@@ -498,7 +741,7 @@ void updateToneGeneration() {
       }
       
       if (cadenceOn) {
-        generateTone(buffer, BUFFER_SIZE, 440.0, false, true); // ringer only
+        generateTone(buffer, BUFFER_SIZE, 440.0, false, true, true); // ringer only
       } else {
         // Silence period - no output needed
       }
@@ -518,7 +761,7 @@ void updateToneGeneration() {
       }
       
       if (cadenceOn) {
-        generateTone(buffer, BUFFER_SIZE, 480.0, true, false); // handset only
+        generateTone(buffer, BUFFER_SIZE, 480.0, true, false, true); // handset only
       } else {
         // Silence period - no output needed
       }
@@ -538,18 +781,14 @@ void updateToneGeneration() {
       }
       
       if (cadenceOn) {
-        // Generate dual tone: 480Hz + 620Hz mixed
-        int16_t buffer1[BUFFER_SIZE];
-        int16_t buffer2[BUFFER_SIZE];
-        
-        // Generate both frequencies separately
+        // Generate dual tone: 480Hz + 620Hz mixed into the one frame
         static float phase1 = 0.0, phase2 = 0.0;
         float phaseIncrement1 = (2.0 * PI * 480.0) / SAMPLE_RATE;
         float phaseIncrement2 = (2.0 * PI * 620.0) / SAMPLE_RATE;
         
         for (size_t i = 0; i < BUFFER_SIZE; i++) {
-          int16_t sample1 = (int16_t)(sin(phase1) * 4000);
-          int16_t sample2 = (int16_t)(sin(phase2) * 4000);
+          int16_t sample1 = (int16_t)(sin(phase1) * (TONE_LEVEL / 2));
+          int16_t sample2 = (int16_t)(sin(phase2) * (TONE_LEVEL / 2));
           buffer[i] = sample1 + sample2; // Mix the tones
           
           phase1 += phaseIncrement1;
@@ -558,7 +797,7 @@ void updateToneGeneration() {
           if (phase2 >= 2.0 * PI) phase2 -= 2.0 * PI;
         }
         
-        writeHandsetAudioBuffer(buffer, BUFFER_SIZE);
+        writeHandset(buffer, BUFFER_SIZE, true);
       } else {
         // Silence period - no output needed
       }
@@ -632,6 +871,7 @@ void updateToneGeneration() {
     default:
       break;
   }
+  releaseScratchFrame(buffer);
 }
 
 /*
@@ -652,7 +892,7 @@ void generateTestTone(int16_t* buffer, size_t samples, float frequency, bool han
   float phaseIncrement = (2.0 * PI * frequency) / SAMPLE_RATE;
   
   for (size_t i = 0; i < samples; i++) {
-    int16_t sample = (int16_t)(sin(phase) * 12000); // Higher amplitude for test
+    int16_t sample = (int16_t)(sin(phase) * TEST_TONE_LEVEL);
     phase += phaseIncrement;
     if (phase >= 2.0 * PI) {
       phase -= 2.0 * PI;
@@ -15,6 +15,7 @@ void setupMicrophone();    // ICS-43434 I2S microphone
 
 // Tone generation and playback
 void playDialTone();
+void playStutterDialTone();  // Dial tone that stutters first: messages waiting
 void playRingbackTone();
 void playRingTone();
 void playErrorTone();  // Fast busy tone for invalid number
@@ -28,9 +29,21 @@ bool readMicrophoneBuffer(int16_t* buffer, size_t samples);
 void writeAudioBuffer(const int16_t* buffer, size_t samples);
 
 // Test mode functions
-void generateTone(int16_t* buffer, size_t samples, float frequency, bool handsetChannel, bool ringerChannel);
+void generateTone(int16_t* buffer, size_t samples, float frequency, bool handsetChannel, bool ringerChannel,
+                  bool scratch = false);  // scratch: buffer may be overwritten (one copy less)
 void generateTestTone(int16_t* buffer, size_t samples, float frequency, bool handsetChannel, bool ringerChannel);
 void writeHandsetAudioBuffer(const int16_t* buffer, size_t samples);
 void writeRingerAudioBuffer(const int16_t* buffer, size_t samples);
+void clearRingerAudio();   // Flush the ringer DMA buffers (silence)
+
+// Master volume per speaker, applied to every block written to it.
+// Levels are 3dB apart; VOLUME_DEFAULT plays everything at its own level.
+#define VOLUME_MAX 10
+#define VOLUME_DEFAULT 8
+void setHandsetVolume(int level);  // 0 (mute) .. VOLUME_MAX
+void setRingerVolume(int level);
+
+// Speakerphone: play everything meant for the handset on the ringer
+void setSpeakerphoneRouting(bool toRinger);
 
 #endif // AUDIO_H
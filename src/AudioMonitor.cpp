@@ -0,0 +1,365 @@
+/*
+ * AudioMonitor - Audio Deadline Monitor
+ *
+ * Misses come from the main loop (capture, speaker writes) and from the
+ * ESP-NOW receive path (speaker writes), so the counters and the culprit
+ * table are shared under a spinlock. The audio path only counts a miss
+ * and queues (gap, core, task); finding the culprit walks the trace ring
+ * and looks up task names, so attributeAudioMisses() does that later from
+ * the web task, when the audio is no longer waiting.
+ */
+
+#include "AudioMonitor.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define AUDIO_READ_BLOCKED_US 500   // A read that took longer waited for the DMA: on time
+
+struct Culprit {
+  const char* task;
+  const char* section;               // Trace span or main loop section, may be nullptr
+  uint32_t misses;
+  uint32_t longestUs;
+};
+
+static const char* const missNames[AUDIO_MISS_KINDS] = {
+  "late frame", "overrun", "underrun", "short write", "short read"
+};
+
+static const char* const copyNames[AUDIO_COPY_KINDS] = {
+  "mic", "payload", "radio", "frame", "recorder", "stage", "speaker"
+};
+
+// A miss waiting to be blamed
+struct PendingMiss {
+  uint32_t fromUs;
+  uint32_t toUs;
+  TaskHandle_t task;                 // Running when the miss was noticed
+  const char* loopSection;           // Slowest main loop section, if that was the main loop
+  uint8_t kind;
+  uint8_t core;
+};
+
+static portMUX_TYPE monitorMux = portMUX_INITIALIZER_UNLOCKED;
+static AudioMissCounts callCounts;
+static AudioMissCounts totalCounts;
+static bool inCall = false;
+static Culprit culprits[AUDIO_CULPRITS];
+static int culpritCount = 0;
+static uint32_t unlistedMisses = 0;        // Table or queue full
+static PendingMiss pendingMisses[AUDIO_PENDING_MISSES];
+static uint32_t pendingHead = 0;
+static uint32_t pendingTail = 0;
+static TaskHandle_t loopTask = nullptr;    // Set by the first capture (main loop)
+static uint32_t longestBacklogUs = 0;
+static AudioCopyCounts callCopies;
+static unsigned long callStartMs = 0;
+
+// Trace snapshot
+static unsigned long windowStartMs = 0;
+static uint32_t windowMisses = 0;
+static bool snapshotArmed = true;
+static unsigned long snapshotAtMs = 0;     // 0 = not taken yet
+
+// Capture clock (main loop only)
+static bool capturing = false;
+static uint32_t dueUs = 0;                 // When the last frame read was ready
+static uint32_t lastReadUs = 0;
+static bool runningLate = false;
+
+const char* getAudioMissName(AudioMiss kind) {
+  return kind < AUDIO_MISS_KINDS ? missNames[kind] : "?";
+}
+
+const char* getAudioCopyName(AudioCopy site) {
+  return site < AUDIO_COPY_KINDS ? copyNames[site] : "?";
+}
+
+void countAudioCopy(AudioCopy site, uint32_t bytes) {
+  if (!inCall) return;
+  portENTER_CRITICAL(&monitorMux);
+  callCopies.bytes[site] += bytes;
+  portEXIT_CRITICAL(&monitorMux);
+}
+
+void getAudioCopyCounts(AudioCopyCounts& counts) {
+  portENTER_CRITICAL(&monitorMux);
+  counts = callCopies;
+  bool calling = inCall;
+  portEXIT_CRITICAL(&monitorMux);
+  if (calling) counts.callMs = millis() - callStartMs;
+}
+
+uint32_t copiedBytesPerSecond(const AudioCopyCounts& counts) {
+  if (counts.callMs == 0) return 0;
+  uint64_t total = 0;
+  for (int c = 0; c < AUDIO_COPY_KINDS; c++) total += counts.bytes[c];
+  return total * 1000 / counts.callMs;
+}
+
+static void countMiss(AudioMiss kind) {
+  static const CounterMetric metrics[AUDIO_MISS_KINDS] = {
+    METRIC_AUDIO_LATE_FRAMES, METRIC_AUDIO_OVERRUNS, METRIC_COUNTER_COUNT,   // Underruns: Audio.cpp
+    METRIC_I2S_SHORT_WRITES, METRIC_I2S_SHORT_READS
+  };
+  portENTER_CRITICAL(&monitorMux);
+  callCounts.count[kind]++;
+  totalCounts.count[kind]++;
+  portEXIT_CRITICAL(&monitorMux);
+  if (metrics[kind] != METRIC_COUNTER_COUNT) countMetric(metrics[kind]);
+}
+
+/*
+ * Record Miss
+ * Count it, queue it for blaming and freeze the trace on a burst.
+ * Runs in the audio path: nothing here walks the trace or the task lists.
+ */
+static void recordMiss(AudioMiss kind, uint32_t fromUs, uint32_t toUs) {
+  TRACE_MARK(audio_miss);
+  countMiss(kind);
+
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  PendingMiss miss = {fromUs, toUs, self, self == loopTask ? profileSlowestSection(nullptr) : nullptr,
+                      (uint8_t)kind, (uint8_t)xPortGetCoreID()};
+
+  bool freeze = false;
+  uint32_t burst = 0;
+  portENTER_CRITICAL(&monitorMux);
+  if (pendingHead - pendingTail < AUDIO_PENDING_MISSES) {
+    pendingMisses[pendingHead % AUDIO_PENDING_MISSES] = miss;
+    pendingHead++;
+  } else {
+    unlistedMisses++;
+  }
+
+  unsigned long now = millis();
+  if (now - windowStartMs > AUDIO_MISS_WINDOW_MS) {
+    windowStartMs = now;
+    windowMisses = 0;
+  }
+  windowMisses++;
+  if (snapshotArmed && windowMisses >= AUDIO_MISS_BURST) {
+    snapshotArmed = false;
+    snapshotAtMs = now;
+    burst = windowMisses;
+    freeze = true;
+  }
+  portEXIT_CRITICAL(&monitorMux);
+
+  if (freeze && !isTraceFrozen()) {
+    traceFreeze();
+    LOG_WARN("%lu audio misses within %d ms, trace frozen: download /api/v1/trace", burst, AUDIO_MISS_WINDOW_MS);
+  }
+}
+
+/*
+ * Blame
+ * Another task that ran for at least half of the gap on that core, else
+ * the task that noticed the miss - in the main loop, its slowest section.
+ */
+static void blame(const PendingMiss& miss, const char*& task, const char*& section) {
+  TraceBusy busy;
+  if (traceBusiest(miss.core, miss.fromUs, miss.toUs, miss.task, busy) &&
+      busy.busyUs * 2 >= miss.toUs - miss.fromUs) {
+    task = busy.task;
+    section = busy.span;
+    return;
+  }
+  const char* name = traceTaskName(miss.task);
+  task = name ? name : "other";
+  section = miss.loopSection;
+}
+
+void attributeAudioMisses() {
+  for (;;) {
+    PendingMiss miss;
+    portENTER_CRITICAL(&monitorMux);
+    bool empty = pendingTail == pendingHead;
+    if (!empty) miss = pendingMisses[pendingTail++ % AUDIO_PENDING_MISSES];
+    portEXIT_CRITICAL(&monitorMux);
+    if (empty) return;
+
+    const char* task;
+    const char* section;
+    blame(miss, task, section);
+    uint32_t gapUs = miss.toUs - miss.fromUs;
+
+    portENTER_CRITICAL(&monitorMux);
+    int i = 0;
+    while (i < culpritCount && !(culprits[i].task == task && culprits[i].section == section)) i++;
+    if (i == culpritCount && culpritCount < AUDIO_CULPRITS) {
+      culprits[i] = {task, section, 0, 0};
+      culpritCount++;
+    }
+    if (i < culpritCount) {
+      culprits[i].misses++;
+      if (gapUs > culprits[i].longestUs) culprits[i].longestUs = gapUs;
+    } else {
+      unlistedMisses++;
+    }
+    portEXIT_CRITICAL(&monitorMux);
+
+    LOG_DEBUG("Audio %s after %lu us: %s %s", missNames[miss.kind], gapUs, task, section ? section : "");
+  }
+}
+
+/*
+ * Capture
+ * Called after every microphone read, with the time the read started
+ * and ended
+ */
+void monitorCapture(uint32_t startUs, uint32_t endUs, uint32_t frameUs, uint32_t queueUs, bool complete) {
+  if (!loopTask) loopTask = xTaskGetCurrentTaskHandle();
+  if (!complete) {
+    countMiss(AUDIO_SHORT_READ);
+    capturing = false;               // Start the clock over
+    return;
+  }
+  if (!capturing || endUs - lastReadUs > AUDIO_CAPTURE_PAUSE_US) {
+    capturing = true;
+    dueUs = endUs;
+    lastReadUs = endUs;
+    runningLate = false;
+    return;
+  }
+
+  dueUs += frameUs;
+  uint32_t previousReadUs = lastReadUs;
+  lastReadUs = endUs;
+  int32_t backlog = endUs - dueUs;
+  if (endUs - startUs > AUDIO_READ_BLOCKED_US || backlog <= 0) {
+    dueUs = endUs;                   // Waited for the frame: on time, follow the mic clock
+    runningLate = false;
+    return;
+  }
+  if ((uint32_t)backlog > longestBacklogUs) longestBacklogUs = backlog;
+
+  if ((uint32_t)backlog > queueUs) {
+    recordMiss(AUDIO_OVERRUN, previousReadUs, startUs);
+    dueUs = endUs;                   // The driver dropped the oldest audio
+    runningLate = true;
+  } else if ((uint32_t)backlog > frameUs) {
+    if (runningLate) {
+      countMiss(AUDIO_LATE_FRAME);   // Still catching up with the same stall
+    } else {
+      recordMiss(AUDIO_LATE_FRAME, previousReadUs, startUs);
+    }
+    runningLate = true;
+  } else {
+    runningLate = false;
+  }
+}
+
+void monitorUnderrun(int port, uint32_t fromUs, uint32_t toUs) {
+  (void)port;
+  recordMiss(AUDIO_UNDERRUN, fromUs, toUs);
+}
+
+void monitorShortWrite(int port) {
+  countMiss(AUDIO_SHORT_WRITE);
+  LOG_DEBUG("Audio short write on I2S%d", port);
+}
+
+void audioMonitorCallStart() {
+  portENTER_CRITICAL(&monitorMux);
+  callCounts = AudioMissCounts();
+  callCopies = AudioCopyCounts();
+  callStartMs = millis();
+  inCall = true;
+  snapshotArmed = true;
+  portEXIT_CRITICAL(&monitorMux);
+}
+
+void audioMonitorCallEnd() {
+  AudioMissCounts call;
+  portENTER_CRITICAL(&monitorMux);
+  call = callCounts;
+  if (inCall) callCopies.callMs = millis() - callStartMs;
+  inCall = false;
+  uint32_t copied = copiedBytesPerSecond(callCopies);
+  portEXIT_CRITICAL(&monitorMux);
+  LOG_INFO("Call audio: %lu late frames, %lu overruns, %lu underruns, %lu short reads/writes",
+           call.count[AUDIO_LATE_FRAME], call.count[AUDIO_OVERRUN], call.count[AUDIO_UNDERRUN],
+           call.count[AUDIO_SHORT_WRITE] + call.count[AUDIO_SHORT_READ]);
+  LOG_INFO("Call audio: %lu bytes copied per second", copied);
+}
+
+void getAudioMissCounts(AudioMissCounts& call, AudioMissCounts& total) {
+  portENTER_CRITICAL(&monitorMux);
+  call = callCounts;
+  total = totalCounts;
+  portEXIT_CRITICAL(&monitorMux);
+}
+
+void resetAudioMonitor() {
+  portENTER_CRITICAL(&monitorMux);
+  callCounts = AudioMissCounts();
+  totalCounts = AudioMissCounts();
+  callCopies = AudioCopyCounts();
+  callStartMs = millis();
+  culpritCount = 0;
+  unlistedMisses = 0;
+  pendingTail = pendingHead;
+  longestBacklogUs = 0;
+  windowMisses = 0;
+  snapshotArmed = true;
+  snapshotAtMs = 0;
+  portEXIT_CRITICAL(&monitorMux);
+}
+
+void printAudioMonitor() {
+  static Culprit copy[AUDIO_CULPRITS];
+  AudioMissCounts call, total;
+  attributeAudioMisses();   // Blame what the web task hasn't got to yet
+  portENTER_CRITICAL(&monitorMux);
+  call = callCounts;
+  total = totalCounts;
+  int count = culpritCount;
+  memcpy(copy, culprits, sizeof(copy));
+  uint32_t unlisted = unlistedMisses;
+  bool armed = snapshotArmed;
+  unsigned long snapshotAt = snapshotAtMs;
+  bool calling = inCall;
+  portEXIT_CRITICAL(&monitorMux);
+
+  Serial.println();
+  Serial.println("========== AUDIO DEADLINES ==========");
+  Serial.printf("%-14s %10s %11s\n", "", calling ? "this call" : "last call", "since boot");
+  for (int k = 0; k < AUDIO_MISS_KINDS; k++) {
+    Serial.printf("%-14s %10lu %11lu\n", missNames[k], (unsigned long)call.count[k], (unsigned long)total.count[k]);
+  }
+  Serial.printf("Longest capture backlog: %lu us (late > one frame, overrun > the RX DMA)\n",
+                (unsigned long)longestBacklogUs);
+
+  Serial.println("Blamed (task, span or loop section, misses, longest gap):");
+  if (count == 0) Serial.println("  nobody yet");
+  for (int i = 0; i < count; i++) {
+    Serial.printf("  %-10s %-16s %6lu %8lu us\n", copy[i].task, copy[i].section ? copy[i].section : "-",
+                  (unsigned long)copy[i].misses, (unsigned long)copy[i].longestUs);
+  }
+  if (unlisted > 0) Serial.printf("  %lu more misses (table or queue full)\n", (unsigned long)unlisted);
+
+  AudioCopyCounts copies;
+  getAudioCopyCounts(copies);
+  Serial.printf("Audio copied %s: %lu bytes/s over %lu s (",
+                calling ? "this call" : "last call", (unsigned long)copiedBytesPerSecond(copies),
+                (unsigned long)(copies.callMs / 1000));
+  for (int c = 0; c < AUDIO_COPY_KINDS; c++) {
+    uint32_t perSecond = copies.callMs ? (uint64_t)copies.bytes[c] * 1000 / copies.callMs : 0;
+    Serial.printf("%s %lu%s", copyNames[c], (unsigned long)perSecond, c < AUDIO_COPY_KINDS - 1 ? ", " : ")\n");
+  }
+
+  if (isTraceFrozen() && snapshotAt != 0) {
+    Serial.printf("Trace frozen %lu s ago after %d misses within %d ms: /api/v1/trace or test trace\n",
+                  (millis() - snapshotAt) / 1000, AUDIO_MISS_BURST, AUDIO_MISS_WINDOW_MS);
+  } else {
+    Serial.printf("Trace snapshot: %s (%d misses within %d ms)\n", armed ? "armed" : "taken this call",
+                  AUDIO_MISS_BURST, AUDIO_MISS_WINDOW_MS);
+  }
+  Serial.println("=====================================");
+}
@@ -0,0 +1,102 @@
+/*
+ * AudioMonitor.h - Audio Deadline Monitor
+ *
+ * Every audio frame has a deadline; this notices the ones that were
+ * missed, says who was running instead, and keeps the trace of the
+ * moment when it gets bad:
+ *
+ *   late frame   the main loop read a microphone frame more than one
+ *                frame (6.25ms) after the DMA had it ready
+ *   overrun      ... more than the RX DMA holds (32ms): audio was lost
+ *   underrun     a speaker ran dry before the next write (see Audio.cpp)
+ *   short write  i2s_write() timed out or wrote less than asked
+ *   short read   i2s_read() failed or returned less than a frame
+ *
+ * The capture deadline follows the microphone clock: frame n is due one
+ * frame after frame n-1 was due. A read that blocks is on time and
+ * re-anchors the clock there; a read that returns at once found the
+ * frame already waiting in the DMA, and now minus its due time is the
+ * backlog.
+ *
+ * Late frames, overruns and underruns are blamed on whoever held the CPU
+ * in the gap: the task whose trace spans (Trace.h) cover most of it, or,
+ * if no other task does, the slowest main loop section (Profiler.h).
+ * The audio path only queues the miss; it is blamed a moment later by
+ * the web task (attributeAudioMisses), off the path that is already late.
+ * AUDIO_MISS_BURST misses within AUDIO_MISS_WINDOW_MS freeze the trace
+ * (once per call) so it can be downloaded before it is overwritten.
+ *
+ * Counters are kept per call (IN_CALL) and since boot.
+ *
+ * The copy meter counts every byte of audio moved between buffers during
+ * a call, by where it happened, and reports bytes per second of call
+ * audio - the measure for the zero-copy frames in FramePool.h.
+ */
+
+#ifndef AUDIO_MONITOR_H
+#define AUDIO_MONITOR_H
+
+#include <stdint.h>
+
+#define AUDIO_CAPTURE_PAUSE_US 500000   // Longer without a read = the stream stopped
+#define AUDIO_MISS_BURST 5               // Misses within the window that freeze the trace
+#define AUDIO_MISS_WINDOW_MS 2000
+#define AUDIO_CULPRITS 8                 // Distinct task/section pairs kept
+#define AUDIO_PENDING_MISSES 16          // Misses queued until they are blamed
+
+enum AudioMiss {
+  AUDIO_LATE_FRAME,
+  AUDIO_OVERRUN,
+  AUDIO_UNDERRUN,
+  AUDIO_SHORT_WRITE,
+  AUDIO_SHORT_READ,
+  AUDIO_MISS_KINDS
+};
+
+struct AudioMissCounts {
+  uint32_t count[AUDIO_MISS_KINDS];
+};
+
+enum AudioCopy {
+  AUDIO_COPY_MIC,                  // i2s_read(): RX DMA into a buffer
+  AUDIO_COPY_PAYLOAD,              // Samples copied into a packet payload
+  AUDIO_COPY_RADIO,                // esp_now_send() copies the packet
+  AUDIO_COPY_FRAME,                // Received audio copied into a shared frame
+  AUDIO_COPY_RECORDER,             // Recorder queue entries and PCM ring
+  AUDIO_COPY_STAGE,                // EQ/volume scratch copy in the output stage
+  AUDIO_COPY_SPEAKER,              // i2s_write(): buffer into TX DMA
+  AUDIO_COPY_KINDS
+};
+
+struct AudioCopyCounts {
+  uint32_t bytes[AUDIO_COPY_KINDS];
+  uint32_t callMs;                 // Call audio measured
+};
+
+// Audio path (Audio.cpp)
+void monitorCapture(uint32_t startUs, uint32_t endUs, uint32_t frameUs, uint32_t queueUs, bool complete);
+void monitorUnderrun(int port, uint32_t fromUs, uint32_t toUs);
+void monitorShortWrite(int port);
+void countAudioCopy(AudioCopy site, uint32_t bytes);   // Only counted in a call
+
+// Web task: blame the queued misses (walks the trace, looks up task names)
+void attributeAudioMisses();
+
+// State machine: per-call counters
+void audioMonitorCallStart();
+void audioMonitorCallEnd();
+
+// This call (or the last one) and since boot
+void getAudioMissCounts(AudioMissCounts& call, AudioMissCounts& total);
+const char* getAudioMissName(AudioMiss kind);
+
+// This call (or the last one); copiedBytesPerSecond() sums every site
+void getAudioCopyCounts(AudioCopyCounts& counts);
+uint32_t copiedBytesPerSecond(const AudioCopyCounts& counts);
+const char* getAudioCopyName(AudioCopy site);
+
+// Diagnostics (test mode)
+void printAudioMonitor();
+void resetAudioMonitor();
+
+#endif // AUDIO_MONITOR_H
@@ -0,0 +1,231 @@
+/*
+ * Bell - Electromechanical Bell Synthesis
+ *
+ * Per output sample, for each of the 8 partials (2 gongs x 4 modes):
+ *
+ *   y[n] = a1 * y[n-1] - a2 * y[n-2]        a1 = 2r cos(w), a2 = r^2 (Q30)
+ *
+ * A strike adds an impulse to y[n-1] of every partial of the struck gong.
+ * r comes from each partial's T60 decay time; the impulse is scaled by
+ * sin(w) so every partial peaks at its own level regardless of pitch.
+ *
+ * Resonator state is kept in Q8 (x256) so the tails decay smoothly
+ * instead of stalling on integer truncation. 8 partials x 2 multiplies
+ * per sample is ~256k 32x32->64 multiplies per second - a few percent of
+ * one core, so the bell is rendered live rather than cached.
+ */
+
+#include "Bell.h"
+#include <Arduino.h>
+#include <math.h>
+
+#define BELL_GONGS 2
+#define BELL_MODES 4                          // Partials per gong
+#define BELL_PARTIALS (BELL_GONGS * BELL_MODES)
+#define BELL_STATE_SHIFT 8                    // Q8 resonator state
+#define BELL_STRIKE_LEVEL 2600                // Peak of the fundamental for one strike
+#define BELL_JITTER_SAMPLES 16                // Strike timing variation (+/- 1ms)
+#define BELL_RINGOUT_MS 1200                  // Longest T60 plus margin
+
+#define BELL_STRIKE_SAMPLES (BELL_SAMPLE_RATE / BELL_STRIKE_HZ / BELL_GONGS)   // 25ms between strikes
+#define BELL_RING_SAMPLES ((uint32_t)BELL_SAMPLE_RATE * BELL_RING_MS / 1000)
+#define BELL_CYCLE_SAMPLES ((uint32_t)BELL_SAMPLE_RATE * (BELL_RING_MS + BELL_SILENCE_MS) / 1000)
+#define BELL_RINGOUT_SAMPLES ((uint32_t)BELL_SAMPLE_RATE * BELL_RINGOUT_MS / 1000)
+
+// Two gongs a sixth apart; partial ratios of a thin steel dome
+static const float gongFundamental[BELL_GONGS] = {880.0f, 1046.5f};
+static const float modeRatio[BELL_MODES] = {1.0f, 2.76f, 5.40f, 8.93f};
+static const float modeT60[BELL_MODES] = {0.90f, 0.45f, 0.20f, 0.08f};    // Seconds to -60dB
+static const float modeLevel[BELL_MODES] = {1.0f, 0.55f, 0.30f, 0.15f};
+
+struct BellPartial {
+  int32_t a1;          // Q30
+  int32_t a2;          // Q30
+  int32_t impulse;     // Q8 state units for a full-strength strike (0 = above Nyquist)
+  int32_t y1;
+  int32_t y2;
+};
+
+static BellPartial partials[BELL_PARTIALS];
+static uint32_t position = 0;        // Sample within the ring cycle
+static uint32_t nextStrike = 0;
+static uint8_t nextGong = 0;
+static uint32_t lastStrike = 0;
+static bool ringing = false;         // Any energy left in the resonators
+static uint32_t randomState = 1;
+
+/*
+ * Xorshift32
+ * Cheap per-strike randomness; never returns 0 for a non-zero state.
+ */
+static uint32_t nextRandom() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+// Random factor in [1 - spread, 1 + spread), Q15
+static int32_t randomFactor(int32_t spreadQ15) {
+  int32_t offset = (int32_t)(nextRandom() & 0xFFFF) - 0x8000;   // -32768..32767
+  return 32768 + ((offset * spreadQ15) >> 15);
+}
+
+/*
+ * Setup Bell
+ * Float math only here; rendering is integer-only.
+ */
+void setupBell() {
+  for (int gong = 0; gong < BELL_GONGS; gong++) {
+    for (int mode = 0; mode < BELL_MODES; mode++) {
+      BellPartial& partial = partials[gong * BELL_MODES + mode];
+      float frequency = gongFundamental[gong] * modeRatio[mode];
+      partial.y1 = 0;
+      partial.y2 = 0;
+      if (frequency >= BELL_SAMPLE_RATE * 0.45f) {
+        // Would alias - leave the partial silent
+        partial.a1 = 0;
+        partial.a2 = 0;
+        partial.impulse = 0;
+        continue;
+      }
+      float w = 2.0f * PI * frequency / BELL_SAMPLE_RATE;
+      float r = expf(-6.9078f / (modeT60[mode] * BELL_SAMPLE_RATE));
+      partial.a1 = (int32_t)(2.0f * r * cosf(w) * (1 << 30));
+      partial.a2 = (int32_t)(r * r * (1 << 30));
+      partial.impulse = (int32_t)(BELL_STRIKE_LEVEL * modeLevel[mode] * sinf(w) * (1 << BELL_STATE_SHIFT));
+    }
+  }
+}
+
+void startBell(uint32_t seed) {
+  for (int i = 0; i < BELL_PARTIALS; i++) {
+    partials[i].y1 = 0;
+    partials[i].y2 = 0;
+  }
+  randomState = seed ? seed : 1;
+  position = 0;
+  nextStrike = 0;
+  nextGong = 0;
+  lastStrike = 0;
+  ringing = false;
+}
+
+/*
+ * Strike
+ * One clapper hit: overall strength varies +/-15%, each partial a further
+ * +/-20% (the clapper never hits exactly the same spot), and the next
+ * strike lands up to 1ms early or late.
+ */
+static void strike() {
+  int32_t strength = randomFactor(4915);   // 0.15 in Q15
+  BellPartial* gong = &partials[nextGong * BELL_MODES];
+  for (int mode = 0; mode < BELL_MODES; mode++) {
+    int32_t level = (int32_t)(((int64_t)gong[mode].impulse * strength * randomFactor(6554)) >> 30);
+    gong[mode].y1 += level;
+  }
+
+  lastStrike = position;
+  ringing = true;
+  nextGong ^= 1;
+  int32_t jitter = (int32_t)(nextRandom() % (2 * BELL_JITTER_SAMPLES + 1)) - BELL_JITTER_SAMPLES;
+  nextStrike = position + BELL_STRIKE_SAMPLES + jitter;
+}
+
+bool renderBell(int16_t* buffer, size_t samples) {
+  // Quiet part of the cadence and the gongs have died away: nothing to do
+  if (!ringing && position >= BELL_RING_SAMPLES) {
+    position += samples;
+    if (position >= BELL_CYCLE_SAMPLES) {
+      position -= BELL_CYCLE_SAMPLES;
+      nextStrike = position;
+    }
+    return false;
+  }
+
+  for (size_t i = 0; i < samples; i++) {
+    if (position < BELL_RING_SAMPLES && position >= nextStrike) {
+      strike();
+    }
+
+    int32_t mix = 0;
+    for (int p = 0; p < BELL_PARTIALS; p++) {
+      BellPartial& partial = partials[p];
+      int32_t y = (int32_t)(((int64_t)partial.a1 * partial.y1 - (int64_t)partial.a2 * partial.y2) >> 30);
+      partial.y2 = partial.y1;
+      partial.y1 = y;
+      mix += y;
+    }
+    mix >>= BELL_STATE_SHIFT;
+    if (mix > 32767) mix = 32767;
+    if (mix < -32768) mix = -32768;
+    buffer[i] = (int16_t)mix;
+
+    position++;
+    if (position >= BELL_CYCLE_SAMPLES) {
+      position = 0;
+      nextStrike = 0;
+      lastStrike = 0;
+    }
+  }
+
+  // After the last strike of a burst, stop once the longest partial is inaudible
+  if (ringing && position >= BELL_RING_SAMPLES && position - lastStrike >= BELL_RINGOUT_SAMPLES) {
+    for (int i = 0; i < BELL_PARTIALS; i++) {
+      partials[i].y1 = 0;
+      partials[i].y2 = 0;
+    }
+    ringing = false;
+  }
+  return true;
+}
+
+/*
+ * Benchmark Bell
+ * Renders one full burst (2s) in 256-sample blocks, the ringer's block size
+ */
+void benchmarkBell() {
+  const size_t blockSamples = 256;
+  const int blocks = BELL_RING_SAMPLES / blockSamples;
+  int16_t block[blockSamples];
+
+  startBell(12345);
+  uint32_t worstUs = 0;
+  uint32_t totalUs = 0;
+  int32_t peak = 0;
+  for (int b = 0; b < blocks; b++) {
+    uint32_t start = micros();
+    renderBell(block, blockSamples);
+    uint32_t elapsed = micros() - start;
+    totalUs += elapsed;
+    if (elapsed > worstUs) worstUs = elapsed;
+    for (size_t i = 0; i < blockSamples; i++) {
+      int32_t magnitude = abs(block[i]);
+      if (magnitude > peak) peak = magnitude;
+    }
+  }
+  startBell(1);
+
+  uint32_t blockBudgetUs = blockSamples * 1000000UL / BELL_SAMPLE_RATE;
+  Serial.println();
+  Serial.println("========== BELL BENCHMARK ==========");
+  Serial.print("Partials: ");
+  Serial.print(BELL_PARTIALS);
+  Serial.print(", block: ");
+  Serial.print(blockSamples);
+  Serial.print(" samples (");
+  Serial.print(blockBudgetUs);
+  Serial.println(" us of audio)");
+  Serial.print("Average: ");
+  Serial.print(totalUs / blocks);
+  Serial.print(" us/block, worst: ");
+  Serial.print(worstUs);
+  Serial.println(" us");
+  Serial.print("CPU: ");
+  Serial.print(100.0f * totalUs / blocks / blockBudgetUs, 2);
+  Serial.println("% of one core while ringing");
+  Serial.print("Peak level: ");
+  Serial.print(peak);
+  Serial.println(peak >= 32767 ? " (clipping!)" : " / 32767");
+  Serial.println("====================================");
+}
@@ -0,0 +1,42 @@
+/*
+ * Bell.h - Electromechanical Bell Synthesis
+ *
+ * Sounds like the two steel gongs of an old desk phone instead of a sine:
+ * a clapper driven by the 20Hz ringing current strikes the gongs
+ * alternately, and each gong rings with a handful of inharmonic partials
+ * that decay at different rates.
+ *
+ * Every partial is a two-pole resonator in fixed point (Q30 coefficients)
+ * that gets an impulse on each strike. Strike strength, the mix of
+ * partials and the exact strike time vary a little from strike to strike
+ * so the ring never sounds like a loop.
+ *
+ * Cadence: 2s ringing, 4s silence (the gongs ring out naturally).
+ * Select with "bell" in the "ringtones" section of config.json.
+ */
+
+#ifndef BELL_H
+#define BELL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BELL_SAMPLE_RATE 16000
+#define BELL_STRIKE_HZ 20          // Ringing current: each gong is hit 20 times per second
+#define BELL_RING_MS 2000
+#define BELL_SILENCE_MS 4000
+
+// Compute resonator coefficients (called once from setup)
+void setupBell();
+
+// Reset the gongs and start a ring cycle from the first strike
+void startBell(uint32_t seed);
+
+// Render the next samples. Returns false (buffer untouched) once the gongs
+// have rung out during the silent part of the cadence - nothing to write.
+bool renderBell(int16_t* buffer, size_t samples);
+
+// Diagnostics (test mode): time per 256-sample block, CPU share
+void benchmarkBell();
+
+#endif // BELL_H
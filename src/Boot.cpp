@@ -0,0 +1,179 @@
+/*
+ * Boot - Staged Startup and Boot Profiler
+ *
+ * One event group bit per stage: a stage waits for all of its `after`
+ * bits, runs, and sets its own. Stages with a core run in their own task,
+ * created at once and deleted when the stage is done; the setup task runs
+ * the rest in table order and then waits for the ready-to-ring bits.
+ *
+ * Timings are written by whichever task runs the stage, under a spinlock,
+ * and read through getBootReport().
+ */
+
+#include "Boot.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+static const BootStage* table = nullptr;
+static int stageCount = 0;
+static uint32_t readyMask = 0;
+static EventGroupHandle_t doneBits = nullptr;
+
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+static BootStageTiming timings[BOOT_STAGE_MAX];
+static uint32_t setupUs = 0;
+static uint32_t readyUs = 0;
+static uint32_t completeUs = 0;
+
+void startBootProfile() {
+  setupUs = micros();
+}
+
+/*
+ * Run Stage
+ * Waits for the stage's dependencies, runs it and marks it done
+ */
+static void runStage(int index) {
+  const BootStage& stage = table[index];
+  uint32_t waitStart = micros();
+  if (stage.after) {
+    xEventGroupWaitBits(doneBits, stage.after, pdFALSE, pdTRUE, portMAX_DELAY);
+  }
+  uint32_t start = micros();
+  portENTER_CRITICAL(&bootMux);
+  timings[index].waitUs = start - waitStart;
+  timings[index].startUs = start;
+  timings[index].core = xPortGetCoreID();
+  portEXIT_CRITICAL(&bootMux);
+
+  stage.run();
+
+  uint32_t end = micros();
+  uint32_t allMask = (1UL << stageCount) - 1;
+  bool complete = false;
+  portENTER_CRITICAL(&bootMux);
+  timings[index].endUs = end;
+  portEXIT_CRITICAL(&bootMux);
+
+  EventBits_t done = xEventGroupSetBits(doneBits, BOOT_AFTER(index)) | BOOT_AFTER(index);
+  portENTER_CRITICAL(&bootMux);
+  if ((done & allMask) == allMask && completeUs == 0) {
+    completeUs = end;
+    complete = true;
+  }
+  portEXIT_CRITICAL(&bootMux);
+  if (complete) {
+    Serial.printf("Boot complete at %lu ms (test boot for the report)\n", (unsigned long)(end / 1000));
+  }
+}
+
+static void bootStageTask(void* parameter) {
+  runStage((int)(intptr_t)parameter);
+  vTaskDelete(NULL);
+}
+
+void runBootStages(const BootStage* stages, int count, uint32_t readyAfter) {
+  if (count > BOOT_STAGE_MAX) count = BOOT_STAGE_MAX;
+  table = stages;
+  stageCount = count;
+  readyMask = readyAfter & ((1UL << count) - 1);
+  doneBits = xEventGroupCreate();
+
+  bool inSetup[BOOT_STAGE_MAX];
+  for (int i = 0; i < count; i++) {
+    timings[i] = {stages[i].name, 0, 0, 0, -1, (readyMask & BOOT_AFTER(i)) != 0};
+    inSetup[i] = BOOT_SEQUENTIAL || stages[i].core == BOOT_IN_SETUP;
+  }
+
+  // Stages with a core of their own start now and wait for their dependencies there
+  for (int i = 0; i < count; i++) {
+    if (inSetup[i]) continue;
+    if (xTaskCreatePinnedToCore(bootStageTask, stages[i].name, BOOT_TASK_STACK, (void*)(intptr_t)i,
+                                BOOT_TASK_PRIORITY, NULL, stages[i].core) != pdPASS) {
+      inSetup[i] = true;   // No memory for the task: run it here instead
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    if (inSetup[i]) runStage(i);
+  }
+
+  xEventGroupWaitBits(doneBits, readyMask, pdFALSE, pdTRUE, portMAX_DELAY);
+  portENTER_CRITICAL(&bootMux);
+  readyUs = micros();
+  portEXIT_CRITICAL(&bootMux);
+}
+
+void getBootReport(BootReport& report) {
+  portENTER_CRITICAL(&bootMux);
+  report.stageCount = stageCount;
+  for (int i = 0; i < stageCount; i++) report.stages[i] = timings[i];
+  report.setupUs = setupUs;
+  report.readyUs = readyUs;
+  report.completeUs = completeUs;
+  portEXIT_CRITICAL(&bootMux);
+
+  report.readySerialUs = 0;
+  report.totalSerialUs = 0;
+  for (int i = 0; i < report.stageCount; i++) {
+    const BootStageTiming& stage = report.stages[i];
+    if (stage.endUs == 0) continue;
+    uint32_t took = stage.endUs - stage.startUs;
+    report.totalSerialUs += took;
+    if (stage.beforeReady) report.readySerialUs += took;
+  }
+  report.sequential = BOOT_SEQUENTIAL;
+}
+
+// Milliseconds with one decimal
+static void printMs(const char* label, uint32_t us) {
+  Serial.printf("%s%lu.%lu ms", label, (unsigned long)(us / 1000), (unsigned long)(us % 1000 / 100));
+}
+
+void printBootReport() {
+  BootReport report;
+  getBootReport(report);
+
+  Serial.println();
+  Serial.println("================= BOOT =================");
+  Serial.println(report.sequential ? "Sequential boot (BOOT_SEQUENTIAL)" : "Staged boot, independent stages in parallel");
+  Serial.println("stage        core    start ms    took ms  waited ms");
+  for (int i = 0; i < report.stageCount; i++) {
+    const BootStageTiming& s = report.stages[i];
+    if (s.startUs == 0) {
+      Serial.printf("%-12s    -   waiting\n", s.name);
+      continue;
+    }
+    Serial.printf("%-12s %4d %11.1f", s.name, s.core, s.startUs / 1000.0f);
+    if (s.endUs == 0) {
+      Serial.println("    running");
+    } else {
+      Serial.printf(" %10.1f %10.1f%s\n", (s.endUs - s.startUs) / 1000.0f, s.waitUs / 1000.0f,
+                    s.beforeReady ? "" : "  (background)");
+    }
+  }
+  printMs("setup() entered at ", report.setupUs);
+  Serial.println();
+  if (report.readyUs == 0) {
+    Serial.println("Not ready to ring yet");
+  } else {
+    printMs("Ready to ring at ", report.readyUs);
+    printMs(" (", report.readyUs - report.setupUs);
+    Serial.println(" after setup() started)");
+    printMs("  Ready stages back to back: ", report.readySerialUs);
+    if (report.readySerialUs > report.readyUs - report.setupUs) {
+      printMs(", saved ", report.readySerialUs - (report.readyUs - report.setupUs));
+      Serial.print(" by overlapping them");
+    }
+    Serial.println();
+  }
+  if (report.completeUs == 0) {
+    Serial.println("Background stages still running");
+  } else {
+    printMs("Everything done at ", report.completeUs);
+    printMs(" (all stages back to back: ", report.totalSerialUs);
+    Serial.println(")");
+  }
+  Serial.println("========================================");
+}
@@ -0,0 +1,92 @@
+/*
+ * Boot.h - Staged Startup and Boot Profiler
+ *
+ * setup() describes startup as a table of stages, each with the stages it
+ * has to wait for, and hands it to runBootStages():
+ *
+ *   inputs      hook switch, rotary dial             setup task (core 1)
+ *   audio       I2S, amplifiers, microphone          setup task (core 1)
+ *   filesystem  LittleFS mount, config.json          boot task on core 0
+ *   radio       Wi-Fi driver in STA mode, ESP-NOW    boot task on core 0
+ *   settings    after inputs, audio, filesystem      setup task
+ *   network     after radio, settings                setup task
+ *   ...
+ *   wifi        router connect, after network        boot task on core 0
+ *   web         after wifi, services                 boot task on core 0
+ *
+ * Stages with a core get their own short-lived task; the others run on the
+ * setup task in table order once their dependencies are done. Boot tasks
+ * run above the setup task, so on core 1 one would simply preempt it until
+ * done: stages that should overlap with the setup task go on core 0.
+ * runBootStages() returns as soon as the stages in `readyAfter` are done
+ * ("ready to ring"); the rest finish in the background while loop() runs.
+ *
+ * Every stage is timed (start and end since the app started, the core it
+ * ran on, how long it waited for its dependencies). `test boot` and
+ * /api/v1/boot show the report, including what the same stages would take
+ * back to back, the measured saving over a sequential boot.
+ *
+ * Build with -DBOOT_SEQUENTIAL=1 to run every stage on the setup task in
+ * table order and wait for all of them, like the old setup(), to compare
+ * the two on the same phone.
+ */
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+
+#ifndef BOOT_SEQUENTIAL
+#define BOOT_SEQUENTIAL 0
+#endif
+
+#define BOOT_STAGE_MAX 12          // Stages in one table (one event group bit each)
+#define BOOT_TASK_STACK 8192       // config.json is parsed on the stack
+#define BOOT_TASK_PRIORITY 2       // Above loop() (1), below the Wi-Fi task: use core 0
+#define BOOT_IN_SETUP -1           // Stage core: run on the setup task itself
+
+#define BOOT_AFTER(stage) (1UL << (stage))
+
+typedef void (*BootStageFunction)();
+
+struct BootStage {
+  const char* name;
+  BootStageFunction run;
+  uint32_t after;                  // BOOT_AFTER() bits of stages that must finish first
+  int core;                        // 0 or 1 for its own task, or BOOT_IN_SETUP
+};
+
+struct BootStageTiming {
+  const char* name;
+  uint32_t startUs;                // Since the app started (0 = not started yet)
+  uint32_t endUs;                  // 0 = still running
+  uint32_t waitUs;                 // Spent waiting for dependencies
+  int8_t core;                     // Core it ran on
+  bool beforeReady;                // Part of the ready-to-ring set
+};
+
+struct BootReport {
+  BootStageTiming stages[BOOT_STAGE_MAX];
+  int stageCount;
+  uint32_t setupUs;                // setup() entered
+  uint32_t readyUs;                // Ready to ring (0 = not yet)
+  uint32_t completeUs;             // Every stage done (0 = not yet)
+  uint32_t readySerialUs;          // Ready-to-ring stages back to back
+  uint32_t totalSerialUs;          // All stages back to back
+  bool sequential;                 // BOOT_SEQUENTIAL build
+};
+
+// Called first thing in setup()
+void startBootProfile();
+
+// Runs the table (kept by reference, so it must be static); returns once
+// every stage in readyAfter is done
+void runBootStages(const BootStage* stages, int count, uint32_t readyAfter);
+
+// Consistent copy of the timings (any task)
+void getBootReport(BootReport& report);
+
+// Diagnostics (test mode)
+void printBootReport();
+
+#endif // BOOT_H
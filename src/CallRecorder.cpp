@@ -0,0 +1,850 @@
+/*
+ * CallRecorder - Streaming Call Recorder
+ *
+ *   recordTxFrame() ──┐                      ┌──► buffer A ──┐
+ *                     ├──► frame queue ──► encoder task      ├──► writer task ──► /rec/<id>.wav
+ *   recordRxAudio() ──┘    (non-blocking,    └──► buffer B ──┘
+ *                          frame pointers)
+ *
+ * Encoder task:
+ *   Keeps a PCM ring per channel and encodes one WAV IMA-ADPCM block as
+ *   soon as channel 0 has a full block (1017 samples, ~64ms). For calls
+ *   channel 0 is the microphone and acts as the clock: if the remote side
+ *   is short the block is padded with silence, if it runs ahead the oldest
+ *   samples are dropped. Messages are mono, so the caller is channel 0.
+ *   Encoded blocks are appended to the active 4KB buffer; a full buffer is
+ *   handed to the writer and encoding continues in the other one.
+ *
+ * Writer task:
+ *   Owns every LittleFS operation - open, 4KB appends, header patch on
+ *   close, index updates and eviction. Each buffer holds ~250ms of audio,
+ *   which is how long a single flash write may take before the encoder has
+ *   to wait. The frame queue absorbs a further ~75ms before frames drop.
+ *
+ * File layout:
+ *   The 60-byte WAV header is the first thing in the first buffer, so every
+ *   append is exactly one 4KB block at a 4KB-aligned offset. The header is
+ *   written with zero lengths and patched on close; a file left open by a
+ *   power cut is repaired from its size at the next boot.
+ */
+
+#include "CallRecorder.h"
+#include "Codec.h"
+#include "Network.h"
+#include "FramePool.h"
+#include "AudioMonitor.h"
+#include "Trace.h"
+#include "MemoryMonitor.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define RECORDER_SAMPLE_RATE 16000
+#define RECORDER_INDEX_FILE RECORDER_DIRECTORY "/index.csv"
+
+// WAV IMA-ADPCM block geometry: 4-byte header per channel, then 4 bits per sample
+#define ADPCM_BLOCK_BYTES_PER_CHANNEL 512
+#define ADPCM_SAMPLES_PER_BLOCK 1017     // 1 in the header + (512 - 4) * 2
+#define WAV_HEADER_SIZE 60               // RIFF + fmt (20) + fact + data headers
+
+#define RECORDER_RING_SAMPLES 2048       // Per direction, two blocks plus slack
+
+enum RecorderFrameType : uint8_t {
+  FRAME_AUDIO,
+  FRAME_START,
+  FRAME_STOP
+};
+
+// Frame queue entry (loop/callback → encoder). Audio travels by reference:
+// the entry holds one reference to a pooled frame, the encoder releases it.
+struct RecorderFrame {
+  uint8_t type;          // RecorderFrameType
+  uint8_t channel;       // FRAME_AUDIO: channel index. FRAME_START: RecordingKind
+  int32_t peer;          // FRAME_START only
+  AudioFrame* audio;     // FRAME_AUDIO only
+};
+
+enum WriterCommandType : uint8_t {
+  WRITE_OPEN,
+  WRITE_DATA,
+  WRITE_CLOSE,
+  WRITE_MARK_HEARD
+};
+
+// Writer queue entry (encoder/loop → writer)
+struct WriterCommand {
+  uint8_t type;
+  uint8_t buffer;        // WRITE_DATA: which buffer to append. WRITE_OPEN: RecordingKind
+  uint16_t length;
+  int32_t peer;          // WRITE_OPEN
+  uint32_t samples;      // WRITE_CLOSE: samples per channel. WRITE_MARK_HEARD: recording id
+};
+
+// ====== Configuration ======
+static bool recordCallsEnabled = false;
+static bool recordMessagesEnabled = false;
+static bool recorderRunning = false;      // Buffers allocated and tasks started
+static uint32_t maxTotalBytes = 0;
+
+// ====== Loop / Callback Side ======
+static QueueHandle_t frameQueue = NULL;
+static volatile bool recordingActive = false;
+static volatile uint8_t activeKind = RECORDING_CALL;
+
+// ====== Encoder Task State ======
+static QueueHandle_t writerQueue = NULL;
+static SemaphoreHandle_t bufferFree[2];
+static uint8_t* writeBuffers[2];
+static uint8_t activeBuffer = 0;
+static size_t bufferFill = 0;
+
+static int16_t* pcmRing[2];
+static size_t ringHead[2];
+static size_t ringCount[2];
+static int16_t* blockPcm[2];
+static uint8_t blockBytes[ADPCM_BLOCK_BYTES_PER_CHANNEL * 2];
+static AdpcmState encoderState[2];
+static bool sessionOpen = false;
+static uint8_t sessionChannels = 2;
+static uint32_t sessionSamples = 0;
+
+// ====== Writer Task State ======
+static File recordingFile;
+static uint32_t recordingId = 0;
+static uint32_t recordingBytes = 0;
+static uint8_t recordingChannels = 2;
+static int recordingPeer = -1;
+static uint8_t recordingKind = RECORDING_CALL;
+static bool recordingTruncated = false;
+
+// ====== Index (writer task writes, web/test mode read) ======
+static portMUX_TYPE indexMux = portMUX_INITIALIZER_UNLOCKED;
+static RecordingInfo recordings[RECORDER_MAX_FILES];
+static int recordingCount = 0;
+static uint32_t indexedBytes = 0;
+static uint32_t nextRecordingId = 1;
+
+// ====== Statistics ======
+static volatile uint32_t framesQueued = 0;
+static volatile uint32_t framesDropped = 0;     // Frame queue full
+static uint32_t samplesOverrun = 0;             // Remote side ran ahead of the mic
+static uint32_t samplesPadded = 0;              // Remote side short, filled with silence
+static uint32_t encoderWaits = 0;               // Both buffers busy - writer fell behind
+static uint32_t blocksEncoded = 0;
+static uint32_t writesDone = 0;
+static uint32_t writeMaxUs = 0;
+static uint64_t writeTotalUs = 0;
+static uint32_t recordingsEvicted = 0;
+static uint32_t writesFailed = 0;
+
+static void writeLE16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+static void writeLE32(uint8_t* p, uint32_t value) {
+  p[0] = value & 0xFF;
+  p[1] = (value >> 8) & 0xFF;
+  p[2] = (value >> 16) & 0xFF;
+  p[3] = value >> 24;
+}
+
+/*
+ * Build WAV Header
+ * RIFF/WAVE with a WAVE_FORMAT_IMA_ADPCM (0x11) fmt chunk and a fact chunk
+ * holding the per-channel sample count.
+ */
+static void buildWavHeader(uint8_t* header, uint8_t channels, uint32_t dataBytes, uint32_t samples) {
+  uint16_t blockAlign = ADPCM_BLOCK_BYTES_PER_CHANNEL * channels;
+
+  memcpy(header + 0, "RIFF", 4);
+  writeLE32(header + 4, WAV_HEADER_SIZE - 8 + dataBytes);
+  memcpy(header + 8, "WAVE", 4);
+
+  memcpy(header + 12, "fmt ", 4);
+  writeLE32(header + 16, 20);
+  writeLE16(header + 20, 0x0011);                      // IMA-ADPCM
+  writeLE16(header + 22, channels);
+  writeLE32(header + 24, RECORDER_SAMPLE_RATE);
+  writeLE32(header + 28, (uint32_t)RECORDER_SAMPLE_RATE * blockAlign / ADPCM_SAMPLES_PER_BLOCK);
+  writeLE16(header + 32, blockAlign);
+  writeLE16(header + 34, 4);                           // Bits per sample
+  writeLE16(header + 36, 2);                           // Extra format bytes
+  writeLE16(header + 38, ADPCM_SAMPLES_PER_BLOCK);
+
+  memcpy(header + 40, "fact", 4);
+  writeLE32(header + 44, 4);
+  writeLE32(header + 48, samples);
+
+  memcpy(header + 52, "data", 4);
+  writeLE32(header + 56, dataBytes);
+}
+
+// ====== Index ======
+
+void getRecordingPath(uint32_t id, char* path, size_t length) {
+  snprintf(path, length, RECORDER_DIRECTORY "/%lu.wav", (unsigned long)id);
+}
+
+static uint8_t channelsFor(uint8_t kind) {
+  return kind == RECORDING_MESSAGE ? 1 : 2;
+}
+
+/*
+ * Save Index
+ * Small CSV (id,peer,duration_ms,bytes,kind,heard), rewritten whenever it changes.
+ */
+static void saveIndex() {
+  File file = LittleFS.open(RECORDER_INDEX_FILE, "w");
+  if (!file) {
+    LOG_WARN("Recorder: failed to write index");
+    return;
+  }
+  for (int i = 0; i < recordingCount; i++) {
+    file.printf("%lu,%d,%lu,%lu,%u,%u\n", (unsigned long)recordings[i].id, recordings[i].peer,
+                (unsigned long)recordings[i].durationMs, (unsigned long)recordings[i].bytes,
+                recordings[i].kind, recordings[i].heard ? 1 : 0);
+  }
+  file.close();
+}
+
+// Insert keeping the index sorted by id (oldest first). Caller holds indexMux.
+static void insertRecording(const RecordingInfo& info) {
+  int pos = recordingCount;
+  while (pos > 0 && recordings[pos - 1].id > info.id) {
+    recordings[pos] = recordings[pos - 1];
+    pos--;
+  }
+  recordings[pos] = info;
+  recordingCount++;
+  indexedBytes += info.bytes;
+  if (info.id >= nextRecordingId) {
+    nextRecordingId = info.id + 1;
+  }
+}
+
+// Oldest recording that isn't an unheard message, else the oldest of all
+static int evictionCandidate(int keep) {
+  for (int i = 0; i < recordingCount - keep; i++) {
+    if (recordings[i].kind != RECORDING_MESSAGE || recordings[i].heard) return i;
+  }
+  return 0;
+}
+
+/*
+ * Evict Oldest
+ * Deletes the oldest recordings until the total fits in the cap, always
+ * keeping at least `keep` of the newest ones. Unheard messages go last.
+ */
+static void evictOldest(int keep) {
+  bool changed = false;
+  while (recordingCount > keep &&
+         (indexedBytes > maxTotalBytes || recordingCount >= RECORDER_MAX_FILES)) {
+    portENTER_CRITICAL(&indexMux);
+    int victim = evictionCandidate(keep);
+    RecordingInfo oldest = recordings[victim];
+    memmove(&recordings[victim], &recordings[victim + 1], (recordingCount - victim - 1) * sizeof(RecordingInfo));
+    recordingCount--;
+    indexedBytes -= oldest.bytes;
+    portEXIT_CRITICAL(&indexMux);
+
+    char path[32];
+    getRecordingPath(oldest.id, path, sizeof(path));
+    LittleFS.remove(path);
+    recordingsEvicted++;
+    changed = true;
+    LOG_INFO("Recorder: evicted " RECORDER_DIRECTORY "/%lu.wav", (unsigned long)oldest.id);
+  }
+  if (changed) {
+    saveIndex();
+  }
+}
+
+/*
+ * Repair Recording
+ * A recording that was never closed (power cut mid-call) still has the
+ * zero-length placeholder header. Work out the lengths from the file size.
+ */
+static bool repairRecording(const char* path, RecordingInfo& info) {
+  File file = LittleFS.open(path, "r+");
+  if (!file) return false;
+
+  uint8_t header[WAV_HEADER_SIZE];
+  if (file.read(header, WAV_HEADER_SIZE) != WAV_HEADER_SIZE ||
+      memcmp(header, "RIFF", 4) != 0 || header[20] != 0x11) {
+    file.close();
+    return false;
+  }
+
+  uint8_t channels = header[22] == 1 ? 1 : 2;
+  uint32_t blockAlign = ADPCM_BLOCK_BYTES_PER_CHANNEL * channels;
+  uint32_t size = file.size();
+  uint32_t blocks = size > WAV_HEADER_SIZE ? (size - WAV_HEADER_SIZE) / blockAlign : 0;
+  uint32_t samples = blocks * ADPCM_SAMPLES_PER_BLOCK;
+
+  buildWavHeader(header, channels, blocks * blockAlign, samples);
+  file.seek(0);
+  file.write(header, WAV_HEADER_SIZE);
+  file.close();
+
+  info.peer = -1;
+  info.durationMs = (uint64_t)samples * 1000 / RECORDER_SAMPLE_RATE;
+  info.bytes = size;
+  info.kind = channels == 1 ? RECORDING_MESSAGE : RECORDING_CALL;
+  info.heard = info.kind == RECORDING_CALL;
+  return true;
+}
+
+/*
+ * Load Index
+ * Reads index.csv, drops entries whose file is gone and adopts any .wav
+ * files the index doesn't know about (repairing their headers).
+ */
+static void loadIndex() {
+  recordingCount = 0;
+  indexedBytes = 0;
+  nextRecordingId = 1;
+
+  if (!LittleFS.exists(RECORDER_DIRECTORY)) {
+    LittleFS.mkdir(RECORDER_DIRECTORY);
+  }
+
+  char path[32];
+  File indexFile = LittleFS.open(RECORDER_INDEX_FILE, "r");
+  if (indexFile) {
+    while (indexFile.available() && recordingCount < RECORDER_MAX_FILES) {
+      String line = indexFile.readStringUntil('\n');
+      unsigned long id, duration, bytes;
+      int peer;
+      unsigned kind = RECORDING_CALL, heard = 1;
+      if (sscanf(line.c_str(), "%lu,%d,%lu,%lu,%u,%u", &id, &peer, &duration, &bytes, &kind, &heard) < 4) continue;
+      getRecordingPath(id, path, sizeof(path));
+      if (!LittleFS.exists(path)) continue;
+      RecordingInfo info = { (uint32_t)id, peer, (uint32_t)duration, (uint32_t)bytes, (uint8_t)kind, heard != 0 };
+      insertRecording(info);
+    }
+    indexFile.close();
+  }
+
+  bool repaired = false;
+  File dir = LittleFS.open(RECORDER_DIRECTORY);
+  File entry = dir.openNextFile();
+  while (entry) {
+    const char* name = entry.name();
+    uint32_t id = strtoul(name, NULL, 10);
+    bool isWav = strstr(name, ".wav") != NULL;
+    entry.close();
+
+    bool known = false;
+    for (int i = 0; i < recordingCount; i++) {
+      if (recordings[i].id == id) known = true;
+    }
+    if (isWav && id > 0 && !known && recordingCount < RECORDER_MAX_FILES) {
+      getRecordingPath(id, path, sizeof(path));
+      RecordingInfo info;
+      info.id = id;
+      if (repairRecording(path, info)) {
+        insertRecording(info);
+        repaired = true;
+        Serial.print("Recorder: recovered ");
+        Serial.println(path);
+      }
+    }
+    entry = dir.openNextFile();
+  }
+  dir.close();
+
+  if (repaired) {
+    saveIndex();
+  }
+}
+
+// ====== Writer Task ======
+
+static void writerOpen(uint8_t kind, int peer) {
+  // Make room for the new file's index slot first
+  evictOldest(0);
+
+  recordingId = nextRecordingId++;
+  recordingKind = kind;
+  recordingChannels = channelsFor(kind);
+  recordingPeer = peer;
+  recordingBytes = 0;
+  recordingTruncated = false;
+
+  char path[32];
+  getRecordingPath(recordingId, path, sizeof(path));
+  recordingFile = LittleFS.open(path, "w");
+  if (!recordingFile) {
+    LOG_WARN("Recorder: cannot create " RECORDER_DIRECTORY "/%lu.wav", (unsigned long)recordingId);
+    writesFailed++;
+  }
+}
+
+static void writerAppend(uint8_t buffer, size_t length) {
+  if (!recordingFile || recordingTruncated) return;
+
+  // A single call may not outgrow the whole recording budget
+  if (recordingBytes + length > maxTotalBytes) {
+    recordingTruncated = true;
+    LOG_WARN("Recorder: size limit reached, recording truncated");
+    return;
+  }
+
+  uint32_t start = micros();
+  size_t written = recordingFile.write(writeBuffers[buffer], length);
+  uint32_t elapsed = micros() - start;
+  TRACE_SPAN(littlefs_write, start);
+
+  writesDone++;
+  writeTotalUs += elapsed;
+  if (elapsed > writeMaxUs) writeMaxUs = elapsed;
+  recordingBytes += written;
+  if (written != length) {
+    writesFailed++;
+    recordingTruncated = true;
+    LOG_WARN("Recorder: write failed (filesystem full?)");
+  }
+}
+
+static void writerClose(uint32_t samples) {
+  if (!recordingFile) return;
+
+  uint32_t blockAlign = ADPCM_BLOCK_BYTES_PER_CHANNEL * recordingChannels;
+  uint32_t dataBytes = recordingBytes > WAV_HEADER_SIZE ? recordingBytes - WAV_HEADER_SIZE : 0;
+  if (recordingTruncated) {
+    // Only whole blocks made it to flash
+    uint32_t blocks = dataBytes / blockAlign;
+    dataBytes = blocks * blockAlign;
+    if (samples > blocks * ADPCM_SAMPLES_PER_BLOCK) samples = blocks * ADPCM_SAMPLES_PER_BLOCK;
+  }
+
+  uint8_t header[WAV_HEADER_SIZE];
+  buildWavHeader(header, recordingChannels, dataBytes, samples);
+  recordingFile.seek(0);
+  recordingFile.write(header, WAV_HEADER_SIZE);
+  recordingFile.close();
+
+  RecordingInfo info;
+  info.id = recordingId;
+  info.peer = recordingPeer;
+  info.durationMs = (uint64_t)samples * 1000 / RECORDER_SAMPLE_RATE;
+  info.bytes = recordingBytes;
+  info.kind = recordingKind;
+  info.heard = recordingKind != RECORDING_MESSAGE;
+
+  portENTER_CRITICAL(&indexMux);
+  insertRecording(info);
+  portEXIT_CRITICAL(&indexMux);
+  saveIndex();
+  evictOldest(1);
+
+  LOG_INFO("Recorder: saved %s #%lu (%lu s, %lu KB)",
+           info.kind == RECORDING_MESSAGE ? "message" : "call", (unsigned long)info.id,
+           (unsigned long)(info.durationMs / 1000), (unsigned long)(info.bytes / 1024));
+}
+
+static void recorderWriterTask(void* parameter) {
+  WriterCommand command;
+  while (true) {
+    if (xQueueReceive(writerQueue, &command, portMAX_DELAY) != pdTRUE) continue;
+    switch (command.type) {
+      case WRITE_OPEN:
+        writerOpen(command.buffer, command.peer);
+        break;
+      case WRITE_DATA:
+        writerAppend(command.buffer, command.length);
+        xSemaphoreGive(bufferFree[command.buffer]);
+        break;
+      case WRITE_CLOSE:
+        writerClose(command.samples);
+        break;
+      case WRITE_MARK_HEARD:
+        saveIndex();
+        break;
+    }
+  }
+}
+
+// ====== Encoder Task ======
+
+// Hand the active buffer to the writer and switch to the other one
+static void submitBuffer(bool takeNext) {
+  WriterCommand command = { WRITE_DATA, activeBuffer, (uint16_t)bufferFill, 0, 0 };
+  xQueueSend(writerQueue, &command, portMAX_DELAY);
+  activeBuffer ^= 1;
+  bufferFill = 0;
+
+  if (takeNext && xSemaphoreTake(bufferFree[activeBuffer], 0) != pdTRUE) {
+    encoderWaits++;
+    xSemaphoreTake(bufferFree[activeBuffer], portMAX_DELAY);
+  }
+}
+
+static void appendOutput(const uint8_t* data, size_t length) {
+  while (length > 0) {
+    size_t space = RECORDER_WRITE_SIZE - bufferFill;
+    size_t chunk = length < space ? length : space;
+    memcpy(writeBuffers[activeBuffer] + bufferFill, data, chunk);
+    bufferFill += chunk;
+    data += chunk;
+    length -= chunk;
+    if (bufferFill == RECORDER_WRITE_SIZE) {
+      submitBuffer(true);
+    }
+  }
+}
+
+static void pushSamples(uint8_t channel, const int16_t* samples, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (ringCount[channel] == RECORDER_RING_SAMPLES) {
+      // Full - drop the oldest sample
+      ringHead[channel] = (ringHead[channel] + 1) % RECORDER_RING_SAMPLES;
+      ringCount[channel]--;
+      samplesOverrun++;
+    }
+    size_t tail = (ringHead[channel] + ringCount[channel]) % RECORDER_RING_SAMPLES;
+    pcmRing[channel][tail] = samples[i];
+    ringCount[channel]++;
+  }
+}
+
+static size_t popSamples(uint8_t channel, int16_t* output, size_t count) {
+  size_t available = ringCount[channel] < count ? ringCount[channel] : count;
+  for (size_t i = 0; i < available; i++) {
+    output[i] = pcmRing[channel][ringHead[channel]];
+    ringHead[channel] = (ringHead[channel] + 1) % RECORDER_RING_SAMPLES;
+  }
+  ringCount[channel] -= available;
+  return available;
+}
+
+/*
+ * Encode Block
+ * WAV IMA-ADPCM block: per channel a 4-byte header (first sample + step
+ * index), then groups of 8 samples (4 bytes) interleaved channel by channel.
+ */
+static void encodeBlock() {
+  uint8_t* out = blockBytes;
+  for (uint8_t ch = 0; ch < sessionChannels; ch++) {
+    encoderState[ch].predictor = blockPcm[ch][0];
+    writeLE16(out, (uint16_t)blockPcm[ch][0]);
+    out[2] = encoderState[ch].stepIndex;
+    out[3] = 0;
+    out += 4;
+  }
+  for (size_t group = 1; group < ADPCM_SAMPLES_PER_BLOCK; group += 8) {
+    for (uint8_t ch = 0; ch < sessionChannels; ch++) {
+      adpcmEncode(encoderState[ch], &blockPcm[ch][group], 8, out);
+      out += 4;
+    }
+  }
+  appendOutput(blockBytes, ADPCM_BLOCK_BYTES_PER_CHANNEL * sessionChannels);
+  blocksEncoded++;
+}
+
+// Pull one block's worth per channel, padding short channels with silence
+static size_t fillBlock() {
+  size_t clock = popSamples(0, blockPcm[0], ADPCM_SAMPLES_PER_BLOCK);
+  memset(blockPcm[0] + clock, 0, (ADPCM_SAMPLES_PER_BLOCK - clock) * sizeof(int16_t));
+  for (uint8_t ch = 1; ch < sessionChannels; ch++) {
+    size_t got = popSamples(ch, blockPcm[ch], clock);
+    samplesPadded += clock - got;
+    memset(blockPcm[ch] + got, 0, (ADPCM_SAMPLES_PER_BLOCK - got) * sizeof(int16_t));
+  }
+  return clock;
+}
+
+static void beginSession(uint8_t kind, int peer) {
+  uint8_t channels = channelsFor(kind);
+  sessionChannels = channels;
+  sessionSamples = 0;
+  for (int ch = 0; ch < 2; ch++) {
+    ringHead[ch] = 0;
+    ringCount[ch] = 0;
+    adpcmReset(encoderState[ch]);
+  }
+
+  WriterCommand command = { WRITE_OPEN, kind, 0, peer, 0 };
+  xQueueSend(writerQueue, &command, portMAX_DELAY);
+
+  // Placeholder header (patched on close) starts the first buffer
+  xSemaphoreTake(bufferFree[activeBuffer], portMAX_DELAY);
+  bufferFill = 0;
+  uint8_t header[WAV_HEADER_SIZE];
+  buildWavHeader(header, channels, 0, 0);
+  appendOutput(header, WAV_HEADER_SIZE);
+  sessionOpen = true;
+}
+
+static void endSession() {
+  // Flush the partial last block, then the partial last buffer
+  if (ringCount[0] > 0) {
+    sessionSamples += fillBlock();
+    encodeBlock();
+  }
+  if (bufferFill > 0) {
+    submitBuffer(false);
+  } else {
+    xSemaphoreGive(bufferFree[activeBuffer]);
+  }
+
+  WriterCommand command = { WRITE_CLOSE, 0, 0, 0, sessionSamples };
+  xQueueSend(writerQueue, &command, portMAX_DELAY);
+  sessionOpen = false;
+}
+
+static void recorderEncoderTask(void* parameter) {
+  RecorderFrame frame;
+  while (true) {
+    if (xQueueReceive(frameQueue, &frame, portMAX_DELAY) != pdTRUE) continue;
+
+    switch (frame.type) {
+      case FRAME_START:
+        if (sessionOpen) endSession();
+        beginSession(frame.channel, frame.peer);
+        break;
+
+      case FRAME_AUDIO:
+        countAudioCopy(AUDIO_COPY_RECORDER, sizeof(RecorderFrame));   // Out of the queue
+        if (sessionOpen && frame.channel < sessionChannels) {
+          pushSamples(frame.channel, frame.audio->samples(), frame.audio->count);
+          countAudioCopy(AUDIO_COPY_RECORDER, frame.audio->count * sizeof(int16_t));
+          while (ringCount[0] >= ADPCM_SAMPLES_PER_BLOCK) {
+            sessionSamples += fillBlock();
+            encodeBlock();
+          }
+        }
+        releaseAudioFrame(frame.audio);
+        break;
+
+      case FRAME_STOP:
+        if (sessionOpen) endSession();
+        break;
+    }
+  }
+}
+
+// ====== Public API ======
+
+/*
+ * Setup Call Recorder
+ * The index is always loaded so old recordings stay downloadable; buffers
+ * and tasks only exist when call recording or voicemail is enabled.
+ */
+void setupCallRecorder(bool recordCalls, bool recordMessages, uint32_t maxBytes) {
+  maxTotalBytes = maxBytes;
+  loadIndex();
+
+  Serial.print("Recorder: ");
+  Serial.print(recordingCount);
+  Serial.print(" recordings (");
+  Serial.print(getUnheardMessageCount());
+  Serial.print(" new messages), ");
+  Serial.print(indexedBytes / 1024);
+  Serial.println(" KB");
+
+  if (!recordCalls && !recordMessages) return;
+
+  for (int i = 0; i < 2; i++) {
+    writeBuffers[i] = (uint8_t*)memoryAlloc(MEMORY_RECORDER, RECORDER_WRITE_SIZE);
+    pcmRing[i] = (int16_t*)memoryAlloc(MEMORY_RECORDER, RECORDER_RING_SAMPLES * sizeof(int16_t));
+    blockPcm[i] = (int16_t*)memoryAlloc(MEMORY_RECORDER, ADPCM_SAMPLES_PER_BLOCK * sizeof(int16_t));
+    bufferFree[i] = xSemaphoreCreateBinary();
+    if (!writeBuffers[i] || !pcmRing[i] || !blockPcm[i] || !bufferFree[i]) {
+      Serial.println("Recorder: out of memory, recording disabled");
+      return;
+    }
+    xSemaphoreGive(bufferFree[i]);
+  }
+
+  frameQueue = xQueueCreate(RECORDER_QUEUE_FRAMES, sizeof(RecorderFrame));
+  writerQueue = xQueueCreate(4, sizeof(WriterCommand));
+  if (!frameQueue || !writerQueue) {
+    Serial.println("Recorder: out of memory, recording disabled");
+    return;
+  }
+
+  // Core 0 alongside Wi-Fi; the audio loop runs on core 1.
+  // The encoder outranks the writer so it keeps draining frames while a write is in flight.
+  xTaskCreatePinnedToCore(recorderEncoderTask, "recEncode", 4096, NULL, 2, NULL, 0);
+  xTaskCreatePinnedToCore(recorderWriterTask, "recWrite", 4096, NULL, 1, NULL, 0);
+
+  recorderRunning = true;
+  recordCallsEnabled = recordCalls;
+  recordMessagesEnabled = recordMessages;
+  if (recordCalls) {
+    Serial.print("Recorder: recording calls, limit ");
+    Serial.print(maxTotalBytes / 1024);
+    Serial.println(" KB");
+  }
+}
+
+static void startRecording(uint8_t kind, int peerNumber) {
+  if (!recorderRunning || recordingActive) return;
+
+  RecorderFrame frame;
+  frame.type = FRAME_START;
+  frame.channel = kind;
+  frame.peer = peerNumber;
+  frame.audio = nullptr;
+  if (xQueueSend(frameQueue, &frame, pdMS_TO_TICKS(20)) != pdTRUE) {
+    LOG_WARN("Recorder: busy, not recording");
+    return;
+  }
+  activeKind = kind;
+  recordingActive = true;
+  LOG_INFO("Recorder: recording %s", kind == RECORDING_MESSAGE ? "message" : "call");
+}
+
+void startCallRecording(int peerNumber) {
+  if (recordCallsEnabled) startRecording(RECORDING_CALL, peerNumber);
+}
+
+void startMessageRecording(int peerNumber) {
+  if (recordMessagesEnabled) startRecording(RECORDING_MESSAGE, peerNumber);
+}
+
+void stopRecording() {
+  if (!recordingActive) return;
+  recordingActive = false;
+
+  RecorderFrame frame;
+  frame.type = FRAME_STOP;
+  frame.channel = 0;
+  frame.peer = -1;
+  frame.audio = nullptr;
+  // If this is lost the next START closes the file instead
+  xQueueSend(frameQueue, &frame, pdMS_TO_TICKS(100));
+}
+
+bool isRecording() {
+  return recordingActive;
+}
+
+// Takes over the caller's reference to `audio`
+static void queueAudio(uint8_t channel, AudioFrame* audio) {
+  if (!audio) {
+    framesDropped++;             // Frame pool empty
+    return;
+  }
+  RecorderFrame frame;
+  frame.type = FRAME_AUDIO;
+  frame.channel = channel;
+  frame.peer = -1;
+  frame.audio = audio;
+
+  if (xQueueSend(frameQueue, &frame, 0) == pdTRUE) {
+    countAudioCopy(AUDIO_COPY_RECORDER, sizeof(RecorderFrame));   // Into the queue
+    framesQueued++;
+  } else {
+    releaseAudioFrame(audio);
+    framesDropped++;
+  }
+}
+
+void recordTxFrame(AudioFrame* frame) {
+  // Messages only keep the caller
+  if (!recordingActive || activeKind == RECORDING_MESSAGE || !frame) return;
+  queueAudio(0, retainAudioFrame(frame));
+}
+
+void recordRxAudio(const int16_t* samples, size_t count) {
+  if (!recordingActive) return;
+  // Arrives in the ESP-NOW or mixer buffer: one copy into a frame
+  queueAudio(activeKind == RECORDING_MESSAGE ? 0 : 1, copyAudioFrame(samples, count));
+}
+
+int getRecordingCount() {
+  return recordingCount;
+}
+
+bool getRecordingInfo(int index, RecordingInfo& info) {
+  bool found = false;
+  portENTER_CRITICAL(&indexMux);
+  if (index >= 0 && index < recordingCount) {
+    info = recordings[index];
+    found = true;
+  }
+  portEXIT_CRITICAL(&indexMux);
+  return found;
+}
+
+bool findRecording(uint32_t id, RecordingInfo& info) {
+  bool found = false;
+  portENTER_CRITICAL(&indexMux);
+  for (int i = 0; i < recordingCount; i++) {
+    if (recordings[i].id == id) {
+      info = recordings[i];
+      found = true;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&indexMux);
+  return found;
+}
+
+int getUnheardMessageCount() {
+  int unheard = 0;
+  portENTER_CRITICAL(&indexMux);
+  for (int i = 0; i < recordingCount; i++) {
+    if (recordings[i].kind == RECORDING_MESSAGE && !recordings[i].heard) unheard++;
+  }
+  portEXIT_CRITICAL(&indexMux);
+  return unheard;
+}
+
+/*
+ * Mark Recording Heard
+ * Updates the index in RAM right away; the writer task saves it to flash.
+ */
+void markRecordingHeard(uint32_t id) {
+  bool changed = false;
+  portENTER_CRITICAL(&indexMux);
+  for (int i = 0; i < recordingCount; i++) {
+    if (recordings[i].id == id && !recordings[i].heard) {
+      recordings[i].heard = true;
+      changed = true;
+    }
+  }
+  portEXIT_CRITICAL(&indexMux);
+
+  if (changed && recorderRunning) {
+    WriterCommand command = { WRITE_MARK_HEARD, 0, 0, 0, id };
+    xQueueSend(writerQueue, &command, pdMS_TO_TICKS(20));
+  }
+}
+
+/*
+ * Print Recorder Stats
+ */
+void printRecorderStats() {
+  Serial.println();
+  Serial.println("========== RECORDER STATS ==========");
+  Serial.print("Calls: ");
+  Serial.print(recordCallsEnabled ? "on" : "off");
+  Serial.print(", voicemail: ");
+  Serial.println(recordMessagesEnabled ? "on" : "off");
+  Serial.print("Recording now: ");
+  Serial.println(recordingActive ? (activeKind == RECORDING_MESSAGE ? "message" : "call") : "no");
+  Serial.printf("Recordings: %d, %lu KB of %lu KB\n", recordingCount,
+                (unsigned long)(indexedBytes / 1024), (unsigned long)(maxTotalBytes / 1024));
+  Serial.printf("Frames queued: %lu, dropped (queue or frame pool full): %lu\n",
+                (unsigned long)framesQueued, (unsigned long)framesDropped);
+  Serial.printf("Blocks encoded: %lu, remote padded: %lu samples, overrun: %lu samples\n",
+                (unsigned long)blocksEncoded, (unsigned long)samplesPadded, (unsigned long)samplesOverrun);
+  Serial.printf("Flash writes: %lu x %d bytes, avg %lu us, max %lu us\n",
+                (unsigned long)writesDone, RECORDER_WRITE_SIZE,
+                writesDone > 0 ? (unsigned long)(writeTotalUs / writesDone) : 0UL,
+                (unsigned long)writeMaxUs);
+  Serial.printf("Encoder waited for writer: %lu, failed writes: %lu, evicted: %lu\n",
+                (unsigned long)encoderWaits, (unsigned long)writesFailed, (unsigned long)recordingsEvicted);
+  Serial.printf("Buffer headroom: %lu ms per 4KB buffer\n",
+                (unsigned long)((uint64_t)RECORDER_WRITE_SIZE * ADPCM_SAMPLES_PER_BLOCK * 1000 /
+                                ((uint64_t)ADPCM_BLOCK_BYTES_PER_CHANNEL * 2 * RECORDER_SAMPLE_RATE)));
+  Serial.println("====================================");
+}
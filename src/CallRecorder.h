@@ -0,0 +1,81 @@
+/*
+ * CallRecorder.h - Streaming Call Recorder
+ *
+ * Records both directions of a call to LittleFS as a stereo IMA-ADPCM WAV
+ * file (left = this phone's microphone, right = the other side).
+ * Opt-in via "record_calls" in config.json.
+ *
+ * Pipeline:
+ *   loop / ESP-NOW callback ──► frame queue ──► encoder task ──► 2 x 4KB buffers ──► writer task ──► LittleFS
+ *
+ * The audio path only ever does a non-blocking queue send of a frame
+ * pointer (the samples stay in the shared frame). Encoding and
+ * flash writes run in background tasks, so a slow LittleFS write (garbage
+ * collection can take hundreds of ms) never stalls the call.
+ *
+ * Voicemail messages go through the same pipeline as mono files (the
+ * caller only) and share the index, marked as messages with a heard flag.
+ *
+ * Files live in /rec/<id>.wav with an index in /rec/index.csv. When the
+ * total size exceeds "record_max_kb" the oldest recordings are deleted,
+ * unheard messages last.
+ */
+
+#ifndef CALL_RECORDER_H
+#define CALL_RECORDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define RECORDER_DIRECTORY "/rec"
+#define RECORDER_MAX_FILES 32           // Index entries kept (oldest evicted beyond this)
+#define RECORDER_WRITE_SIZE 4096        // One LittleFS block per append
+#define RECORDER_QUEUE_FRAMES 24        // ~75ms of both directions
+
+enum RecordingKind : uint8_t {
+  RECORDING_CALL = 0,     // Stereo: left = local mic, right = remote
+  RECORDING_MESSAGE = 1   // Mono: remote only (voicemail)
+};
+
+// Index entry for a finished recording
+struct RecordingInfo {
+  uint32_t id;            // File is /rec/<id>.wav
+  int peer;               // Other phone's number (-1 if unknown)
+  uint32_t durationMs;
+  uint32_t bytes;
+  uint8_t kind;           // RecordingKind
+  bool heard;             // Messages: played back at least once
+};
+
+// Load the index and, if either kind of recording is enabled, start the
+// encoder and writer tasks
+void setupCallRecorder(bool recordCalls, bool recordMessages, uint32_t maxTotalBytes);
+
+// Start a recording (call: entering IN_CALL, message: voicemail answered)
+void startCallRecording(int peerNumber);
+void startMessageRecording(int peerNumber);
+
+// Close the current recording, if any
+void stopRecording();
+bool isRecording();
+
+// Audio taps - never block. The microphone frame is queued by reference
+// (FramePool.h); remote audio is copied once into a pooled frame.
+struct AudioFrame;
+void recordTxFrame(AudioFrame* frame);                      // Local microphone (loop)
+void recordRxAudio(const int16_t* samples, size_t count);   // Remote audio (callback or loop)
+
+// Finished recordings, oldest first
+int getRecordingCount();
+bool getRecordingInfo(int index, RecordingInfo& info);
+bool findRecording(uint32_t id, RecordingInfo& info);
+void getRecordingPath(uint32_t id, char* path, size_t length);
+
+// Voicemail bookkeeping
+int getUnheardMessageCount();
+void markRecordingHeard(uint32_t id);
+
+// Diagnostics (test mode)
+void printRecorderStats();
+
+#endif // CALL_RECORDER_H
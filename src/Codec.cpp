@@ -0,0 +1,137 @@
+/*
+ * Codec - IMA-ADPCM and Sample Rate Helpers
+ *
+ * IMA-ADPCM encodes the difference between each sample and a running
+ * prediction as a 4-bit code scaled by an adaptive step size. The decoder
+ * runs the same prediction, so encoder and decoder stay in lockstep as
+ * long as they start from the same AdpcmState.
+ *
+ * Everything here is integer-only and allocation-free.
+ */
+
+#include "Codec.h"
+
+// Standard IMA-ADPCM step size table
+static const int16_t ADPCM_STEP_TABLE[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+  19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+  130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+  337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+  2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+  5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+// Step index adjustment per code magnitude
+static const int8_t ADPCM_INDEX_TABLE[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static inline int16_t clamp16(int32_t value) {
+  if (value > 32767) return 32767;
+  if (value < -32768) return -32768;
+  return (int16_t)value;
+}
+
+static inline uint8_t nextIndex(uint8_t index, uint8_t code) {
+  int next = index + ADPCM_INDEX_TABLE[code & 7];
+  if (next < 0) next = 0;
+  if (next > 88) next = 88;
+  return (uint8_t)next;
+}
+
+/*
+ * Decode one 4-bit code, updating the predictor and step index
+ */
+static inline int16_t decodeNibble(AdpcmState& state, uint8_t code) {
+  int32_t step = ADPCM_STEP_TABLE[state.stepIndex];
+  int32_t diff = step >> 3;
+  if (code & 4) diff += step;
+  if (code & 2) diff += step >> 1;
+  if (code & 1) diff += step >> 2;
+
+  int32_t predicted = state.predictor + ((code & 8) ? -diff : diff);
+  state.predictor = clamp16(predicted);
+  state.stepIndex = nextIndex(state.stepIndex, code);
+  return state.predictor;
+}
+
+/*
+ * Encode one sample into a 4-bit code
+ * Uses the decoder itself for reconstruction so both sides agree exactly.
+ */
+static inline uint8_t encodeSample(AdpcmState& state, int16_t sample) {
+  int32_t step = ADPCM_STEP_TABLE[state.stepIndex];
+  int32_t diff = (int32_t)sample - state.predictor;
+  uint8_t code = 0;
+
+  if (diff < 0) {
+    code = 8;
+    diff = -diff;
+  }
+  if (diff >= step) { code |= 4; diff -= step; }
+  step >>= 1;
+  if (diff >= step) { code |= 2; diff -= step; }
+  step >>= 1;
+  if (diff >= step) { code |= 1; }
+
+  decodeNibble(state, code);
+  return code;
+}
+
+void adpcmReset(AdpcmState& state) {
+  state.predictor = 0;
+  state.stepIndex = 0;
+}
+
+void adpcmEncode(AdpcmState& state, const int16_t* input, size_t samples, uint8_t* output) {
+  adpcmEncodeStrided(state, input, samples, 1, output);
+}
+
+void adpcmDecode(AdpcmState& state, const uint8_t* input, size_t samples, int16_t* output) {
+  adpcmDecodeStrided(state, input, samples, output, 1);
+}
+
+void adpcmEncodeStrided(AdpcmState& state, const int16_t* input, size_t samples, size_t stride, uint8_t* output) {
+  for (size_t i = 0; i + 1 < samples; i += 2) {
+    uint8_t low = encodeSample(state, input[i * stride]);
+    uint8_t high = encodeSample(state, input[(i + 1) * stride]);
+    *output++ = low | (high << 4);
+  }
+}
+
+void adpcmDecodeStrided(AdpcmState& state, const uint8_t* input, size_t samples, int16_t* output, size_t stride) {
+  for (size_t i = 0; i + 1 < samples; i += 2) {
+    uint8_t byte = *input++;
+    output[i * stride] = decodeNibble(state, byte & 0x0F);
+    output[(i + 1) * stride] = decodeNibble(state, byte >> 4);
+  }
+}
+
+/*
+ * Downsample 2x
+ * A [1 2 1]/4 smoothing filter is enough to keep speech energy above 4kHz
+ * from folding back hard; cheaper than a proper half-band FIR.
+ */
+size_t downsample2x(const int16_t* input, size_t samples, int16_t* output, int16_t& history) {
+  size_t outCount = 0;
+  for (size_t i = 0; i + 1 < samples; i += 2) {
+    int32_t filtered = (int32_t)history + 2 * input[i] + input[i + 1];
+    output[outCount++] = (int16_t)(filtered >> 2);
+    history = input[i + 1];
+  }
+  return outCount;
+}
+
+/*
+ * Upsample 2x
+ * Each input sample is preceded by the midpoint between it and the
+ * previous one.
+ */
+void upsample2x(const int16_t* input, size_t samples, int16_t* output, int16_t& history) {
+  for (size_t i = 0; i < samples; i++) {
+    output[2 * i] = (int16_t)(((int32_t)history + input[i]) >> 1);
+    output[2 * i + 1] = input[i];
+    history = input[i];
+  }
+}
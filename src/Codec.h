@@ -0,0 +1,47 @@
+/*
+ * Codec.h - Low-Rate Audio Codecs
+ *
+ * IMA-ADPCM: 4 bits per sample (4:1 versus 16-bit PCM).
+ * Cheap enough to run per packet on the ESP32 and robust to packet loss
+ * when each packet carries its own starting predictor/step index.
+ *
+ * Also provides the 2:1 sample rate helpers used to move between the
+ * 16kHz audio path and 8kHz low-rate streams.
+ *
+ * Nibble order: first sample in the low nibble (matches WAV IMA-ADPCM).
+ */
+
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Encoder/decoder state (carry across calls to keep a continuous stream)
+struct AdpcmState {
+  int16_t predictor;   // Last reconstructed sample
+  uint8_t stepIndex;   // Index into the step size table (0-88)
+};
+
+// Reset state to silence
+void adpcmReset(AdpcmState& state);
+
+// Encode samples (must be even) into samples/2 bytes
+void adpcmEncode(AdpcmState& state, const int16_t* input, size_t samples, uint8_t* output);
+
+// Decode samples (must be even) from samples/2 bytes
+void adpcmDecode(AdpcmState& state, const uint8_t* input, size_t samples, int16_t* output);
+
+// Encode/decode with a sample stride (interleaved multi-channel data)
+void adpcmEncodeStrided(AdpcmState& state, const int16_t* input, size_t samples, size_t stride, uint8_t* output);
+void adpcmDecodeStrided(AdpcmState& state, const uint8_t* input, size_t samples, int16_t* output, size_t stride);
+
+// 16kHz → 8kHz: [1 2 1]/4 low-pass then drop every other sample
+// history carries the last input sample between blocks. Returns output count.
+size_t downsample2x(const int16_t* input, size_t samples, int16_t* output, int16_t& history);
+
+// 8kHz → 16kHz: linear interpolation. history carries the last input sample.
+// Writes samples*2 outputs.
+void upsample2x(const int16_t* input, size_t samples, int16_t* output, int16_t& history);
+
+#endif // CODEC_H
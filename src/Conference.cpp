@@ -0,0 +1,593 @@
+/*
+ * Conference - N-Party Conference Bridge
+ *
+ * The phone that dials additional numbers during a call becomes the host.
+ * Each invited phone runs a normal two-party call with the host, so no
+ * protocol changes are needed on the participants.
+ *
+ * Host audio path (once per 100-sample microphone frame):
+ *
+ *   mic ──┐
+ *   leg 1 ┼──► sum (int32) ──► sum - leg 1 ──► saturate ──► ESP-NOW to leg 1
+ *   leg 2 ┤                ──► sum - leg 2 ──► saturate ──► ESP-NOW to leg 2
+ *   leg N ┘                ──► sum - mic   ──► saturate ──► host handset
+ *
+ * Received frames are queued per leg from the ESP-NOW callback (Wi-Fi task)
+ * and consumed by the main loop. A leg with no queued frame is mixed as
+ * silence for that frame so one late phone never stalls the others.
+ *
+ * Airtime:
+ * Every leg is a separate unicast stream in each direction, so the host
+ * puts 2 × legs × 160 packets/s on the air. Invites are refused beyond
+ * CONF_AIRTIME_BUDGET_PERCENT at the ESP-NOW rate startRadio() set.
+ * printConferenceStats() reports the measured packet rates and the
+ * resulting airtime estimate.
+ */
+
+#include "Conference.h"
+#include "Network.h"
+#include "Audio.h"
+#include "Configuration.h"
+#include "CallRecorder.h"
+#include "Speakerphone.h"
+#include "Log.h"
+#include <Arduino.h>
+
+// Airtime estimate for one ESP-NOW frame: preamble (192µs long DSSS
+// preamble at 1-2 Mbps, 20µs for OFDM rates) + payload and ~43 bytes
+// MAC/vendor header at the rate in use
+#define ESPNOW_FRAME_OVERHEAD_BYTES 43
+#define ESPNOW_DSSS_PREAMBLE_US 192
+#define ESPNOW_OFDM_PREAMBLE_US 20
+
+// One remote phone in the conference
+struct ConferenceLeg {
+  int number;                 // Phone number (-1 = slot free)
+  bool active;                // Answered and being mixed
+  bool invited;               // Invite sent, waiting for answer
+  unsigned long inviteTime;   // When the invite was sent
+
+  // Jitter FIFO (written by ESP-NOW callback, read by main loop)
+  int16_t frames[CONF_JITTER_FRAMES][AUDIO_SAMPLES_PER_PACKET];
+  uint8_t head;
+  uint8_t count;
+
+  // Per-leg statistics
+  uint32_t framesReceived;
+  uint32_t framesDropped;     // FIFO overflow (leg sending faster than we mix)
+  uint32_t framesMissing;     // Mixed as silence because nothing arrived
+};
+
+static ConferenceLeg legs[CONF_MAX_PARTICIPANTS];
+static portMUX_TYPE conferenceMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Mixer work buffers (main loop only - kept off the stack)
+static int16_t legInput[CONF_MAX_PARTICIPANTS][AUDIO_SAMPLES_PER_PACKET];
+static int16_t legOutput[CONF_MAX_PARTICIPANTS][AUDIO_SAMPLES_PER_PACKET];
+static int16_t hostOutput[AUDIO_SAMPLES_PER_PACKET];
+
+// Measurements since the conference started
+static unsigned long conferenceStartTime = 0;
+static uint32_t mixFrames = 0;
+static uint64_t mixCyclesTotal = 0;
+static uint32_t mixCyclesMax = 0;
+static uint32_t packetsSent = 0;
+static uint32_t packetsReceived = 0;
+
+/*
+ * Saturate to 16-bit
+ * Clamps a 32-bit mix sum to the int16_t range instead of wrapping.
+ */
+static inline int16_t saturate16(int32_t value) {
+  if (value > 32767) return 32767;
+  if (value < -32768) return -32768;
+  return (int16_t)value;
+}
+
+/*
+ * Mix Minus-One
+ *
+ * Core block mixer shared by the live path and the benchmark.
+ * Builds one 32-bit sum of the microphone and every leg, then derives each
+ * leg's output by subtracting its own contribution. Legs without a frame
+ * (hasFrame[l] == false) contribute silence.
+ */
+static void mixMinusOne(const int16_t* mic, int legCount, const bool* hasFrame, size_t count) {
+  int32_t sum[AUDIO_SAMPLES_PER_PACKET];
+
+  for (size_t i = 0; i < count; i++) {
+    sum[i] = mic[i];
+  }
+  for (int l = 0; l < legCount; l++) {
+    if (!hasFrame[l]) continue;
+    const int16_t* in = legInput[l];
+    for (size_t i = 0; i < count; i++) {
+      sum[i] += in[i];
+    }
+  }
+
+  for (int l = 0; l < legCount; l++) {
+    int16_t* out = legOutput[l];
+    if (hasFrame[l]) {
+      const int16_t* in = legInput[l];
+      for (size_t i = 0; i < count; i++) {
+        out[i] = saturate16(sum[i] - in[i]);
+      }
+    } else {
+      for (size_t i = 0; i < count; i++) {
+        out[i] = saturate16(sum[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    hostOutput[i] = saturate16(sum[i] - mic[i]);
+  }
+}
+
+static int findLeg(int number) {
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    if (legs[i].number == number && (legs[i].active || legs[i].invited)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int findFreeLeg() {
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    if (!legs[i].active && !legs[i].invited) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int countLegs(bool activeOnly) {
+  int count = 0;
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    if (legs[i].active || (!activeOnly && legs[i].invited)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+static void clearLeg(ConferenceLeg& leg) {
+  portENTER_CRITICAL(&conferenceMux);
+  leg.number = -1;
+  leg.active = false;
+  leg.invited = false;
+  leg.head = 0;
+  leg.count = 0;
+  portEXIT_CRITICAL(&conferenceMux);
+}
+
+// Caller holds conferenceMux
+static void activateLeg(ConferenceLeg& leg, int number) {
+  leg.number = number;
+  leg.active = true;
+  leg.invited = false;
+  leg.head = 0;
+  leg.count = 0;
+  leg.framesReceived = 0;
+  leg.framesDropped = 0;
+  leg.framesMissing = 0;
+}
+
+static float frameAirtimeUs(size_t bytes) {
+  int mbps = getEspNowRateMbps();
+  int preambleUs = mbps <= 2 ? ESPNOW_DSSS_PREAMBLE_US : ESPNOW_OFDM_PREAMBLE_US;
+  return preambleUs + (bytes + ESPNOW_FRAME_OVERHEAD_BYTES) * 8.0f / mbps;
+}
+
+// Percent of the air the host needs for legCount legs (both directions)
+static float conferenceAirtime(int legCount) {
+  float packetsPerSecond = 16000.0f / AUDIO_SAMPLES_PER_PACKET;
+  return 2 * legCount * packetsPerSecond * frameAirtimeUs(sizeof(Message)) / 10000.0f;
+}
+
+static void resetMeasurements() {
+  conferenceStartTime = millis();
+  mixFrames = 0;
+  mixCyclesTotal = 0;
+  mixCyclesMax = 0;
+  packetsSent = 0;
+  packetsReceived = 0;
+}
+
+/*
+ * Setup Conference
+ * Clears all legs. Called once from setup().
+ */
+void setupConference() {
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    clearLeg(legs[i]);
+  }
+}
+
+/*
+ * Is Conference Active
+ * A conference exists once at least two remote legs are being mixed.
+ */
+bool isConferenceActive() {
+  return countLegs(true) >= 2;
+}
+
+/*
+ * Conference Invite
+ *
+ * Sends a call request to another phone without disturbing the current call.
+ * The invited phone rings normally; when it answers, the current call peer
+ * and the new phone both become conference legs.
+ */
+bool conferenceInvite(int targetNumber) {
+  int primaryPeer = getCurrentCallPeer();
+
+  if (targetNumber < 0 || targetNumber == getPhoneNumber() || targetNumber == primaryPeer) {
+    LOG_WARN("Conference: cannot invite that number");
+    return false;
+  }
+  if (findLeg(targetNumber) >= 0) {
+    LOG_WARN("Conference: phone already in the call");
+    return false;
+  }
+
+  // The primary peer needs a slot too once the conference starts
+  int slotsNeeded = countLegs(false) + 1;
+  if (primaryPeer >= 0 && findLeg(primaryPeer) < 0) {
+    slotsNeeded++;
+  }
+  if (slotsNeeded > CONF_MAX_PARTICIPANTS) {
+    LOG_WARN("Conference: full");
+    return false;
+  }
+  if (conferenceAirtime(slotsNeeded) > CONF_AIRTIME_BUDGET_PERCENT) {
+    LOG_WARN("Conference: not enough airtime for %d legs at %d Mbps", slotsNeeded, getEspNowRateMbps());
+    return false;
+  }
+
+  // Claim the leg before the invite goes out: the accept can arrive on the
+  // Wi-Fi task before sendConferenceInvite() has even returned
+  portENTER_CRITICAL(&conferenceMux);
+  int slot = findFreeLeg();
+  if (slot >= 0) {
+    legs[slot].number = targetNumber;
+    legs[slot].invited = true;
+    legs[slot].inviteTime = millis();
+    legs[slot].head = 0;
+    legs[slot].count = 0;
+  }
+  portEXIT_CRITICAL(&conferenceMux);
+  if (slot < 0) {
+    LOG_WARN("Conference: full");
+    return false;
+  }
+
+  if (!sendConferenceInvite(targetNumber)) {
+    clearLeg(legs[slot]);   // Nothing was sent, so no answer can come
+    return false;
+  }
+
+  LOG_INFO("Conference: inviting #%d", targetNumber);
+  return true;
+}
+
+/*
+ * Handle Accept (Wi-Fi task)
+ * An invited phone answered. The first accepted invite starts the
+ * conference and pulls the primary call peer in as a leg. Finding the
+ * slots and activating them is one critical section, so an invite being
+ * claimed on the main loop can't take the same slot.
+ */
+bool conferenceHandleAccept(int fromNumber) {
+  int primaryPeer = getCurrentCallPeer();
+
+  portENTER_CRITICAL(&conferenceMux);
+  int slot = findLeg(fromNumber);
+  if (slot < 0 || !legs[slot].invited) {
+    portEXIT_CRITICAL(&conferenceMux);
+    return false;
+  }
+  bool starting = countLegs(true) < 2;
+  if (primaryPeer >= 0 && findLeg(primaryPeer) < 0) {
+    int primarySlot = findFreeLeg();
+    if (primarySlot >= 0) {
+      activateLeg(legs[primarySlot], primaryPeer);
+    }
+  }
+  activateLeg(legs[slot], fromNumber);
+  portEXIT_CRITICAL(&conferenceMux);
+
+  if (starting) {
+    resetMeasurements();
+  }
+
+  LOG_INFO("Conference: #%d joined (%d participants)", fromNumber, countLegs(true) + 1);
+  return true;
+}
+
+/*
+ * Handle Busy
+ * An invited phone is already in a call - drop the invite quietly so the
+ * existing call is not interrupted by a busy tone.
+ */
+bool conferenceHandleBusy(int fromNumber) {
+  int slot = findLeg(fromNumber);
+  if (slot < 0 || !legs[slot].invited) {
+    return false;
+  }
+  clearLeg(legs[slot]);
+  LOG_INFO("Conference: #%d is busy", fromNumber);
+  return true;
+}
+
+/*
+ * Handle Leave
+ *
+ * A leg hung up. If at least one other leg remains the call continues;
+ * with a single leg left the conference collapses back into an ordinary
+ * two-party call with that phone.
+ *
+ * Returns the number of a remaining leg (or the current call peer when a
+ * pending invitee backs out), or -1 if the caller should treat the hangup
+ * as the end of the call.
+ */
+int conferenceHandleLeave(int fromNumber) {
+  int slot = findLeg(fromNumber);
+  if (slot < 0) {
+    return -1;
+  }
+  bool wasActive = legs[slot].active;
+  clearLeg(legs[slot]);
+
+  if (!wasActive) {
+    return getCurrentCallPeer(); // Pending invite withdrawn - call carries on
+  }
+
+  LOG_INFO("Conference: #%d left", fromNumber);
+
+  int remaining = -1;
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    if (legs[i].active) {
+      remaining = legs[i].number;
+      break;
+    }
+  }
+
+  // Back to a plain call - the remaining leg goes through the normal audio path
+  if (remaining >= 0 && countLegs(true) < 2) {
+    LOG_INFO("Conference: back to two-party call");
+    clearLeg(legs[findLeg(remaining)]);
+  }
+
+  return remaining;
+}
+
+/*
+ * Receive Audio
+ *
+ * Called from the ESP-NOW receive callback (Wi-Fi task).
+ * Queues the frame in the sender's jitter FIFO; on overflow the oldest
+ * frame is dropped so latency stays bounded.
+ */
+bool conferenceReceiveAudio(int fromNumber, const int16_t* samples, size_t count) {
+  if (count > AUDIO_SAMPLES_PER_PACKET) {
+    count = AUDIO_SAMPLES_PER_PACKET;
+  }
+
+  bool stored = false;
+  portENTER_CRITICAL(&conferenceMux);
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    ConferenceLeg& leg = legs[i];
+    if (!leg.active || leg.number != fromNumber) continue;
+
+    if (leg.count == CONF_JITTER_FRAMES) {
+      leg.head = (leg.head + 1) % CONF_JITTER_FRAMES;
+      leg.count--;
+      leg.framesDropped++;
+    }
+    uint8_t tail = (leg.head + leg.count) % CONF_JITTER_FRAMES;
+    memcpy(leg.frames[tail], samples, count * sizeof(int16_t));
+    if (count < AUDIO_SAMPLES_PER_PACKET) {
+      memset(&leg.frames[tail][count], 0, (AUDIO_SAMPLES_PER_PACKET - count) * sizeof(int16_t));
+    }
+    leg.count++;
+    leg.framesReceived++;
+    packetsReceived++;
+    stored = true;
+    break;
+  }
+  portEXIT_CRITICAL(&conferenceMux);
+  return stored;
+}
+
+/*
+ * Process Frame (host)
+ *
+ * Called from the IN_CALL branch of loop() with one microphone frame.
+ * Pulls one frame per leg, mixes, sends each leg its minus-one stream and
+ * plays the mix of all remote legs on the host handset.
+ */
+void conferenceProcessFrame(const int16_t* micFrame, size_t count) {
+  if (count > AUDIO_SAMPLES_PER_PACKET) {
+    count = AUDIO_SAMPLES_PER_PACKET;
+  }
+
+  int legSlot[CONF_MAX_PARTICIPANTS];
+  bool hasFrame[CONF_MAX_PARTICIPANTS];
+  int legCount = 0;
+
+  // Pull one frame per active leg
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    ConferenceLeg& leg = legs[i];
+    if (!leg.active) continue;
+
+    portENTER_CRITICAL(&conferenceMux);
+    bool available = leg.count > 0;
+    if (available) {
+      memcpy(legInput[legCount], leg.frames[leg.head], count * sizeof(int16_t));
+      leg.head = (leg.head + 1) % CONF_JITTER_FRAMES;
+      leg.count--;
+    } else {
+      leg.framesMissing++;
+    }
+    portEXIT_CRITICAL(&conferenceMux);
+
+    legSlot[legCount] = i;
+    hasFrame[legCount] = available;
+    legCount++;
+  }
+
+  uint32_t startCycles = ESP.getCycleCount();
+  mixMinusOne(micFrame, legCount, hasFrame, count);
+  uint32_t cycles = ESP.getCycleCount() - startCycles;
+
+  mixFrames++;
+  mixCyclesTotal += cycles;
+  if (cycles > mixCyclesMax) mixCyclesMax = cycles;
+
+  for (int l = 0; l < legCount; l++) {
+    sendAudioDataTo(legs[legSlot[l]].number, legOutput[l], count);
+    packetsSent++;
+  }
+  if (isSpeakerphoneActive()) {
+    speakerphoneReceive(hostOutput, count);
+  } else {
+    writeAudioBuffer(hostOutput, count);
+  }
+  recordRxAudio(hostOutput, count);  // The recording hears what the host hears
+}
+
+/*
+ * Update Conference
+ * Drops invites nobody answered so the slot can be reused.
+ */
+void updateConference() {
+  unsigned long now = millis();
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    if (legs[i].invited && now - legs[i].inviteTime > CONF_INVITE_TIMEOUT_MS) {
+      LOG_INFO("Conference: invite to #%d timed out", legs[i].number);
+      sendCallEnd(legs[i].number); // Stop it ringing
+      clearLeg(legs[i]);
+    }
+  }
+}
+
+/*
+ * Hang Up Conference
+ *
+ * Ends every leg and outstanding invite. The primary call peer is left
+ * alone - the caller hangs that one up through the normal sendCallEnd() path.
+ */
+void hangUpConference(int primaryPeer) {
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    if (!legs[i].active && !legs[i].invited) continue;
+    if (legs[i].number != primaryPeer) {
+      sendCallEnd(legs[i].number);
+    }
+    clearLeg(legs[i]);
+  }
+}
+
+/*
+ * Get Conference Participants
+ * Copies the numbers of all mixed legs (not pending invites).
+ */
+int getConferenceParticipants(int* numbers, int maxNumbers) {
+  int count = 0;
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS && count < maxNumbers; i++) {
+    if (legs[i].active) {
+      numbers[count++] = legs[i].number;
+    }
+  }
+  return count;
+}
+
+/*
+ * Print Conference Stats
+ *
+ * Shows mixer CPU cost and measured packet rates for the running conference.
+ * Airtime is estimated from the packet rate using ESPNOW_AIRTIME_US.
+ */
+void printConferenceStats() {
+  Serial.println();
+  Serial.println("========== CONFERENCE STATS ==========");
+  if (!isConferenceActive()) {
+    Serial.println("No conference active.");
+    Serial.println("======================================");
+    return;
+  }
+
+  float seconds = (millis() - conferenceStartTime) / 1000.0f;
+  if (seconds < 0.001f) seconds = 0.001f;
+
+  Serial.printf("Participants: %d (host + %d legs)\n", countLegs(true) + 1, countLegs(true));
+  for (int i = 0; i < CONF_MAX_PARTICIPANTS; i++) {
+    const ConferenceLeg& leg = legs[i];
+    if (!leg.active) continue;
+    Serial.printf("  #%d: rx %lu, dropped %lu, missing %lu\n", leg.number,
+                  (unsigned long)leg.framesReceived, (unsigned long)leg.framesDropped,
+                  (unsigned long)leg.framesMissing);
+  }
+
+  if (mixFrames > 0) {
+    uint32_t avgCycles = (uint32_t)(mixCyclesTotal / mixFrames);
+    float frameBudgetCycles = ESP.getCpuFreqMHz() * 1000000.0f * AUDIO_SAMPLES_PER_PACKET / 16000.0f;
+    Serial.printf("Mixer: avg %lu cycles, max %lu cycles per frame (%.2f%% CPU)\n",
+                  (unsigned long)avgCycles, (unsigned long)mixCyclesMax,
+                  100.0f * avgCycles / frameBudgetCycles);
+  }
+
+  float txRate = packetsSent / seconds;
+  float rxRate = packetsReceived / seconds;
+  float airtime = (txRate + rxRate) * frameAirtimeUs(sizeof(Message)) / 10000.0f;
+  Serial.printf("Packets: tx %.0f/s, rx %.0f/s\n", txRate, rxRate);
+  Serial.printf("Estimated airtime: %.1f%% at %d Mbps\n", airtime, getEspNowRateMbps());
+  Serial.println("======================================");
+}
+
+/*
+ * Benchmark Conference Mixer
+ *
+ * Runs the mixer on synthetic frames for 3, 4 and 6 participants
+ * (2, 3 and 5 legs) and reports cycles per frame. Also prints the
+ * airtime the host would need for each size at 160 packets/s per stream,
+ * at the ESP-NOW rate in use.
+ */
+void benchmarkConferenceMixer() {
+  const int legCounts[] = {2, 3, 5};
+  const int ITERATIONS = 1000;
+  int16_t mic[AUDIO_SAMPLES_PER_PACKET];
+  bool hasFrame[CONF_MAX_PARTICIPANTS];
+
+  // Loud synthetic input to exercise the saturation path
+  for (int i = 0; i < AUDIO_SAMPLES_PER_PACKET; i++) {
+    mic[i] = (int16_t)((i * 997) & 0x7FFF) - 16384;
+  }
+  for (int l = 0; l < CONF_MAX_PARTICIPANTS; l++) {
+    hasFrame[l] = true;
+    for (int i = 0; i < AUDIO_SAMPLES_PER_PACKET; i++) {
+      legInput[l][i] = (int16_t)(((i + l * 31) * 1231) & 0x7FFF) - 16384;
+    }
+  }
+
+  float frameBudgetCycles = ESP.getCpuFreqMHz() * 1000000.0f * AUDIO_SAMPLES_PER_PACKET / 16000.0f;
+
+  Serial.println();
+  Serial.println("====== CONFERENCE MIXER BENCHMARK ======");
+  for (int c = 0; c < 3; c++) {
+    int legCount = legCounts[c];
+
+    uint32_t start = ESP.getCycleCount();
+    for (int n = 0; n < ITERATIONS; n++) {
+      mixMinusOne(mic, legCount, hasFrame, AUDIO_SAMPLES_PER_PACKET);
+    }
+    uint32_t perFrame = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    Serial.printf("%d participants: %lu cycles/frame (%.2f%% CPU), airtime %.0f%% at %d Mbps\n",
+                  legCount + 1, (unsigned long)perFrame, 100.0f * perFrame / frameBudgetCycles,
+                  conferenceAirtime(legCount), getEspNowRateMbps());
+  }
+  Serial.println("========================================");
+}
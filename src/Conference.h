@@ -0,0 +1,76 @@
+/*
+ * Conference.h - N-Party Conference Bridge
+ *
+ * Turns an ordinary two-party call into a conference hosted by this phone.
+ * While IN_CALL, dialing another number invites that phone into the call.
+ * Every invited phone sees a normal call to the host - only the host mixes.
+ *
+ * Mixing (host only):
+ * - Each remote leg feeds a small jitter FIFO from the ESP-NOW callback
+ * - Once per microphone frame the host builds one 32-bit sum of all legs
+ *   plus its own microphone
+ * - Each leg receives "sum minus itself" (minus-one), saturated to 16-bit
+ * - The host handset plays "sum minus host microphone"
+ *
+ * Cost is O(legs × samples) per frame: one add pass per leg to build the
+ * sum, one subtract pass per leg for the tailored streams.
+ *
+ * Limits:
+ * - Up to CONF_MAX_PARTICIPANTS remote legs (host + 5 = 6-way call)
+ * - The host sends and receives 2 × legs streams of 160 packets/s; an
+ *   invite that would take more than CONF_AIRTIME_BUDGET_PERCENT of the
+ *   air at the ESP-NOW rate in use (Network.h) is refused. At 24 Mbps a
+ *   6-way call needs ~17%; at the 1 Mbps fallback not even 3 phones fit
+ * - Invites that are not answered within CONF_INVITE_TIMEOUT_MS are dropped
+ */
+
+#ifndef CONFERENCE_H
+#define CONFERENCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CONF_MAX_PARTICIPANTS 5         // Remote legs mixed by the host
+#define CONF_JITTER_FRAMES 4            // Frames buffered per leg (4 × 6.25ms)
+#define CONF_INVITE_TIMEOUT_MS 30000    // Give up on an unanswered invite
+#define CONF_AIRTIME_BUDGET_PERCENT 50  // Host airtime a conference may use
+
+// Reset conference state (called once from setup)
+void setupConference();
+
+// True while this phone is hosting a conference with 2+ remote legs
+bool isConferenceActive();
+
+// Invite another phone into the current call (host dialed a number while IN_CALL)
+// Returns true if the invite was sent
+bool conferenceInvite(int targetNumber);
+
+// Network hooks - each returns true if the message belonged to the conference
+bool conferenceHandleAccept(int fromNumber);   // Invitee answered
+bool conferenceHandleBusy(int fromNumber);     // Invitee is busy
+
+// A conference leg hung up. Returns the number of a leg that is still in the
+// call (the new primary peer), or -1 if the message was not conference business.
+int conferenceHandleLeave(int fromNumber);
+
+// Store a received audio frame for a conference leg (ESP-NOW callback context)
+// Returns false if the sender is not part of the conference
+bool conferenceReceiveAudio(int fromNumber, const int16_t* samples, size_t count);
+
+// Mix one microphone frame, send minus-one streams and play the host mix
+void conferenceProcessFrame(const int16_t* micFrame, size_t count);
+
+// Expire unanswered invites (call from loop while IN_CALL)
+void updateConference();
+
+// End every conference leg and pending invite except the primary call peer
+void hangUpConference(int primaryPeer);
+
+// Copy participant numbers into the array, returns the count
+int getConferenceParticipants(int* numbers, int maxNumbers);
+
+// Diagnostics (test mode)
+void printConferenceStats();
+void benchmarkConferenceMixer();
+
+#endif // CONFERENCE_H
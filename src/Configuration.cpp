@@ -9,6 +9,7 @@
 #include "RotaryDial.h"
 #include "HookSwitch.h"
 #include "State.h"
+#include "Audio.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 #include <WiFi.h>
@@ -16,6 +17,56 @@
 // Current configuration (cached in memory)
 static PhoneConfig currentConfig;
 
+// Values used when config.json is missing or cannot be parsed
+static void setConfigurationDefaults(PhoneConfig& config) {
+  config.phoneNumber = -1; // Indicates not configured
+  config.wifiChannel = 0;
+  config.recordCalls = false;
+  config.recordMaxKB = 1024;
+  config.voicemailRings = 0;
+  config.ringtoneCount = 0;
+  config.handsetEqCount = 0;
+  config.ringerEqCount = 0;
+  config.handsetVolume = VOLUME_DEFAULT;
+  config.ringerVolume = VOLUME_DEFAULT;
+  config.speakerphone.rxThreshold = 200;
+  config.speakerphone.txThreshold = 400;
+  config.speakerphone.couplingDb = 0.0f;
+  config.speakerphone.hangoverMs = 250;
+  config.speakerphone.attenuationDb = 20.0f;
+  config.logToFile = false;
+}
+
+// Read one speaker's "eq" array, returns the number of bands
+static int loadEqBands(JsonArray bands, EqBandSpec* out, const char* speaker) {
+  int count = 0;
+  for (JsonVariant band : bands) {
+    if (count >= MAX_EQ_BANDS) {
+      Serial.print("⚠ Too many EQ bands for ");
+      Serial.print(speaker);
+      Serial.println(", ignoring the rest");
+      break;
+    }
+    EqBandSpec& spec = out[count++];
+    spec.type = band["type"] | "peak";
+    spec.frequency = band["freq"] | 1000.0f;
+    spec.gainDb = band["gain"] | 0.0f;
+    spec.q = band["q"] | 0.707f;
+  }
+  return count;
+}
+
+static void saveEqBands(JsonObject eq, const char* speaker, const EqBandSpec* bands, int count) {
+  JsonArray array = eq.createNestedArray(speaker);
+  for (int i = 0; i < count; i++) {
+    JsonObject band = array.createNestedObject();
+    band["type"] = bands[i].type;
+    band["freq"] = bands[i].frequency;
+    band["gain"] = bands[i].gainDb;
+    band["q"] = bands[i].q;
+  }
+}
+
 /*
  * Setup Configuration System
  * 
@@ -42,8 +93,29 @@ void setupConfiguration() {
  * {
  *   "number": 101,
  *   "wifi_ssid": "YourNetwork",
- *   "wifi_password": "YourPassword"
+ *   "wifi_password": "YourPassword",
+ *   "wifi_channel": 6,
+ *   "record_calls": false,
+ *   "record_max_kb": 1024,
+ *   "voicemail_rings": 0,
+ *   "handset_volume": 8,
+ *   "ringer_volume": 8,
+ *   "speakerphone": {"rx_threshold": 200, "tx_threshold": 400, "coupling_db": 0,
+ *                    "hangover_ms": 250, "attenuation_db": 20},
+ *   "log_to_file": false,
+ *   "ringtones": {
+ *     "default": "/ringtones/ring.mp3",
+ *     "102": "/ringtones/grandma.wav"
+ *   },
+ *   "eq": {
+ *     "handset": [{"type": "highpass", "freq": 250, "q": 0.7}],
+ *     "ringer": [{"type": "lowshelf", "freq": 400, "gain": 6, "q": 0.7}]
+ *   }
  * }
+ *
+ * "ringtones" is optional; a caller without a rule uses "default", and
+ * without a default the classic 440Hz ring is used. "eq" is optional too
+ * (no bands = speaker output untouched).
  * 
  * Returns:
  * - true if configuration loaded successfully
@@ -55,19 +127,19 @@ bool loadConfiguration(PhoneConfig& config) {
   File configFile = LittleFS.open("/config.json", "r");
   if (!configFile) {
     Serial.println("Config file not found - first time setup required");
-    config.phoneNumber = -1; // Indicates not configured
+    setConfigurationDefaults(config);
     return false;
   }
 
   // Parse JSON
-  StaticJsonDocument<256> doc;
+  StaticJsonDocument<2048> doc;
   DeserializationError error = deserializeJson(doc, configFile);
   configFile.close();
   
   if (error) {
     Serial.print("Failed to parse config file: ");
     Serial.println(error.c_str());
-    config.phoneNumber = -1;
+    setConfigurationDefaults(config);
     return false;
   }
 
@@ -75,6 +147,34 @@ bool loadConfiguration(PhoneConfig& config) {
   config.phoneNumber = doc["number"] | -1; // Default to -1 if not present
   config.wifiSsid = doc["wifi_ssid"].as<String>();
   config.wifiPassword = doc["wifi_password"].as<String>();
+  config.wifiChannel = doc["wifi_channel"] | 0;
+  config.recordCalls = doc["record_calls"] | false;
+  config.recordMaxKB = doc["record_max_kb"] | 1024;
+  config.voicemailRings = doc["voicemail_rings"] | 0;
+  config.handsetVolume = doc["handset_volume"] | VOLUME_DEFAULT;
+  config.ringerVolume = doc["ringer_volume"] | VOLUME_DEFAULT;
+  JsonObject speakerphone = doc["speakerphone"];
+  config.speakerphone.rxThreshold = speakerphone["rx_threshold"] | 200;
+  config.speakerphone.txThreshold = speakerphone["tx_threshold"] | 400;
+  config.speakerphone.couplingDb = speakerphone["coupling_db"] | 0.0f;
+  config.speakerphone.hangoverMs = speakerphone["hangover_ms"] | 250;
+  config.speakerphone.attenuationDb = speakerphone["attenuation_db"] | 20.0f;
+  config.logToFile = doc["log_to_file"] | false;
+
+  config.ringtoneCount = 0;
+  for (JsonPair rule : doc["ringtones"].as<JsonObject>()) {
+    if (config.ringtoneCount >= MAX_RINGTONE_RULES) {
+      Serial.println("⚠ Too many ringtones, ignoring the rest");
+      break;
+    }
+    const char* key = rule.key().c_str();
+    RingtoneRule& entry = config.ringtones[config.ringtoneCount++];
+    entry.caller = strcmp(key, "default") == 0 ? -1 : atoi(key);
+    entry.sound = rule.value().as<String>();
+  }
+
+  config.handsetEqCount = loadEqBands(doc["eq"]["handset"].as<JsonArray>(), config.handsetEq, "handset");
+  config.ringerEqCount = loadEqBands(doc["eq"]["ringer"].as<JsonArray>(), config.ringerEq, "ringer");
   
   // Cache in memory
   currentConfig = config;
@@ -110,10 +210,35 @@ bool saveConfiguration(const PhoneConfig& config) {
   Serial.println("Saving configuration to /config.json...");
   
   // Create JSON document
-  StaticJsonDocument<256> doc;
+  StaticJsonDocument<2048> doc;
   doc["number"] = config.phoneNumber;
   doc["wifi_ssid"] = config.wifiSsid;
   doc["wifi_password"] = config.wifiPassword;
+  if (config.wifiChannel > 0) doc["wifi_channel"] = config.wifiChannel;
+  doc["record_calls"] = config.recordCalls;
+  doc["record_max_kb"] = config.recordMaxKB;
+  doc["voicemail_rings"] = config.voicemailRings;
+  doc["handset_volume"] = config.handsetVolume;
+  doc["ringer_volume"] = config.ringerVolume;
+  JsonObject speakerphone = doc.createNestedObject("speakerphone");
+  speakerphone["rx_threshold"] = config.speakerphone.rxThreshold;
+  speakerphone["tx_threshold"] = config.speakerphone.txThreshold;
+  speakerphone["coupling_db"] = config.speakerphone.couplingDb;
+  speakerphone["hangover_ms"] = config.speakerphone.hangoverMs;
+  speakerphone["attenuation_db"] = config.speakerphone.attenuationDb;
+  doc["log_to_file"] = config.logToFile;
+  if (config.ringtoneCount > 0) {
+    JsonObject ringtones = doc.createNestedObject("ringtones");
+    for (int i = 0; i < config.ringtoneCount; i++) {
+      const RingtoneRule& rule = config.ringtones[i];
+      ringtones[rule.caller < 0 ? String("default") : String(rule.caller)] = rule.sound;
+    }
+  }
+  if (config.handsetEqCount > 0 || config.ringerEqCount > 0) {
+    JsonObject eq = doc.createNestedObject("eq");
+    saveEqBands(eq, "handset", config.handsetEq, config.handsetEqCount);
+    saveEqBands(eq, "ringer", config.ringerEq, config.ringerEqCount);
+  }
   
   // Open file for writing
   File configFile = LittleFS.open("/config.json", "w");
@@ -7,6 +7,13 @@
  * - Phone number (0-999, or -1 for not configured)
  * - Wi-Fi SSID
  * - Wi-Fi password
+ * - Router channel from the last connect (saved automatically)
+ * - Call recorder and voicemail settings (opt-in)
+ * - Ringtones per calling phone
+ * - Speaker equalizer bands (handset and ringer)
+ * - Handset and ringer volume (changed with the volume buttons)
+ * - Speakerphone voice switch tuning
+ * - Log to a file on LittleFS (opt-in)
  * 
  * The configuration is stored in /config.json on the ESP32's flash filesystem.
  */
@@ -16,11 +23,52 @@
 
 #include <Arduino.h>
 
+#define MAX_RINGTONE_RULES 8
+
+// One "ringtones" entry: which sound to ring with for which caller
+struct RingtoneRule {
+  int caller;            // Calling phone's number (-1 = default for everyone else)
+  String sound;          // File on LittleFS (MP3 or WAV), "bell", or "tone" for the classic ring
+};
+
+#define MAX_EQ_BANDS 4
+
+// One parametric equalizer band (see Equalizer.h for the filter types)
+struct EqBandSpec {
+  String type;           // "peak", "lowshelf", "highshelf", "highpass" or "lowpass"
+  float frequency;       // Hz (center, corner or shelf midpoint)
+  float gainDb;          // Boost/cut for peak and shelves
+  float q;               // Bandwidth / resonance
+};
+
+// Speakerphone voice switch (see Speakerphone.h)
+struct SpeakerphoneSettings {
+  int rxThreshold;       // Far-end level (mean |sample|) that counts as talking
+  int txThreshold;       // Microphone level that counts as talking
+  float couplingDb;      // Speaker-to-mic echo level (0 = mic hears the speaker at full level)
+  int hangoverMs;        // Keep a direction open this long after talking stops
+  float attenuationDb;   // Attenuation of the closed direction
+};
+
 // Configuration structure
 struct PhoneConfig {
   int phoneNumber;       // This phone's number (-1 = not configured)
   String wifiSsid;       // Wi-Fi network name
   String wifiPassword;   // Wi-Fi password
+  int wifiChannel;       // Router's channel at the last connect (0 = unknown), see Network.h
+  bool recordCalls;      // Record every call to LittleFS (opt-in)
+  int recordMaxKB;       // Total space for recordings before oldest are evicted
+  int voicemailRings;    // Rings before the answering machine picks up (0 = off)
+  RingtoneRule ringtones[MAX_RINGTONE_RULES];
+  int ringtoneCount;
+  EqBandSpec handsetEq[MAX_EQ_BANDS];
+  int handsetEqCount;
+  EqBandSpec ringerEq[MAX_EQ_BANDS];
+  int ringerEqCount;
+  int handsetVolume;     // 0 (mute) .. VOLUME_MAX, see Audio.h
+  int ringerVolume;
+  SpeakerphoneSettings speakerphone;
+  bool logToFile;        // Keep a rotating log in /log (see Log.h)
 };
 
 // Initialize configuration system
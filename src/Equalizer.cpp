@@ -0,0 +1,301 @@
+/*
+ * Equalizer - Speaker Equalizer (Fixed-Point Biquad Cascade)
+ *
+ * Each band is a direct form I biquad:
+ *
+ *   acc = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2] + e[n-1]
+ *   y[n] = acc >> 28                 e[n] = acc - (y[n] << 28)
+ *
+ * Coefficients are Q3.28 (range +/-8, so a +12dB shelf's b0 of ~4 fits)
+ * with a 64-bit accumulator. Feeding the rounding error e back into the next
+ * sample (first-order noise shaping) keeps low-frequency filters from
+ * adding audible hiss or limit cycles at 16-bit output.
+ *
+ * Direct form I keeps the state in sample units, so one band's output can
+ * be saturated to 16 bits before the next band without overflowing state.
+ *
+ * Processing is block-wise: one band at a time over the whole block with
+ * its coefficients and state in registers, then the next band.
+ */
+
+#include "Equalizer.h"
+#include <Arduino.h>
+#include <math.h>
+
+#define EQ_SAMPLE_RATE 16000
+#define EQ_COEFF_SHIFT 28
+#define EQ_OUTPUTS 2
+#define EQ_BENCH_BLOCK 256
+
+struct Biquad {
+  int32_t b0, b1, b2, a1, a2;   // Q3.28, normalized by a0
+  int32_t x1, x2, y1, y2;       // State, sample units
+  int64_t error;                // Rounding error carried to the next sample
+};
+
+struct EqCascade {
+  Biquad bands[MAX_EQ_BANDS];
+  int count;
+};
+
+static EqCascade cascades[EQ_OUTPUTS];
+static const char* outputNames[EQ_OUTPUTS] = {"handset", "ringer"};
+
+static int32_t toFixed(double value) {
+  return (int32_t)lround(value * (1 << EQ_COEFF_SHIFT));
+}
+
+/*
+ * Design Band
+ * Audio EQ Cookbook (R. Bristow-Johnson) formulas, normalized by a0.
+ * Returns false for unknown types or out-of-range parameters.
+ */
+static bool designBand(const EqBandSpec& spec, Biquad& band) {
+  if (spec.frequency < 20.0f || spec.frequency > EQ_SAMPLE_RATE * 0.49f) return false;
+  if (spec.q < 0.1f || spec.q > 20.0f) return false;
+  if (spec.gainDb < -24.0f || spec.gainDb > 12.0f) return false;
+
+  double A = pow(10.0, spec.gainDb / 40.0);
+  double w0 = 2.0 * PI * spec.frequency / EQ_SAMPLE_RATE;
+  double cosw = cos(w0);
+  double alpha = sin(w0) / (2.0 * spec.q);
+  double shelf = 2.0 * sqrt(A) * alpha;
+  double b0, b1, b2, a0, a1, a2;
+
+  if (spec.type == "peak") {
+    b0 = 1 + alpha * A;  b1 = -2 * cosw;  b2 = 1 - alpha * A;
+    a0 = 1 + alpha / A;  a1 = -2 * cosw;  a2 = 1 - alpha / A;
+  } else if (spec.type == "lowshelf") {
+    b0 = A * ((A + 1) - (A - 1) * cosw + shelf);
+    b1 = 2 * A * ((A - 1) - (A + 1) * cosw);
+    b2 = A * ((A + 1) - (A - 1) * cosw - shelf);
+    a0 = (A + 1) + (A - 1) * cosw + shelf;
+    a1 = -2 * ((A - 1) + (A + 1) * cosw);
+    a2 = (A + 1) + (A - 1) * cosw - shelf;
+  } else if (spec.type == "highshelf") {
+    b0 = A * ((A + 1) + (A - 1) * cosw + shelf);
+    b1 = -2 * A * ((A - 1) + (A + 1) * cosw);
+    b2 = A * ((A + 1) + (A - 1) * cosw - shelf);
+    a0 = (A + 1) - (A - 1) * cosw + shelf;
+    a1 = 2 * ((A - 1) - (A + 1) * cosw);
+    a2 = (A + 1) - (A - 1) * cosw - shelf;
+  } else if (spec.type == "highpass") {
+    b0 = (1 + cosw) / 2;  b1 = -(1 + cosw);  b2 = (1 + cosw) / 2;
+    a0 = 1 + alpha;       a1 = -2 * cosw;    a2 = 1 - alpha;
+  } else if (spec.type == "lowpass") {
+    b0 = (1 - cosw) / 2;  b1 = 1 - cosw;     b2 = (1 - cosw) / 2;
+    a0 = 1 + alpha;       a1 = -2 * cosw;    a2 = 1 - alpha;
+  } else {
+    return false;
+  }
+
+  band.b0 = toFixed(b0 / a0);
+  band.b1 = toFixed(b1 / a0);
+  band.b2 = toFixed(b2 / a0);
+  band.a1 = toFixed(a1 / a0);
+  band.a2 = toFixed(a2 / a0);
+  band.x1 = band.x2 = band.y1 = band.y2 = 0;
+  band.error = 0;
+  return true;
+}
+
+/*
+ * Run Band
+ * One biquad over a whole block, in place.
+ */
+static void runBand(Biquad& band, int16_t* samples, size_t count) {
+  const int64_t b0 = band.b0, b1 = band.b1, b2 = band.b2, a1 = band.a1, a2 = band.a2;
+  int32_t x1 = band.x1, x2 = band.x2, y1 = band.y1, y2 = band.y2;
+  int64_t error = band.error;
+
+  for (size_t i = 0; i < count; i++) {
+    int32_t x0 = samples[i];
+    int64_t acc = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 + error;
+    int32_t y0 = (int32_t)(acc >> EQ_COEFF_SHIFT);
+    if (y0 > 32767) {
+      y0 = 32767;
+      error = 0;          // Don't carry clipping into the next sample
+    } else if (y0 < -32768) {
+      y0 = -32768;
+      error = 0;
+    } else {
+      error = acc - ((int64_t)y0 << EQ_COEFF_SHIFT);
+    }
+    samples[i] = (int16_t)y0;
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = y0;
+  }
+
+  band.x1 = x1;
+  band.x2 = x2;
+  band.y1 = y1;
+  band.y2 = y2;
+  band.error = error;
+}
+
+int configureEqualizer(EqOutput output, const EqBandSpec* bands, int count) {
+  EqCascade& cascade = cascades[output];
+  EqCascade designed;
+  designed.count = 0;
+
+  for (int i = 0; i < count && i < MAX_EQ_BANDS; i++) {
+    if (designBand(bands[i], designed.bands[designed.count])) {
+      designed.count++;
+    } else {
+      Serial.printf("EQ: ignoring invalid %s band %d (%s %.0fHz %.1fdB Q%.2f)\n",
+                    outputNames[output], i, bands[i].type.c_str(),
+                    bands[i].frequency, bands[i].gainDb, bands[i].q);
+    }
+  }
+
+  cascade = designed;
+  return cascade.count;
+}
+
+/*
+ * Setup Equalizer
+ */
+void setupEqualizer(const PhoneConfig& config) {
+  int handset = configureEqualizer(EQ_HANDSET, config.handsetEq, config.handsetEqCount);
+  int ringer = configureEqualizer(EQ_RINGER, config.ringerEq, config.ringerEqCount);
+  if (handset > 0 || ringer > 0) {
+    Serial.printf("EQ: %d handset bands, %d ringer bands\n", handset, ringer);
+  }
+}
+
+bool isEqualizerActive(EqOutput output) {
+  return cascades[output].count > 0;
+}
+
+void processEqualizer(EqOutput output, int16_t* samples, size_t count) {
+  EqCascade& cascade = cascades[output];
+  for (int i = 0; i < cascade.count; i++) {
+    runBand(cascade.bands[i], samples, count);
+  }
+}
+
+/*
+ * Designed Response
+ * |H(e^jw)| of the quantized cascade in dB
+ */
+static float designedResponseDb(const EqCascade& cascade, float frequency) {
+  double w = 2.0 * PI * frequency / EQ_SAMPLE_RATE;
+  double cos1 = cos(w), sin1 = sin(w), cos2 = cos(2 * w), sin2 = sin(2 * w);
+  double scale = 1.0 / (1 << EQ_COEFF_SHIFT);
+  double db = 0.0;
+  for (int i = 0; i < cascade.count; i++) {
+    const Biquad& band = cascade.bands[i];
+    double b0 = band.b0 * scale, b1 = band.b1 * scale, b2 = band.b2 * scale;
+    double a1 = band.a1 * scale, a2 = band.a2 * scale;
+    double numRe = b0 + b1 * cos1 + b2 * cos2, numIm = -(b1 * sin1 + b2 * sin2);
+    double denRe = 1 + a1 * cos1 + a2 * cos2, denIm = -(a1 * sin1 + a2 * sin2);
+    db += 10.0 * log10((numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm));
+  }
+  return (float)db;
+}
+
+/*
+ * Measured Response
+ * Runs a -12dBFS sine through a copy of the cascade (live state untouched)
+ * and compares RMS after the filter has settled.
+ */
+static float measuredResponseDb(const EqCascade& cascade, float frequency) {
+  EqCascade scratch = cascade;
+  for (int i = 0; i < scratch.count; i++) {
+    Biquad& band = scratch.bands[i];
+    band.x1 = band.x2 = band.y1 = band.y2 = 0;
+    band.error = 0;
+  }
+
+  int16_t block[EQ_BENCH_BLOCK];
+  double phase = 0.0;
+  double increment = 2.0 * PI * frequency / EQ_SAMPLE_RATE;
+  double inputPower = 0.0, outputPower = 0.0;
+  for (int b = 0; b < 24; b++) {
+    double blockInput = 0.0;
+    for (int i = 0; i < EQ_BENCH_BLOCK; i++) {
+      block[i] = (int16_t)(8192.0 * sin(phase));
+      blockInput += (double)block[i] * block[i];
+      phase += increment;
+    }
+    for (int i = 0; i < scratch.count; i++) {
+      runBand(scratch.bands[i], block, EQ_BENCH_BLOCK);
+    }
+    if (b < 8) continue;   // Let the filters settle (~128ms)
+    inputPower += blockInput;
+    for (int i = 0; i < EQ_BENCH_BLOCK; i++) {
+      outputPower += (double)block[i] * block[i];
+    }
+  }
+  return (float)(10.0 * log10(outputPower / inputPower));
+}
+
+/*
+ * Print Equalizer Response
+ * Designed (from the quantized coefficients) next to measured (through
+ * the fixed-point code). They should agree within a few tenths of a dB;
+ * a measured value stuck near +12dB or more means clipping.
+ */
+void printEqualizerResponse(EqOutput output) {
+  static const float frequencies[] = {100, 200, 300, 500, 800, 1000, 1500, 2000, 3000, 4000, 5000, 6000, 7000};
+  const EqCascade& cascade = cascades[output];
+
+  Serial.println();
+  Serial.printf("========== EQ RESPONSE: %s (%d bands) ==========\n", outputNames[output], cascade.count);
+  if (cascade.count == 0) {
+    Serial.println("No bands configured - output is not processed");
+    return;
+  }
+  Serial.println("   Freq   Designed   Measured");
+  for (size_t i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); i++) {
+    Serial.printf("%5.0f Hz  %+7.2f dB  %+7.2f dB\n", frequencies[i],
+                  designedResponseDb(cascade, frequencies[i]),
+                  measuredResponseDb(cascade, frequencies[i]));
+  }
+  Serial.println("===============================================");
+}
+
+/*
+ * Benchmark Equalizer
+ * Cost of one 256-sample block per band on a scratch cascade
+ */
+void benchmarkEqualizer() {
+  EqBandSpec spec;
+  spec.type = "peak";
+  spec.frequency = 1000.0f;
+  spec.gainDb = -3.0f;
+  spec.q = 1.0f;
+
+  EqCascade scratch;
+  scratch.count = MAX_EQ_BANDS;
+  for (int i = 0; i < MAX_EQ_BANDS; i++) {
+    designBand(spec, scratch.bands[i]);
+  }
+
+  int16_t block[EQ_BENCH_BLOCK];
+  for (int i = 0; i < EQ_BENCH_BLOCK; i++) {
+    block[i] = (int16_t)(random(-8000, 8000));
+  }
+
+  const int iterations = 200;
+  uint32_t start = micros();
+  for (int n = 0; n < iterations; n++) {
+    for (int i = 0; i < scratch.count; i++) {
+      runBand(scratch.bands[i], block, EQ_BENCH_BLOCK);
+    }
+  }
+  uint32_t elapsed = micros() - start;
+
+  float perBlockUs = (float)elapsed / iterations;
+  float blockBudgetUs = EQ_BENCH_BLOCK * 1000000.0f / EQ_SAMPLE_RATE;
+  Serial.println();
+  Serial.println("========== EQ BENCHMARK ==========");
+  Serial.printf("%d bands, %d-sample block: %.1f us (%.2f us per band)\n",
+                MAX_EQ_BANDS, EQ_BENCH_BLOCK, perBlockUs, perBlockUs / MAX_EQ_BANDS);
+  Serial.printf("CPU: %.2f%% of one core per output with %d bands\n",
+                100.0f * perBlockUs / blockBudgetUs, MAX_EQ_BANDS);
+  Serial.printf("Active: handset %d bands, ringer %d bands\n", cascades[EQ_HANDSET].count, cascades[EQ_RINGER].count);
+  Serial.println("==================================");
+}
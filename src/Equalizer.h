@@ -0,0 +1,48 @@
+/*
+ * Equalizer.h - Speaker Equalizer (Fixed-Point Biquad Cascade)
+ *
+ * The small 8 ohm handset and ringer speakers are peaky and weak in the
+ * bass. Each output gets its own cascade of up to MAX_EQ_BANDS biquads,
+ * designed from simple parametric specs in config.json ("eq") and applied
+ * in writeHandsetAudioBuffer() / writeRingerAudioBuffer().
+ *
+ * Filter types (Audio EQ Cookbook designs):
+ *   peak       boost/cut "gain" dB around "freq", width "q"
+ *   lowshelf   boost/cut below "freq"
+ *   highshelf  boost/cut above "freq"
+ *   highpass   remove rumble/boom below "freq" (gain ignored)
+ *   lowpass    remove hiss above "freq" (gain ignored)
+ *
+ * With no bands configured an output is passed through untouched.
+ */
+
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include "Configuration.h"
+#include <stdint.h>
+#include <stddef.h>
+
+enum EqOutput {
+  EQ_HANDSET = 0,
+  EQ_RINGER = 1
+};
+
+// Design both cascades from config (called once from setup)
+void setupEqualizer(const PhoneConfig& config);
+
+// Replace one output's bands. Invalid bands are skipped with a warning.
+// Returns the number of bands in use.
+int configureEqualizer(EqOutput output, const EqBandSpec* bands, int count);
+
+// True if the output has at least one band (otherwise skip processing)
+bool isEqualizerActive(EqOutput output);
+
+// Filter samples in place
+void processEqualizer(EqOutput output, int16_t* samples, size_t count);
+
+// Diagnostics (test mode): designed vs. measured response, CPU cost
+void printEqualizerResponse(EqOutput output);
+void benchmarkEqualizer();
+
+#endif // EQUALIZER_H
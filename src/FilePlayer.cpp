@@ -0,0 +1,532 @@
+/*
+ * FilePlayer - Streaming WAV Playback from LittleFS
+ *
+ *   startFilePlayback() ──► request queue ──► reader task ──► frame queue ──► readFilePlaybackFrame()
+ *                                             (LittleFS read,  (32 x 100 samples)   (main loop)
+ *                                              WAV decode)
+ *
+ * The reader blocks when the frame queue is full, so read-ahead is bounded.
+ * Every frame carries the generation of the playback it belongs to;
+ * stopping or restarting bumps the generation, and anything still queued
+ * from the old file is thrown away by the consumer.
+ *
+ * A request can be a playlist: files are decoded back to back into the
+ * same frames, so there is no padding or gap between them. An empty frame
+ * (count = 0) marks the end of the last file.
+ *
+ * Head cache: for files registered with cacheFileHead() the parsed format
+ * and the first ~1KB of sample data stay in RAM. The reader decodes that
+ * head without touching flash and only then opens the file, so the
+ * prefill is ready before LittleFS has even found the file.
+ */
+
+#include "FilePlayer.h"
+#include "Codec.h"
+#include "Trace.h"
+#include "MemoryMonitor.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#define PLAYER_SAMPLE_RATE 16000
+#define PLAYER_MAX_BLOCK_PER_CHANNEL 1024     // IMA-ADPCM block size limit
+#define PLAYER_MAX_BLOCK_SAMPLES ((PLAYER_MAX_BLOCK_PER_CHANNEL - 4) * 2 + 1)
+
+struct PlayerFrame {
+  uint16_t generation;
+  uint16_t count;        // 0 = end of file
+  int16_t samples[PLAYER_FRAME_SAMPLES];
+};
+
+struct PlayerRequest {
+  uint16_t generation;
+  uint8_t count;
+  char paths[PLAYER_MAX_PLAYLIST][PLAYER_PATH_LENGTH];
+};
+
+// Parsed "fmt " chunk
+struct WavFormat {
+  uint16_t format;       // 1 = PCM, 0x11 = IMA-ADPCM
+  uint16_t channels;
+  uint32_t sampleRate;
+  uint16_t blockAlign;
+  uint16_t bitsPerSample;
+  uint32_t dataBytes;
+};
+
+struct HeadCacheEntry {
+  char path[PLAYER_PATH_LENGTH];
+  WavFormat format;
+  uint32_t dataOffset;   // File position of the first sample
+  uint8_t* head;         // First headLength bytes of sample data
+  uint16_t headLength;
+};
+
+// A file being decoded: cached head first, then the file (opened lazily)
+struct ClipSource {
+  const char* path;
+  File file;
+  const uint8_t* head;
+  size_t headLength;
+  size_t headPosition;
+  uint32_t fileOffset;   // Where the file continues after the head
+};
+
+static QueueHandle_t requestQueue = NULL;
+static QueueHandle_t frameQueue = NULL;
+static volatile uint16_t playGeneration = 0;
+static volatile uint16_t readerDoneGeneration = 0;   // Last generation whose EOF is queued
+
+// Written only from setup, before playback; entries are complete before the count grows
+static HeadCacheEntry headCache[PLAYER_HEAD_CACHE_ENTRIES];
+static volatile int headCacheCount = 0;
+
+// ====== Consumer (main loop) State ======
+static bool playbackActive = false;
+static bool playbackPrimed = false;
+static uint32_t playbackStartUs = 0;
+
+// ====== Reader Task State ======
+static uint8_t* blockBytes = NULL;
+static int16_t* blockPcm[2];
+static PlayerFrame pendingFrame;
+
+// ====== Statistics ======
+static uint32_t framesPlayed = 0;
+static uint32_t underruns = 0;
+static uint32_t staleFramesDropped = 0;
+static uint32_t readMaxUs = 0;
+static uint32_t startLatencyLastUs = 0;   // Start request to first frame
+static uint32_t startLatencyMaxUs = 0;
+static uint32_t headCacheHits = 0;
+
+static uint16_t readLE16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t readLE32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Parse WAV Header
+ * Walks the RIFF chunks until "data", leaving the file positioned at the
+ * first sample. Unknown chunks (LIST, fact, ...) are skipped.
+ */
+static bool parseWavHeader(File& file, WavFormat& format) {
+  uint8_t header[12];
+  if (file.read(header, 12) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+
+  bool haveFormat = false;
+  uint8_t chunk[8];
+  while (file.read(chunk, 8) == 8) {
+    uint32_t size = readLE32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0) {
+      uint8_t fmt[16];
+      if (size < 16 || file.read(fmt, 16) != 16) return false;
+      format.format = readLE16(fmt);
+      format.channels = readLE16(fmt + 2);
+      format.sampleRate = readLE32(fmt + 4);
+      format.blockAlign = readLE16(fmt + 12);
+      format.bitsPerSample = readLE16(fmt + 14);
+      file.seek(file.position() + size - 16 + (size & 1));
+      haveFormat = true;
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      format.dataBytes = size;
+      return haveFormat;
+    } else {
+      file.seek(file.position() + size + (size & 1));
+    }
+  }
+  return false;
+}
+
+static bool isSupported(const WavFormat& format) {
+  if (format.sampleRate != PLAYER_SAMPLE_RATE) return false;
+  if (format.channels < 1 || format.channels > 2) return false;
+  if (format.format == 1) return format.bitsPerSample == 16;
+  if (format.format == 0x11) {
+    return format.bitsPerSample == 4 &&
+           format.blockAlign % format.channels == 0 &&
+           format.blockAlign / format.channels <= PLAYER_MAX_BLOCK_PER_CHANNEL;
+  }
+  return false;
+}
+
+static const HeadCacheEntry* findHeadCache(const char* path) {
+  for (int i = 0; i < headCacheCount; i++) {
+    if (strcmp(headCache[i].path, path) == 0) return &headCache[i];
+  }
+  return NULL;
+}
+
+/*
+ * Read Clip
+ * Serves the cached head, then continues from the file. The file is only
+ * opened once the head is used up.
+ */
+static size_t readClip(ClipSource& clip, uint8_t* buffer, size_t length) {
+  size_t done = 0;
+  if (clip.headPosition < clip.headLength) {
+    size_t chunk = clip.headLength - clip.headPosition;
+    if (chunk > length) chunk = length;
+    memcpy(buffer, clip.head + clip.headPosition, chunk);
+    clip.headPosition += chunk;
+    done = chunk;
+    if (done == length) return done;
+  }
+
+  uint32_t start = micros();
+  if (!clip.file) {
+    clip.file = LittleFS.open(clip.path, "r");
+    if (!clip.file) return done;
+    clip.file.seek(clip.fileOffset);
+  }
+  done += clip.file.read(buffer + done, length - done);
+  uint32_t elapsed = micros() - start;
+  TRACE_SPAN(littlefs_read, start);
+  if (elapsed > readMaxUs) readMaxUs = elapsed;
+  return done;
+}
+
+/*
+ * Queue Frame
+ * Retries while the queue is full, giving up if the playback was stopped.
+ */
+static bool queueFrame(PlayerFrame& frame) {
+  while (xQueueSend(frameQueue, &frame, pdMS_TO_TICKS(50)) != pdTRUE) {
+    if (frame.generation != playGeneration) return false;
+  }
+  return frame.generation == playGeneration;
+}
+
+// Append decoded mono samples to the pending frame, sending each full one
+static bool emitSamples(const int16_t* samples, size_t count) {
+  while (count > 0) {
+    size_t space = PLAYER_FRAME_SAMPLES - pendingFrame.count;
+    size_t chunk = count < space ? count : space;
+    memcpy(pendingFrame.samples + pendingFrame.count, samples, chunk * sizeof(int16_t));
+    pendingFrame.count += chunk;
+    samples += chunk;
+    count -= chunk;
+    if (pendingFrame.count == PLAYER_FRAME_SAMPLES) {
+      if (!queueFrame(pendingFrame)) return false;
+      pendingFrame.count = 0;
+    }
+  }
+  return true;
+}
+
+static void mixDown(int16_t* left, const int16_t* right, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    left[i] = (int16_t)(((int32_t)left[i] + right[i]) >> 1);
+  }
+}
+
+static bool streamPcm(ClipSource& clip, const WavFormat& format) {
+  uint32_t remaining = format.dataBytes;
+  size_t frameBytes = PLAYER_FRAME_SAMPLES * format.channels * sizeof(int16_t);
+  int16_t* interleaved = blockPcm[0];
+
+  while (remaining >= format.channels * sizeof(int16_t)) {
+    size_t want = remaining < frameBytes ? remaining : frameBytes;
+    size_t got = readClip(clip, (uint8_t*)interleaved, want);
+    if (got == 0) break;
+    remaining -= got;
+
+    size_t samples = got / (format.channels * sizeof(int16_t));
+    if (format.channels == 2) {
+      for (size_t i = 0; i < samples; i++) {
+        interleaved[i] = (int16_t)(((int32_t)interleaved[2 * i] + interleaved[2 * i + 1]) >> 1);
+      }
+    }
+    if (!emitSamples(interleaved, samples)) return false;
+  }
+  return true;
+}
+
+/*
+ * Stream IMA-ADPCM
+ * Decodes one WAV block at a time: per channel a 4-byte header (first
+ * sample + step index), then 4-byte groups of 8 samples per channel.
+ */
+static bool streamAdpcm(ClipSource& clip, const WavFormat& format) {
+  uint32_t remaining = format.dataBytes;
+  size_t perChannel = format.blockAlign / format.channels;
+  size_t samplesPerBlock = (perChannel - 4) * 2 + 1;
+
+  while (remaining >= format.blockAlign) {
+    size_t got = readClip(clip, blockBytes, format.blockAlign);
+    if (got != format.blockAlign) break;
+    remaining -= got;
+
+    AdpcmState state[2];
+    const uint8_t* in = blockBytes;
+    for (uint16_t ch = 0; ch < format.channels; ch++) {
+      state[ch].predictor = (int16_t)readLE16(in);
+      state[ch].stepIndex = in[2] > 88 ? 88 : in[2];
+      blockPcm[ch][0] = state[ch].predictor;
+      in += 4;
+    }
+    for (size_t group = 1; group < samplesPerBlock; group += 8) {
+      for (uint16_t ch = 0; ch < format.channels; ch++) {
+        adpcmDecode(state[ch], in, 8, &blockPcm[ch][group]);
+        in += 4;
+      }
+    }
+
+    if (format.channels == 2) {
+      mixDown(blockPcm[0], blockPcm[1], samplesPerBlock);
+    }
+    if (!emitSamples(blockPcm[0], samplesPerBlock)) return false;
+  }
+  return true;
+}
+
+/*
+ * Stream File
+ * Decodes one playlist entry into the pending frame. A missing or
+ * unsupported file is skipped so the rest of the playlist still plays.
+ */
+static bool streamFile(const char* path) {
+  ClipSource clip;
+  clip.path = path;
+  clip.head = NULL;
+  clip.headLength = 0;
+  clip.headPosition = 0;
+
+  WavFormat format;
+  const HeadCacheEntry* cached = findHeadCache(path);
+  if (cached) {
+    headCacheHits++;
+    format = cached->format;
+    clip.head = cached->head;
+    clip.headLength = cached->headLength;
+    clip.fileOffset = cached->dataOffset + cached->headLength;
+  } else {
+    uint32_t start = micros();
+    clip.file = LittleFS.open(path, "r");
+    if (!clip.file) {
+      Serial.print("Player: cannot open ");
+      Serial.println(path);
+      return true;
+    }
+    bool valid = parseWavHeader(clip.file, format) && isSupported(format);
+    uint32_t elapsed = micros() - start;
+    if (elapsed > readMaxUs) readMaxUs = elapsed;
+    if (!valid) {
+      Serial.print("Player: unsupported file (need 16kHz PCM or IMA-ADPCM WAV): ");
+      Serial.println(path);
+      clip.file.close();
+      return true;
+    }
+    clip.fileOffset = clip.file.position();
+  }
+
+  bool ok = format.format == 1 ? streamPcm(clip, format) : streamAdpcm(clip, format);
+  if (clip.file) clip.file.close();
+  return ok;
+}
+
+static void playerReaderTask(void* parameter) {
+  static PlayerRequest request;   // Too big for the task stack
+  while (true) {
+    if (xQueueReceive(requestQueue, &request, portMAX_DELAY) != pdTRUE) continue;
+    if (request.generation != playGeneration) continue;   // Superseded before we got to it
+
+    pendingFrame.generation = request.generation;
+    pendingFrame.count = 0;
+
+    bool ok = true;
+    for (uint8_t i = 0; i < request.count && ok; i++) {
+      ok = streamFile(request.paths[i]);
+    }
+
+    // Aborted playbacks don't get an end marker - their generation is dead anyway
+    if (request.generation != playGeneration) continue;
+    if (ok && pendingFrame.count > 0) {
+      memset(pendingFrame.samples + pendingFrame.count, 0,
+             (PLAYER_FRAME_SAMPLES - pendingFrame.count) * sizeof(int16_t));
+      pendingFrame.count = PLAYER_FRAME_SAMPLES;
+      queueFrame(pendingFrame);
+    }
+    pendingFrame.count = 0;
+    queueFrame(pendingFrame);
+    readerDoneGeneration = request.generation;
+  }
+}
+
+/*
+ * Setup File Player
+ */
+void setupFilePlayer() {
+  blockBytes = (uint8_t*)memoryAlloc(MEMORY_PLAYER, PLAYER_MAX_BLOCK_PER_CHANNEL * 2);
+  blockPcm[0] = (int16_t*)memoryAlloc(MEMORY_PLAYER, PLAYER_MAX_BLOCK_SAMPLES * sizeof(int16_t));
+  blockPcm[1] = (int16_t*)memoryAlloc(MEMORY_PLAYER, PLAYER_MAX_BLOCK_SAMPLES * sizeof(int16_t));
+  requestQueue = xQueueCreate(2, sizeof(PlayerRequest));
+  frameQueue = xQueueCreate(PLAYER_QUEUE_FRAMES, sizeof(PlayerFrame));
+  if (!blockBytes || !blockPcm[0] || !blockPcm[1] || !requestQueue || !frameQueue) {
+    Serial.println("Player: out of memory, file playback disabled");
+    requestQueue = NULL;
+    return;
+  }
+
+  // Core 0, low priority: reads only need to stay ahead of a 200ms queue
+  xTaskCreatePinnedToCore(playerReaderTask, "player", 4096, NULL, 1, NULL, 0);
+}
+
+bool startFilePlayback(const char* path) {
+  // Cached heads skip the flash lookup - they were checked when cached
+  if (!findHeadCache(path) && !LittleFS.exists(path)) {
+    stopFilePlayback();
+    return false;
+  }
+  return startFilePlaylist(&path, 1);
+}
+
+bool startFilePlaylist(const char* const* paths, int count) {
+  stopFilePlayback();
+  if (!requestQueue || count <= 0) return false;
+  if (count > PLAYER_MAX_PLAYLIST) count = PLAYER_MAX_PLAYLIST;
+
+  static PlayerRequest request;   // Only the main loop starts playback
+  request.generation = ++playGeneration;
+  request.count = count;
+  for (int i = 0; i < count; i++) {
+    strncpy(request.paths[i], paths[i], PLAYER_PATH_LENGTH - 1);
+    request.paths[i][PLAYER_PATH_LENGTH - 1] = '\0';
+  }
+  if (xQueueSend(requestQueue, &request, 0) != pdTRUE) return false;
+
+  playbackActive = true;
+  playbackPrimed = false;
+  playbackStartUs = micros();
+  return true;
+}
+
+/*
+ * Cache File Head
+ * Parses the header and keeps the first whole blocks (up to
+ * PLAYER_HEAD_BYTES) of sample data in RAM.
+ */
+bool cacheFileHead(const char* path) {
+  if (findHeadCache(path)) return true;
+  if (headCacheCount >= PLAYER_HEAD_CACHE_ENTRIES) return false;
+
+  File file = LittleFS.open(path, "r");
+  if (!file) return false;
+
+  HeadCacheEntry& entry = headCache[headCacheCount];
+  if (!parseWavHeader(file, entry.format) || !isSupported(entry.format)) {
+    Serial.print("Player: not caching unsupported file ");
+    Serial.println(path);
+    file.close();
+    return false;
+  }
+
+  size_t unit = entry.format.format == 1 ? entry.format.channels * sizeof(int16_t) : entry.format.blockAlign;
+  size_t length = PLAYER_HEAD_BYTES < entry.format.dataBytes ? PLAYER_HEAD_BYTES : entry.format.dataBytes;
+  length -= length % unit;
+
+  entry.dataOffset = file.position();
+  entry.head = length > 0 ? (uint8_t*)memoryAlloc(MEMORY_PLAYER, length) : NULL;
+  entry.headLength = 0;
+  if (entry.head && file.read(entry.head, length) == length) {
+    entry.headLength = length;
+  }
+  file.close();
+  if (length > 0 && entry.headLength == 0) {
+    memoryFree(MEMORY_PLAYER, entry.head, length);
+    return false;
+  }
+
+  strncpy(entry.path, path, PLAYER_PATH_LENGTH - 1);
+  entry.path[PLAYER_PATH_LENGTH - 1] = '\0';
+  headCacheCount++;
+  return true;
+}
+
+void stopFilePlayback() {
+  if (!playbackActive) return;
+  playbackActive = false;
+  playGeneration++;
+  // Unblocks the reader if it is waiting for space
+  if (frameQueue) xQueueReset(frameQueue);
+}
+
+bool readFilePlaybackFrame(int16_t* frame) {
+  if (!playbackActive) return false;
+
+  if (!playbackPrimed) {
+    if (uxQueueMessagesWaiting(frameQueue) < PLAYER_PREFILL_FRAMES &&
+        readerDoneGeneration != playGeneration) {
+      return false;
+    }
+    playbackPrimed = true;
+  }
+
+  PlayerFrame queued;
+  while (xQueueReceive(frameQueue, &queued, 0) == pdTRUE) {
+    if (queued.generation != playGeneration) {
+      staleFramesDropped++;
+      continue;
+    }
+    if (queued.count == 0) {
+      playbackActive = false;
+      return false;
+    }
+    memcpy(frame, queued.samples, PLAYER_FRAME_SAMPLES * sizeof(int16_t));
+    if (playbackStartUs != 0) {
+      startLatencyLastUs = micros() - playbackStartUs;
+      if (startLatencyLastUs > startLatencyMaxUs) startLatencyMaxUs = startLatencyLastUs;
+      playbackStartUs = 0;
+    }
+    framesPlayed++;
+    return true;
+  }
+
+  underruns++;
+  return false;
+}
+
+bool isFilePlaybackActive() {
+  return playbackActive;
+}
+
+/*
+ * Print File Player Stats
+ */
+void printFilePlayerStats() {
+  Serial.println();
+  Serial.println("========== FILE PLAYER STATS ==========");
+  Serial.print("Playing: ");
+  Serial.println(playbackActive ? "yes" : "no");
+  Serial.print("Frames buffered: ");
+  Serial.print(frameQueue ? uxQueueMessagesWaiting(frameQueue) : 0);
+  Serial.print(" / ");
+  Serial.println(PLAYER_QUEUE_FRAMES);
+  Serial.print("Frames played: ");
+  Serial.println(framesPlayed);
+  Serial.print("Underruns: ");
+  Serial.println(underruns);
+  Serial.print("Stale frames dropped: ");
+  Serial.println(staleFramesDropped);
+  Serial.print("Slowest flash read: ");
+  Serial.print(readMaxUs);
+  Serial.println(" us");
+  Serial.print("Start latency: ");
+  Serial.print(startLatencyLastUs);
+  Serial.print(" us (max ");
+  Serial.print(startLatencyMaxUs);
+  Serial.println(" us)");
+  Serial.print("Head cache: ");
+  Serial.print(headCacheCount);
+  Serial.print(" files, ");
+  Serial.print(headCacheHits);
+  Serial.println(" hits");
+  Serial.println("=======================================");
+}
@@ -0,0 +1,57 @@
+/*
+ * FilePlayer.h - Streaming WAV Playback from LittleFS
+ *
+ * A background task reads and decodes the file into a bounded queue of
+ * 100-sample frames; the main loop pulls one frame at a time. Flash reads
+ * never run in the audio path, and the queue caps memory at ~200ms of
+ * audio no matter how long the file is.
+ *
+ * Supported: 16kHz WAV, 16-bit PCM or IMA-ADPCM (as written by the call
+ * recorder), mono or stereo (stereo is mixed down).
+ *
+ * Playlists are decoded back to back without gaps, and short files that
+ * must start instantly (voice prompts) can keep their first block in RAM.
+ */
+
+#ifndef FILE_PLAYER_H
+#define FILE_PLAYER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PLAYER_FRAME_SAMPLES 100     // Same as AUDIO_SAMPLES_PER_PACKET
+#define PLAYER_QUEUE_FRAMES 32       // 200ms read-ahead
+#define PLAYER_PREFILL_FRAMES 8      // Frames buffered before playback starts
+#define PLAYER_PATH_LENGTH 48
+#define PLAYER_MAX_PLAYLIST 12       // Files per gapless playlist
+#define PLAYER_HEAD_CACHE_ENTRIES 24
+#define PLAYER_HEAD_BYTES 1024       // Per cached file: 64-128ms of mono IMA-ADPCM
+
+// Create the reader task (called once from setup)
+void setupFilePlayer();
+
+// Start streaming a file (stops any current playback). Returns false if
+// the file is missing or not a supported format.
+bool startFilePlayback(const char* path);
+void stopFilePlayback();
+
+// Play several files back to back with no gap between them. Missing files
+// are skipped.
+bool startFilePlaylist(const char* const* paths, int count);
+
+// Keep the start of a file in RAM so playback begins without a flash read.
+// Call from setup; returns false if the file is missing, unsupported or
+// the cache is full.
+bool cacheFileHead(const char* path);
+
+// Fetch the next frame (always PLAYER_FRAME_SAMPLES, zero-padded at the end).
+// Returns false while prefilling, on underrun or once the file is finished.
+bool readFilePlaybackFrame(int16_t* frame);
+
+// True from start until the last frame has been read
+bool isFilePlaybackActive();
+
+// Diagnostics (test mode)
+void printFilePlayerStats();
+
+#endif // FILE_PLAYER_H
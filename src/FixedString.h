@@ -0,0 +1,85 @@
+/*
+ * FixedString.h - Fixed-Capacity Strings
+ *
+ * Arduino String grows on the heap with every +=, which is fine in setup
+ * but not on a path that runs per digit or per frame. FixedString<N>
+ * keeps up to N characters (plus the terminator) inside the object:
+ *
+ *   FixedString<MAX_DIGITS> number;   // 4 bytes, lives wherever it is declared
+ *   number.appendDigit(7);            // false once full, never allocates
+ *   number.toInt();                   // 7
+ *
+ * Appending to a full string is refused (the return value says so) rather
+ * than truncating silently. Only what the dial and the test console need
+ * is here; everything else can work on c_str().
+ */
+
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+template <size_t N>
+class FixedString {
+public:
+  FixedString() { clear(); }
+
+  void clear() {
+    len = 0;
+    text[0] = '\0';
+  }
+
+  size_t length() const { return len; }
+  static constexpr size_t capacity() { return N; }
+  bool isEmpty() const { return len == 0; }
+  bool isFull() const { return len == N; }
+  const char* c_str() const { return text; }
+
+  bool append(char c) {
+    if (len == N) return false;
+    text[len++] = c;
+    text[len] = '\0';
+    return true;
+  }
+
+  // One decimal digit (0-9)
+  bool appendDigit(int digit) {
+    return digit >= 0 && digit <= 9 && append((char)('0' + digit));
+  }
+
+  // Decimal value of the leading digits, 0 if there are none
+  int32_t toInt() const {
+    int32_t value = 0;
+    for (size_t i = 0; i < len && isdigit((unsigned char)text[i]); i++) {
+      value = value * 10 + (text[i] - '0');
+    }
+    return value;
+  }
+
+  // Strip leading and trailing whitespace in place
+  void trim() {
+    size_t start = 0;
+    while (start < len && isspace((unsigned char)text[start])) start++;
+    size_t end = len;
+    while (end > start && isspace((unsigned char)text[end - 1])) end--;
+    len = end - start;
+    memmove(text, text + start, len);
+    text[len] = '\0';
+  }
+
+  void toLowerCase() {
+    for (size_t i = 0; i < len; i++) text[i] = (char)tolower((unsigned char)text[i]);
+  }
+
+  bool operator==(const char* other) const { return strcmp(text, other) == 0; }
+  bool operator!=(const char* other) const { return strcmp(text, other) != 0; }
+
+private:
+  char text[N + 1];
+  size_t len;
+};
+
+#endif // FIXED_STRING_H
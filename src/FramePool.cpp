@@ -0,0 +1,150 @@
+/*
+ * FramePool - Preallocated Audio Frames and Network Messages
+ *
+ * Each pool is a static array and a mask of free items (bit set = free);
+ * acquire takes the lowest free bit. Both run in a few hundred
+ * nanoseconds under a spinlock, shorter than a heap_caps_malloc(). Audio
+ * frame reference counts change under the same lock; the frame goes back
+ * to its pool when the last owner releases it.
+ */
+
+#include "FramePool.h"
+#include "AudioMonitor.h"
+#include <Arduino.h>
+
+struct FramePool {
+  const char* name;
+  uint8_t* storage;
+  uint32_t size;
+  uint32_t itemBytes;
+  uint32_t freeMask;
+  uint32_t peakInUse;
+  uint32_t acquired;
+  uint32_t exhausted;
+};
+
+static int16_t scratchFrames[SCRATCH_FRAME_POOL][SCRATCH_FRAME_SAMPLES];
+static Message messages[MESSAGE_POOL];
+static AudioFrame audioFrames[AUDIO_FRAME_POOL];
+
+// Full mask for n items (n <= 32)
+#define POOL_MASK(n) ((n) >= 32 ? 0xFFFFFFFFUL : (1UL << (n)) - 1)
+static_assert(AUDIO_FRAME_POOL <= 32 && SCRATCH_FRAME_POOL <= 32 && MESSAGE_POOL <= 32, "one mask bit per item");
+
+static FramePool pools[FRAME_POOL_COUNT] = {
+  {"scratch", (uint8_t*)scratchFrames, SCRATCH_FRAME_POOL, sizeof(scratchFrames[0]), POOL_MASK(SCRATCH_FRAME_POOL), 0, 0, 0},
+  {"messages", (uint8_t*)messages, MESSAGE_POOL, sizeof(messages[0]), POOL_MASK(MESSAGE_POOL), 0, 0, 0},
+  {"audio frames", (uint8_t*)audioFrames, AUDIO_FRAME_POOL, sizeof(audioFrames[0]), POOL_MASK(AUDIO_FRAME_POOL), 0, 0, 0}
+};
+
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t inUse(const FramePool& pool) {
+  return pool.size - __builtin_popcount(pool.freeMask);
+}
+
+static void* acquire(FramePool& pool) {
+  void* item = nullptr;
+  portENTER_CRITICAL(&poolMux);
+  if (pool.freeMask == 0) {
+    pool.exhausted++;
+  } else {
+    int index = __builtin_ctz(pool.freeMask);
+    pool.freeMask &= ~(1UL << index);
+    pool.acquired++;
+    uint32_t used = inUse(pool);
+    if (used > pool.peakInUse) pool.peakInUse = used;
+    item = pool.storage + index * pool.itemBytes;
+  }
+  portEXIT_CRITICAL(&poolMux);
+  return item;
+}
+
+static void release(FramePool& pool, void* item) {
+  if (!item) return;
+  uint32_t index = ((uint8_t*)item - pool.storage) / pool.itemBytes;
+  if (index >= pool.size) return;   // Not from this pool
+  portENTER_CRITICAL(&poolMux);
+  pool.freeMask |= 1UL << index;
+  portEXIT_CRITICAL(&poolMux);
+}
+
+int16_t* acquireScratchFrame() {
+  return (int16_t*)acquire(pools[POOL_SCRATCH_FRAMES]);
+}
+
+void releaseScratchFrame(int16_t* frame) {
+  release(pools[POOL_SCRATCH_FRAMES], frame);
+}
+
+Message* acquireMessage() {
+  return (Message*)acquire(pools[POOL_MESSAGES]);
+}
+
+void releaseMessage(Message* msg) {
+  release(pools[POOL_MESSAGES], msg);
+}
+
+AudioFrame* newAudioFrame() {
+  AudioFrame* frame = (AudioFrame*)acquire(pools[POOL_AUDIO_FRAMES]);
+  if (frame) {
+    frame->count = 0;
+    frame->refs = 1;
+  }
+  return frame;
+}
+
+AudioFrame* copyAudioFrame(const int16_t* samples, size_t count) {
+  AudioFrame* frame = newAudioFrame();
+  if (!frame) return nullptr;
+  if (count > AUDIO_SAMPLES_PER_PACKET) count = AUDIO_SAMPLES_PER_PACKET;
+  memcpy(frame->samples(), samples, count * sizeof(int16_t));
+  countAudioCopy(AUDIO_COPY_FRAME, count * sizeof(int16_t));
+  frame->count = count;
+  return frame;
+}
+
+AudioFrame* retainAudioFrame(AudioFrame* frame) {
+  portENTER_CRITICAL(&poolMux);
+  frame->refs++;
+  portEXIT_CRITICAL(&poolMux);
+  return frame;
+}
+
+void releaseAudioFrame(AudioFrame* frame) {
+  if (!frame) return;
+  portENTER_CRITICAL(&poolMux);
+  bool last = frame->refs <= 1;
+  if (!last) frame->refs--;
+  portEXIT_CRITICAL(&poolMux);
+  if (last) {
+    frame->refs = 0;
+    release(pools[POOL_AUDIO_FRAMES], frame);
+  }
+}
+
+void getFramePoolStats(FramePoolStats* out) {
+  portENTER_CRITICAL(&poolMux);
+  for (int p = 0; p < FRAME_POOL_COUNT; p++) {
+    const FramePool& pool = pools[p];
+    out[p] = {pool.name, pool.size, pool.itemBytes, inUse(pool), pool.peakInUse, pool.acquired, pool.exhausted};
+  }
+  portEXIT_CRITICAL(&poolMux);
+}
+
+void printFramePools() {
+  FramePoolStats stats[FRAME_POOL_COUNT];
+  getFramePoolStats(stats);
+
+  Serial.println();
+  Serial.println("============== FRAME POOLS ==============");
+  Serial.println("pool           items  bytes  in use  peak   acquired  exhausted");
+  for (int p = 0; p < FRAME_POOL_COUNT; p++) {
+    const FramePoolStats& s = stats[p];
+    Serial.printf("%-14s %5lu %6lu %7lu %5lu %10lu %10lu\n", s.name, (unsigned long)s.size,
+                  (unsigned long)s.itemBytes, (unsigned long)s.inUse, (unsigned long)s.peakInUse,
+                  (unsigned long)s.acquired, (unsigned long)s.exhausted);
+  }
+  Serial.println("(exhausted = a frame or message was dropped; raise the pool size)");
+  Serial.println("=========================================");
+}
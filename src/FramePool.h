@@ -0,0 +1,92 @@
+/*
+ * FramePool.h - Preallocated Audio Frames and Network Messages
+ *
+ * Buffers for the audio and ESP-NOW paths come from fixed pools reserved
+ * at compile time instead of the heap or big stack arrays:
+ *
+ *   scratch frames  SCRATCH_FRAME_POOL x SCRATCH_FRAME_SAMPLES samples - the
+ *                   EQ/volume chunk in the output stage and the tone buffer
+ *   messages        MESSAGE_POOL x Message - control messages
+ *   audio frames    AUDIO_FRAME_POOL x AudioFrame - one packet of call
+ *                   audio, shared by reference (below)
+ *
+ * Audio frames are reference counted so one capture can fan out without
+ * copies. The samples live inside the ESP-NOW Message, so the microphone
+ * is read straight into the packet payload:
+ *
+ *   AudioFrame* frame = newAudioFrame();               refs 1
+ *   readMicrophoneBuffer(frame->samples(), ...)        I2S DMA ──► payload
+ *   recordTxFrame(frame)                               refs 2, queued by pointer
+ *   sendAudioFrame(frame)                              header filled in place, sent as is
+ *   releaseAudioFrame(frame)                           refs 1 - the recorder releases the last
+ *
+ * A frame's samples are read-only once it has been shared (refs > 1);
+ * only the sole owner may change them in place.
+ *
+ * acquire/release are a bit mask under a spinlock, so any task can use
+ * them (the main loop, the Wi-Fi receive callback, the player, ringtone
+ * and recorder tasks). An empty pool returns nullptr and is counted: the
+ * caller drops that frame or message rather than falling back to the
+ * heap. In-use peaks and exhaustion are shown by `test pools`.
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include "Network.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define SCRATCH_FRAME_SAMPLES 256 // Largest chunk written to I2S at once
+#define SCRATCH_FRAME_POOL 6      // Main loop, Wi-Fi callback, player, ringtone, spares
+#define MESSAGE_POOL 4            // Senders: main loop and Wi-Fi callback, plus spares
+#define AUDIO_FRAME_POOL 32       // Recorder queue (24) plus capture, receive and encoder
+
+enum FramePoolId {
+  POOL_SCRATCH_FRAMES,
+  POOL_MESSAGES,
+  POOL_AUDIO_FRAMES,
+  FRAME_POOL_COUNT
+};
+
+struct FramePoolStats {
+  const char* name;
+  uint32_t size;                  // Items in the pool
+  uint32_t itemBytes;
+  uint32_t inUse;
+  uint32_t peakInUse;             // Since boot
+  uint32_t acquired;              // Since boot
+  uint32_t exhausted;             // Acquires that found the pool empty
+};
+
+// One packet of audio: an ESP-NOW message with its samples as the payload
+struct AudioFrame {
+  Message message;
+  uint16_t count;                 // Samples used (up to AUDIO_SAMPLES_PER_PACKET)
+  volatile uint16_t refs;         // Owners; back to the pool at 0
+
+  int16_t* samples() { return (int16_t*)message.data; }
+  const int16_t* samples() const { return (const int16_t*)message.data; }
+};
+
+// SCRATCH_FRAME_SAMPLES samples, or nullptr if all are in use
+int16_t* acquireScratchFrame();
+void releaseScratchFrame(int16_t* frame);
+
+// Uninitialized Message, or nullptr if all are in use
+Message* acquireMessage();
+void releaseMessage(Message* msg);
+
+// Audio frame with refs = 1 and count = 0, or nullptr if all are in use
+AudioFrame* newAudioFrame();
+// New frame holding a copy of `samples` (for audio that arrives in someone else's buffer)
+AudioFrame* copyAudioFrame(const int16_t* samples, size_t count);
+AudioFrame* retainAudioFrame(AudioFrame* frame);   // refs + 1, returns frame
+void releaseAudioFrame(AudioFrame* frame);         // refs - 1 (nullptr is fine)
+
+void getFramePoolStats(FramePoolStats* out);   // FRAME_POOL_COUNT entries
+
+// Diagnostics (test mode)
+void printFramePools();
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,214 @@
+/*
+ * HeapGuard - Allocation-Free Hot Paths
+ *
+ * Each task that enters a guarded scope claims one slot (once, under a
+ * spinlock) and from then on only changes its own depth counters, so the
+ * check in the malloc wrapper is a lock-free scan of HEAP_GUARD_TASKS
+ * handles. Violations go to a small ring under a spinlock.
+ *
+ * The __wrap_ functions only exist in the guard build; the linker routes
+ * every malloc/calloc/realloc call in the firmware and the framework
+ * libraries through them (-Wl,--wrap=..., see platformio.ini).
+ */
+
+#include "HeapGuard.h"
+#include "Trace.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct GuardSlot {
+  TaskHandle_t task;
+  const char* name;
+  HeapGuardPath path;
+  volatile uint8_t depth;
+  volatile uint8_t allowDepth;
+};
+
+static const char* const pathNames[HEAP_GUARD_PATHS] = {"audio", "network", "isr"};
+
+static portMUX_TYPE guardMux = portMUX_INITIALIZER_UNLOCKED;
+static GuardSlot slots[HEAP_GUARD_TASKS];
+static HeapGuardViolation violations[HEAP_GUARD_VIOLATIONS];
+static uint32_t violationCount = 0;
+static bool slotsFullLogged = false;
+
+const char* getHeapGuardPathName(HeapGuardPath path) {
+  return path < HEAP_GUARD_PATHS ? pathNames[path] : "?";
+}
+
+static GuardSlot* findSlot(TaskHandle_t task) {
+  for (int i = 0; i < HEAP_GUARD_TASKS; i++) {
+    if (slots[i].task == task) return &slots[i];
+  }
+  return nullptr;
+}
+
+static GuardSlot* claimSlot() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  GuardSlot* slot = findSlot(self);
+  if (slot) return slot;
+
+  const char* name = traceTaskName(self);   // Outside the lock: walks the task lists
+  portENTER_CRITICAL(&guardMux);
+  slot = findSlot(nullptr);
+  if (slot) {
+    slot->name = name ? name : "other";
+    slot->depth = 0;
+    slot->allowDepth = 0;
+    slot->task = self;
+  }
+  portEXIT_CRITICAL(&guardMux);
+  if (!slot && !slotsFullLogged) {
+    slotsFullLogged = true;
+    LOG_WARN("Heap guard: more than %d tasks, one is not guarded", HEAP_GUARD_TASKS);
+  }
+  return slot;
+}
+
+void heapGuardEnter(HeapGuardPath path) {
+  GuardSlot* slot = claimSlot();
+  if (!slot) return;
+  if (slot->depth == 0) slot->path = path;   // Outermost scope names the path
+  slot->depth++;
+}
+
+void heapGuardExit() {
+  GuardSlot* slot = findSlot(xTaskGetCurrentTaskHandle());
+  if (slot && slot->depth > 0) slot->depth--;
+}
+
+void heapGuardAllow() {
+  GuardSlot* slot = findSlot(xTaskGetCurrentTaskHandle());
+  if (slot) slot->allowDepth++;
+}
+
+void heapGuardDisallow() {
+  GuardSlot* slot = findSlot(xTaskGetCurrentTaskHandle());
+  if (slot && slot->allowDepth > 0) slot->allowDepth--;
+}
+
+int getHeapGuardViolations(HeapGuardViolation* out, int maxViolations, uint32_t* total) {
+  portENTER_CRITICAL(&guardMux);
+  uint32_t count = violationCount;
+  int kept = count < HEAP_GUARD_VIOLATIONS ? count : HEAP_GUARD_VIOLATIONS;
+  if (kept > maxViolations) kept = maxViolations;
+  for (int i = 0; i < kept; i++) {
+    out[i] = violations[(count - 1 - i) % HEAP_GUARD_VIOLATIONS];
+  }
+  portEXIT_CRITICAL(&guardMux);
+  if (total) *total = count;
+  return kept;
+}
+
+#if HEAP_GUARD
+
+/*
+ * Refuse
+ * True if the caller is on a guarded path: record it, say so and (with
+ * HEAP_GUARD=2) stop right here
+ */
+static bool refuse(size_t size, const void* caller) {
+  HeapGuardViolation violation;
+  if (xPortInIsrContext()) {
+    violation.path = HEAP_GUARD_ISR;
+    violation.task = "isr";
+  } else {
+    GuardSlot* slot = findSlot(xTaskGetCurrentTaskHandle());
+    if (!slot || slot->depth == 0 || slot->allowDepth > 0) return false;
+    violation.path = slot->path;
+    violation.task = slot->name;
+  }
+  violation.size = size;
+  violation.caller = caller;
+  violation.atMs = millis();
+
+  portENTER_CRITICAL_SAFE(&guardMux);
+  violations[violationCount % HEAP_GUARD_VIOLATIONS] = violation;
+  violationCount++;
+  portEXIT_CRITICAL_SAFE(&guardMux);
+
+  LOG_ERROR("Heap guard: %s path allocated %lu bytes in %s, caller %p", pathNames[violation.path],
+            (unsigned long)size, violation.task, caller);
+#if HEAP_GUARD >= 2
+  abort();
+#endif
+  return true;
+}
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* block, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  if (refuse(size, __builtin_return_address(0))) return nullptr;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  if (refuse(count * size, __builtin_return_address(0))) return nullptr;
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* block, size_t size) {
+  if (refuse(size, __builtin_return_address(0))) return nullptr;
+  return __real_realloc(block, size);
+}
+
+}
+
+#endif // HEAP_GUARD
+
+void printHeapGuard() {
+  HeapGuardViolation recent[HEAP_GUARD_VIOLATIONS];
+  uint32_t total = 0;
+  int count = getHeapGuardViolations(recent, HEAP_GUARD_VIOLATIONS, &total);
+
+  Serial.println();
+  Serial.println("============== HEAP GUARD ==============");
+#if HEAP_GUARD
+  Serial.printf("Compiled in (HEAP_GUARD=%d): allocations on guarded paths %s\n", HEAP_GUARD,
+                HEAP_GUARD >= 2 ? "abort" : "return nullptr and are logged");
+#else
+  Serial.println("Compiled out: build the heapguard environment (pio run -e heapguard)");
+#endif
+  Serial.println("Guarded tasks:");
+  for (int i = 0; i < HEAP_GUARD_TASKS; i++) {
+    if (slots[i].task == nullptr) continue;
+    Serial.printf("  %-10s %s\n", slots[i].name,
+                  slots[i].depth > 0 ? getHeapGuardPathName(slots[i].path) : "outside a guarded scope");
+  }
+  Serial.printf("Violations since boot: %lu\n", (unsigned long)total);
+  for (int i = 0; i < count; i++) {
+    Serial.printf("  %8lu ms  %-8s %-10s %6lu bytes  caller %p\n", recent[i].atMs,
+                  getHeapGuardPathName(recent[i].path), recent[i].task, (unsigned long)recent[i].size,
+                  recent[i].caller);
+  }
+  Serial.println("========================================");
+}
+
+void testHeapGuard() {
+#if HEAP_GUARD
+  // Through a volatile pointer, so the compiler can't drop the malloc/free pair
+  void* (*volatile allocate)(size_t) = malloc;
+  uint32_t before = 0, after = 0;
+  getHeapGuardViolations(nullptr, 0, &before);
+  void* block;
+  {
+    HEAP_GUARD_SCOPE(HEAP_GUARD_AUDIO);
+    block = allocate(32);
+  }
+  getHeapGuardViolations(nullptr, 0, &after);
+  if (block == nullptr && after == before + 1) {
+    Serial.println("Heap guard OK: malloc(32) in a guarded scope was refused and logged");
+  } else {
+    Serial.println("Heap guard FAILED: malloc(32) in a guarded scope succeeded (is malloc wrapped?)");
+  }
+  free(block);
+#else
+  Serial.println("Heap guard compiled out: build the heapguard environment (pio run -e heapguard)");
+#endif
+}
@@ -0,0 +1,96 @@
+/*
+ * HeapGuard.h - Allocation-Free Hot Paths
+ *
+ * The audio frame, the ESP-NOW audio receive and every ISR must not touch
+ * the heap: malloc can block on the heap lock, takes a variable time and
+ * fragments memory over a long call. A debug build can enforce that:
+ *
+ *   pio run -e heapguard      (-DHEAP_GUARD=1 and -Wl,--wrap=malloc,...)
+ *
+ * Code marks a hot path with HEAP_GUARD_SCOPE(HEAP_GUARD_AUDIO); ISRs are
+ * always guarded. In the guard build malloc, calloc and realloc check
+ * whether the calling task is inside such a scope, and if so the
+ * allocation fails loudly:
+ *
+ *   - it returns nullptr (operator new then aborts, String stays empty)
+ *   - LOG_ERROR names the path, the task, the size and the caller's address
+ *     (addr2line -e .pio/build/heapguard/firmware.elf <address>)
+ *   - the violation is kept for `test heap guard`
+ *   - with -DHEAP_GUARD=2 the phone aborts at once, with a backtrace
+ *
+ * HEAP_GUARD_ALLOW() opens a hole for code we can't change: esp_now_send()
+ * queues the frame in a buffer the Wi-Fi driver allocates.
+ *
+ * In the normal build the macros compile to nothing and malloc is not
+ * wrapped. Only malloc/calloc/realloc are wrapped; heap_caps_malloc()
+ * (memoryAlloc) is for long-lived buffers and never on a hot path.
+ */
+
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef HEAP_GUARD
+#define HEAP_GUARD 0
+#endif
+
+#define HEAP_GUARD_TASKS 4          // Tasks that can be inside a guarded scope
+#define HEAP_GUARD_VIOLATIONS 8     // Most recent violations kept
+
+enum HeapGuardPath {
+  HEAP_GUARD_AUDIO,                 // Main loop audio frame
+  HEAP_GUARD_NETWORK,               // ESP-NOW audio send and receive
+  HEAP_GUARD_ISR,                   // Any interrupt handler (automatic)
+  HEAP_GUARD_PATHS
+};
+
+struct HeapGuardViolation {
+  HeapGuardPath path;
+  const char* task;                 // Known task name or "other"
+  uint32_t size;
+  const void* caller;               // Return address into the allocating code
+  unsigned long atMs;
+};
+
+void heapGuardEnter(HeapGuardPath path);
+void heapGuardExit();
+void heapGuardAllow();              // Suspend the current task's guard (nests)
+void heapGuardDisallow();
+
+// Copies the most recent violations (newest first), returns how many;
+// total is every violation since boot
+int getHeapGuardViolations(HeapGuardViolation* out, int maxViolations, uint32_t* total);
+const char* getHeapGuardPathName(HeapGuardPath path);
+
+// Diagnostics (test mode): status and violations / allocate on purpose
+// inside a guarded scope and report whether the guard caught it
+void printHeapGuard();
+void testHeapGuard();
+
+#if HEAP_GUARD
+
+class HeapGuardScope {
+public:
+  explicit HeapGuardScope(HeapGuardPath path) { heapGuardEnter(path); }
+  ~HeapGuardScope() { heapGuardExit(); }
+};
+
+class HeapGuardAllowScope {
+public:
+  HeapGuardAllowScope() { heapGuardAllow(); }
+  ~HeapGuardAllowScope() { heapGuardDisallow(); }
+};
+
+#define HEAP_GUARD_SCOPE(path) HeapGuardScope heapGuardScope(path)
+#define HEAP_GUARD_ALLOW() HeapGuardAllowScope heapGuardAllowScope
+
+#else
+
+#define HEAP_GUARD_SCOPE(path) ((void)0)
+#define HEAP_GUARD_ALLOW() ((void)0)
+
+#endif
+
+#endif // HEAP_GUARD_H
@@ -12,7 +12,9 @@
  * - 50ms debouncing to prevent false triggers
  * - State transitions: IDLE ↔ OFF_HOOK
  * - Answers incoming calls (RINGING → IN_CALL)
+ * - Takes over calls from the answering machine (VOICEMAIL → IN_CALL)
  * - Ends calls when hung up (IN_CALL/CALLING → IDLE)
+ * - Moves a speakerphone call to the handset when it is lifted
  */
 
 #include "HookSwitch.h"
@@ -20,6 +22,10 @@
 #include "State.h"
 #include "Network.h"
 #include "RotaryDial.h"
+#include "Conference.h"
+#include "Paging.h"
+#include "Speakerphone.h"
+#include "Log.h"
 #include <Arduino.h>
 
 // Hook Switch Debouncing
@@ -66,29 +72,61 @@ void handleHookSwitch() {
 
       // A HIGH reading means the handset is OFF the hook (switch is open)
       if (currentHookState == HIGH) {
-        // Only transition to OFF_HOOK if we are currently IDLE
-        if (getCurrentState() == IDLE) {
-          changeState(OFF_HOOK);
-          startDialing(); // Initialize the dialing system
-        }
-        // If we're RINGING and user picks up, answer the call
-        else if (getCurrentState() == RINGING) {
-          Serial.println("Answering incoming call");
-          sendCallAccept(getCurrentCallPeer());
-          changeState(IN_CALL);
-        }
+        liftHandset();
       }
       // A LOW reading means the handset is ON the hook (switch is closed)
       else {
-        // Hanging up should end any active call and return to IDLE
-        if (getCurrentState() == IN_CALL || getCurrentState() == CALLING) {
-          Serial.println("Hanging up");
-          sendCallEnd(getCurrentCallPeer());
-        }
-        changeState(IDLE);
+        hangUp();
       }
     }
   }
 
   lastHookState = reading;
 }
+
+/*
+ * Lift Handset
+ * 
+ * Everything that happens when the handset comes off the hook.
+ */
+void liftHandset() {
+  // On speakerphone: carry on in whatever state on the handset
+  if (isSpeakerphoneActive()) {
+    LOG_INFO("Handset lifted - speakerphone off");
+    stopSpeakerphone();
+  }
+  // Only transition to OFF_HOOK if we are currently IDLE
+  if (getCurrentState() == IDLE) {
+    changeState(OFF_HOOK);
+    startDialing(); // Initialize the dialing system
+  }
+  // If we're RINGING and user picks up, answer the call
+  else if (getCurrentState() == RINGING) {
+    LOG_INFO("Answering incoming call");
+    sendCallAccept(getCurrentCallPeer());
+    changeState(IN_CALL);
+  }
+  // Answering machine already accepted the call - just take it over
+  else if (getCurrentState() == VOICEMAIL) {
+    LOG_INFO("Picking up from voicemail");
+    changeState(IN_CALL);
+  }
+}
+
+/*
+ * Hang Up
+ * 
+ * Ends any active call or page and returns to IDLE.
+ */
+void hangUp() {
+  // Hanging up should end any active call and return to IDLE
+  if (getCurrentState() == IN_CALL || getCurrentState() == CALLING) {
+    LOG_INFO("Hanging up");
+    hangUpConference(getCurrentCallPeer()); // Other conference legs, if any
+    sendCallEnd(getCurrentCallPeer());
+  }
+  if (getCurrentState() == PAGING) {
+    stopPaging();
+  }
+  changeState(IDLE);
+}
@@ -4,4 +4,12 @@
 void setupHookSwitch();
 void handleHookSwitch();
 
+// Act as if the handset was lifted: dial tone, answer, or take over from
+// voicemail (used by remote call control)
+void liftHandset();
+
+// End whatever is going on and go IDLE, as if the handset was replaced
+// (used by the speakerphone, where the handset stays on the cradle)
+void hangUp();
+
 #endif // HOOK_SWITCH_H
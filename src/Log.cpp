@@ -0,0 +1,286 @@
+/*
+ * Log - Deferred Logging
+ *
+ * The ring is a bounded multi-producer / single-consumer queue:
+ *
+ *   writeIndex   next sequence number to hand out (producers, CAS)
+ *   readIndex    next sequence the log task formats (log task only)
+ *   slot.ready   sequence + 1 once the producer has filled the slot
+ *
+ * A producer claims sequence s with compare-and-swap as long as
+ * s - readIndex < LOG_RECORDS, fills ring[s % LOG_RECORDS] and publishes
+ * it by storing s + 1 in `ready` (release). The log task stops at the
+ * first slot that isn't ready yet, so records come out in claim order
+ * even if a later producer finishes first. Only the log task advances
+ * readIndex, and only after it is done with the slot.
+ *
+ * Everything a producer touches is in IRAM/DRAM, so logging from an ISR
+ * is safe even while flash is busy.
+ */
+
+#include "Log.h"
+#include "Trace.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct LogRecord {
+  std::atomic<uint32_t> ready;
+  uint32_t timeMs;
+  const char* format;
+  uint8_t level;
+  uint8_t argCount;
+  uint32_t args[LOG_MAX_ARGS];
+};
+
+static LogRecord ring[LOG_RECORDS];
+static std::atomic<uint32_t> writeIndex(0);
+static std::atomic<uint32_t> readIndex(0);
+
+// Statistics
+static std::atomic<uint32_t> recordsDropped(0);
+static uint32_t recordsPrinted = 0;
+static uint32_t dropsReported = 0;
+static uint32_t ringHighWater = 0;
+static uint32_t fileBytes = 0;
+static uint32_t fileRotations = 0;
+static uint32_t fileErrors = 0;
+
+// Recent text for the web page (written by the log task only)
+static char tail[LOG_TAIL_BYTES];
+static uint32_t tailWritten = 0;          // Total bytes ever appended
+static portMUX_TYPE tailMux = portMUX_INITIALIZER_UNLOCKED;
+
+// LittleFS sink: lines are collected and appended in one go
+static bool logToFile = false;
+static char fileBuffer[1024];
+static size_t fileBuffered = 0;
+static unsigned long lastFileFlush = 0;
+
+static TaskHandle_t logTask = NULL;
+
+static const char levelLetters[] = {'-', 'E', 'W', 'I', 'D'};
+
+void IRAM_ATTR logWrite(uint8_t level, const char* format, const uint32_t* args, int argCount) {
+  uint32_t sequence = writeIndex.load(std::memory_order_relaxed);
+  do {
+    if (sequence - readIndex.load(std::memory_order_acquire) >= LOG_RECORDS) {
+      recordsDropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!writeIndex.compare_exchange_weak(sequence, sequence + 1, std::memory_order_relaxed));
+
+  LogRecord& record = ring[sequence % LOG_RECORDS];
+  record.timeMs = millis();
+  record.format = format;
+  record.level = level;
+  record.argCount = argCount;
+  for (int i = 0; i < argCount; i++) {
+    record.args[i] = args[i];
+  }
+  record.ready.store(sequence + 1, std::memory_order_release);
+}
+
+static void appendTail(const char* text, size_t length) {
+  portENTER_CRITICAL(&tailMux);
+  for (size_t i = 0; i < length; i++) {
+    tail[(tailWritten + i) % LOG_TAIL_BYTES] = text[i];
+  }
+  tailWritten += length;
+  portEXIT_CRITICAL(&tailMux);
+}
+
+size_t copyLogTail(char* buffer, size_t size) {
+  if (size == 0) return 0;
+  portENTER_CRITICAL(&tailMux);
+  uint32_t available = tailWritten < LOG_TAIL_BYTES ? tailWritten : LOG_TAIL_BYTES;
+  size_t length = available < size - 1 ? available : size - 1;
+  uint32_t start = tailWritten - length;
+  for (size_t i = 0; i < length; i++) {
+    buffer[i] = tail[(start + i) % LOG_TAIL_BYTES];
+  }
+  bool cut = start > 0;
+  portEXIT_CRITICAL(&tailMux);
+
+  // Don't start in the middle of a line
+  size_t skip = 0;
+  if (cut) {
+    while (skip < length && buffer[skip] != '\n') skip++;
+    if (skip < length) skip++;
+    memmove(buffer, buffer + skip, length - skip);
+  }
+  length -= skip;
+  buffer[length] = '\0';
+  return length;
+}
+
+static void flushLogFile() {
+  if (fileBuffered == 0) return;
+  TRACE_SCOPE(log_file);
+  File file = LittleFS.open(LOG_FILE_PATH, "a");
+  if (!file) {
+    fileErrors++;
+    fileBuffered = 0;
+    return;
+  }
+  file.write((const uint8_t*)fileBuffer, fileBuffered);
+  fileBytes = file.size();
+  file.close();
+  fileBuffered = 0;
+  lastFileFlush = millis();
+
+  if (fileBytes > LOG_FILE_MAX_BYTES) {
+    LittleFS.remove(LOG_FILE_OLD_PATH);
+    LittleFS.rename(LOG_FILE_PATH, LOG_FILE_OLD_PATH);
+    fileBytes = 0;
+    fileRotations++;
+  }
+}
+
+// Send one finished line (with '\n') to every sink
+static void outputLine(const char* line, size_t length) {
+  Serial.write((const uint8_t*)line, length);
+  appendTail(line, length);
+  if (logToFile) {
+    if (fileBuffered + length > sizeof(fileBuffer)) {
+      flushLogFile();
+    }
+    memcpy(fileBuffer + fileBuffered, line, length);
+    fileBuffered += length;
+  }
+}
+
+static size_t formatPrefix(char* line, uint32_t timeMs, uint8_t level) {
+  return snprintf(line, LOG_LINE_SIZE, "[%6lu.%03lu] %c ", (unsigned long)(timeMs / 1000),
+                  (unsigned long)(timeMs % 1000), levelLetters[level <= LOG_LEVEL_DEBUG ? level : 0]);
+}
+
+static void finishLine(char* line, size_t length) {
+  if (length > LOG_LINE_SIZE - 2) length = LOG_LINE_SIZE - 2;
+  line[length++] = '\n';
+  line[length] = '\0';
+  outputLine(line, length);
+}
+
+/*
+ * Drain Log
+ * Formats every ready record in order. Unused arguments are passed to
+ * snprintf too, which ignores them; every argument is one 32-bit word on
+ * the ESP32, including the pointers behind %s.
+ */
+static void drainLog() {
+  static char line[LOG_LINE_SIZE];
+  uint32_t sequence = readIndex.load(std::memory_order_relaxed);
+  uint32_t pending = writeIndex.load(std::memory_order_relaxed) - sequence;
+  if (pending > ringHighWater) ringHighWater = pending;
+
+  while (true) {
+    LogRecord& record = ring[sequence % LOG_RECORDS];
+    if (record.ready.load(std::memory_order_acquire) != sequence + 1) break;
+
+    uint32_t a[LOG_MAX_ARGS] = {0, 0, 0, 0};
+    for (int i = 0; i < record.argCount; i++) a[i] = record.args[i];
+    size_t length = formatPrefix(line, record.timeMs, record.level);
+    int written = snprintf(line + length, LOG_LINE_SIZE - length, record.format, a[0], a[1], a[2], a[3]);
+    if (written > 0) length += written;
+
+    sequence++;
+    readIndex.store(sequence, std::memory_order_release);   // Slot is free again
+    recordsPrinted++;
+    finishLine(line, length);
+  }
+
+  uint32_t dropped = recordsDropped.load(std::memory_order_relaxed);
+  if (dropped != dropsReported) {
+    size_t length = formatPrefix(line, millis(), LOG_LEVEL_WARN);
+    length += snprintf(line + length, LOG_LINE_SIZE - length, "%lu log records dropped (ring full)",
+                       (unsigned long)(dropped - dropsReported));
+    dropsReported = dropped;
+    finishLine(line, length);
+  }
+}
+
+static void logTaskLoop(void* parameter) {
+  while (true) {
+    drainLog();
+    if (logToFile && fileBuffered > 0 && millis() - lastFileFlush >= LOG_FILE_FLUSH_MS) {
+      flushLogFile();
+    }
+    vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+  }
+}
+
+/*
+ * Setup Log
+ * Called once LittleFS is mounted and the config is loaded
+ */
+void setupLog(const PhoneConfig& config) {
+  logToFile = config.logToFile;
+  if (logToFile) {
+    if (!LittleFS.exists("/log")) {
+      LittleFS.mkdir("/log");
+    }
+    File file = LittleFS.open(LOG_FILE_PATH, "r");
+    if (file) {
+      fileBytes = file.size();
+      file.close();
+    }
+  }
+  lastFileFlush = millis();
+  xTaskCreatePinnedToCore(logTaskLoop, "log", LOG_TASK_STACK, NULL, LOG_TASK_PRIORITY, &logTask, LOG_TASK_CORE);
+  Serial.print("Deferred log started (level ");
+  Serial.print(LOG_LEVEL);
+  Serial.println(logToFile ? ", also to " LOG_FILE_PATH ")" : ")");
+}
+
+void printLogStats() {
+  uint32_t written = writeIndex.load(std::memory_order_relaxed);
+  uint32_t pending = written - readIndex.load(std::memory_order_relaxed);
+  Serial.printf("Log: level %d, %lu records, %lu printed, %lu pending, %lu dropped\n",
+                LOG_LEVEL, (unsigned long)written, (unsigned long)recordsPrinted,
+                (unsigned long)pending, (unsigned long)recordsDropped.load(std::memory_order_relaxed));
+  Serial.printf("  ring high water %lu of %d records, %u bytes RAM\n",
+                (unsigned long)ringHighWater, LOG_RECORDS, (unsigned)sizeof(ring));
+  if (logToFile) {
+    Serial.printf("  file %s: %lu bytes, %lu rotations, %lu write errors\n",
+                  LOG_FILE_PATH, (unsigned long)fileBytes, (unsigned long)fileRotations, (unsigned long)fileErrors);
+  } else {
+    Serial.println("  file: off (\"log_to_file\" in config.json)");
+  }
+  if (logTask) {
+    Serial.printf("  log task stack: %u bytes never used\n", (unsigned)uxTaskGetStackHighWaterMark(logTask));
+  }
+}
+
+/*
+ * Benchmark Log
+ * Cost of one deferred record vs. printing the same line directly
+ */
+void benchmarkLog() {
+  const int records = 32;        // Well below LOG_RECORDS, nothing is dropped
+  uint32_t start = micros();
+  for (int i = 0; i < records; i++) {
+    logAt(LOG_LEVEL_DEBUG, "Log benchmark record %d of %d", i + 1, records);
+  }
+  uint32_t deferredUs = micros() - start;
+
+  const int lines = 4;
+  Serial.flush();
+  start = micros();
+  for (int i = 0; i < lines; i++) {
+    Serial.printf("[%6lu.%03lu] D Log benchmark record %d of %d\n", 0UL, 0UL, i + 1, lines);
+  }
+  uint32_t directUs = micros() - start;
+
+  Serial.println();
+  Serial.println("========== LOG BENCHMARK ==========");
+  Serial.print("Deferred: ");
+  Serial.print((float)deferredUs / records, 1);
+  Serial.println(" us per record");
+  Serial.print("Serial:   ");
+  Serial.print((float)directUs / lines, 1);
+  Serial.println(" us per line (after the UART buffer fills: ~87 us per character)");
+  Serial.println("===================================");
+}
@@ -0,0 +1,118 @@
+/*
+ * Log.h - Deferred Logging
+ *
+ * At 115200 baud every character on Serial takes 87us, and a print blocks
+ * once the UART buffer is full - a few lines from the ESP-NOW callback or
+ * while dialing are enough to make the audio stutter. LOG_INFO() and
+ * friends only store a small binary record in a RAM ring:
+ *
+ *   LOG_INFO("Peer #%d not found!", number)
+ *     └─► [time | level | format address | up to 4 args]  (32 bytes, a few us)
+ *           └─► log task (core 0, low priority) formats it later ──► Serial
+ *                                                             ├──► last 2KB for GET /api/v1/log
+ *                                                             └──► /log/retrobell.log ("log_to_file")
+ *
+ * Any task or ISR can log; slots are claimed with one compare-and-swap, no
+ * lock. A full ring drops new records (counted) instead of waiting.
+ *
+ * Because formatting happens later, in another task:
+ *   - the format must be a string literal (only its address is stored)
+ *   - arguments are 32-bit integers, chars or pointers, at most 4; %s only
+ *     for strings that never change (literals, getStateName()) - never
+ *     String::c_str() or a stack buffer
+ *   - no floats
+ *
+ * Levels are filtered at compile time: records above LOG_LEVEL (default
+ * INFO) are still type-checked but compile to nothing. Build with
+ * -DLOG_LEVEL=LOG_LEVEL_DEBUG to see every received packet.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include "Configuration.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RECORDS 256                 // Ring slots (32 bytes each)
+#define LOG_MAX_ARGS 4
+#define LOG_LINE_SIZE 160               // Longest formatted line
+#define LOG_TAIL_BYTES 2048             // Recent text kept for the web page
+#define LOG_DRAIN_MS 20
+#define LOG_TASK_STACK 4096
+#define LOG_TASK_PRIORITY 1
+#define LOG_TASK_CORE 0
+#define LOG_FILE_PATH "/log/retrobell.log"
+#define LOG_FILE_OLD_PATH "/log/retrobell.1.log"
+#define LOG_FILE_MAX_BYTES (64 * 1024)  // Rotate to .1 beyond this
+#define LOG_FILE_FLUSH_MS 2000          // Append to flash at most this often
+
+// Start the log task (records logged before this are kept and printed then)
+void setupLog(const PhoneConfig& config);
+
+// Store one record (use the LOG_* macros instead). Safe from ISRs.
+void logWrite(uint8_t level, const char* format, const uint32_t* args, int argCount);
+
+// Always inlined: an ISR must not call into flash
+template <typename T>
+inline __attribute__((always_inline)) uint32_t logArg(T value) {
+  static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                "log arguments must be integers or static strings");
+  return (uint32_t)(uintptr_t)value;
+}
+
+inline __attribute__((always_inline)) void logAt(uint8_t level, const char* format) {
+  logWrite(level, format, nullptr, 0);
+}
+
+template <typename... Args>
+inline __attribute__((always_inline)) void logAt(uint8_t level, const char* format, Args... args) {
+  static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "at most 4 log arguments");
+  const uint32_t values[] = {logArg(args)...};
+  logWrite(level, format, values, sizeof...(Args));
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logAt(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do { if (0) logAt(LOG_LEVEL_ERROR, __VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logAt(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do { if (0) logAt(LOG_LEVEL_WARN, __VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logAt(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do { if (0) logAt(LOG_LEVEL_INFO, __VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logAt(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { if (0) logAt(LOG_LEVEL_DEBUG, __VA_ARGS__); } while (0)
+#endif
+
+// Copy the most recent log text (whole lines) for the web page.
+// Returns the length; buffer is always terminated.
+size_t copyLogTail(char* buffer, size_t size);
+
+// Diagnostics (test mode)
+void printLogStats();
+void benchmarkLog();
+
+#endif // LOG_H
@@ -0,0 +1,200 @@
+/*
+ * MemoryMonitor - Heap, PSRAM and Stack Watermarks
+ *
+ * Tag counters change on every memoryAlloc()/memoryFree() and are guarded
+ * by a spinlock; the sample itself (heap_caps_get_info() walks the heap)
+ * only runs in the web task, and the finished report is swapped in under
+ * the same lock.
+ */
+
+#include "MemoryMonitor.h"
+#include "Log.h"
+#include "Trace.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Tasks whose stacks are watched (missing ones are skipped)
+static const char* const taskNames[MEMORY_TASKS] = {
+  "loopTask", "web", "log", "wifi", "tiT", "esp_timer", "arduino_events",
+  "recEncode", "recWrite", "player", "ringtone", "sys_evt"
+};
+
+static const char* const tagNames[MEMORY_TAG_COUNT] = {
+  "recorder", "player", "ringtone"
+};
+
+static portMUX_TYPE memoryMux = portMUX_INITIALIZER_UNLOCKED;
+static MemoryTagUsage tags[MEMORY_TAG_COUNT];
+static MemoryReport latest;
+
+// Web task only
+static unsigned long lastSampleAt = 0;
+static uint32_t activeAlerts = 0;
+static uint32_t stackAlerted = 0;          // Bit per task in taskNames
+static uint32_t alertCount = 0;
+
+void* memoryAlloc(MemoryTag tag, size_t size, uint32_t caps) {
+  void* block = heap_caps_malloc(size, caps);
+  portENTER_CRITICAL(&memoryMux);
+  MemoryTagUsage& usage = tags[tag];
+  if (block) {
+    usage.bytes += size;
+    usage.blocks++;
+    usage.allocations++;
+    if (usage.bytes > usage.peakBytes) usage.peakBytes = usage.bytes;
+  } else {
+    usage.failures++;
+  }
+  portEXIT_CRITICAL(&memoryMux);
+  return block;
+}
+
+void memoryFree(MemoryTag tag, void* block, size_t size) {
+  if (!block) return;
+  heap_caps_free(block);
+  portENTER_CRITICAL(&memoryMux);
+  MemoryTagUsage& usage = tags[tag];
+  usage.bytes -= size < usage.bytes ? size : usage.bytes;
+  if (usage.blocks > 0) usage.blocks--;
+  portEXIT_CRITICAL(&memoryMux);
+}
+
+static void sampleRegion(MemoryRegion& region, uint32_t caps, uint32_t* allocatedBlocks) {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, caps);
+  region.total = heap_caps_get_total_size(caps);
+  region.free = info.total_free_bytes;
+  region.minFree = info.minimum_free_bytes;
+  region.largestBlock = info.largest_free_block;
+  region.fragmentationPermille = region.free ? 1000 - (uint64_t)region.largestBlock * 1000 / region.free : 0;
+  if (allocatedBlocks) *allocatedBlocks = info.allocated_blocks;
+}
+
+// Log once when a value drops below its limit; clear once it is back
+static void checkAlert(uint32_t bit, bool low, const char* what, uint32_t value, uint32_t limit) {
+  if (low && !(activeAlerts & bit)) {
+    activeAlerts |= bit;
+    alertCount++;
+    LOG_WARN("Memory alert: %s %lu bytes (limit %lu)", what, value, limit);
+  } else if (!low && (activeAlerts & bit)) {
+    activeAlerts &= ~bit;
+    LOG_INFO("Memory: %s back to %lu bytes", what, value);
+  }
+}
+
+static void sampleMemory() {
+  TRACE_SCOPE(memory_sample);
+  static MemoryReport next;
+  sampleRegion(next.internal, MALLOC_CAP_INTERNAL, &next.allocatedBlocks);
+  next.psram = MemoryRegion();
+  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+    sampleRegion(next.psram, MALLOC_CAP_SPIRAM, nullptr);
+  }
+
+  next.taskCount = 0;
+  bool stackLow = false;
+  for (int i = 0; i < MEMORY_TASKS; i++) {
+    TaskHandle_t task = xTaskGetHandle(taskNames[i]);
+    if (task == NULL) continue;
+    uint32_t stackFree = uxTaskGetStackHighWaterMark(task);
+    next.tasks[next.taskCount++] = {taskNames[i], stackFree};
+    if (stackFree < MEMORY_STACK_ALERT_BYTES) {
+      stackLow = true;
+      if (!(stackAlerted & (1UL << i))) {
+        stackAlerted |= 1UL << i;
+        alertCount++;
+        LOG_WARN("Memory alert: task %s has only %lu bytes of stack left", taskNames[i], stackFree);
+      }
+    }
+  }
+  if (stackLow) activeAlerts |= MEMORY_ALERT_STACK;
+
+  checkAlert(MEMORY_ALERT_HEAP, next.internal.free < MEMORY_HEAP_ALERT_BYTES, "internal heap free",
+             next.internal.free, MEMORY_HEAP_ALERT_BYTES);
+  checkAlert(MEMORY_ALERT_BLOCK, next.internal.largestBlock < MEMORY_BLOCK_ALERT_BYTES, "largest internal block",
+             next.internal.largestBlock, MEMORY_BLOCK_ALERT_BYTES);
+  if (next.psram.total > 0) {
+    checkAlert(MEMORY_ALERT_PSRAM, next.psram.free < MEMORY_PSRAM_ALERT_BYTES, "PSRAM free",
+               next.psram.free, MEMORY_PSRAM_ALERT_BYTES);
+  }
+  next.alerts = activeAlerts;
+  next.alertCount = alertCount;
+  next.sampledAt = millis();
+
+  uint32_t used = (next.internal.total - next.internal.free) + (next.psram.total - next.psram.free);
+  portENTER_CRITICAL(&memoryMux);
+  uint32_t tagged = 0;
+  for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+    next.tags[t] = tags[t];
+    next.tags[t].name = tagNames[t];
+    tagged += tags[t].bytes;
+  }
+  next.untaggedBytes = used > tagged ? used - tagged : 0;
+  latest = next;
+  portEXIT_CRITICAL(&memoryMux);
+}
+
+void updateMemoryMonitor() {
+  if (lastSampleAt != 0 && millis() - lastSampleAt < MEMORY_SAMPLE_MS) return;
+  lastSampleAt = millis();
+  sampleMemory();
+}
+
+void getMemoryReport(MemoryReport& report) {
+  portENTER_CRITICAL(&memoryMux);
+  report = latest;
+  portEXIT_CRITICAL(&memoryMux);
+}
+
+static void printRegion(const char* name, const MemoryRegion& region) {
+  Serial.printf("%-9s %7lu KB total, %7lu free, %7lu lowest, %7lu largest block, %3lu.%lu%% fragmented\n", name,
+                (unsigned long)(region.total / 1024), (unsigned long)(region.free / 1024),
+                (unsigned long)(region.minFree / 1024), (unsigned long)(region.largestBlock / 1024),
+                (unsigned long)(region.fragmentationPermille / 10), (unsigned long)(region.fragmentationPermille % 10));
+}
+
+void printMemoryReport() {
+  static MemoryReport report;
+  getMemoryReport(report);
+
+  Serial.println();
+  Serial.println("============== MEMORY ==============");
+  if (report.sampledAt == 0) {
+    Serial.println("Not sampled yet (the web task samples every 5 s)");
+    Serial.println("====================================");
+    return;
+  }
+  Serial.printf("Sampled %lu s ago, every %d s\n", (millis() - report.sampledAt) / 1000, MEMORY_SAMPLE_MS / 1000);
+  printRegion("Internal", report.internal);
+  if (report.psram.total > 0) {
+    printRegion("PSRAM", report.psram);
+  } else {
+    Serial.println("PSRAM     not fitted");
+  }
+  Serial.printf("%lu blocks allocated in internal RAM\n", (unsigned long)report.allocatedBlocks);
+
+  Serial.println("By tag:        bytes      peak  blocks  allocs  failed");
+  for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+    const MemoryTagUsage& tag = report.tags[t];
+    Serial.printf("  %-9s %9lu %9lu %7lu %7lu %7lu\n", tag.name, (unsigned long)tag.bytes, (unsigned long)tag.peakBytes,
+                  (unsigned long)tag.blocks, (unsigned long)tag.allocations, (unsigned long)tag.failures);
+  }
+  Serial.printf("  %-9s %9lu   (Wi-Fi, lwIP, stacks, Strings - rising over time = leak)\n", "untagged",
+                (unsigned long)report.untaggedBytes);
+
+  Serial.println("Task stacks (never used, bytes):");
+  for (int i = 0; i < report.taskCount; i++) {
+    Serial.printf("  %-15s %6lu%s\n", report.tasks[i].name, (unsigned long)report.tasks[i].stackFree,
+                  report.tasks[i].stackFree < MEMORY_STACK_ALERT_BYTES ? "  LOW" : "");
+  }
+
+  Serial.printf("Alerts: %s%s%s%s%s(%lu logged since boot)\n",
+                report.alerts == 0 ? "none " : "",
+                report.alerts & MEMORY_ALERT_HEAP ? "heap " : "",
+                report.alerts & MEMORY_ALERT_BLOCK ? "fragmented " : "",
+                report.alerts & MEMORY_ALERT_PSRAM ? "psram " : "",
+                report.alerts & MEMORY_ALERT_STACK ? "stack " : "",
+                (unsigned long)report.alertCount);
+  Serial.println("====================================");
+}
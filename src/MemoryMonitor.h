@@ -0,0 +1,101 @@
+/*
+ * MemoryMonitor.h - Heap, PSRAM and Stack Watermarks
+ *
+ * Where the RAM goes, sampled every MEMORY_SAMPLE_MS by the web task:
+ *
+ *   internal heap   free, lowest free, largest free block, fragmentation
+ *   PSRAM           the same (if fitted)
+ *   by tag          bytes, peak and blocks of the buffers modules allocate
+ *                   with memoryAlloc() (recorder, player, ringtones)
+ *   untagged        everything else in use: Wi-Fi, lwIP, task stacks,
+ *                   Strings - the part to watch for leaks
+ *   task stacks     lowest unused stack of every known task, including
+ *                   the Wi-Fi task that runs the ESP-NOW callbacks
+ *
+ * Fragmentation is 1 - largest block / free: high means there is memory
+ * but no single piece big enough for a buffer.
+ *
+ * Crossing a threshold logs a warning once (LOG_WARN) and sets a bit in
+ * `alerts` until the value recovers; stacks only ever get lower, so a
+ * stack alert stays. Reported by `test memory`, /api/v1/memory and
+ * /metrics.
+ */
+
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_heap_caps.h>
+
+#define MEMORY_SAMPLE_MS 5000
+#define MEMORY_HEAP_ALERT_BYTES (32 * 1024)     // Internal heap free below this
+#define MEMORY_BLOCK_ALERT_BYTES (8 * 1024)     // Largest internal block below this
+#define MEMORY_PSRAM_ALERT_BYTES (256 * 1024)   // PSRAM free below this
+#define MEMORY_STACK_ALERT_BYTES 512            // Task stack never used below this
+#define MEMORY_TASKS 12                         // Tasks watched (see MemoryMonitor.cpp)
+
+enum MemoryTag {
+  MEMORY_RECORDER,                // CallRecorder buffers
+  MEMORY_PLAYER,                  // FilePlayer blocks and head cache
+  MEMORY_RINGTONE,                // Decoded ringtones (PSRAM)
+  MEMORY_TAG_COUNT
+};
+
+// Bits of MemoryReport.alerts
+#define MEMORY_ALERT_HEAP 0x01
+#define MEMORY_ALERT_BLOCK 0x02
+#define MEMORY_ALERT_PSRAM 0x04
+#define MEMORY_ALERT_STACK 0x08
+
+struct MemoryTagUsage {
+  const char* name;
+  uint32_t bytes;
+  uint32_t peakBytes;
+  uint32_t blocks;
+  uint32_t allocations;           // Since boot
+  uint32_t failures;
+};
+
+struct MemoryRegion {
+  uint32_t total;
+  uint32_t free;
+  uint32_t minFree;               // Since boot
+  uint32_t largestBlock;
+  uint32_t fragmentationPermille;
+};
+
+struct MemoryTaskUsage {
+  const char* name;
+  uint32_t stackFree;             // Lowest unused stack since the task started
+};
+
+struct MemoryReport {
+  MemoryRegion internal;
+  MemoryRegion psram;             // All zero without PSRAM
+  uint32_t allocatedBlocks;
+  uint32_t untaggedBytes;
+  MemoryTagUsage tags[MEMORY_TAG_COUNT];
+  MemoryTaskUsage tasks[MEMORY_TASKS];
+  int taskCount;                  // Tasks that exist right now
+  uint32_t alerts;                // MEMORY_ALERT_* active now
+  uint32_t alertCount;            // Warnings logged since boot
+  unsigned long sampledAt;        // millis(), 0 = not sampled yet
+};
+
+// Tagged allocation: heap_caps_malloc() plus per-tag accounting (any task).
+// Free with the size it was allocated with; bytes are as requested, without
+// the allocator's overhead.
+void* memoryAlloc(MemoryTag tag, size_t size, uint32_t caps = MALLOC_CAP_DEFAULT);
+void memoryFree(MemoryTag tag, void* block, size_t size);
+
+// Sample if MEMORY_SAMPLE_MS has passed (web task)
+void updateMemoryMonitor();
+
+// Latest sample (any task)
+void getMemoryReport(MemoryReport& report);
+
+// Diagnostics (test mode)
+void printMemoryReport();
+
+#endif // MEMORY_MONITOR_H
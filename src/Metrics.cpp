@@ -0,0 +1,199 @@
+/*
+ * Metrics - Metrics Registry (Prometheus)
+ *
+ * Everything is a fixed array of std::atomic<uint32_t>, updated with
+ * relaxed fetch_add (one S32C1I loop on the ESP32-S3, no lock):
+ *
+ *   counters[id]                       one value
+ *   packets[sent|received|dropped][type]
+ *   histograms[id].buckets[i]          observations <= bound i (not cumulative),
+ *                                      last slot is +Inf
+ *   histograms[id].sum                 64-bit, in native units, under sumMux
+ *
+ * Bucket bounds are stored in the unit the caller measures in (us, ms, s)
+ * and divided by `scale` only when rendered, so observing never touches
+ * floating point. Cumulative counts and _count are computed at scrape time.
+ *
+ * Sums are 64-bit so they never wrap (a 32-bit loop latency sum in us
+ * would after ~71 min, which rate() mistakes for a counter reset while
+ * _count keeps growing). The ESP32-S3 has no 64-bit atomic add, so the
+ * sum takes a spinlock; that is a few dozen cycles per observation.
+ */
+
+#include "Metrics.h"
+#include "MemoryMonitor.h"
+#include "PrintFormat.h"
+#include <atomic>
+#include <esp_heap_caps.h>
+#include <WiFi.h>
+
+struct HistogramInfo {
+  const char* name;
+  const char* help;
+  uint32_t bounds[METRIC_MAX_BUCKETS];
+  uint8_t boundCount;
+  float scale;                    // Native units per second
+};
+
+struct Histogram {
+  std::atomic<uint32_t> buckets[METRIC_MAX_BUCKETS + 1];
+  uint64_t sum;                   // Under sumMux
+};
+
+static const HistogramInfo histogramInfo[METRIC_HISTOGRAM_COUNT] = {
+  {"retrobell_loop_latency_seconds", "Duration of one main loop pass",
+   {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000}, 10, 1000000.0f},
+  {"retrobell_call_setup_seconds", "Time from calling to answered (includes ringing)",
+   {500, 1000, 2000, 5000, 10000, 20000, 30000, 60000}, 8, 1000.0f},
+  {"retrobell_call_duration_seconds", "Length of finished calls",
+   {10, 30, 60, 120, 300, 600, 1800, 3600}, 8, 1.0f},
+};
+
+static const char* const counterNames[METRIC_COUNTER_COUNT][3] = {
+  // name, label, help
+  {"retrobell_i2s_underruns_total", "port=\"handset\"", "Estimated I2S DMA underruns (audio written too late)"},
+  {"retrobell_i2s_underruns_total", "port=\"ringer\"", nullptr},
+  {"retrobell_packets_invalid_total", nullptr, "Received ESP-NOW messages with an invalid length"},
+  {"retrobell_audio_late_frames_total", nullptr, "Microphone frames read more than one frame after they were ready"},
+  {"retrobell_audio_overruns_total", nullptr, "Microphone audio lost because the RX DMA was full"},
+  {"retrobell_i2s_short_writes_total", nullptr, "i2s_write() calls that timed out or wrote less than asked"},
+  {"retrobell_i2s_short_reads_total", nullptr, "i2s_read() calls that failed or returned less than a frame"},
+};
+
+static const char* const packetNames[PACKET_METRIC_COUNT][2] = {
+  {"retrobell_packets_sent_total", "ESP-NOW messages sent"},
+  {"retrobell_packets_received_total", "ESP-NOW messages received"},
+  {"retrobell_packets_dropped_total", "ESP-NOW messages esp_now_send() refused"},
+};
+
+static const char* const messageTypeNames[METRIC_MESSAGE_TYPES] = {
+  "discovery", "call_request", "call_accept", "call_reject", "call_busy",
+  "call_end", "audio", "page_audio", "page_end"
+};
+
+static std::atomic<uint32_t> counters[METRIC_COUNTER_COUNT];
+static std::atomic<uint32_t> packets[PACKET_METRIC_COUNT][METRIC_MESSAGE_TYPES];
+static Histogram histograms[METRIC_HISTOGRAM_COUNT];
+static portMUX_TYPE sumMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t lastLoopUs = 0;
+
+void countMetric(CounterMetric metric) {
+  counters[metric].fetch_add(1, std::memory_order_relaxed);
+}
+
+void countPacket(PacketMetric metric, int messageType) {
+  if (messageType < 0 || messageType >= METRIC_MESSAGE_TYPES) return;
+  packets[metric][messageType].fetch_add(1, std::memory_order_relaxed);
+}
+
+void observeMetric(HistogramMetric metric, uint32_t value) {
+  const HistogramInfo& info = histogramInfo[metric];
+  int bucket = 0;
+  while (bucket < info.boundCount && value > info.bounds[bucket]) bucket++;
+  histograms[metric].buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  portENTER_CRITICAL(&sumMux);
+  histograms[metric].sum += value;
+  portEXIT_CRITICAL(&sumMux);
+}
+
+void markLoopPass() {
+  uint32_t now = micros();
+  if (lastLoopUs != 0) observeMetric(METRIC_LOOP_LATENCY, now - lastLoopUs);
+  lastLoopUs = now;
+}
+
+/*
+ * Rendering
+ * HELP/TYPE once per metric family, then one line per series
+ */
+static void writeHeader(Print& out, const char* name, const char* type, const char* help) {
+  printFormat(out, "# HELP %s %s\n", name, help);
+  printFormat(out, "# TYPE %s %s\n", name, type);
+}
+
+static void writeGauge(Print& out, const char* name, const char* help, long value) {
+  writeHeader(out, name, "gauge", help);
+  printFormat(out, "%s %ld\n", name, value);
+}
+
+static void writeHistogram(Print& out, HistogramMetric metric) {
+  const HistogramInfo& info = histogramInfo[metric];
+  const Histogram& histogram = histograms[metric];
+  writeHeader(out, info.name, "histogram", info.help);
+
+  uint32_t cumulative = 0;
+  for (int i = 0; i < info.boundCount; i++) {
+    cumulative += histogram.buckets[i].load(std::memory_order_relaxed);
+    printFormat(out, "%s_bucket{le=\"%g\"} %lu\n", info.name, info.bounds[i] / info.scale, (unsigned long)cumulative);
+  }
+  cumulative += histogram.buckets[info.boundCount].load(std::memory_order_relaxed);
+  printFormat(out, "%s_bucket{le=\"+Inf\"} %lu\n", info.name, (unsigned long)cumulative);
+  portENTER_CRITICAL(&sumMux);
+  uint64_t sum = histogram.sum;
+  portEXIT_CRITICAL(&sumMux);
+  printFormat(out, "%s_sum %.9g\n", info.name, (double)sum / info.scale);
+  printFormat(out, "%s_count %lu\n", info.name, (unsigned long)cumulative);
+}
+
+void writeMetrics(Print& out) {
+  for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+    const char* name = counterNames[i][0];
+    const char* label = counterNames[i][1];
+    const char* help = counterNames[i][2];
+    if (help) writeHeader(out, name, "counter", help);
+    unsigned long value = counters[i].load(std::memory_order_relaxed);
+    if (label) {
+      printFormat(out, "%s{%s} %lu\n", name, label, value);
+    } else {
+      printFormat(out, "%s %lu\n", name, value);
+    }
+  }
+
+  for (int m = 0; m < PACKET_METRIC_COUNT; m++) {
+    writeHeader(out, packetNames[m][0], "counter", packetNames[m][1]);
+    for (int type = 0; type < METRIC_MESSAGE_TYPES; type++) {
+      printFormat(out, "%s{type=\"%s\"} %lu\n", packetNames[m][0], messageTypeNames[type],
+                 (unsigned long)packets[m][type].load(std::memory_order_relaxed));
+    }
+  }
+
+  for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+    writeHistogram(out, (HistogramMetric)h);
+  }
+
+  writeGauge(out, "retrobell_uptime_seconds", "Time since boot", millis() / 1000);
+  writeGauge(out, "retrobell_heap_free_bytes", "Free internal heap",
+             heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+  writeGauge(out, "retrobell_heap_min_free_bytes", "Lowest free internal heap since boot",
+             heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+  writeGauge(out, "retrobell_heap_largest_free_block_bytes", "Largest allocatable internal block",
+             heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+  writeGauge(out, "retrobell_wifi_rssi_dbm", "Signal strength of the access point", WiFi.RSSI());
+
+  PeerStatus peers[MAX_PEERS];
+  writeGauge(out, "retrobell_peers", "Phones in the peer directory", getPeerDirectory(peers, MAX_PEERS));
+
+  // Sampled by MemoryMonitor (at most MEMORY_SAMPLE_MS old)
+  static MemoryReport memory;
+  getMemoryReport(memory);
+  writeGauge(out, "retrobell_heap_fragmentation_permille", "1000 - largest free block * 1000 / free (internal)",
+             memory.internal.fragmentationPermille);
+  writeGauge(out, "retrobell_psram_free_bytes", "Free PSRAM (0 without PSRAM)", memory.psram.free);
+  writeGauge(out, "retrobell_psram_min_free_bytes", "Lowest free PSRAM since boot", memory.psram.minFree);
+  writeGauge(out, "retrobell_memory_untagged_bytes", "Heap in use outside memoryAlloc() tags", memory.untaggedBytes);
+  writeGauge(out, "retrobell_memory_alerts", "MemoryMonitor alert bits active (heap 1, block 2, psram 4, stack 8)",
+             memory.alerts);
+
+  writeHeader(out, "retrobell_memory_tagged_bytes", "gauge", "Heap allocated with memoryAlloc(), per tag");
+  for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+    printFormat(out, "retrobell_memory_tagged_bytes{tag=\"%s\"} %lu\n", memory.tags[t].name ? memory.tags[t].name : "?",
+         (unsigned long)memory.tags[t].bytes);
+  }
+
+  writeHeader(out, "retrobell_task_stack_free_bytes", "gauge", "Lowest unused stack of each task since it started");
+  for (int i = 0; i < memory.taskCount; i++) {
+    printFormat(out, "retrobell_task_stack_free_bytes{task=\"%s\"} %lu\n", memory.tasks[i].name,
+               (unsigned long)memory.tasks[i].stackFree);
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ * Metrics.h - Metrics Registry (Prometheus)
+ *
+ * Counters and fixed-bucket histograms that any task - including the
+ * ESP-NOW callback and the audio path - can update with a couple of
+ * atomic adds: no locks, no allocation, no formatting. Gauges (heap,
+ * Wi-Fi) are read when scraped; PSRAM, tags and stacks come from the
+ * last MemoryMonitor sample.
+ *
+ * Rendered in Prometheus text format at GET /metrics (see WebApi.cpp):
+ *
+ *   retrobell_packets_sent_total{type="audio"} 48211
+ *   retrobell_loop_latency_seconds_bucket{le="0.005"} 912345
+ *   retrobell_heap_free_bytes 183412
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "Network.h"
+#include <Arduino.h>
+#include <stdint.h>
+
+#define METRIC_MESSAGE_TYPES (MSG_PAGE_END + 1)
+#define METRIC_MAX_BUCKETS 10
+
+enum CounterMetric {
+  METRIC_I2S_UNDERRUN_HANDSET,   // Estimated in writeOutputStage()
+  METRIC_I2S_UNDERRUN_RINGER,
+  METRIC_PACKETS_INVALID,        // Received with a bad length
+  METRIC_AUDIO_LATE_FRAMES,      // AudioMonitor.cpp
+  METRIC_AUDIO_OVERRUNS,
+  METRIC_I2S_SHORT_WRITES,
+  METRIC_I2S_SHORT_READS,
+  METRIC_COUNTER_COUNT
+};
+
+enum PacketMetric {
+  PACKET_SENT,
+  PACKET_RECEIVED,
+  PACKET_DROPPED,                // esp_now_send() refused it
+  PACKET_METRIC_COUNT
+};
+
+enum HistogramMetric {
+  METRIC_LOOP_LATENCY,           // Main loop pass, microseconds
+  METRIC_CALL_SETUP,             // CALLING → IN_CALL (includes ringing), milliseconds
+  METRIC_CALL_DURATION,          // IN_CALL, seconds
+  METRIC_HISTOGRAM_COUNT
+};
+
+// Hot path: lock-free, safe from any task
+void countMetric(CounterMetric metric);
+void countPacket(PacketMetric metric, int messageType);
+void observeMetric(HistogramMetric metric, uint32_t value);
+
+// Call at the top of every loop() pass
+void markLoopPass();
+
+// Write every metric in Prometheus text exposition format
+void writeMetrics(Print& out);
+
+#endif // METRICS_H
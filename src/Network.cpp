@@ -21,33 +21,58 @@
  * - MSG_CALL_REJECT: "I rejected your call"
  * - MSG_CALL_END: "I'm hanging up"
  * - MSG_AUDIO_DATA: Audio stream for voice calls
+ * - MSG_PAGE_AUDIO / MSG_PAGE_END: Paging broadcast (see Paging.cpp)
  */
 
 #include "Network.h"
 #include "State.h"
 #include "Configuration.h"
 #include "Audio.h"
+#include "Conference.h"
+#include "Paging.h"
+#include "CallRecorder.h"
+#include "Speakerphone.h"
+#include "Metrics.h"
+#include "FramePool.h"
+#include "AudioMonitor.h"
+#include "HeapGuard.h"
+#include "Log.h"
+#include "Trace.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_now.h>
-
-// External references
-extern String dialedNumber;
+#include <esp_wifi.h>
 
 // Peer information
 struct PeerInfo {
   int number;
   uint8_t macAddress[6];
   bool registered;
+  unsigned long lastSeen;
+  int8_t rssi;
 };
 
-#define MAX_PEERS 10
 PeerInfo peers[MAX_PEERS];
 int peerCount = 0;
+static portMUX_TYPE peerMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Signal strength of the last ESP-NOW frame, captured in promiscuous mode
+// (the ESP-NOW receive callback doesn't report RSSI)
+static uint8_t lastFrameMac[6];
+static int8_t lastFrameRssi = 0;
 
 // Current call state
 int currentCallPeer = -1;
 
+// Wi-Fi driver and ESP-NOW up (startRadio)
+static bool radioStarted = false;
+static int espNowRateMbps = 1;   // Driver default until startRadio() sets ours
+
+// Router channel remembered in config.json (setupNetwork)
+static PhoneConfig* networkConfig = nullptr;
+static volatile bool routerConnected = false;  // Set by the Wi-Fi event task
+static bool channelSaveNeeded = false;
+
 // Discovery state
 unsigned long lastDiscoveryTime = 0;
 const unsigned long DISCOVERY_INTERVAL = 10000; // Broadcast every 10 seconds
@@ -61,6 +86,9 @@ const unsigned long DISCOVERY_INTERVAL = 10000; // Broadcast every 10 seconds
  * 
  * Note: ESP-NOW communication is direct peer-to-peer and does NOT go through the router
  * 
+ * Blocks for up to 10 seconds, so boot runs it in the background after
+ * the phone is already ready to ring (see Boot.h).
+ * 
  * Parameters:
  * - ssid: Wi-Fi network name
  * - password: Wi-Fi password
@@ -103,34 +131,180 @@ void printMacAddress() {
   Serial.println(WiFi.macAddress());
 }
 
+/*
+ * Promiscuous Packet Callback (Wi-Fi task)
+ * 
+ * ESP-NOW frames are vendor-specific action frames (frame control 0xD0,
+ * category 127). Remember the sender and RSSI of the latest one; the
+ * ESP-NOW receive callback for the same frame runs right after this.
+ */
+static void onPromiscuousPacket(void* buffer, wifi_promiscuous_pkt_type_t type) {
+  if (type != WIFI_PKT_MGMT) return;
+  const wifi_promiscuous_pkt_t* packet = (const wifi_promiscuous_pkt_t*)buffer;
+  const uint8_t* frame = packet->payload;
+  if (packet->rx_ctrl.sig_len < 25 || frame[0] != 0xD0 || frame[24] != 127) return;
+  memcpy(lastFrameMac, frame + 10, 6);   // Address 2: transmitter
+  lastFrameRssi = packet->rx_ctrl.rssi;
+}
+
+/*
+ * Note Peer Seen
+ * Updates last-seen time and RSSI for a known sender
+ */
+static void notePeerSeen(const uint8_t* macAddress) {
+  portENTER_CRITICAL(&peerMux);
+  for (int i = 0; i < peerCount; i++) {
+    if (memcmp(peers[i].macAddress, macAddress, 6) == 0) {
+      peers[i].lastSeen = millis();
+      if (memcmp(lastFrameMac, macAddress, 6) == 0) {
+        peers[i].rssi = lastFrameRssi;
+      }
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&peerMux);
+}
+
+int getPeerDirectory(PeerStatus* out, int maxPeers) {
+  portENTER_CRITICAL(&peerMux);
+  int count = peerCount < maxPeers ? peerCount : maxPeers;
+  for (int i = 0; i < count; i++) {
+    out[i].number = peers[i].number;
+    memcpy(out[i].macAddress, peers[i].macAddress, 6);
+    out[i].lastSeen = peers[i].lastSeen;
+    out[i].rssi = peers[i].rssi;
+  }
+  portEXIT_CRITICAL(&peerMux);
+  return count;
+}
+
+/*
+ * New Message
+ * A message from the pool (FramePool.h) with the header filled in, or
+ * nullptr (counted as dropped) if the pool is empty
+ */
+static Message* newMessage(MessageType type, int toNumber) {
+  Message* msg = acquireMessage();
+  if (!msg) {
+    countPacket(PACKET_DROPPED, type);
+    return nullptr;
+  }
+  msg->type = type;
+  msg->fromNumber = getPhoneNumber();
+  msg->toNumber = toNumber;
+  return msg;
+}
+
+/*
+ * Send Message
+ * Every ESP-NOW send goes through transmit() so it is counted per message
+ * type. esp_now_send() copies the frame, so the message goes back to the
+ * pool right away. A nullptr from newMessage() was already counted.
+ */
+static esp_err_t transmit(const uint8_t* mac, const Message* msg, size_t length) {
+  TRACE_SCOPE(espnow_send);
+  esp_err_t result;
+  {
+    HEAP_GUARD_ALLOW();   // The Wi-Fi driver allocates the frame it queues
+    result = esp_now_send(mac, (const uint8_t*)msg, length);
+  }
+  if (msg->type == MSG_AUDIO_DATA) countAudioCopy(AUDIO_COPY_RADIO, length);
+  countPacket(result == ESP_OK ? PACKET_SENT : PACKET_DROPPED, msg->type);
+  return result;
+}
+
+static esp_err_t sendMessage(const uint8_t* mac, Message* msg, size_t length) {
+  if (!msg) return ESP_ERR_NO_MEM;
+  esp_err_t result = transmit(mac, msg, length);
+  releaseMessage(msg);
+  return result;
+}
+
+/*
+ * Start Radio
+ * 
+ * Brings up the Wi-Fi driver in STA mode and ESP-NOW, nothing more: no
+ * callbacks, no peers, no phone number needed. This is the slow part of
+ * network setup (~100ms+), so boot runs it on core 0 while the audio and
+ * the filesystem come up (see Boot.h). ESP-NOW works without a router
+ * connection, on whatever channel the radio is on: setupNetwork() moves
+ * it to the router's channel from the last boot, and once setupWifi()
+ * connects the radio follows the router's channel, where every phone on
+ * that router meets.
+ * 
+ * ESP-NOW frames go out at ESPNOW_PHY_RATE instead of the 1 Mbps default
+ * (set after the driver starts, before ESP-NOW); see Conference.h for why.
+ * 
+ * Returns: true if ESP-NOW is running (safe to call again)
+ */
+bool startRadio() {
+  if (radioStarted) return true;
+  WiFi.mode(WIFI_STA);
+  if (esp_wifi_config_espnow_rate(WIFI_IF_STA, ESPNOW_PHY_RATE) == ESP_OK) {
+    espNowRateMbps = ESPNOW_PHY_RATE_MBPS;
+  } else {
+    Serial.println("Could not set the ESP-NOW rate, staying at 1 Mbps");
+  }
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("Error initializing ESP-NOW");
+    return false;
+  }
+  radioStarted = true;
+  return true;
+}
+
+int getEspNowRateMbps() {
+  return espNowRateMbps;
+}
+
+/*
+ * Router Connected (Wi-Fi event task)
+ * 
+ * The radio has just moved to the router's channel: updateNetwork()
+ * announces this phone there and remembers the channel.
+ */
+static void onRouterConnected(arduino_event_id_t event) {
+  routerConnected = true;
+}
+
 /*
  * Setup Network
  * 
  * Initializes ESP-NOW and prepares for peer-to-peer communication.
  * 
  * Steps:
- * 1. Ensure WiFi is in STA (station) mode
- * 2. Initialize ESP-NOW protocol
- * 3. Register callback for incoming messages
+ * 1. Start the radio if boot hasn't yet (WiFi STA mode, ESP-NOW)
+ * 2. Register callback for incoming messages
+ * 3. Tune to the router's channel from the last boot (config "wifi_channel")
  * 4. Add broadcast peer (FF:FF:FF:FF:FF:FF) for discovery
  * 5. Send initial discovery broadcast
  * 
  * Why Broadcast Peer?
  * The broadcast address allows sending to all nearby devices without
  * knowing their MAC addresses in advance. Perfect for automatic discovery!
+ * 
+ * Runs before setupWifi() starts connecting: the channel can't be changed
+ * while the station is connecting.
  */
-void setupNetwork() {
-  // WiFi must be in STA mode for ESP-NOW
-  WiFi.mode(WIFI_STA);
-  
-  // Initialize ESP-NOW
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("Error initializing ESP-NOW");
-    return;
-  }
+void setupNetwork(PhoneConfig& config) {
+  if (!startRadio()) return;
+  networkConfig = &config;
   
   // Register callback for received data
   esp_now_register_recv_cb(handleIncomingMessage);
+  WiFi.onEvent(onRouterConnected, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+  
+  // Management frames only, to read the RSSI of ESP-NOW frames
+  wifi_promiscuous_filter_t filter = { .filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT };
+  esp_wifi_set_promiscuous_filter(&filter);
+  esp_wifi_set_promiscuous_rx_cb(onPromiscuousPacket);
+  esp_wifi_set_promiscuous(true);
+  
+  // Until the router connects, ESP-NOW sends on the radio's own channel;
+  // start where the other phones were last time
+  if (config.wifiChannel > 0) {
+    esp_wifi_set_channel(config.wifiChannel, WIFI_SECOND_CHAN_NONE);
+  }
   
   // Add broadcast peer for discovery
   esp_now_peer_info_t broadcastPeer;
@@ -170,15 +344,14 @@ void addPeerByMac(const uint8_t* macAddress, int phoneNumber) {
       // Peer already exists, just update the number if needed
       if (peers[i].number != phoneNumber) {
         peers[i].number = phoneNumber;
-        Serial.print("Updated peer number to: ");
-        Serial.println(phoneNumber);
+        LOG_INFO("Updated peer number to: %d", phoneNumber);
       }
       return;
     }
   }
   
   if (peerCount >= MAX_PEERS) {
-    Serial.println("Max peers reached!");
+    LOG_WARN("Max peers reached!");
     return;
   }
   
@@ -189,24 +362,24 @@ void addPeerByMac(const uint8_t* macAddress, int phoneNumber) {
   peerInfo.encrypt = false;
   
   if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-    Serial.println("Failed to add peer");
+    LOG_ERROR("Failed to add peer");
     return;
   }
   
   // Store in our peer list
+  portENTER_CRITICAL(&peerMux);
   memcpy(peers[peerCount].macAddress, macAddress, 6);
   peers[peerCount].number = phoneNumber;
   peers[peerCount].registered = true;
+  peers[peerCount].lastSeen = millis();
+  peers[peerCount].rssi = memcmp(lastFrameMac, macAddress, 6) == 0 ? lastFrameRssi : 0;
   peerCount++;
+  portEXIT_CRITICAL(&peerMux);
   
-  Serial.print("Added peer #");
-  Serial.print(phoneNumber);
-  Serial.print(" with MAC: ");
-  for (int i = 0; i < 6; i++) {
-    Serial.printf("%02X", macAddress[i]);
-    if (i < 5) Serial.print(":");
-  }
-  Serial.println();
+  // MAC as two words: the log takes at most 4 arguments
+  LOG_INFO("Added peer #%d with MAC: %04lX%08lX", phoneNumber,
+           ((uint32_t)macAddress[0] << 8) | macAddress[1],
+           ((uint32_t)macAddress[2] << 24) | ((uint32_t)macAddress[3] << 16) | ((uint32_t)macAddress[4] << 8) | macAddress[5]);
 }
 
 /*
@@ -223,35 +396,77 @@ void addPeerByMac(const uint8_t* macAddress, int phoneNumber) {
  * Frequency: Every 10 seconds
  */
 void broadcastDiscovery() {
-  Message msg;
-  msg.type = MSG_DISCOVERY;
-  msg.fromNumber = getPhoneNumber();
-  msg.toNumber = -1; // Broadcast to all
+  TRACE_SCOPE(discovery);
+  Message* msg = newMessage(MSG_DISCOVERY, -1); // Broadcast to all
   
   uint8_t broadcastAddr[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-  esp_err_t result = esp_now_send(broadcastAddr, (uint8_t*)&msg, sizeof(msg));
+  esp_err_t result = sendMessage(broadcastAddr, msg, sizeof(Message));
   
   if (result == ESP_OK) {
-    Serial.print("Discovery broadcast sent. I am phone #");
-    Serial.println(getPhoneNumber());
+    LOG_DEBUG("Discovery broadcast sent. I am phone #%d", getPhoneNumber());
   } else {
-    Serial.println("Error sending discovery broadcast");
+    LOG_WARN("Error sending discovery broadcast");
   }
   
   lastDiscoveryTime = millis();
 }
 
+/*
+ * Broadcast Message
+ * 
+ * Sends a message to FF:FF:FF:FF:FF:FF with only the used part of the
+ * payload. Broadcasts go out with no retries and every phone in range
+ * hears them, so keeping them short matters for airtime.
+ * 
+ * Parameters:
+ * - type: Message type
+ * - payload: Bytes to place in Message.data (may be nullptr if length is 0)
+ * - payloadLength: Number of payload bytes (max sizeof(Message::data))
+ */
+bool broadcastMessage(MessageType type, const uint8_t* payload, size_t payloadLength) {
+  Message* msg = newMessage(type, -1); // Broadcast to all
+  if (!msg) return false;
+  
+  if (payloadLength > sizeof(msg->data)) {
+    payloadLength = sizeof(msg->data);
+  }
+  if (payloadLength > 0) {
+    memcpy(msg->data, payload, payloadLength);
+  }
+  
+  uint8_t broadcastAddr[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  return sendMessage(broadcastAddr, msg, MESSAGE_HEADER_SIZE + payloadLength) == ESP_OK;
+}
+
 /*
  * Update Network
  * 
  * Called continuously from main loop to maintain network presence.
- * Sends periodic discovery broadcasts so other phones know we're alive.
+ * Sends periodic discovery broadcasts so other phones know we're alive,
+ * and one right after every router connect, on the router's channel.
  */
 void updateNetwork() {
+  if (routerConnected) {
+    routerConnected = false;
+    broadcastDiscovery();
+    int channel = WiFi.channel();
+    if (networkConfig && channel != networkConfig->wifiChannel) {
+      LOG_INFO("Router channel %d (was %d), saving it for the next boot", channel, networkConfig->wifiChannel);
+      networkConfig->wifiChannel = channel;
+      channelSaveNeeded = true;
+    }
+  }
+
   // Periodically broadcast our presence
   if (millis() - lastDiscoveryTime > DISCOVERY_INTERVAL) {
     broadcastDiscovery();
   }
+
+  // Like the volume: rewriting config.json can stall, so only once idle
+  if (channelSaveNeeded && getCurrentState() == IDLE) {
+    channelSaveNeeded = false;
+    saveConfiguration(*networkConfig);
+  }
 }
 
 /*
@@ -272,32 +487,25 @@ void updateNetwork() {
  * Note: If peer isn't found, call fails. Discovery must happen first!
  */
 bool sendCallRequest(int targetNumber) {
-  Serial.print("Sending call request to: ");
-  Serial.println(targetNumber);
+  LOG_INFO("Sending call request to: %d", targetNumber);
   
   // Find the peer with this number
   for (int i = 0; i < peerCount; i++) {
     if (peers[i].registered && peers[i].number == targetNumber) {
-      Message msg;
-      msg.type = MSG_CALL_REQUEST;
-      msg.fromNumber = getPhoneNumber();
-      msg.toNumber = targetNumber;
-      
-      esp_err_t result = esp_now_send(peers[i].macAddress, (uint8_t*)&msg, sizeof(msg));
+      Message* msg = newMessage(MSG_CALL_REQUEST, targetNumber);
+      esp_err_t result = sendMessage(peers[i].macAddress, msg, sizeof(Message));
       if (result == ESP_OK) {
-        Serial.println("Call request sent");
+        LOG_INFO("Call request sent");
         currentCallPeer = targetNumber;
         return true;
       } else {
-        Serial.println("Error sending call request");
+        LOG_ERROR("Error sending call request");
         return false;
       }
     }
   }
   
-  Serial.print("Peer #");
-  Serial.print(targetNumber);
-  Serial.println(" not found!");
+  LOG_WARN("Peer #%d not found!", targetNumber);
   return false;
 }
 
@@ -308,17 +516,12 @@ bool sendCallRequest(int targetNumber) {
  * Sent in response to MSG_CALL_REQUEST when user lifts handset.
  */
 void sendCallAccept(int targetNumber) {
-  Serial.print("Sending call accept to: ");
-  Serial.println(targetNumber);
+  LOG_INFO("Sending call accept to: %d", targetNumber);
   
   for (int i = 0; i < peerCount; i++) {
     if (peers[i].registered && peers[i].number == targetNumber) {
-      Message msg;
-      msg.type = MSG_CALL_ACCEPT;
-      msg.fromNumber = getPhoneNumber();
-      msg.toNumber = targetNumber;
-      
-      esp_now_send(peers[i].macAddress, (uint8_t*)&msg, sizeof(msg));
+      Message* msg = newMessage(MSG_CALL_ACCEPT, targetNumber);
+      sendMessage(peers[i].macAddress, msg, sizeof(Message));
       currentCallPeer = targetNumber;
       return;
     }
@@ -332,17 +535,12 @@ void sendCallAccept(int targetNumber) {
  * Sent when receiving a call while already in another call.
  */
 void sendCallBusy(int targetNumber) {
-  Serial.print("Sending busy signal to: ");
-  Serial.println(targetNumber);
+  LOG_INFO("Sending busy signal to: %d", targetNumber);
   
   for (int i = 0; i < peerCount; i++) {
     if (peers[i].registered && peers[i].number == targetNumber) {
-      Message msg;
-      msg.type = MSG_CALL_BUSY;
-      msg.fromNumber = getPhoneNumber();
-      msg.toNumber = targetNumber;
-      
-      esp_now_send(peers[i].macAddress, (uint8_t*)&msg, sizeof(msg));
+      Message* msg = newMessage(MSG_CALL_BUSY, targetNumber);
+      sendMessage(peers[i].macAddress, msg, sizeof(Message));
       return;
     }
   }
@@ -355,18 +553,15 @@ void sendCallBusy(int targetNumber) {
  * Sent when user hangs up the handset.
  */
 void sendCallEnd(int targetNumber) {
-  Serial.print("Sending call end to: ");
-  Serial.println(targetNumber);
+  LOG_INFO("Sending call end to: %d", targetNumber);
   
   for (int i = 0; i < peerCount; i++) {
     if (peers[i].registered && peers[i].number == targetNumber) {
-      Message msg;
-      msg.type = MSG_CALL_END;
-      msg.fromNumber = getPhoneNumber();
-      msg.toNumber = targetNumber;
-      
-      esp_now_send(peers[i].macAddress, (uint8_t*)&msg, sizeof(msg));
-      currentCallPeer = -1;
+      Message* msg = newMessage(MSG_CALL_END, targetNumber);
+      sendMessage(peers[i].macAddress, msg, sizeof(Message));
+      if (targetNumber == currentCallPeer) {
+        currentCallPeer = -1;
+      }
       return;
     }
   }
@@ -387,30 +582,101 @@ void sendCallEnd(int targetNumber) {
 void sendAudioData(const int16_t* audioBuffer, size_t samples) {
   // Only send if we're in a call
   if (currentCallPeer == -1) return;
+  HEAP_GUARD_SCOPE(HEAP_GUARD_NETWORK);
   
   // Find peer MAC address
   for (int i = 0; i < peerCount; i++) {
     if (peers[i].registered && peers[i].number == currentCallPeer) {
-      Message msg;
-      msg.type = MSG_AUDIO_DATA;
-      msg.fromNumber = getPhoneNumber();
-      msg.toNumber = currentCallPeer;
+      Message* msg = newMessage(MSG_AUDIO_DATA, currentCallPeer);
+      if (!msg) return;   // Pool empty: this frame is dropped
       
       // Copy audio samples to message data field
       // Each sample is 2 bytes (16-bit), max 100 samples = 200 bytes
       size_t bytesToCopy = samples * sizeof(int16_t);
-      if (bytesToCopy > sizeof(msg.data)) {
-        bytesToCopy = sizeof(msg.data);
+      if (bytesToCopy > sizeof(msg->data)) {
+        bytesToCopy = sizeof(msg->data);
       }
-      memcpy(msg.data, audioBuffer, bytesToCopy);
+      memcpy(msg->data, audioBuffer, bytesToCopy);
+      countAudioCopy(AUDIO_COPY_PAYLOAD, bytesToCopy);
       
       // Send via ESP-NOW (no error checking for speed)
-      esp_now_send(peers[i].macAddress, (uint8_t*)&msg, sizeof(msg));
+      sendMessage(peers[i].macAddress, msg, sizeof(Message));
       return;
     }
   }
 }
 
+/*
+ * Send Audio Frame
+ * 
+ * Zero-copy version of sendAudioData(): the samples are already the
+ * payload of the frame's message (FramePool.h), so only the header is
+ * filled in and the frame goes out as it is. The caller keeps its
+ * reference; other owners (the recorder) only read the samples.
+ */
+void sendAudioFrame(AudioFrame* frame) {
+  if (currentCallPeer == -1 || !frame) return;
+  HEAP_GUARD_SCOPE(HEAP_GUARD_NETWORK);
+  
+  for (int i = 0; i < peerCount; i++) {
+    if (peers[i].registered && peers[i].number == currentCallPeer) {
+      Message& msg = frame->message;
+      msg.type = MSG_AUDIO_DATA;
+      msg.fromNumber = getPhoneNumber();
+      msg.toNumber = currentCallPeer;
+      transmit(peers[i].macAddress, &msg, MESSAGE_HEADER_SIZE + frame->count * sizeof(int16_t));
+      return;
+    }
+  }
+}
+
+/*
+ * Send Audio Data To
+ * 
+ * Same as sendAudioData() but addressed to an explicit phone number.
+ * Used by the conference bridge to send each leg its own mix.
+ */
+void sendAudioDataTo(int targetNumber, const int16_t* audioBuffer, size_t samples) {
+  HEAP_GUARD_SCOPE(HEAP_GUARD_NETWORK);
+  for (int i = 0; i < peerCount; i++) {
+    if (peers[i].registered && peers[i].number == targetNumber) {
+      Message* msg = newMessage(MSG_AUDIO_DATA, targetNumber);
+      if (!msg) return;
+      
+      size_t bytesToCopy = samples * sizeof(int16_t);
+      if (bytesToCopy > sizeof(msg->data)) {
+        bytesToCopy = sizeof(msg->data);
+      }
+      memcpy(msg->data, audioBuffer, bytesToCopy);
+      countAudioCopy(AUDIO_COPY_PAYLOAD, bytesToCopy);
+      
+      sendMessage(peers[i].macAddress, msg, sizeof(Message));
+      return;
+    }
+  }
+}
+
+/*
+ * Send Conference Invite
+ * 
+ * Sends a MSG_CALL_REQUEST to another phone while we are already in a call.
+ * Unlike sendCallRequest(), currentCallPeer is left untouched - the invited
+ * phone only becomes a conference leg once it answers.
+ */
+bool sendConferenceInvite(int targetNumber) {
+  LOG_INFO("Sending conference invite to: %d", targetNumber);
+  
+  for (int i = 0; i < peerCount; i++) {
+    if (peers[i].registered && peers[i].number == targetNumber) {
+      Message* msg = newMessage(MSG_CALL_REQUEST, targetNumber);
+      return sendMessage(peers[i].macAddress, msg, sizeof(Message)) == ESP_OK;
+    }
+  }
+  
+  LOG_WARN("Peer #%d not found!", targetNumber);
+  return false;
+}
+
 /*
  * Handle Incoming Message
  * 
@@ -419,7 +685,7 @@ void sendAudioData(const int16_t* audioBuffer, size_t samples) {
  * Parameters:
  * - mac: Sender's MAC address (used for discovery)
  * - data: Message payload
- * - len: Message length (validated against expected size)
+ * - len: Message length (header plus however much payload was sent)
  * 
  * Message Processing:
  * - MSG_DISCOVERY: Add sender to peer list
@@ -428,31 +694,38 @@ void sendAudioData(const int16_t* audioBuffer, size_t samples) {
  * - MSG_CALL_REJECT: Call declined → return to IDLE
  * - MSG_CALL_END: Peer hung up → return to IDLE
  * - MSG_AUDIO_DATA: Voice data (TODO: implement streaming)
+ * - MSG_PAGE_AUDIO/MSG_PAGE_END: Paging broadcast → Paging.cpp
  * 
  * Security Note:
  * Messages check toNumber to ensure they're intended for this phone.
  * Discovery broadcasts have toNumber=-1 (everyone processes them).
  */
 void handleIncomingMessage(const uint8_t *mac, const uint8_t *data, int len) {
-  if (len != sizeof(Message)) {
-    Serial.println("Invalid message size");
+  TRACE_SCOPE(espnow_rx);
+  if (len < (int)MESSAGE_HEADER_SIZE || len > (int)sizeof(Message)) {
+    countMetric(METRIC_PACKETS_INVALID);
+    LOG_WARN("Invalid message size: %d", len);
     return;
   }
   
   Message* msg = (Message*)data;
+  countPacket(PACKET_RECEIVED, msg->type);
+  size_t payloadLength = len - MESSAGE_HEADER_SIZE;
+  notePeerSeen(mac);
+  
+  // Paging audio arrives many times per second - skip the per-message log
+  if (msg->type == MSG_PAGE_AUDIO) {
+    HEAP_GUARD_SCOPE(HEAP_GUARD_NETWORK);
+    pagingReceive(msg->fromNumber, msg->data, payloadLength);
+    return;
+  }
   
-  Serial.print("Message received. Type: ");
-  Serial.print(msg->type);
-  Serial.print(" From: ");
-  Serial.print(msg->fromNumber);
-  Serial.print(" To: ");
-  Serial.println(msg->toNumber);
+  LOG_DEBUG("Message received. Type: %d From: %d To: %d", msg->type, msg->fromNumber, msg->toNumber);
   
   switch (msg->type) {
     case MSG_DISCOVERY:
       // Another phone is announcing its presence
-      Serial.print("Discovered phone #");
-      Serial.println(msg->fromNumber);
+      LOG_DEBUG("Discovered phone #%d", msg->fromNumber);
       addPeerByMac(mac, msg->fromNumber);
       break;
       
@@ -461,12 +734,11 @@ void handleIncomingMessage(const uint8_t *mac, const uint8_t *data, int len) {
       if (msg->toNumber != getPhoneNumber()) {
         return;
       }
-      Serial.print("Incoming call from: ");
-      Serial.println(msg->fromNumber);
+      LOG_INFO("Incoming call from: %d", msg->fromNumber);
       
       // Check if we're already in a call
-      if (getCurrentState() == IN_CALL || getCurrentState() == RINGING) {
-        Serial.println("Already busy, sending busy signal");
+      if (getCurrentState() == IN_CALL || getCurrentState() == RINGING || getCurrentState() == VOICEMAIL) {
+        LOG_INFO("Already busy, sending busy signal");
         sendCallBusy(msg->fromNumber);
         return;
       }
@@ -477,38 +749,71 @@ void handleIncomingMessage(const uint8_t *mac, const uint8_t *data, int len) {
       
     case MSG_CALL_ACCEPT:
       if (msg->toNumber != getPhoneNumber()) return;
-      Serial.println("Call accepted!");
+      // An invited phone joining our call?
+      if (conferenceHandleAccept(msg->fromNumber)) break;
+      LOG_INFO("Call accepted!");
       changeState(IN_CALL);
       break;
       
     case MSG_CALL_BUSY:
       if (msg->toNumber != getPhoneNumber()) return;
-      Serial.println("Called party is busy");
+      // A busy invitee must not interrupt the call we are already in
+      if (conferenceHandleBusy(msg->fromNumber)) break;
+      LOG_INFO("Called party is busy");
       currentCallPeer = -1;
       changeState(CALL_BUSY);
       break;
       
     case MSG_CALL_REJECT:
       if (msg->toNumber != getPhoneNumber()) return;
-      Serial.println("Call rejected");
+      LOG_INFO("Call rejected");
       changeState(IDLE);
       break;
       
-    case MSG_CALL_END:
+    case MSG_CALL_END: {
       if (msg->toNumber != getPhoneNumber()) return;
-      Serial.println("Call ended by peer");
+      // A conference leg leaving doesn't end the call for everyone else
+      int remainingPeer = conferenceHandleLeave(msg->fromNumber);
+      if (remainingPeer >= 0) {
+        if (msg->fromNumber == currentCallPeer) {
+          currentCallPeer = remainingPeer;
+        }
+        break;
+      }
+      LOG_INFO("Call ended by peer");
       currentCallPeer = -1;
       changeState(IDLE);
       break;
+    }
       
-    case MSG_AUDIO_DATA:
+    case MSG_AUDIO_DATA: {
       if (msg->toNumber != getPhoneNumber()) return;
+      HEAP_GUARD_SCOPE(HEAP_GUARD_NETWORK);
       // Extract audio samples from message and play through speaker
       // msg->data contains up to 100 samples (200 bytes) of 16-bit audio
       int16_t* audioSamples = (int16_t*)msg->data;
-      size_t sampleCount = sizeof(msg->data) / sizeof(int16_t);
+      size_t sampleCount = payloadLength / sizeof(int16_t);
+      // Conference host: queue for the mixer instead of playing directly
+      if (isConferenceActive() && conferenceReceiveAudio(msg->fromNumber, audioSamples, sampleCount)) {
+        break;
+      }
+      recordRxAudio(audioSamples, sampleCount);
+      // Answering machine: the handset is on the cradle, only record
+      if (getCurrentState() == VOICEMAIL) break;
+      if (isSpeakerphoneActive()) {
+        speakerphoneReceive(audioSamples, sampleCount);  // Voice switch, then the ringer
+        break;
+      }
       writeAudioBuffer(audioSamples, sampleCount);
       break;
+    }
+      
+    case MSG_PAGE_END:
+      pagingEnd(msg->fromNumber, msg->data, payloadLength);
+      break;
+      
+    default:
+      break;
   }
 }
 
@@ -10,6 +10,8 @@
  * - MSG_CALL_REJECT: Decline an incoming call
  * - MSG_CALL_END: Hang up an active call
  * - MSG_AUDIO_DATA: Voice data packet (future implementation)
+ * - MSG_PAGE_AUDIO: Broadcast announcement audio (IMA-ADPCM, 8kHz)
+ * - MSG_PAGE_END: Broadcast announcement finished
  * 
  * Message Structure:
  * - type: One of the MessageType enums
@@ -17,6 +19,9 @@
  * - toNumber: Recipient's phone number (-1 for broadcast)
  * - data: Payload (200 bytes, used for audio or other data)
  * 
+ * Messages may be sent shorter than sizeof(Message): only the header plus
+ * the used part of data goes on the air (see broadcastMessage()).
+ * 
  * Key Features:
  * - Automatic peer discovery (no manual MAC configuration)
  * - Direct peer-to-peer communication (low latency)
@@ -27,6 +32,7 @@
 #ifndef NETWORK_H
 #define NETWORK_H
 
+#include "Configuration.h"
 #include <esp_now.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -42,7 +48,9 @@ enum MessageType {
   MSG_CALL_REJECT,    // "I declined your call"
   MSG_CALL_BUSY,      // "I'm already in a call"
   MSG_CALL_END,       // "I'm hanging up"
-  MSG_AUDIO_DATA      // Voice data packet (for future audio streaming)
+  MSG_AUDIO_DATA,     // Voice data packet (for future audio streaming)
+  MSG_PAGE_AUDIO,     // Paging audio broadcast to every phone
+  MSG_PAGE_END        // Paging finished
 };
 
 // Message structure (sent via ESP-NOW)
@@ -53,8 +61,24 @@ struct Message {
   uint8_t data[200];  // Payload for audio or other data
 };
 
-// Initialize ESP-NOW and start discovery
-void setupNetwork();
+// Bytes before the payload - the shortest valid message
+#define MESSAGE_HEADER_SIZE offsetof(Message, data)
+
+// ESP-NOW PHY rate (set by startRadio). The 1 Mbps default spends ~2ms on
+// every 212-byte audio frame; at 24 Mbps OFDM it is ~105µs, so a
+// conference host's 2 × legs streams fit on the air
+#define ESPNOW_PHY_RATE WIFI_PHY_RATE_24M
+#define ESPNOW_PHY_RATE_MBPS 24
+
+// Wi-Fi driver in STA mode and ESP-NOW only (boot runs it early, on core 0)
+bool startRadio();
+
+// ESP-NOW PHY rate in use: ESPNOW_PHY_RATE_MBPS, or 1 if it couldn't be set
+int getEspNowRateMbps();
+
+// Initialize ESP-NOW (if startRadio hasn't), tune to the router channel
+// from the last boot and start discovery; keeps the config to save a new one
+void setupNetwork(PhoneConfig& config);
 
 // Setup Wi-Fi connection (required for ESP-NOW to work reliably)
 void setupWifi(const char* ssid, const char* password);
@@ -68,6 +92,10 @@ void addPeerByMac(const uint8_t* macAddress, int phoneNumber);
 // Broadcast our phone number to all nearby devices
 void broadcastDiscovery();
 
+// Broadcast a message with a variable-length payload to every phone
+// Only MESSAGE_HEADER_SIZE + payloadLength bytes are transmitted
+bool broadcastMessage(MessageType type, const uint8_t* payload, size_t payloadLength);
+
 // Send call request to a specific phone number
 // Returns true if peer found and message sent, false if peer not found
 bool sendCallRequest(int targetNumber);
@@ -84,12 +112,36 @@ void sendCallEnd(int targetNumber);
 // Send audio data to peer during call
 void sendAudioData(const int16_t* audioBuffer, size_t samples);
 
+// Send a pooled audio frame to the peer without copying its samples (FramePool.h)
+struct AudioFrame;
+void sendAudioFrame(AudioFrame* frame);
+
+// Send audio data to a specific phone (conference legs)
+void sendAudioDataTo(int targetNumber, const int16_t* audioBuffer, size_t samples);
+
+// Invite another phone into the current call (does not change currentCallPeer)
+// Returns true if peer found and message sent
+bool sendConferenceInvite(int targetNumber);
+
 // Callback for incoming ESP-NOW messages
 void handleIncomingMessage(const uint8_t *mac, const uint8_t *data, int len);
 
 // Get the phone number we're currently in a call with
 int getCurrentCallPeer();
 
+#define MAX_PEERS 10              // Phones remembered in the peer directory
+
+// One entry of the peer directory (for the web interface / API)
+struct PeerStatus {
+  int number;
+  uint8_t macAddress[6];
+  unsigned long lastSeen;   // millis() of the last message from this phone
+  int8_t rssi;              // Signal strength of that message (dBm, 0 = unknown)
+};
+
+// Copy the peer directory, returns the number of peers
+int getPeerDirectory(PeerStatus* out, int maxPeers);
+
 // Maintain network presence (call periodically from main loop)
 void updateNetwork();
 
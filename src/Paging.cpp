@@ -0,0 +1,276 @@
+/*
+ * Paging - One-to-Many Intercom Broadcast
+ *
+ * Sender (PAGING state):
+ *   mic 16kHz ──► downsample 2x ──► collect 160 samples ──► IMA-ADPCM ──► broadcast
+ *
+ * Receiver (IDLE state only):
+ *   ESP-NOW callback ──► sequence check ──► IMA-ADPCM decode ──► upsample 2x ──► ringer (I2S1)
+ *
+ * Every packet starts with the encoder state it was encoded from, so a lost
+ * packet only costs its own 20ms of audio - the next one decodes cleanly.
+ *
+ * Only one page plays at a time; packets from a second sender are ignored
+ * until the first page ends.
+ */
+
+#include "Paging.h"
+#include "Codec.h"
+#include "Network.h"
+#include "Audio.h"
+#include "State.h"
+#include "Log.h"
+#include <Arduino.h>
+
+// MSG_PAGE_AUDIO payload layout
+struct __attribute__((packed)) PagePacket {
+  uint16_t sequence;
+  int16_t predictor;      // ADPCM state at the start of this packet
+  uint8_t stepIndex;
+  uint8_t reserved;
+  uint8_t adpcm[PAGE_SAMPLES_PER_PACKET / 2];
+};
+
+// MSG_PAGE_END payload layout
+struct __attribute__((packed)) PageEndPacket {
+  uint16_t packetsSent;   // Lets receivers count losses at the tail
+};
+
+// ====== Sender State ======
+static bool pagingActive = false;
+static AdpcmState encoderState;
+static int16_t pendingSamples[PAGE_SAMPLES_PER_PACKET];
+static size_t pendingCount = 0;
+static int16_t downsampleHistory = 0;
+static uint16_t sendSequence = 0;
+static unsigned long pagingStartTime = 0;
+
+// ====== Receiver State ======
+// Written by the ESP-NOW callback, read by updatePaging() in the main loop
+static portMUX_TYPE pagingMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool receivingPage = false;
+static volatile int pageSource = -1;
+static volatile unsigned long lastPacketTime = 0;
+static uint16_t expectedSequence = 0;
+static int16_t upsampleHistory = 0;
+
+// Loss accounting for the current (or last) received page
+static uint32_t pagePacketsReceived = 0;
+static uint32_t pagePacketsLost = 0;
+static uint32_t pagePacketsLate = 0;     // Out of order or duplicate (dropped)
+static uint32_t pagePacketsIgnored = 0;  // Arrived while off-hook or from a second sender
+
+/*
+ * Setup Paging
+ */
+void setupPaging() {
+  pagingActive = false;
+  receivingPage = false;
+  pageSource = -1;
+}
+
+/*
+ * Start Paging (sender)
+ * Called when the paging code is dialed.
+ */
+void startPaging() {
+  adpcmReset(encoderState);
+  pendingCount = 0;
+  downsampleHistory = 0;
+  sendSequence = 0;
+  pagingStartTime = millis();
+  pagingActive = true;
+  LOG_INFO("Paging: broadcasting to all phones - hang up to finish");
+}
+
+/*
+ * Stop Paging (sender)
+ * Tells every receiver the page is over and how many packets were sent.
+ */
+void stopPaging() {
+  if (!pagingActive) return;
+  pagingActive = false;
+
+  PageEndPacket end;
+  end.packetsSent = sendSequence;
+  broadcastMessage(MSG_PAGE_END, (const uint8_t*)&end, sizeof(end));
+
+  LOG_INFO("Paging: finished, %lu packets in %lu s", sendSequence, (millis() - pagingStartTime) / 1000);
+}
+
+/*
+ * Paging Process Frame (sender)
+ *
+ * Accepts microphone frames of any size at 16kHz. Samples are decimated to
+ * 8kHz and sent once a full 160-sample packet has been collected.
+ */
+void pagingProcessFrame(const int16_t* samples, size_t count) {
+  if (!pagingActive) return;
+
+  int16_t decimated[AUDIO_SAMPLES_PER_PACKET];
+  while (count > 0) {
+    size_t chunk = count > AUDIO_SAMPLES_PER_PACKET ? AUDIO_SAMPLES_PER_PACKET : count;
+    size_t produced = downsample2x(samples, chunk, decimated, downsampleHistory);
+    samples += chunk;
+    count -= chunk;
+
+    for (size_t i = 0; i < produced; i++) {
+      pendingSamples[pendingCount++] = decimated[i];
+      if (pendingCount < PAGE_SAMPLES_PER_PACKET) continue;
+
+      PagePacket packet;
+      packet.sequence = sendSequence++;
+      packet.predictor = encoderState.predictor;
+      packet.stepIndex = encoderState.stepIndex;
+      packet.reserved = 0;
+      adpcmEncode(encoderState, pendingSamples, PAGE_SAMPLES_PER_PACKET, packet.adpcm);
+      broadcastMessage(MSG_PAGE_AUDIO, (const uint8_t*)&packet, sizeof(packet));
+      pendingCount = 0;
+    }
+  }
+}
+
+/*
+ * Finish Received Page
+ * Prints loss statistics and silences the ringer.
+ */
+static void finishReceivedPage(const char* reason) {
+  int source;
+  portENTER_CRITICAL(&pagingMux);
+  if (!receivingPage) {
+    portEXIT_CRITICAL(&pagingMux);
+    return;
+  }
+  receivingPage = false;
+  source = pageSource;
+  pageSource = -1;
+  portEXIT_CRITICAL(&pagingMux);
+
+  LOG_INFO("Page from #%d %s: %lu received, %lu lost", source, reason, pagePacketsReceived, pagePacketsLost);
+  LOG_INFO("Page from #%d: %lu late", source, pagePacketsLate);
+  clearRingerAudio();
+}
+
+/*
+ * Paging Receive (receiver, ESP-NOW callback)
+ *
+ * Plays the packet on the ringer if this phone is on-hook.
+ * Sequence gaps are counted as losses; old or duplicate packets are dropped.
+ */
+void pagingReceive(int fromNumber, const uint8_t* payload, size_t length) {
+  if (length < sizeof(PagePacket)) return;
+
+  if (getCurrentState() != IDLE) {
+    // Handset lifted (or busy) - stop playing on the ringer
+    pagePacketsIgnored++;
+    if (receivingPage) finishReceivedPage("interrupted");
+    return;
+  }
+
+  PagePacket packet;
+  memcpy(&packet, payload, sizeof(packet));
+
+  portENTER_CRITICAL(&pagingMux);
+  bool starting = !receivingPage;
+  if (starting) {
+    receivingPage = true;
+    pageSource = fromNumber;
+  } else if (pageSource != fromNumber) {
+    portEXIT_CRITICAL(&pagingMux);
+    pagePacketsIgnored++;
+    return;
+  }
+  lastPacketTime = millis();
+  portEXIT_CRITICAL(&pagingMux);
+
+  if (starting) {
+    expectedSequence = packet.sequence;
+    upsampleHistory = 0;
+    pagePacketsReceived = 0;
+    pagePacketsLost = 0;
+    pagePacketsLate = 0;
+    LOG_INFO("Page from #%d - playing on ringer", fromNumber);
+  }
+
+  int16_t gap = (int16_t)(packet.sequence - expectedSequence);
+  if (gap < 0) {
+    pagePacketsLate++;
+    return;
+  }
+  pagePacketsLost += gap;
+  pagePacketsReceived++;
+  expectedSequence = packet.sequence + 1;
+
+  AdpcmState decoder;
+  decoder.predictor = packet.predictor;
+  decoder.stepIndex = packet.stepIndex > 88 ? 88 : packet.stepIndex;
+
+  int16_t decoded[PAGE_SAMPLES_PER_PACKET];
+  int16_t output[PAGE_SAMPLES_PER_PACKET * 2];
+  adpcmDecode(decoder, packet.adpcm, PAGE_SAMPLES_PER_PACKET, decoded);
+  upsample2x(decoded, PAGE_SAMPLES_PER_PACKET, output, upsampleHistory);
+  writeRingerAudioBuffer(output, PAGE_SAMPLES_PER_PACKET * 2);
+}
+
+/*
+ * Paging End (receiver, ESP-NOW callback)
+ * The sender reports how many packets it sent so missing tail packets
+ * are counted as lost too.
+ */
+void pagingEnd(int fromNumber, const uint8_t* payload, size_t length) {
+  if (!receivingPage || pageSource != fromNumber) return;
+
+  if (length >= sizeof(PageEndPacket)) {
+    PageEndPacket end;
+    memcpy(&end, payload, sizeof(end));
+    int16_t tail = (int16_t)(end.packetsSent - expectedSequence);
+    if (tail > 0) {
+      pagePacketsLost += tail;
+    }
+  }
+  finishReceivedPage("ended");
+}
+
+/*
+ * Update Paging
+ * Ends a received page if the sender has gone quiet (lost MSG_PAGE_END).
+ */
+void updatePaging() {
+  if (receivingPage && millis() - lastPacketTime > PAGE_TIMEOUT_MS) {
+    finishReceivedPage("timed out");
+  }
+}
+
+bool isReceivingPage() {
+  return receivingPage;
+}
+
+/*
+ * Print Paging Stats
+ */
+void printPagingStats() {
+  Serial.println();
+  Serial.println("========== PAGING STATS ==========");
+  Serial.print("Sending: ");
+  Serial.println(pagingActive ? "yes" : "no");
+  Serial.print("Packets sent (last page): ");
+  Serial.println(sendSequence);
+  Serial.print("Receiving: ");
+  if (receivingPage) {
+    Serial.print("yes, from #");
+    Serial.println(pageSource);
+  } else {
+    Serial.println("no");
+  }
+  uint32_t expected = pagePacketsReceived + pagePacketsLost;
+  Serial.printf("Last received page: %lu received, %lu lost (%.1f%%), %lu late\n",
+                (unsigned long)pagePacketsReceived, (unsigned long)pagePacketsLost,
+                expected > 0 ? 100.0f * pagePacketsLost / expected : 0.0f,
+                (unsigned long)pagePacketsLate);
+  Serial.print("Ignored (off-hook / second sender): ");
+  Serial.println(pagePacketsIgnored);
+  Serial.printf("Packet size: %u bytes, %d packets/s\n",
+                (unsigned)(MESSAGE_HEADER_SIZE + sizeof(PagePacket)),
+                PAGE_SAMPLE_RATE / PAGE_SAMPLES_PER_PACKET);
+  Serial.println("==================================");
+}
@@ -0,0 +1,50 @@
+/*
+ * Paging.h - One-to-Many Intercom Broadcast
+ *
+ * Lift the handset and dial the paging code (900) to talk to every phone at
+ * once. Microphone audio is broadcast over ESP-NOW and every phone that is
+ * on-hook plays it on the base ringer speaker (I2S1) - nobody has to pick up.
+ *
+ * Stream format (MSG_PAGE_AUDIO payload):
+ * - 16-bit sequence number for loss accounting
+ * - IMA-ADPCM state (predictor + step index) so every packet decodes alone
+ * - 160 samples of 8kHz IMA-ADPCM (20ms, 80 bytes)
+ *
+ * Each packet is 98 bytes on the air at 50 packets/s, compared to 212 bytes
+ * at 160 packets/s for call audio, which keeps broadcast airtime bounded.
+ */
+
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PAGE_SAMPLE_RATE 8000
+#define PAGE_SAMPLES_PER_PACKET 160   // 20ms per packet at 8kHz
+#define PAGE_TIMEOUT_MS 1000          // Receiver ends the page after this much silence
+
+// Reset paging state (called once from setup)
+void setupPaging();
+
+// Sender: start/stop broadcasting
+void startPaging();
+void stopPaging();
+
+// Sender: feed one 16kHz microphone frame (called from loop while PAGING)
+void pagingProcessFrame(const int16_t* samples, size_t count);
+
+// Receiver: ESP-NOW callback hooks
+void pagingReceive(int fromNumber, const uint8_t* payload, size_t length);
+void pagingEnd(int fromNumber, const uint8_t* payload, size_t length);
+
+// Receiver: end pages whose sender went silent (call from loop)
+void updatePaging();
+
+// True while a page is playing on this phone's ringer
+bool isReceivingPage();
+
+// Diagnostics (test mode)
+void printPagingStats();
+
+#endif // PAGING_H
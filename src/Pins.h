@@ -9,7 +9,7 @@
  * - Amplifier Control: Shutdown/enable pins for dual amps
  * - Hook Switch: Detects handset on/off cradle
  * - Rotary Dial: Pulse counting and active state detection
- * - Buttons: Optional volume control (not yet implemented)
+ * - Buttons: Volume up/down (see Volume.cpp)
  * 
  * Audio Architecture:
  * - I2S0: Handset amplifier (mono output) + ICS-43434 microphone (input)
@@ -54,8 +54,8 @@
 #define ROTARY_PULSE_PIN 17   // Pulse output (generates pulses as dial returns)
 #define ROTARY_ACTIVE_PIN 18  // Dial active (LOW=dialing, HIGH=idle)
 
-// ====== Optional Buttons ======
-// Reserved for volume control (future enhancement)
+// ====== Volume Buttons ======
+// Push buttons to GND (internal pull-ups)
 #define VOL_UP_PIN 4       // Volume up button (was MIC_ADC_PIN)
 #define VOL_DOWN_PIN 5     // Volume down button
 
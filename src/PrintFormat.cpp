@@ -0,0 +1,17 @@
+/*
+ * PrintFormat - printf to a Print Without the Heap
+ */
+
+#include "PrintFormat.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+void printFormat(Print& out, const char* format, ...) {
+  char line[PRINT_FORMAT_LINE];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (length > (int)sizeof(line) - 1) length = sizeof(line) - 1;
+  if (length > 0) out.write((const uint8_t*)line, length);
+}
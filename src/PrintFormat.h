@@ -0,0 +1,22 @@
+/*
+ * PrintFormat.h - printf to a Print Without the Heap
+ *
+ * Print::printf() mallocs a buffer for any line over 64 bytes. The
+ * exporters (Prometheus metrics, trace JSON) write many longer lines
+ * from the web task, so they format on the stack instead:
+ *
+ *   printFormat(out, "%s_count %lu\n", name, count);
+ *
+ * Lines are cut at PRINT_FORMAT_LINE - 1 characters.
+ */
+
+#ifndef PRINT_FORMAT_H
+#define PRINT_FORMAT_H
+
+#include <Arduino.h>
+
+#define PRINT_FORMAT_LINE 160
+
+void printFormat(Print& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#endif // PRINT_FORMAT_H
@@ -0,0 +1,225 @@
+/*
+ * Profiler - Main Loop Profiler
+ *
+ * Marks only add to per-pass accumulators (no lock, main loop only);
+ * profileLoopStart() folds the finished pass into the histograms under a
+ * spinlock, a few microseconds once per pass. getProfileReport() takes
+ * the same lock while it summarizes, so the web task never sees half a
+ * pass.
+ */
+
+#include "Profiler.h"
+#include <Arduino.h>
+
+struct ProfileHistogram {
+  uint32_t buckets[PROFILE_BUCKETS];
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t totalUs;
+};
+
+static const char* const sectionNames[PROFILE_SECTION_COUNT] = {
+  "hook_switch", "rotary_dial", "volume", "remote_control", "tones", "network", "paging",
+  "web_snapshot", "dialing", "state_entry", "state_machine", "mic_read", "audio_send"
+};
+
+static ProfileHistogram sections[PROFILE_SECTION_COUNT];
+static ProfileHistogram period;
+static ProfileHistogram jitter;
+static unsigned long resetAt = 0;
+static portMUX_TYPE profileMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Current pass (main loop only)
+static uint32_t passUs[PROFILE_SECTION_COUNT];
+static uint32_t touched = 0;                // Bit per section marked this pass
+static uint32_t lastPassUs[PROFILE_SECTION_COUNT];
+static uint32_t lastTouched = 0;
+static uint32_t passStartUs = 0;
+static uint32_t lastMarkUs = 0;
+static bool passPaced = false;
+static uint32_t lastPeriodUs = 0;           // 0 = no paced pass before this one
+
+static int bucketFor(uint32_t us) {
+  int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+  return bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1;
+}
+
+uint32_t profileBucketFloorUs(int bucket) {
+  return bucket == 0 ? 0 : 1UL << (bucket - 1);
+}
+
+static void observe(ProfileHistogram& histogram, uint32_t us) {
+  histogram.buckets[bucketFor(us)]++;
+  histogram.count++;
+  histogram.totalUs += us;
+  if (us > histogram.maxUs) histogram.maxUs = us;
+}
+
+void profileLoopStart(bool paced) {
+  uint32_t now = micros();
+  portENTER_CRITICAL(&profileMux);
+  for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+    if (touched & (1UL << i)) observe(sections[i], passUs[i]);
+  }
+  if (passStartUs != 0 && passPaced && paced) {
+    uint32_t periodUs = now - passStartUs;
+    observe(period, periodUs);
+    if (lastPeriodUs != 0) {
+      observe(jitter, periodUs > lastPeriodUs ? periodUs - lastPeriodUs : lastPeriodUs - periodUs);
+    }
+    lastPeriodUs = periodUs;
+  } else {
+    lastPeriodUs = 0;
+  }
+  portEXIT_CRITICAL(&profileMux);
+
+  memcpy(lastPassUs, passUs, sizeof(lastPassUs));
+  lastTouched = touched;
+  touched = 0;
+  passStartUs = now;
+  lastMarkUs = now;
+  passPaced = paced;
+}
+
+void profileMark(ProfileSection section) {
+  uint32_t now = micros();
+  uint32_t elapsed = now - lastMarkUs;
+  if (touched & (1UL << section)) {
+    passUs[section] += elapsed;
+  } else {
+    passUs[section] = elapsed;
+    touched |= 1UL << section;
+  }
+  lastMarkUs = now;
+}
+
+const char* profileSlowestSection(uint32_t* us) {
+  int slowest = -1;
+  uint32_t slowestUs = 0;
+  for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+    if (i == PROFILE_MIC_READ) continue;   // Waiting, not working
+    uint32_t current = (touched & (1UL << i)) ? passUs[i] : 0;
+    uint32_t previous = (lastTouched & (1UL << i)) ? lastPassUs[i] : 0;
+    uint32_t longest = current > previous ? current : previous;
+    if (longest > slowestUs || slowest < 0) {
+      slowest = i;
+      slowestUs = longest;
+    }
+  }
+  if (us) *us = slowestUs;
+  return (touched | lastTouched) ? sectionNames[slowest] : nullptr;
+}
+
+// Upper bound of the bucket where the cumulative count reaches `fraction`
+static uint32_t percentile(const ProfileHistogram& histogram, uint32_t perMille) {
+  if (histogram.count == 0) return 0;
+  uint32_t target = ((uint64_t)histogram.count * perMille + 999) / 1000;
+  uint32_t seen = 0;
+  for (int b = 0; b < PROFILE_BUCKETS; b++) {
+    seen += histogram.buckets[b];
+    if (seen >= target) {
+      uint32_t upper = b == PROFILE_BUCKETS - 1 ? histogram.maxUs : (1UL << b) - 1;
+      return upper < histogram.maxUs ? upper : histogram.maxUs;
+    }
+  }
+  return histogram.maxUs;
+}
+
+static void summarize(const ProfileHistogram& histogram, const char* name, uint64_t allUs, ProfileSummary& out) {
+  out.name = name;
+  out.count = histogram.count;
+  out.averageUs = histogram.count ? histogram.totalUs / histogram.count : 0;
+  out.p50Us = percentile(histogram, 500);
+  out.p99Us = percentile(histogram, 990);
+  out.maxUs = histogram.maxUs;
+  out.sharePermille = allUs ? histogram.totalUs * 1000 / allUs : 0;
+}
+
+void getProfileReport(ProfileReport& report) {
+  portENTER_CRITICAL(&profileMux);
+  uint64_t allUs = 0;
+  for (int i = 0; i < PROFILE_SECTION_COUNT; i++) allUs += sections[i].totalUs;
+  for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+    summarize(sections[i], sectionNames[i], allUs, report.sections[i]);
+  }
+  summarize(period, "period", 0, report.period);
+  summarize(jitter, "jitter", 0, report.jitter);
+  memcpy(report.periodBuckets, period.buckets, sizeof(report.periodBuckets));
+  memcpy(report.jitterBuckets, jitter.buckets, sizeof(report.jitterBuckets));
+  portEXIT_CRITICAL(&profileMux);
+  report.elapsedMs = millis() - resetAt;
+
+  // Worst offenders: longest single pass. The microphone read is left out,
+  // its time is spent waiting for the next packet of audio.
+  for (int w = 0; w < PROFILE_WORST; w++) {
+    report.worst[w] = -1;
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+      if (i == PROFILE_MIC_READ || report.sections[i].count == 0) continue;
+      bool taken = false;
+      for (int k = 0; k < w; k++) taken |= report.worst[k] == i;
+      if (taken) continue;
+      if (report.worst[w] < 0 || report.sections[i].maxUs > report.sections[report.worst[w]].maxUs) {
+        report.worst[w] = i;
+      }
+    }
+  }
+}
+
+void resetProfile() {
+  portENTER_CRITICAL(&profileMux);
+  memset(sections, 0, sizeof(sections));
+  memset(&period, 0, sizeof(period));
+  memset(&jitter, 0, sizeof(jitter));
+  portEXIT_CRITICAL(&profileMux);
+  resetAt = millis();
+}
+
+static void printBuckets(const char* label, const uint32_t* buckets) {
+  Serial.print(label);
+  for (int b = 0; b < PROFILE_BUCKETS; b++) {
+    if (buckets[b] == 0) continue;
+    Serial.printf(" >=%luus:%lu", (unsigned long)profileBucketFloorUs(b), (unsigned long)buckets[b]);
+  }
+  Serial.println();
+}
+
+void printProfile() {
+  static ProfileReport report;
+  getProfileReport(report);
+
+  Serial.println();
+  Serial.println("============== MAIN LOOP PROFILE ==============");
+  Serial.printf("Over the last %lu s (test profile reset to restart)\n", (unsigned long)(report.elapsedMs / 1000));
+  Serial.println("section           passes     avg     p50     p99     max  share   (us)");
+  for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+    const ProfileSummary& s = report.sections[i];
+    Serial.printf("%-16s %8lu %7lu %7lu %7lu %7lu %4lu.%lu%%\n", s.name, (unsigned long)s.count,
+                  (unsigned long)s.averageUs, (unsigned long)s.p50Us, (unsigned long)s.p99Us,
+                  (unsigned long)s.maxUs, (unsigned long)(s.sharePermille / 10), (unsigned long)(s.sharePermille % 10));
+  }
+  Serial.println("(p50/p99 are bucket upper bounds; mic_read is mostly waiting for audio)");
+
+  Serial.println();
+  if (report.period.count == 0) {
+    Serial.println("Period: no paced passes yet (make a call)");
+  } else {
+    Serial.printf("Period (paced, 6250 us expected): avg %lu, p99 %lu, max %lu us over %lu passes\n",
+                  (unsigned long)report.period.averageUs, (unsigned long)report.period.p99Us,
+                  (unsigned long)report.period.maxUs, (unsigned long)report.period.count);
+    printBuckets("  ", report.periodBuckets);
+    Serial.printf("Jitter (change between periods): avg %lu, p99 %lu, max %lu us\n",
+                  (unsigned long)report.jitter.averageUs, (unsigned long)report.jitter.p99Us,
+                  (unsigned long)report.jitter.maxUs);
+    printBuckets("  ", report.jitterBuckets);
+  }
+
+  Serial.println();
+  Serial.print("Worst offenders (longest pass):");
+  for (int w = 0; w < PROFILE_WORST; w++) {
+    if (report.worst[w] < 0) break;
+    const ProfileSummary& s = report.sections[report.worst[w]];
+    Serial.printf(" %s %lu us%s", s.name, (unsigned long)s.maxUs, w < PROFILE_WORST - 1 ? "," : "");
+  }
+  Serial.println();
+  Serial.println("===============================================");
+}
@@ -0,0 +1,89 @@
+/*
+ * Profiler.h - Main Loop Profiler
+ *
+ * Times every part of loop() on every pass, into log2 histograms:
+ *
+ *   profileLoopStart(paced)      top of loop(): closes the previous pass
+ *   handleHookSwitch();
+ *   profileMark(PROFILE_HOOK_SWITCH);    time since the previous mark
+ *   handleRotaryDial();
+ *   profileMark(PROFILE_ROTARY_DIAL);
+ *   ...
+ *
+ * A section marked more than once in a pass is summed, so each histogram
+ * holds per-pass times. Bucket b counts times of 2^(b-1) .. 2^b - 1 us,
+ * so 1us to over 262ms fits in 20 counters per section.
+ *
+ * While the microphone paces the loop (call, paging, answering machine)
+ * the pass period and its jitter (change from one period to the next)
+ * are recorded too: one pass should take one packet, 6.25ms.
+ *
+ * Everything is updated from the main loop only. Readers (test mode, the
+ * web task) take a consistent copy with getProfileReport().
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#define PROFILE_BUCKETS 20
+#define PROFILE_WORST 3              // Sections in the worst-offender list
+
+enum ProfileSection {
+  PROFILE_HOOK_SWITCH,
+  PROFILE_ROTARY_DIAL,
+  PROFILE_VOLUME,
+  PROFILE_REMOTE_CONTROL,
+  PROFILE_TONES,
+  PROFILE_NETWORK,
+  PROFILE_PAGING,
+  PROFILE_WEB_SNAPSHOT,
+  PROFILE_DIALING,                   // On-hook and off-hook dialing logic
+  PROFILE_STATE_ENTRY,               // State entry/exit actions
+  PROFILE_STATE_MACHINE,             // Per-state work (tones, ringtone, prompts, conference)
+  PROFILE_MIC_READ,                  // Waits for the I2S DMA - paces the loop
+  PROFILE_AUDIO_SEND,                // Voice switch, recorder, mixer, ESP-NOW send
+  PROFILE_SECTION_COUNT
+};
+
+struct ProfileSummary {
+  const char* name;
+  uint32_t count;
+  uint32_t averageUs;
+  uint32_t p50Us;                    // Upper bound of the bucket holding the median
+  uint32_t p99Us;
+  uint32_t maxUs;
+  uint32_t sharePermille;            // Of all time spent in sections
+};
+
+struct ProfileReport {
+  ProfileSummary sections[PROFILE_SECTION_COUNT];
+  ProfileSummary period;             // Paced passes only
+  ProfileSummary jitter;
+  uint32_t periodBuckets[PROFILE_BUCKETS];
+  uint32_t jitterBuckets[PROFILE_BUCKETS];
+  int worst[PROFILE_WORST];          // Sections with the longest single pass (-1 = none)
+  uint32_t elapsedMs;                // Since the last reset
+};
+
+// Main loop
+void profileLoopStart(bool paced);
+void profileMark(ProfileSection section);
+
+// Main loop: section that took longest in this pass so far or the one
+// before (for blaming a late audio frame), nullptr before the first pass
+const char* profileSlowestSection(uint32_t* us);
+
+// Consistent copy of all histograms (any task)
+void getProfileReport(ProfileReport& report);
+
+// Lowest time of a bucket (for labels)
+uint32_t profileBucketFloorUs(int bucket);
+
+void resetProfile();
+
+// Diagnostics (test mode)
+void printProfile();
+
+#endif // PROFILER_H
@@ -0,0 +1,129 @@
+/*
+ * RemoteControl - Call Control from the Web Interface
+ *
+ * The queue is the only thing the web task touches. Everything else runs
+ * in the main loop, so remote commands can never race the hook switch,
+ * the dial or the state machine.
+ *
+ * Digits are fed one at a time: the next one only after the main loop
+ * has taken the previous one (getDialedDigit() back to -1), at least
+ * REMOTE_DIGIT_GAP_MS apart and not in the pass that changed state, so
+ * the state entry code (startDialing()) always runs first.
+ */
+
+#include "RemoteControl.h"
+#include "State.h"
+#include "HookSwitch.h"
+#include "RotaryDial.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+struct RemoteCommand {
+  RemoteCommandType type;
+  int number;
+};
+
+static QueueHandle_t commandQueue = NULL;
+
+static char pendingDigits[8] = "";   // Still to dial, most significant first
+static int pendingIndex = 0;
+static unsigned long lastDigitAt = 0;
+
+static uint32_t commandsQueued = 0;
+static uint32_t commandsRejected = 0;
+static uint32_t digitsInjected = 0;
+
+void setupRemoteControl() {
+  commandQueue = xQueueCreate(REMOTE_QUEUE_COMMANDS, sizeof(RemoteCommand));
+}
+
+bool queueRemoteCommand(RemoteCommandType type, int number) {
+  RemoteCommand command = {type, number};
+  if (commandQueue == NULL || xQueueSend(commandQueue, &command, 0) != pdTRUE) {
+    commandsRejected++;
+    return false;
+  }
+  commandsQueued++;
+  return true;
+}
+
+static bool canDial(PhoneState state) {
+  return state == IDLE || state == OFF_HOOK || state == DIALING || state == IN_CALL;
+}
+
+static void runCommand(const RemoteCommand& command) {
+  PhoneState state = getCurrentState();
+  switch (command.type) {
+    case REMOTE_DIAL:
+      if (!canDial(state)) {
+        LOG_INFO("Remote dial ignored in state %s", getStateName(state));
+        return;
+      }
+      LOG_INFO("Remote dial: %d", command.number);
+      snprintf(pendingDigits, sizeof(pendingDigits), "%d", command.number);
+      pendingIndex = 0;
+      lastDigitAt = millis();
+      if (state == IDLE) liftHandset();
+      break;
+
+    case REMOTE_ANSWER:
+      if (state != RINGING && state != VOICEMAIL) {
+        LOG_INFO("Remote answer ignored - not ringing");
+        return;
+      }
+      LOG_INFO("Remote answer");
+      liftHandset();
+      break;
+
+    case REMOTE_HANGUP:
+      LOG_INFO("Remote hang up");
+      pendingDigits[0] = '\0';
+      hangUp();
+      break;
+  }
+}
+
+/*
+ * Feed Digits
+ * One pending digit per call, once the previous one has been collected
+ */
+static void feedDigits() {
+  if (pendingDigits[pendingIndex] == '\0') return;
+
+  PhoneState state = getCurrentState();
+  if (state != OFF_HOOK && state != DIALING && state != IN_CALL) {
+    pendingDigits[0] = '\0';   // Call attempt ended (hung up, failed)
+    pendingIndex = 0;
+    return;
+  }
+  unsigned long now = millis();
+  if (getDialedDigit() >= 0 || now - lastDigitAt < REMOTE_DIGIT_GAP_MS ||
+      now - getStateChangedAt() < REMOTE_DIGIT_GAP_MS) {
+    return;
+  }
+
+  injectDigit(pendingDigits[pendingIndex++] - '0');
+  digitsInjected++;
+  lastDigitAt = now;
+  if (pendingDigits[pendingIndex] == '\0') {
+    pendingDigits[0] = '\0';
+    pendingIndex = 0;
+  }
+}
+
+void handleRemoteControl() {
+  RemoteCommand command;
+  // A new command waits until the digits of the last dial are out
+  if (pendingDigits[0] == '\0' && commandQueue != NULL &&
+      xQueueReceive(commandQueue, &command, 0) == pdTRUE) {
+    runCommand(command);
+  }
+  feedDigits();
+}
+
+void printRemoteControlStats() {
+  Serial.printf("Remote control: %lu commands queued, %lu rejected (queue full), %lu digits dialed\n",
+                (unsigned long)commandsQueued, (unsigned long)commandsRejected, (unsigned long)digitsInjected);
+}
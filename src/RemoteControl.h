@@ -0,0 +1,40 @@
+/*
+ * RemoteControl.h - Call Control from the Web Interface
+ *
+ * Lets the dashboard or a test script dial, answer and hang up. Commands
+ * are queued by the web task and carried out by the main loop through
+ * the same code as the real handset and dial:
+ *
+ *   dial 123   IDLE → liftHandset(), then digits via injectDigit()
+ *              (also OFF_HOOK/DIALING, and IN_CALL to add a conference leg)
+ *   answer     RINGING/VOICEMAIL → liftHandset()
+ *   hangup     hangUp()
+ *
+ * The handset can stay on the cradle; the call then uses the handset
+ * speaker as usual (or the base speaker if the speakerphone is on).
+ */
+
+#ifndef REMOTE_CONTROL_H
+#define REMOTE_CONTROL_H
+
+#define REMOTE_QUEUE_COMMANDS 4
+#define REMOTE_DIGIT_GAP_MS 100      // Between injected digits (and after going off-hook)
+
+enum RemoteCommandType {
+  REMOTE_DIAL,
+  REMOTE_ANSWER,
+  REMOTE_HANGUP
+};
+
+void setupRemoteControl();
+
+// Web task: queue a command. Returns false if the queue is full.
+bool queueRemoteCommand(RemoteCommandType type, int number = -1);
+
+// Main loop: carry out queued commands and feed pending digits
+void handleRemoteControl();
+
+// Diagnostics (test mode)
+void printRemoteControlStats();
+
+#endif // REMOTE_CONTROL_H
@@ -0,0 +1,729 @@
+/*
+ * Ringtone - Custom Ringtones with a Pre-decoded PCM Cache
+ *
+ * Cache build (decode task, core 0, low priority):
+ *
+ *   AudioFileSourceLittleFS ──► AudioGeneratorMP3/WAV ──► CacheOutput ──► /cache/tmp.wav ──rename──► /cache/<key>.wav
+ *                                                         (mono mix, lowpass,
+ *                                                          16.16 linear resampler)
+ *
+ * The cache file is a plain 16kHz mono PCM WAV, so without PSRAM the file
+ * player streams it like any other WAV. With PSRAM the samples are also
+ * loaded into a buffer and ringing is a memcpy to the I2S DMA.
+ *
+ * Cache key: /cache/<fnv1a(path)>-<size>-<mtime>.wav. A key that doesn't
+ * exist yet means the source is new or was changed; older files with the
+ * same path hash are deleted when the new one is built. Only finished
+ * files are renamed into place, so a reboot mid-decode never leaves a
+ * truncated ringtone behind.
+ *
+ * Lazy revalidation: every ring posts a check for the slot it used. If the
+ * source changed, the decode task waits until the phone stops ringing
+ * before re-decoding and swapping the new samples in.
+ *
+ * "bell" is not a file: it is synthesized live by Bell.cpp, nothing to cache.
+ */
+
+#include "Ringtone.h"
+#include "Audio.h"
+#include "FilePlayer.h"
+#include "Bell.h"
+#include "MemoryMonitor.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "AudioFileSourceLittleFS.h"
+#include "AudioGeneratorMP3.h"
+#include "AudioGeneratorWAV.h"
+#include "AudioOutput.h"
+
+#define RINGTONE_PATH_LENGTH 48
+#define RINGTONE_TEMP_PATH RINGTONE_CACHE_DIRECTORY "/tmp.wav"
+#define RINGTONE_SLOTS (MAX_RINGTONE_RULES + 1)     // Last slot is the test-mode preview
+#define PREVIEW_SLOT MAX_RINGTONE_RULES
+#define WAV_HEADER_SIZE 44
+#define RINGER_CHUNK_SAMPLES 256                    // Same as Audio.cpp BUFFER_SIZE
+#define CACHE_WRITE_SAMPLES 512
+#define LOWPASS_CUTOFF_HZ 7000.0f
+#define DECODE_YIELD_PASSES 16                      // Decoder loop() calls between yields
+
+enum CacheState : uint8_t {
+  CACHE_NONE,        // Classic tone or bell, nothing to cache
+  CACHE_PENDING,     // Queued or decoding
+  CACHE_READY,
+  CACHE_FAILED
+};
+
+enum RingPhase {
+  RING_WAITING,      // Preview only: waiting for the decode to finish
+  RING_PLAYING,
+  RING_GAP
+};
+
+struct RingtoneSlot {
+  int caller;                             // -1 = default rule
+  char source[RINGTONE_PATH_LENGTH];      // "" = classic tone
+  bool bell;                              // Synthesized bell instead of a file
+  char cachePath[RINGTONE_PATH_LENGTH];   // Valid when READY
+  volatile uint8_t state;                 // CacheState
+  volatile bool checkQueued;
+  int16_t* pcm;                           // PSRAM copy (NULL = stream cachePath)
+  uint32_t samples;
+};
+
+static RingtoneSlot slots[RINGTONE_SLOTS];
+static int slotCount = 0;                 // Rules from config (preview slot not counted)
+static QueueHandle_t checkQueue = NULL;
+static portMUX_TYPE slotMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t psramUsed = 0;
+
+// ====== Ringing State (main loop) ======
+static volatile int activeSlot = -1;      // Read by the decode task: don't swap what is ringing
+static bool previewMode = false;
+static RingPhase ringPhase = RING_PLAYING;
+static const int16_t* ringPcm = NULL;
+static bool ringStreaming = false;        // Current pass comes from the file player
+static bool bellActive = false;           // Ringing with the synthesized bell
+static uint32_t ringSamples = 0;
+static uint32_t ringPosition = 0;
+static unsigned long gapStartTime = 0;
+
+// ====== Statistics ======
+static uint32_t customRings = 0;
+static uint32_t classicRings = 0;         // No rule, or cache not ready yet
+static uint32_t decodes = 0;
+static uint32_t decodeFailures = 0;
+static uint32_t cacheHits = 0;
+static uint32_t lastDecodeMs = 0;
+static uint32_t lastDecodeAudioMs = 0;
+static uint32_t streamStalls = 0;
+
+/*
+ * Cache Output
+ * ESP8266Audio output that writes 16kHz mono PCM to the cache file instead
+ * of I2S. Sources above 16kHz go through two one-pole lowpass stages
+ * before the linear resampler - cheap, and enough to keep cymbals from
+ * folding back as whistles on a small ringer speaker.
+ */
+class CacheOutput : public AudioOutput {
+public:
+  CacheOutput(File& file, uint32_t maxSamples) : file(file), maxSamples(maxSamples) {
+    hertz = RINGTONE_SAMPLE_RATE;
+    bps = 16;
+    channels = 2;
+    SetRate(RINGTONE_SAMPLE_RATE);
+  }
+
+  virtual bool SetRate(int hz) override {
+    if (hz <= 0) return false;
+    hertz = hz;
+    step = ((uint32_t)hz << 16) / RINGTONE_SAMPLE_RATE;
+    lowpassAlpha = 0;
+    if (hz > RINGTONE_SAMPLE_RATE) {
+      lowpassAlpha = (int32_t)((1.0f - expf(-2.0f * PI * LOWPASS_CUTOFF_HZ / hz)) * 16384.0f);
+    }
+    return true;
+  }
+
+  virtual bool begin() override { return true; }
+
+  virtual bool ConsumeSample(int16_t sample[2]) override {
+    if (isFull()) return true;   // Drop the rest, the decode loop stops shortly
+
+    int32_t left = sample[LEFTCHANNEL];
+    int32_t right = channels == 2 ? sample[RIGHTCHANNEL] : left;
+    if (bps == 8) {
+      left = (left - 128) << 8;
+      right = (right - 128) << 8;
+    }
+    int32_t mono = (left + right) >> 1;
+
+    if (lowpassAlpha) {
+      stage1 += ((mono - stage1) * lowpassAlpha) >> 14;
+      stage2 += ((stage1 - stage2) * lowpassAlpha) >> 14;
+      mono = stage2;
+    }
+
+    // Emit every output sample that falls between the previous input and this one
+    previous = current;
+    current = mono;
+    while (phase < 0x10000 && !isFull()) {
+      int32_t value = previous + (int32_t)(((int64_t)(current - previous) * phase) >> 16);
+      buffer[buffered++] = (int16_t)value;
+      written++;
+      if (buffered == CACHE_WRITE_SAMPLES) flush();
+      phase += step;
+    }
+    phase -= 0x10000;
+    return true;
+  }
+
+  virtual bool stop() override {
+    flush();
+    return true;
+  }
+
+  void flush() {
+    if (buffered == 0) return;
+    if (file.write((const uint8_t*)buffer, buffered * sizeof(int16_t)) != buffered * sizeof(int16_t)) {
+      writeError = true;
+    }
+    buffered = 0;
+  }
+
+  bool isFull() const { return written >= maxSamples; }
+  uint32_t samplesWritten() const { return written; }
+  bool failed() const { return writeError; }
+
+private:
+  File& file;
+  uint32_t maxSamples;
+  uint32_t written = 0;
+  bool writeError = false;
+  uint32_t step = 0x10000;   // Input samples per output sample, 16.16
+  uint32_t phase = 0;
+  int32_t previous = 0;
+  int32_t current = 0;
+  int32_t lowpassAlpha = 0;  // Q14 (no overflow on full-scale steps), 0 = bypass
+  int32_t stage1 = 0;
+  int32_t stage2 = 0;
+  int16_t buffer[CACHE_WRITE_SAMPLES];
+  size_t buffered = 0;
+};
+
+static uint32_t fnv1a(const char* text) {
+  uint32_t hash = 2166136261u;
+  while (*text) {
+    hash ^= (uint8_t)*text++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static bool hasExtension(const char* path, const char* extension) {
+  size_t length = strlen(path);
+  size_t extensionLength = strlen(extension);
+  return length >= extensionLength && strcasecmp(path + length - extensionLength, extension) == 0;
+}
+
+static void putLE16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+static void putLE32(uint8_t* p, uint32_t value) {
+  p[0] = value & 0xFF;
+  p[1] = (value >> 8) & 0xFF;
+  p[2] = (value >> 16) & 0xFF;
+  p[3] = value >> 24;
+}
+
+// 16kHz mono 16-bit PCM
+static void writeWavHeader(File& file, uint32_t dataBytes) {
+  uint8_t header[WAV_HEADER_SIZE];
+  memcpy(header, "RIFF", 4);
+  putLE32(header + 4, 36 + dataBytes);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  putLE32(header + 16, 16);
+  putLE16(header + 20, 1);
+  putLE16(header + 22, 1);
+  putLE32(header + 24, RINGTONE_SAMPLE_RATE);
+  putLE32(header + 28, RINGTONE_SAMPLE_RATE * 2);
+  putLE16(header + 32, 2);
+  putLE16(header + 34, 16);
+  memcpy(header + 36, "data", 4);
+  putLE32(header + 40, dataBytes);
+  file.write(header, WAV_HEADER_SIZE);
+}
+
+/*
+ * Remove Stale Caches
+ * Deletes every cache file for this source except the current one.
+ */
+static void removeStaleCaches(uint32_t hash, const char* keep) {
+  char prefix[12];
+  snprintf(prefix, sizeof(prefix), "%08lx-", (unsigned long)hash);
+
+  File directory = LittleFS.open(RINGTONE_CACHE_DIRECTORY);
+  if (!directory) return;
+  char path[RINGTONE_PATH_LENGTH];
+  File entry = directory.openNextFile();
+  while (entry) {
+    snprintf(path, sizeof(path), RINGTONE_CACHE_DIRECTORY "/%s", entry.name());
+    entry.close();
+    if (strncmp(path + sizeof(RINGTONE_CACHE_DIRECTORY), prefix, 9) == 0 && strcmp(path, keep) != 0) {
+      LittleFS.remove(path);
+      Serial.print("Ringtone: removed stale cache ");
+      Serial.println(path);
+    }
+    entry = directory.openNextFile();
+  }
+  directory.close();
+}
+
+/*
+ * Decode to Cache
+ * Runs the ESP8266Audio decoder to completion, yielding every few passes
+ * so the decode never starves Wi-Fi or the idle task on core 0.
+ */
+static bool decodeToCache(const char* source, const char* cachePath) {
+  bool isMp3 = hasExtension(source, ".mp3");
+  if (!isMp3 && !hasExtension(source, ".wav")) {
+    Serial.print("Ringtone: unsupported file type (MP3 or WAV only): ");
+    Serial.println(source);
+    return false;
+  }
+
+  File output = LittleFS.open(RINGTONE_TEMP_PATH, "w");
+  if (!output) {
+    Serial.println("Ringtone: cannot create cache file");
+    return false;
+  }
+  writeWavHeader(output, 0);
+
+  uint32_t start = millis();
+  AudioFileSourceLittleFS input(source);
+  AudioGeneratorMP3 mp3;
+  AudioGeneratorWAV wav;
+  AudioGenerator* decoder = isMp3 ? (AudioGenerator*)&mp3 : (AudioGenerator*)&wav;
+  CacheOutput sink(output, (uint32_t)RINGTONE_MAX_SECONDS * RINGTONE_SAMPLE_RATE);
+
+  bool started = decoder->begin(&input, &sink);
+  uint32_t passes = 0;
+  while (started && decoder->isRunning() && !sink.isFull()) {
+    if (!decoder->loop()) break;
+    if (++passes % DECODE_YIELD_PASSES == 0) vTaskDelay(1);
+  }
+  decoder->stop();
+  sink.flush();
+
+  uint32_t samples = sink.samplesWritten();
+  output.seek(0);
+  writeWavHeader(output, samples * sizeof(int16_t));
+  output.close();
+  input.close();
+
+  if (!started || samples == 0 || sink.failed()) {
+    LittleFS.remove(RINGTONE_TEMP_PATH);
+    Serial.print("Ringtone: decode failed for ");
+    Serial.println(source);
+    return false;
+  }
+
+  LittleFS.remove(cachePath);
+  if (!LittleFS.rename(RINGTONE_TEMP_PATH, cachePath)) {
+    LittleFS.remove(RINGTONE_TEMP_PATH);
+    return false;
+  }
+
+  decodes++;
+  lastDecodeMs = millis() - start;
+  lastDecodeAudioMs = samples / (RINGTONE_SAMPLE_RATE / 1000);
+  Serial.printf("Ringtone: decoded %s (%lu ms of audio in %lu ms)\n", source,
+                (unsigned long)lastDecodeAudioMs, (unsigned long)lastDecodeMs);
+  if (sink.isFull()) {
+    Serial.printf("Ringtone: %s is longer than %ds, cut off\n", source, RINGTONE_MAX_SECONDS);
+  }
+  return true;
+}
+
+/*
+ * Load PSRAM Copy
+ * Returns NULL without PSRAM or when the budget is used up - the ringtone
+ * is then streamed from the cache file instead.
+ */
+static int16_t* loadPsramCopy(const char* cachePath, uint32_t& samples) {
+  samples = 0;
+  if (!psramFound()) return NULL;
+
+  File file = LittleFS.open(cachePath, "r");
+  if (!file) return NULL;
+  uint32_t bytes = file.size() > WAV_HEADER_SIZE ? file.size() - WAV_HEADER_SIZE : 0;
+  if (bytes == 0 || psramUsed + bytes > RINGTONE_PSRAM_BUDGET) {
+    file.close();
+    return NULL;
+  }
+
+  int16_t* pcm = (int16_t*)memoryAlloc(MEMORY_RINGTONE, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (pcm) {
+    file.seek(WAV_HEADER_SIZE);
+    if (file.read((uint8_t*)pcm, bytes) == bytes) {
+      samples = bytes / sizeof(int16_t);
+    } else {
+      memoryFree(MEMORY_RINGTONE, pcm, bytes);
+      pcm = NULL;
+    }
+  }
+  file.close();
+  return pcm;
+}
+
+/*
+ * Refresh Slot
+ * Makes sure the slot's cache matches its source file, decoding if the
+ * file is new or changed since the cache was built.
+ */
+static void refreshSlot(int index) {
+  RingtoneSlot& slot = slots[index];
+  char source[RINGTONE_PATH_LENGTH];
+  strcpy(source, slot.source);
+
+  File file = LittleFS.open(source, "r");
+  if (!file || file.isDirectory()) {
+    Serial.print("Ringtone: file not found: ");
+    Serial.println(source);
+    if (file) file.close();
+    slot.state = CACHE_FAILED;
+    return;
+  }
+  uint32_t size = file.size();
+  uint32_t modified = (uint32_t)file.getLastWrite();
+  file.close();
+
+  uint32_t hash = fnv1a(source);
+  char cachePath[RINGTONE_PATH_LENGTH];
+  snprintf(cachePath, sizeof(cachePath), RINGTONE_CACHE_DIRECTORY "/%08lx-%08lx-%08lx.wav",
+           (unsigned long)hash, (unsigned long)size, (unsigned long)modified);
+
+  if (slot.state == CACHE_READY && strcmp(cachePath, slot.cachePath) == 0) {
+    return;   // Unchanged since it was cached
+  }
+
+  // Changed while in use: leave the old version ringing until the call stops
+  while (activeSlot == index && slot.state == CACHE_READY) {
+    vTaskDelay(pdMS_TO_TICKS(200));
+  }
+
+  if (LittleFS.exists(cachePath)) {
+    cacheHits++;
+  } else if (!decodeToCache(source, cachePath)) {
+    decodeFailures++;
+    if (slot.state != CACHE_READY) slot.state = CACHE_FAILED;
+    return;
+  }
+  removeStaleCaches(hash, cachePath);
+
+  uint32_t samples;
+  int16_t* pcm = loadPsramCopy(cachePath, samples);
+
+  // A ring may have started during the decode and be reading the old
+  // buffer: check again under the lock and swap only once it has stopped
+  int16_t* old = NULL;
+  uint32_t oldBytes = 0;
+  while (true) {
+    portENTER_CRITICAL(&slotMux);
+    bool ringing = activeSlot == index && slot.state == CACHE_READY;
+    if (!ringing) {
+      old = slot.pcm;
+      oldBytes = slot.samples * sizeof(int16_t);
+      slot.pcm = pcm;
+      slot.samples = samples;
+      strcpy(slot.cachePath, cachePath);
+      slot.state = CACHE_READY;
+    }
+    portEXIT_CRITICAL(&slotMux);
+    if (!ringing) break;
+    vTaskDelay(pdMS_TO_TICKS(200));
+  }
+
+  if (old) {
+    memoryFree(MEMORY_RINGTONE, old, oldBytes);
+    psramUsed -= oldBytes;
+  }
+  psramUsed += samples * sizeof(int16_t);
+}
+
+static void ringtoneDecodeTask(void* parameter) {
+  uint8_t index;
+  while (true) {
+    if (xQueueReceive(checkQueue, &index, portMAX_DELAY) != pdTRUE) continue;
+    slots[index].checkQueued = false;
+    refreshSlot(index);
+  }
+}
+
+static void queueCheck(int index) {
+  if (!checkQueue || slots[index].checkQueued) return;
+  uint8_t item = index;
+  slots[index].checkQueued = true;
+  if (xQueueSend(checkQueue, &item, 0) != pdTRUE) {
+    slots[index].checkQueued = false;
+  }
+}
+
+static void setSlotSource(RingtoneSlot& slot, int caller, const String& sound) {
+  slot.caller = caller;
+  slot.pcm = NULL;
+  slot.samples = 0;
+  slot.cachePath[0] = '\0';
+  slot.checkQueued = false;
+  slot.bell = sound == "bell";
+  if (sound.length() == 0 || sound == "tone") {
+    slot.source[0] = '\0';
+    slot.state = CACHE_NONE;
+  } else if (slot.bell) {
+    strcpy(slot.source, "bell");
+    slot.state = CACHE_NONE;
+  } else {
+    strncpy(slot.source, sound.c_str(), RINGTONE_PATH_LENGTH - 1);
+    slot.source[RINGTONE_PATH_LENGTH - 1] = '\0';
+    slot.state = CACHE_PENDING;
+  }
+}
+
+/*
+ * Setup Ringtones
+ */
+void setupRingtones(const PhoneConfig& config) {
+  setupBell();
+  slotCount = 0;
+  for (int i = 0; i < config.ringtoneCount && i < MAX_RINGTONE_RULES; i++) {
+    setSlotSource(slots[slotCount++], config.ringtones[i].caller, config.ringtones[i].sound);
+  }
+  setSlotSource(slots[PREVIEW_SLOT], -2, String());
+
+  checkQueue = xQueueCreate(RINGTONE_SLOTS, sizeof(uint8_t));
+  if (!checkQueue) {
+    Serial.println("Ringtone: out of memory, using the classic ring");
+    return;
+  }
+  LittleFS.mkdir(RINGTONE_CACHE_DIRECTORY);
+
+  // Core 0, low priority. MP3 decoding needs a bigger stack than the other workers.
+  xTaskCreatePinnedToCore(ringtoneDecodeTask, "ringtone", 8192, NULL, 1, NULL, 0);
+
+  for (int i = 0; i < slotCount; i++) {
+    if (slots[i].state == CACHE_PENDING) queueCheck(i);
+  }
+  if (slotCount > 0) {
+    Serial.print("Ringtone: ");
+    Serial.print(slotCount);
+    Serial.println(" rules, building cache in the background");
+  }
+}
+
+// Exact caller match first, then the default rule
+static int findSlot(int callerNumber) {
+  int fallback = -1;
+  for (int i = 0; i < slotCount; i++) {
+    if (slots[i].caller == callerNumber) return i;
+    if (slots[i].caller == -1) fallback = i;
+  }
+  return fallback;
+}
+
+/*
+ * Begin Pass
+ * Starts one play-through of the active slot. PSRAM pointers are taken
+ * under the lock; the decode task checks activeSlot under the same lock
+ * and never swaps or frees the buffer of a slot that is ringing.
+ */
+static bool beginPass() {
+  RingtoneSlot& slot = slots[activeSlot];
+  char cachePath[RINGTONE_PATH_LENGTH];
+
+  portENTER_CRITICAL(&slotMux);
+  bool ready = slot.state == CACHE_READY;
+  ringPcm = slot.pcm;
+  ringSamples = slot.samples;
+  strcpy(cachePath, slot.cachePath);
+  portEXIT_CRITICAL(&slotMux);
+
+  if (!ready) return false;
+  ringPosition = 0;
+  ringPhase = RING_PLAYING;
+  if (ringPcm) return true;
+  ringStreaming = startFilePlayback(cachePath);
+  return ringStreaming;
+}
+
+void startRingtone(int callerNumber) {
+  stopRingtone();
+  int index = findSlot(callerNumber);
+  if (index < 0 || (slots[index].state == CACHE_NONE && !slots[index].bell)) {
+    classicRings++;
+    return;
+  }
+
+  if (slots[index].bell) {
+    activeSlot = index;
+    previewMode = false;
+    bellActive = true;
+    startBell(micros());   // Different strike pattern every call
+    customRings++;
+    LOG_INFO("Ringtone: ringing with the bell");
+    return;
+  }
+
+  // Active first, so the decode task sees it before it could swap the slot
+  activeSlot = index;
+  previewMode = false;
+
+  // Check for a changed file in the background - this ring uses what is cached
+  queueCheck(index);
+  if (!beginPass()) {
+    // Still decoding (first ring after boot) or broken file
+    activeSlot = -1;
+    classicRings++;
+    return;
+  }
+  customRings++;
+  LOG_INFO("Ringtone: ringing with %s", slots[index].source);   // Rule slots are fixed after setup
+}
+
+bool updateRingtone() {
+  if (activeSlot < 0) return false;
+
+  if (bellActive) {
+    int16_t buffer[RINGER_CHUNK_SAMPLES];
+    if (renderBell(buffer, RINGER_CHUNK_SAMPLES)) {
+      writeRingerAudioBuffer(buffer, RINGER_CHUNK_SAMPLES);
+    } else if (previewMode) {
+      // Preview is one burst, and it has rung out
+      stopRingtone();
+      return false;
+    }
+    return true;
+  }
+
+  switch (ringPhase) {
+    case RING_WAITING:
+      if (slots[activeSlot].state == CACHE_PENDING) return true;
+      if (!beginPass()) {
+        stopRingtone();
+        return false;
+      }
+      return true;
+
+    case RING_PLAYING:
+      if (ringPcm) {
+        uint32_t remaining = ringSamples - ringPosition;
+        uint32_t chunk = remaining < RINGER_CHUNK_SAMPLES ? remaining : RINGER_CHUNK_SAMPLES;
+        writeRingerAudioBuffer(ringPcm + ringPosition, chunk);
+        ringPosition += chunk;
+        if (ringPosition < ringSamples) return true;
+      } else {
+        int16_t frame[PLAYER_FRAME_SAMPLES];
+        if (readFilePlaybackFrame(frame)) {
+          writeRingerAudioBuffer(frame, PLAYER_FRAME_SAMPLES);
+          return true;
+        }
+        if (isFilePlaybackActive()) {
+          streamStalls++;   // Prefilling or flash behind
+          return true;
+        }
+        ringStreaming = false;
+      }
+      if (previewMode) {
+        stopRingtone();
+        return false;
+      }
+      ringPhase = RING_GAP;
+      gapStartTime = millis();
+      return true;
+
+    case RING_GAP:
+      // No writes needed - the DMA plays silence once it runs dry
+      if (millis() - gapStartTime >= RINGTONE_GAP_MS && !beginPass()) {
+        // Cache vanished under us - finish the call on the classic ring
+        activeSlot = -1;
+        return false;
+      }
+      return true;
+  }
+  return false;
+}
+
+void stopRingtone() {
+  if (activeSlot < 0) return;
+  if (ringStreaming) stopFilePlayback();
+  ringStreaming = false;
+  bellActive = false;
+  activeSlot = -1;
+  previewMode = false;
+  ringPcm = NULL;
+  clearRingerAudio();
+}
+
+bool previewRingtone(const char* path) {
+  stopRingtone();
+  if (strcmp(path, "bell") == 0) {
+    activeSlot = PREVIEW_SLOT;
+    previewMode = true;
+    bellActive = true;
+    startBell(micros());
+    return true;
+  }
+  if (!checkQueue || !LittleFS.exists(path)) return false;
+
+  RingtoneSlot& slot = slots[PREVIEW_SLOT];
+  portENTER_CRITICAL(&slotMux);
+  if (strcmp(slot.source, path) != 0) {
+    // Different file: forget the old preview (its cache file stays valid)
+    strncpy(slot.source, path, RINGTONE_PATH_LENGTH - 1);
+    slot.source[RINGTONE_PATH_LENGTH - 1] = '\0';
+    slot.state = CACHE_PENDING;
+  }
+  portEXIT_CRITICAL(&slotMux);
+
+  activeSlot = PREVIEW_SLOT;
+  previewMode = true;
+  ringPhase = RING_WAITING;
+  queueCheck(PREVIEW_SLOT);
+  return true;
+}
+
+bool isRingtonePreviewActive() {
+  return previewMode && activeSlot >= 0;
+}
+
+/*
+ * Print Ringtone Stats
+ */
+void printRingtoneStats() {
+  static const char* stateNames[] = {"classic", "decoding", "ready", "failed"};
+
+  Serial.println();
+  Serial.println("========== RINGTONE STATS ==========");
+  for (int i = 0; i < slotCount; i++) {
+    const RingtoneSlot& slot = slots[i];
+    Serial.print(slot.caller < 0 ? String("default") : String("#") + String(slot.caller));
+    Serial.print(": ");
+    Serial.print(slot.source[0] ? slot.source : "tone");
+    Serial.print(" [");
+    Serial.print(slot.bell ? "synthesized" : stateNames[slot.state]);
+    if (slot.state == CACHE_READY) {
+      Serial.print(slot.pcm ? ", PSRAM " : ", streamed ");
+      Serial.print(slot.cachePath);
+    }
+    Serial.println("]");
+  }
+  Serial.print("Rings: ");
+  Serial.print(customRings);
+  Serial.print(" custom, ");
+  Serial.print(classicRings);
+  Serial.println(" classic");
+  Serial.print("Decodes: ");
+  Serial.print(decodes);
+  Serial.print(" (");
+  Serial.print(decodeFailures);
+  Serial.print(" failed), cache hits: ");
+  Serial.println(cacheHits);
+  if (decodes > 0) {
+    Serial.print("Last decode: ");
+    Serial.print(lastDecodeAudioMs);
+    Serial.print(" ms of audio in ");
+    Serial.print(lastDecodeMs);
+    Serial.println(" ms");
+  }
+  Serial.print("PSRAM used: ");
+  Serial.print(psramUsed / 1024);
+  Serial.print(" KB");
+  Serial.println(psramFound() ? "" : " (no PSRAM - streaming from flash)");
+  Serial.print("Stream stalls: ");
+  Serial.println(streamStalls);
+  Serial.println("====================================");
+}
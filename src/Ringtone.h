@@ -0,0 +1,56 @@
+/*
+ * Ringtone.h - Custom Ringtones with a Pre-decoded PCM Cache
+ *
+ * Rings the base ringer (I2S1) with an MP3 or WAV file from LittleFS,
+ * chosen per calling phone ("ringtones" in config.json).
+ *
+ * Decoding MP3 while ringing would cost CPU on every call and delay the
+ * first ring, so each ringtone is decoded once in the background to
+ * 16kHz mono PCM and kept in /cache:
+ *
+ *   /ringtones/x.mp3 ──► decode task (MP3/WAV → mono → lowpass → resample) ──► /cache/<key>.wav
+ *                                                                                  │
+ *                                       PSRAM copy (if the board has PSRAM) ◄──────┘
+ *
+ * Ringing only copies samples (PSRAM) or streams the cache file through
+ * the file player. The cache key includes the source's size and
+ * modification time; a changed file is re-decoded lazily, after it has
+ * rung once with the old cache.
+ *
+ * A rule can also say "bell" (synthesized two-gong bell, see Bell.h) or
+ * "tone" (the classic 440Hz ring).
+ */
+
+#ifndef RINGTONE_H
+#define RINGTONE_H
+
+#include "Configuration.h"
+
+#define RINGTONE_CACHE_DIRECTORY "/cache"
+#define RINGTONE_SAMPLE_RATE 16000
+#define RINGTONE_MAX_SECONDS 30          // Longer files are cut off
+#define RINGTONE_GAP_MS 2000             // Silence between repeats
+#define RINGTONE_PSRAM_BUDGET (2 * 1024 * 1024)
+
+// Take the rules from config and start building the cache in the background
+void setupRingtones(const PhoneConfig& config);
+
+// Start ringing for a caller (call when entering RINGING)
+void startRingtone(int callerNumber);
+
+// Feed the ringer. Returns false when there is no custom ringtone ready for
+// this call - the caller then plays the classic ring tone instead.
+bool updateRingtone();
+
+// Stop ringing (leaving RINGING). Safe to call more than once.
+void stopRingtone();
+
+// Test mode: decode (if needed) and play a file once on the ringer
+// ("bell" plays one burst of the synthesized bell)
+bool previewRingtone(const char* path);
+bool isRingtonePreviewActive();
+
+// Diagnostics (test mode)
+void printRingtoneStats();
+
+#endif // RINGTONE_H
@@ -28,6 +28,8 @@
 
 #include "RotaryDial.h"
 #include "Pins.h"
+#include "Log.h"
+#include "FixedString.h"
 #include <Arduino.h>
 
 // Single digit state (interrupt-driven, proven reliable)
@@ -48,11 +50,11 @@ const unsigned long DIAL_DEBOUNCE_MS = 50;     // Shunt switch debounce
 const unsigned long SAFETY_TIMEOUT_MS = 3000;  // Safety backup timeout
 
 // Multi-digit collection state (high-level)
-String collectedNumber = "";           // Complete phone number being dialed
-unsigned long lastDigitCollectedTime = 0;
-bool isCollectingNumber = false;
 const unsigned long DIAL_COMPLETE_TIMEOUT = 3000; // 3 seconds after last digit = complete
 const int MAX_DIGITS = 3;                         // Maximum digits in a phone number
+static FixedString<MAX_DIGITS> collectedNumber;   // Complete phone number being dialed (no heap)
+unsigned long lastDigitCollectedTime = 0;
+bool isCollectingNumber = false;
 
 // Interrupt handlers for proven reliable detection
 void IRAM_ATTR onPulseInterrupt() {
@@ -98,7 +100,7 @@ void IRAM_ATTR onDialInterrupt() {
             pulseCount = 0;
             digitReady = false;
             dialingTimeout = now;
-            // Remove Serial.println from ISR - causes watchdog timeout
+            LOG_DEBUG("Dial started turning");     // Deferred: safe in an ISR
         }
         // End dialing when shunt goes HIGH (dial returned to rest)
         else if (isDialing && currentDialState == HIGH) {
@@ -109,7 +111,7 @@ void IRAM_ATTR onDialInterrupt() {
                 digitReady = true;
                 // Convert pulse count to digit (10 pulses = 0)
                 lastDialedDigit = (pulseCount == 10) ? 0 : pulseCount;
-                // Remove Serial.println from ISR - causes watchdog timeout
+                LOG_DEBUG("Dial returned to rest after %d pulses", pulseCount);
             }
         }
         
@@ -153,26 +155,11 @@ void setupRotaryDial() {
 void handleRotaryDial() {
     unsigned long now = millis();
     
-    // Handle dial state messages (moved from ISR to avoid watchdog timeout)
-    static bool lastReportedDialing = false;
+    // Report digits (the ISRs log start/stop themselves at debug level)
     static bool lastReportedDigitReady = false;
     
-    if (isDialing && !lastReportedDialing) {
-        Serial.println("[Dial started turning]");
-        lastReportedDialing = true;
-    }
-    
-    if (!isDialing && lastReportedDialing) {
-        Serial.println("[Dial returned to rest]");
-        lastReportedDialing = false;
-    }
-    
     if (digitReady && !lastReportedDigitReady) {
-        Serial.print("✓ Digit dialed: ");
-        Serial.print(lastDialedDigit);
-        Serial.print(" (");
-        Serial.print(pulseCount);
-        Serial.println(" pulses)");
+        LOG_INFO("Digit dialed: %d (%d pulses)", lastDialedDigit, pulseCount);
         lastReportedDigitReady = true;
     }
     
@@ -180,37 +167,16 @@ void handleRotaryDial() {
         lastReportedDigitReady = false;
     }
     
-    // Handle pulse display (show dots for visual feedback)
-    static int lastDisplayedCount = 0;
-    if (isDialing && pulseCount > lastDisplayedCount) {
-        Serial.print(".");
-        Serial.print("[");
-        Serial.print(pulseCount);
-        Serial.print("]");
-        lastDisplayedCount = pulseCount;
-    }
-    
-    // Reset display counter when not dialing
-    if (!isDialing) {
-        lastDisplayedCount = 0;
-    }
-    
     // Safety timeout check - if we've been dialing too long, force completion
     if (isDialing && (now - dialingTimeout) > (SAFETY_TIMEOUT_MS * 2)) {
         // Safety timeout reached - something went wrong
         isDialing = false;
         
-        Serial.println("\n[Safety timeout - dial may be stuck]");
+        LOG_WARN("Safety timeout - dial may be stuck");
         
         if (pulseCount > 0) {
             digitReady = true;
             lastDialedDigit = (pulseCount == 10) ? 0 : pulseCount;
-            
-            Serial.print("✓ Digit dialed: ");
-            Serial.print(lastDialedDigit);
-            Serial.print(" (");
-            Serial.print(pulseCount);
-            Serial.println(" pulses)");
         }
     }
 }
@@ -235,6 +201,15 @@ void clearDialedDigit() {
     lastDialedDigit = -1;
 }
 
+/*
+ * Inject Digit
+ * Hands a digit to the collection code exactly like the dial interrupt does
+ */
+void injectDigit(int digit) {
+    lastDialedDigit = digit;
+    digitReady = true;
+}
+
 // ====== Multi-Digit Collection Functions ======
 
 /*
@@ -244,10 +219,10 @@ void clearDialedDigit() {
  * Call this when transitioning to OFF_HOOK state.
  */
 void startDialing() {
-    collectedNumber = "";
+    collectedNumber.clear();
     isCollectingNumber = true;
     lastDigitCollectedTime = millis();
-    Serial.println("Started collecting phone number");
+    LOG_INFO("Started collecting phone number");
 }
 
 /*
@@ -269,27 +244,24 @@ bool isDialingComplete() {
     // Check for new digit and add to collected number
     int digit = getDialedDigit();
     if (digit >= 0) {
-        collectedNumber += String(digit);
+        collectedNumber.appendDigit(digit);
         lastDigitCollectedTime = millis();
         clearDialedDigit();
         
-        Serial.print("Dialed so far: ");
-        Serial.println(collectedNumber);
+        LOG_INFO("Dialed so far: %d (%u digits)", collectedNumber.toInt(), collectedNumber.length());
         
         // Check if we've reached maximum digits
-        if (collectedNumber.length() >= MAX_DIGITS) {
-            Serial.print("Maximum digits reached. Complete number: ");
-            Serial.println(collectedNumber);
+        if (collectedNumber.isFull()) {
+            LOG_INFO("Maximum digits reached. Complete number: %d", collectedNumber.toInt());
             return true;
         }
     }
     
     // Check for timeout (user stopped dialing)
-    if (collectedNumber.length() > 0) {
+    if (!collectedNumber.isEmpty()) {
         unsigned long timeSinceLastDigit = millis() - lastDigitCollectedTime;
         if (timeSinceLastDigit >= DIAL_COMPLETE_TIMEOUT) {
-            Serial.print("Dial timeout. Complete number: ");
-            Serial.println(collectedNumber);
+            LOG_INFO("Dial timeout. Complete number: %d", collectedNumber.toInt());
             return true;
         }
     }
@@ -304,7 +276,7 @@ bool isDialingComplete() {
  * Used to detect transition from OFF_HOOK to DIALING state.
  */
 bool hasStartedDialing() {
-    return isCollectingNumber && collectedNumber.length() > 0;
+    return isCollectingNumber && !collectedNumber.isEmpty();
 }
 
 /*
@@ -316,7 +288,7 @@ bool hasStartedDialing() {
  * Example: "102" → 102
  */
 int getDialedNumber() {
-    if (collectedNumber.length() == 0) {
+    if (collectedNumber.isEmpty()) {
         return -1;
     }
     return collectedNumber.toInt();
@@ -329,8 +301,8 @@ int getDialedNumber() {
  * Call this after the call is complete or when returning to IDLE.
  */
 void resetDialedNumber() {
-    collectedNumber = "";
+    collectedNumber.clear();
     isCollectingNumber = false;
     lastDigitCollectedTime = 0;
-    Serial.println("Dialed number reset");
+    LOG_INFO("Dialed number reset");
 }
@@ -6,6 +6,7 @@ void setupRotaryDial();
 void handleRotaryDial();
 int getDialedDigit(); // Returns -1 if no digit is ready, otherwise 0-9
 void clearDialedDigit();
+void injectDigit(int digit);   // Present a digit as if it was dialed (remote call control)
 
 // Multi-digit collection functions (high-level)
 void startDialing();           // Start collecting a phone number
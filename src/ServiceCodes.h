@@ -0,0 +1,24 @@
+/*
+ * ServiceCodes.h - Reserved Dial Codes
+ * 
+ * Numbers in the 900-999 range are never routed as calls. When one of
+ * these is dialed the phone starts a local feature instead.
+ * 
+ * Keep phone numbers below 900 (auto-assigned numbers are 100-255).
+ */
+
+#ifndef SERVICE_CODES_H
+#define SERVICE_CODES_H
+
+#define SERVICE_CODE_FIRST 900
+
+#define SERVICE_CODE_PAGING 900   // Broadcast announcement to every on-hook phone
+#define SERVICE_CODE_VOICEMAIL 901 // Listen to answering machine messages
+#define SERVICE_CODE_SPEAKERPHONE 902 // Dialed on-hook: hands-free on the base speaker (again: hang up)
+
+// True if the dialed number is a service code rather than a phone number
+inline bool isServiceCode(int number) {
+  return number >= SERVICE_CODE_FIRST;
+}
+
+#endif // SERVICE_CODES_H
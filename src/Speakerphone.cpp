@@ -0,0 +1,238 @@
+/*
+ * Speakerphone - Half-Duplex Voice Switch
+ *
+ * Per 100-sample frame (6.25ms) and direction:
+ *
+ *   level = sum(|x|) / n                     no multiplies
+ *   envelope = max(level, envelope - envelope/8)   fast attack, ~50ms release
+ *
+ * The receive side runs in the ESP-NOW callback (Wi-Fi task) and only
+ * updates its envelope and applies its gain. All decisions are made on the
+ * transmit side in the main loop, once per microphone frame:
+ *
+ *   echo  = rx envelope * rx gain * coupling      what the mic hears of the speaker
+ *   near  = tx envelope > tx_threshold and > echo
+ *   far   = rx envelope > rx_threshold
+ *
+ *   IDLE ──near──► TX      IDLE ──far──► RX      RX ──near──► TX (break-in)
+ *   TX/RX ──quiet for hangover_ms──► RX if far, else IDLE
+ *
+ * In IDLE both directions get half the attenuation (in dB), so the first
+ * syllable from either side is not lost entirely.
+ */
+
+#include "Speakerphone.h"
+#include "Audio.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <math.h>
+
+#define SPK_GAIN_UNITY 32768     // Q15
+#define SPK_MAX_FRAME 256
+
+enum VoiceDirection {
+  VOICE_IDLE,
+  VOICE_RX,     // Far end talking: microphone attenuated
+  VOICE_TX      // Near end talking: speaker attenuated
+};
+
+static const char* directionNames[] = {"idle", "receive", "transmit"};
+
+// Settings (from config)
+static int32_t rxThreshold = 200;
+static int32_t txThreshold = 400;
+static int32_t couplingQ8 = 256;       // Expected echo / speaker level, Q8
+static unsigned long hangoverMs = 250;
+static int32_t closedGain = 3277;      // Q15 gain of the attenuated direction
+static int32_t idleGain = 10362;       // Q15, half the attenuation in dB
+static int32_t rampStep = 102;         // Q15 per sample
+
+static volatile bool active = false;
+static VoiceDirection direction = VOICE_IDLE;
+static unsigned long lastNearTalk = 0;
+static unsigned long lastFarTalk = 0;
+
+// Receive side (Wi-Fi task writes, main loop reads)
+static volatile int32_t rxEnvelope = 0;
+static volatile int32_t rxTarget = SPK_GAIN_UNITY;
+static volatile int32_t rxGain = SPK_GAIN_UNITY;
+
+// Transmit side (main loop only)
+static int32_t txEnvelope = 0;
+static int32_t txTarget = SPK_GAIN_UNITY;
+static int32_t txGain = SPK_GAIN_UNITY;
+
+// Statistics since startSpeakerphone()
+static uint32_t framesPerDirection[3] = {0, 0, 0};
+static uint32_t switches = 0;
+static uint32_t breakIns = 0;
+static uint32_t rxFrames = 0;
+
+static int32_t dbToQ15(float db) {
+  return (int32_t)(SPK_GAIN_UNITY * powf(10.0f, db / 20.0f));
+}
+
+void setupSpeakerphone(const PhoneConfig& config) {
+  const SpeakerphoneSettings& settings = config.speakerphone;
+  rxThreshold = settings.rxThreshold;
+  txThreshold = settings.txThreshold;
+  couplingQ8 = (int32_t)(256.0f * powf(10.0f, settings.couplingDb / 20.0f));
+  hangoverMs = settings.hangoverMs;
+  closedGain = dbToQ15(-settings.attenuationDb);
+  idleGain = dbToQ15(-settings.attenuationDb / 2.0f);
+  rampStep = SPK_GAIN_UNITY / (SPEAKERPHONE_RAMP_MS * 16);   // 16 samples per ms
+}
+
+/*
+ * Frame Level
+ * Mean absolute value - enough to tell speech from silence and compare sides
+ */
+static int32_t frameLevel(const int16_t* samples, size_t count) {
+  int32_t sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    sum += abs(samples[i]);
+  }
+  return count ? sum / (int32_t)count : 0;
+}
+
+static int32_t followEnvelope(int32_t envelope, int32_t level) {
+  envelope -= envelope >> 3;
+  return level > envelope ? level : envelope;
+}
+
+/*
+ * Ramp Gain (Q15)
+ * Moves towards the target by at most rampStep per sample while scaling
+ */
+static int32_t rampGain(int16_t* samples, size_t count, int32_t gain, int32_t target) {
+  for (size_t i = 0; i < count; i++) {
+    if (gain < target) {
+      gain = min(gain + rampStep, target);
+    } else if (gain > target) {
+      gain = max(gain - rampStep, target);
+    }
+    samples[i] = (int16_t)((samples[i] * gain) >> 15);
+  }
+  return gain;
+}
+
+static void setDirection(VoiceDirection newDirection) {
+  if (newDirection == direction) return;
+  direction = newDirection;
+  switches++;
+  switch (direction) {
+    case VOICE_RX:
+      rxTarget = SPK_GAIN_UNITY;
+      txTarget = closedGain;
+      break;
+    case VOICE_TX:
+      rxTarget = closedGain;
+      txTarget = SPK_GAIN_UNITY;
+      break;
+    case VOICE_IDLE:
+    default:
+      rxTarget = idleGain;
+      txTarget = idleGain;
+      break;
+  }
+}
+
+void startSpeakerphone() {
+  rxEnvelope = 0;
+  txEnvelope = 0;
+  direction = VOICE_RX;          // Force the IDLE gains below
+  setDirection(VOICE_IDLE);
+  rxGain = idleGain;
+  txGain = idleGain;
+  switches = 0;
+  breakIns = 0;
+  rxFrames = 0;
+  for (int i = 0; i < 3; i++) framesPerDirection[i] = 0;
+
+  setSpeakerphoneRouting(true);
+  active = true;
+  LOG_INFO("Speakerphone on");
+}
+
+void stopSpeakerphone() {
+  if (!active) return;
+  active = false;
+  setSpeakerphoneRouting(false);
+  clearRingerAudio();
+  LOG_INFO("Speakerphone off");
+}
+
+bool isSpeakerphoneActive() {
+  return active;
+}
+
+void speakerphoneTransmit(int16_t* samples, size_t count) {
+  if (!active) return;
+  unsigned long now = millis();
+
+  txEnvelope = followEnvelope(txEnvelope, frameLevel(samples, count));
+  int32_t rxLevel = rxEnvelope;
+  int32_t echo = (int32_t)((((int64_t)rxLevel * rxGain) >> 15) * couplingQ8 >> 8);
+  bool nearTalk = txEnvelope > txThreshold && txEnvelope > echo;
+  bool farTalk = rxLevel > rxThreshold;
+  if (nearTalk) lastNearTalk = now;
+  if (farTalk) lastFarTalk = now;
+
+  switch (direction) {
+    case VOICE_IDLE:
+      if (nearTalk) {
+        setDirection(VOICE_TX);
+      } else if (farTalk) {
+        setDirection(VOICE_RX);
+      }
+      break;
+    case VOICE_RX:
+      if (nearTalk) {
+        breakIns++;
+        setDirection(VOICE_TX);
+      } else if (now - lastFarTalk > hangoverMs) {
+        setDirection(VOICE_IDLE);
+      }
+      break;
+    case VOICE_TX:
+      if (now - lastNearTalk > hangoverMs) {
+        setDirection(farTalk ? VOICE_RX : VOICE_IDLE);
+      }
+      break;
+  }
+  framesPerDirection[direction]++;
+
+  txGain = rampGain(samples, count, txGain, txTarget);
+}
+
+void speakerphoneReceive(const int16_t* samples, size_t count) {
+  if (count > SPK_MAX_FRAME) count = SPK_MAX_FRAME;
+  int16_t frame[SPK_MAX_FRAME];
+  memcpy(frame, samples, count * sizeof(int16_t));
+
+  rxEnvelope = followEnvelope(rxEnvelope, frameLevel(frame, count));
+  rxGain = rampGain(frame, count, rxGain, rxTarget);
+  rxFrames++;
+  writeAudioBuffer(frame, count);   // Routed to the ringer
+}
+
+void printSpeakerphoneStats() {
+  uint32_t total = framesPerDirection[0] + framesPerDirection[1] + framesPerDirection[2];
+  Serial.println();
+  Serial.println("========== SPEAKERPHONE ==========");
+  Serial.printf("Active: %s, direction: %s\n", active ? "yes" : "no", directionNames[direction]);
+  Serial.printf("Levels: mic %ld (threshold %ld), far end %ld (threshold %ld)\n",
+                (long)txEnvelope, (long)txThreshold, (long)rxEnvelope, (long)rxThreshold);
+  Serial.printf("Gains: mic %.1f dB, speaker %.1f dB\n",
+                20.0f * log10f(max(txGain, (int32_t)1) / 32768.0f),
+                20.0f * log10f(max((int32_t)rxGain, (int32_t)1) / 32768.0f));
+  if (total > 0) {
+    Serial.printf("Time: idle %.0f%%, receive %.0f%%, transmit %.0f%%\n",
+                  100.0f * framesPerDirection[VOICE_IDLE] / total,
+                  100.0f * framesPerDirection[VOICE_RX] / total,
+                  100.0f * framesPerDirection[VOICE_TX] / total);
+  }
+  Serial.printf("Switches: %lu (%lu break-ins), far-end frames: %lu\n",
+                (unsigned long)switches, (unsigned long)breakIns, (unsigned long)rxFrames);
+  Serial.println("==================================");
+}
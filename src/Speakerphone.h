@@ -0,0 +1,56 @@
+/*
+ * Speakerphone.h - Hands-Free Calls on the Base Speaker
+ *
+ * With the handset on the cradle, dial 902 to get a dial tone from the
+ * base ringer speaker and make a call without lifting the handset (or dial
+ * 902 while it rings to answer hands-free). Everything that would play on
+ * the handset plays on the ringer instead; the microphone stays the same.
+ *
+ * Speaker and microphone sit close together, so the far end would hear
+ * itself (or howl) if both directions were open. A voice switch keeps only
+ * one direction open at a time:
+ *
+ *   far end ──► rx gain ──► ringer ~~~ acoustic echo ~~~► mic ──► tx gain ──► far end
+ *                  ▲                                                ▲
+ *                  └──── voice switch: whoever talks louder ────────┘
+ *
+ * Each direction's level is a cheap envelope (mean absolute value per
+ * frame). The near end only wins when the microphone is louder than the
+ * echo the speaker is expected to produce ("coupling_db"). The closed
+ * direction is attenuated by "attenuation_db", with short gain ramps and
+ * a hangover so the switch doesn't chop words.
+ *
+ * Hang up by dialing 902 again (any digit while calling or on a busy or
+ * error tone), or lift the handset to continue the call on it.
+ */
+
+#ifndef SPEAKERPHONE_H
+#define SPEAKERPHONE_H
+
+#include "Configuration.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define SPEAKERPHONE_RAMP_MS 20   // Gain ramp when the switch changes direction
+
+// Take the voice switch settings from config
+void setupSpeakerphone(const PhoneConfig& config);
+
+// Route handset audio to the ringer and start the voice switch
+void startSpeakerphone();
+
+// Back to the handset (hang-up or handset lifted). Safe to call more than once.
+void stopSpeakerphone();
+
+bool isSpeakerphoneActive();
+
+// Main loop: decide the direction and attenuate one microphone frame in place
+void speakerphoneTransmit(int16_t* samples, size_t count);
+
+// ESP-NOW callback / conference mixer: attenuate and play far-end audio
+void speakerphoneReceive(const int16_t* samples, size_t count);
+
+// Diagnostics (test mode)
+void printSpeakerphoneStats();
+
+#endif // SPEAKERPHONE_H
@@ -10,15 +10,23 @@
  * - CALLING: Waiting for peer to answer
  * - RINGING: Receiving incoming call
  * - IN_CALL: Active voice call
+ * - PAGING: Broadcast announcement
+ * - VOICEMAIL: Answering machine took the call
+ * - MESSAGES: Voicemail playback
  * 
  * State transitions are logged to serial for debugging.
  */
 
 #include "State.h"
+#include "WebEvents.h"
+#include "Metrics.h"
+#include "AudioMonitor.h"
+#include "Log.h"
 #include <Arduino.h>
 
 // Current state of the phone (shared across modules)
 PhoneState currentState = IDLE;
+static unsigned long stateChangedAt = 0;
 
 /*
  * Change Phone State
@@ -40,18 +48,22 @@ PhoneState currentState = IDLE;
 void changeState(PhoneState newState) {
   if (newState == currentState) return; // No change needed
   
-  currentState = newState;
-  Serial.print("State changed to: ");
-  switch (currentState) {
-    case IDLE: Serial.println("IDLE"); break;
-    case OFF_HOOK: Serial.println("OFF_HOOK"); break;
-    case DIALING: Serial.println("DIALING"); break;
-    case CALLING: Serial.println("CALLING"); break;
-    case RINGING: Serial.println("RINGING"); break;
-    case IN_CALL: Serial.println("IN_CALL"); break;
-    case CALL_FAILED: Serial.println("CALL_FAILED"); break;
-    case CALL_BUSY: Serial.println("CALL_BUSY"); break;
+  PhoneState previousState = currentState;
+  unsigned long now = millis();
+  if (previousState == CALLING && newState == IN_CALL) {
+    observeMetric(METRIC_CALL_SETUP, now - stateChangedAt);
+  } else if (previousState == IN_CALL) {
+    observeMetric(METRIC_CALL_DURATION, (now - stateChangedAt) / 1000);
+    audioMonitorCallEnd();
+  }
+  if (newState == IN_CALL) {
+    audioMonitorCallStart();
   }
+  
+  currentState = newState;
+  stateChangedAt = now;
+  LOG_INFO("State changed to: %s", getStateName(currentState));
+  notifyStateChange(previousState, newState);   // Live web page / event stream
 }
 
 /*
@@ -65,3 +77,28 @@ void changeState(PhoneState newState) {
 PhoneState getCurrentState() {
   return currentState;
 }
+
+unsigned long getStateChangedAt() {
+  return stateChangedAt;
+}
+
+/*
+ * Get State Name
+ * Converts PhoneState enum to human-readable string (serial log, web, API)
+ */
+const char* getStateName(PhoneState state) {
+  switch (state) {
+    case IDLE: return "IDLE";
+    case OFF_HOOK: return "OFF_HOOK";
+    case DIALING: return "DIALING";
+    case CALLING: return "CALLING";
+    case RINGING: return "RINGING";
+    case IN_CALL: return "IN_CALL";
+    case CALL_FAILED: return "CALL_FAILED";
+    case CALL_BUSY: return "CALL_BUSY";
+    case PAGING: return "PAGING";
+    case VOICEMAIL: return "VOICEMAIL";
+    case MESSAGES: return "MESSAGES";
+    default: return "UNKNOWN";
+  }
+}
@@ -13,6 +13,14 @@
  * 
  * Any active state → User hangs up → IDLE
  * 
+ * OFF_HOOK → Dial paging code (900) → PAGING → User hangs up → IDLE
+ * 
+ * RINGING → Not answered after N rings → VOICEMAIL → Caller hangs up → IDLE
+ *                                            ↓ User lifts handset
+ *                                         IN_CALL
+ * 
+ * OFF_HOOK → Dial voicemail code (901) → MESSAGES → Last message played → OFF_HOOK
+ * 
  * States:
  * - IDLE: Phone at rest, waiting for activity
  * - OFF_HOOK: Handset lifted, dial tone playing, ready to dial
@@ -20,6 +28,9 @@
  * - CALLING: Dialed a complete number, ringing remote phone
  * - RINGING: Incoming call, playing ring tone
  * - IN_CALL: Connected call, audio streaming active
+ * - PAGING: Broadcasting an announcement to all on-hook phones
+ * - VOICEMAIL: Auto-answered, playing greeting / recording the caller
+ * - MESSAGES: Playing recorded voicemail messages on the handset
  */
 
 #ifndef STATE_H
@@ -34,7 +45,10 @@ enum PhoneState {
   RINGING,    // Incoming call, ringing
   IN_CALL,    // Active call in progress
   CALL_FAILED,// Call failed (number not found, etc.)
-  CALL_BUSY   // Called phone is busy (already in a call)
+  CALL_BUSY,  // Called phone is busy (already in a call)
+  PAGING,     // Broadcasting microphone audio to every phone
+  VOICEMAIL,  // Answering machine took the call
+  MESSAGES    // Listening to voicemail messages
 };
 
 // Change phone state and log to serial
@@ -43,4 +57,10 @@ void changeState(PhoneState newState);
 // Get current phone state
 PhoneState getCurrentState();
 
+// millis() when the current state was entered
+unsigned long getStateChangedAt();
+
+// Human-readable state name ("IDLE", "IN_CALL", ...)
+const char* getStateName(PhoneState state);
+
 #endif // STATE_H
@@ -9,17 +9,34 @@
 #include "Audio.h"
 #include "Pins.h"
 #include "State.h"
+#include "Conference.h"
+#include "Paging.h"
+#include "CallRecorder.h"
+#include "Voicemail.h"
+#include "Ringtone.h"
+#include "VoicePrompt.h"
+#include "Bell.h"
+#include "Equalizer.h"
+#include "Volume.h"
+#include "Speakerphone.h"
+#include "WebInterface.h"
+#include "Log.h"
+#include "Trace.h"
+#include "Profiler.h"
+#include "AudioMonitor.h"
+#include "MemoryMonitor.h"
+#include "FramePool.h"
+#include "HeapGuard.h"
+#include "Boot.h"
 #include <Arduino.h>
 #include <driver/i2s.h>
-#include "AudioFileSourceLittleFS.h"
-#include "AudioGeneratorMP3.h"
-#include "AudioOutputI2S.h"
 
 #define I2S_PORT I2S_NUM_0
 
 // Test mode state
 bool testModeActive = false;
-String testCommandBuffer = "";
+static TestCommand testCommandBuffer;     // Line being typed (fixed size, no heap)
+static bool testCommandOverflow = false;  // Line too long: discarded at the newline
 
 // Microphone test state
 bool micTestActive = false;
@@ -51,7 +68,7 @@ unsigned long audioTestStartTime = 0;
  */
 void setupTestMode() {
   testModeActive = false;
-  testCommandBuffer = "";
+  testCommandBuffer.clear();
   Serial.println("Test mode initialized. Type 'test help' for commands.");
 }
 
@@ -65,12 +82,15 @@ void handleTestMode() {
     char c = Serial.read();
     
     if (c == '\n' || c == '\r') {
-      if (testCommandBuffer.length() > 0) {
+      if (testCommandOverflow) {
+        Serial.printf("Command too long (max %u characters)\n", (unsigned)TEST_COMMAND_LENGTH);
+      } else if (!testCommandBuffer.isEmpty()) {
         processTestCommand(testCommandBuffer);
-        testCommandBuffer = "";
       }
+      testCommandBuffer.clear();
+      testCommandOverflow = false;
     } else if (c >= ' ') { // Printable characters only
-      testCommandBuffer += c;
+      if (!testCommandBuffer.append(c)) testCommandOverflow = true;
     }
   }
   
@@ -78,6 +98,10 @@ void handleTestMode() {
   if (testModeActive) {
     handleMicrophoneTest();
     handleAudioTest();
+    if (isRingtonePreviewActive()) {
+      updateRingtone();
+    }
+    updatePrompt();
     
     // CRITICAL: Update audio system for recorded playback and other audio tests
     updateToneGeneration();
@@ -88,7 +112,7 @@ void handleTestMode() {
  * Process Test Command
  * Parse and execute test commands from serial input
  */
-void processTestCommand(String command) {
+void processTestCommand(TestCommand command) {
   command.trim();
   command.toLowerCase();
   
@@ -137,6 +161,70 @@ void processTestCommand(String command) {
     testSineWave();
   } else if (command == "test pins") {
     testPinStates();
+  } else if (command == "test conf stats") {
+    printConferenceStats();
+  } else if (command == "test conf bench") {
+    benchmarkConferenceMixer();
+  } else if (command == "test page stats") {
+    printPagingStats();
+  } else if (command == "test rec stats") {
+    printRecorderStats();
+  } else if (command == "test vm stats") {
+    printVoicemailStats();
+  } else if (command == "test rt stats") {
+    printRingtoneStats();
+  } else if (command == "test bell") {
+    testBellRing();
+  } else if (command == "test bell bench") {
+    benchmarkBell();
+  } else if (command == "test eq") {
+    printEqualizerResponse(EQ_HANDSET);
+    printEqualizerResponse(EQ_RINGER);
+  } else if (command == "test eq bench") {
+    benchmarkEqualizer();
+  } else if (command == "test vol") {
+    printVolumeStats();
+  } else if (command == "test web stats") {
+    printWebStats();
+  } else if (command == "test web reset") {
+    resetWebStats();
+    Serial.println("Web and loop gap counters reset");
+  } else if (command == "test log") {
+    printLogStats();
+  } else if (command == "test log bench") {
+    benchmarkLog();
+  } else if (command == "test trace") {
+    Serial.println("----- BEGIN TRACE (save as .json, open in ui.perfetto.dev) -----");
+    writeTrace(Serial);
+    Serial.println("----- END TRACE -----");
+  } else if (command == "test trace stats") {
+    printTraceStats();
+  } else if (command == "test profile") {
+    printProfile();
+  } else if (command == "test profile reset") {
+    resetProfile();
+    Serial.println("Main loop profile reset");
+  } else if (command == "test memory") {
+    printMemoryReport();
+  } else if (command == "test pools") {
+    printFramePools();
+  } else if (command == "test heap guard") {
+    printHeapGuard();
+  } else if (command == "test heap guard check") {
+    testHeapGuard();
+  } else if (command == "test boot") {
+    printBootReport();
+  } else if (command == "test deadline") {
+    printAudioMonitor();
+  } else if (command == "test deadline reset") {
+    resetAudioMonitor();
+    Serial.println("Audio deadline counters reset, trace snapshot armed");
+  } else if (command == "test spk stats") {
+    printSpeakerphoneStats();
+  } else if (command == "test prompt") {
+    testVoicePrompt();
+  } else if (command == "test prompt stats") {
+    printPromptStats();
   } else {
     Serial.println("Unknown command. Type 'test help' for available commands.");
   }
@@ -272,6 +360,8 @@ void testDialTone() {
  * Stop Audio Test
  */
 void stopAudioTest() {
+  stopRingtone(); // Ends a 'test mp3' preview
+  stopPrompt();
   if (currentAudioTest != AUDIO_TEST_NONE) {
     Serial.println("Audio test stopped.");
     currentAudioTest = AUDIO_TEST_NONE;
@@ -773,7 +863,7 @@ void showTestHelp() {
   Serial.println("  test mic record     - Record and playback test (FULL TEST)");
   Serial.println("  test mic tone       - Test playback with synthetic tone");
   Serial.println("  test wav            - Test WAV-like audio playback");
-  Serial.println("  test mp3            - Test MP3-like audio playback");
+  Serial.println("  test mp3            - Decode /test.mp3 and play it on the ringer");
   Serial.println("  test mic stop       - Stop microphone test");
   Serial.println();
   Serial.println("Debug Tests:");
@@ -781,6 +871,51 @@ void showTestHelp() {
   Serial.println();
   Serial.println("Hardware Diagnostics:");
   Serial.println("  test pins           - Show all GPIO pin states");
+  Serial.println();
+  Serial.println("Conference:");
+  Serial.println("  test conf stats     - Mixer CPU, packet rates and airtime");
+  Serial.println("  test conf bench     - Benchmark mixer for 3, 4 and 6 parties");
+  Serial.println();
+  Serial.println("Paging:");
+  Serial.println("  test page stats     - Packets sent/received/lost for paging");
+  Serial.println();
+  Serial.println("Call Recorder:");
+  Serial.println("  test rec stats      - Queue drops, flash write latency, disk usage");
+  Serial.println("  test vm stats       - Voicemail answers, greeting stalls, player buffer");
+  Serial.println();
+  Serial.println("Ringtones:");
+  Serial.println("  test rt stats       - Cache state per rule, decode time, PSRAM use");
+  Serial.println("  test bell           - One burst of the synthesized bell on the ringer");
+  Serial.println("  test bell bench     - Bell synthesis time per block and CPU share");
+  Serial.println();
+  Serial.println("Speakers:");
+  Serial.println("  test eq             - Designed vs. measured response of both outputs");
+  Serial.println("  test eq bench       - EQ time per block and CPU share (4 bands)");
+  Serial.println("  test vol            - Handset/ringer volume, button presses and state");
+  Serial.println("  test spk stats      - Speakerphone voice switch: levels, gains, switches");
+  Serial.println();
+  Serial.println("Voice Prompts:");
+  Serial.println("  test prompt         - Say \"number 1 2 3 is busy\" on the handset");
+  Serial.println("  test prompt stats   - Clips cached, start latency, stalls");
+  Serial.println();
+  Serial.println("Web Interface:");
+  Serial.println("  test web stats      - Page size, time and heap counters per request");
+  Serial.println("  test web reset      - Clear counters (before a load test)");
+  Serial.println();
+  Serial.println("Logging and Tracing:");
+  Serial.println("  test log            - Deferred log: records, drops, ring use, file");
+  Serial.println("  test log bench      - Cost of one log record vs. one Serial line");
+  Serial.println("  test trace          - Dump timing spans as Chrome Trace JSON");
+  Serial.println("  test trace stats    - Spans recorded per core, time covered, cost");
+  Serial.println("  test profile        - Main loop time per section, period and jitter");
+  Serial.println("  test profile reset  - Start a new profile (e.g. before a test call)");
+  Serial.println("  test memory         - Heap, PSRAM, tagged buffers, task stacks, alerts");
+  Serial.println("  test pools          - Audio frame and message pools: in use, peak, exhausted");
+  Serial.println("  test heap guard     - Allocations caught on the audio/network/ISR paths");
+  Serial.println("  test heap guard check - Allocate in a guarded scope, expect it refused");
+  Serial.println("  test deadline       - Audio late frames, overruns, underruns and who caused them");
+  Serial.println("  test deadline reset - Clear the counters and re-arm the trace snapshot");
+  Serial.println("  test boot           - Time per boot stage, core, ready-to-ring time");
   Serial.println("=============================================");
 }
 
@@ -829,68 +964,52 @@ void testWAVPlayback() {
 
 /*
  * Test MP3 File Playback
- * Tests playing back MP3 files from LittleFS through the audio system
+ * Decodes /test.mp3 through the ringtone cache (first run only) and plays
+ * it once on the base ringer
  */
 void testMP3Playback() {
   Serial.println("MP3 playback test...");
-  Serial.println("Looking for test MP3 files in filesystem...");
   
   // Enable ringer amplifier for playback
   pinMode(AMP_RINGER_SD_PIN, OUTPUT);
   digitalWrite(AMP_RINGER_SD_PIN, HIGH);
   Serial.println("Ringer amplifier enabled for MP3 test.");
   
-  // For now, let's create a simple tone-based test that simulates MP3 playback
-  // In a real implementation, you would:
-  // 1. Create AudioFileSourceLittleFS source("/test.mp3");
-  // 2. Create AudioGeneratorMP3 mp3;
-  // 3. Create AudioOutputI2S out;
-  // 4. mp3.begin(&source, &out);
-  // 5. Loop mp3.loop() until !mp3.isRunning();
-  
-  Serial.println("NOTE: For real MP3 playback, you would need:");
-  Serial.println("1. An MP3 file uploaded to LittleFS (/test.mp3)");
-  Serial.println("2. ESP8266Audio library properly configured");
-  Serial.println("3. Sufficient heap memory for MP3 decoding");
-  
-  Serial.println();
-  Serial.println("For now, playing MP3-like test pattern...");
-  
-  // Create a more complex test pattern (simulates compressed audio)
-  const int PATTERN_SIZE = 1000;
-  static int16_t mp3Pattern[PATTERN_SIZE];
-  
-  // Generate a more complex pattern: multiple frequencies mixed
-  for (int i = 0; i < PATTERN_SIZE; i++) {
-    float t = (float)i / 500.0f; // 500Hz sample rate simulation
-    
-    // Mix multiple frequencies (simulates MP3 complexity)
-    float sine440 = sin(2.0 * PI * 440.0 * t) * 0.4;     // Base tone
-    float sine880 = sin(2.0 * PI * 880.0 * t) * 0.3;     // Octave
-    float sine220 = sin(2.0 * PI * 220.0 * t) * 0.3;     // Sub-octave
-    
-    float envelope = 1.0 + sin(2.0 * PI * 1.0 * t) * 0.5; // 1Hz amplitude modulation
-    float mixed = (sine440 + sine880 + sine220) * envelope;
-    
-    mp3Pattern[i] = (int16_t)(mixed * 3000);
+  if (!previewRingtone("/test.mp3")) {
+    Serial.println("No /test.mp3 on LittleFS - upload one with 'pio run --target uploadfs'");
+    return;
   }
   
-  Serial.print("Generated MP3-like test pattern: ");
-  Serial.print(PATTERN_SIZE);
-  Serial.println(" samples");
-  
-  // Set up the test pattern for the audio system
-  testRecordedBuffer = mp3Pattern;
-  testRecordedSamples = PATTERN_SIZE;
-  
-  Serial.println("Pattern loaded into audio system.");
+  Serial.println("Decoding /test.mp3 to the ringtone cache (skipped if already cached)...");
+  Serial.println("Playback starts when the cache is ready. 'test rt stats' shows decode time.");
+}
+
+/*
+ * Test Bell Ring
+ * One 2 second burst of the synthesized bell, left to ring out
+ */
+void testBellRing() {
+  pinMode(AMP_RINGER_SD_PIN, OUTPUT);
+  digitalWrite(AMP_RINGER_SD_PIN, HIGH);
   
-  // Use the working audio system to play the pattern
-  playTestRecordedAudio();
+  previewRingtone("bell");
+  Serial.println("Ringing the synthesized bell on the base ringer...");
+}
+
+/*
+ * Test Voice Prompt
+ * Plays a sample announcement on the handset through the prompt engine
+ */
+void testVoicePrompt() {
+  pinMode(AMP_HANDSET_SD_PIN, OUTPUT);
+  digitalWrite(AMP_HANDSET_SD_PIN, HIGH);
   
-  Serial.println("Playing MP3-like test pattern...");
-  Serial.println("You should hear a rich harmonic sound with slow amplitude modulation.");
-  Serial.println("This demonstrates the audio path that MP3 files would use.");
+  if (!announceBusy(123)) {
+    Serial.println("No voice prompts installed in " PROMPT_DIRECTORY " - see README");
+    return;
+  }
+  Serial.println("Playing \"the number 1 2 3 is busy\" on the handset...");
+  Serial.println("'test prompt stats' shows the start latency.");
 }
 
 /*
@@ -26,6 +26,11 @@
 #define TEST_MODE_H
 
 #include <Arduino.h>
+#include "FixedString.h"
+
+#define TEST_COMMAND_LENGTH 63   // Longest command line (characters)
+
+typedef FixedString<TEST_COMMAND_LENGTH> TestCommand;
 
 // Test mode state
 extern bool testModeActive;
@@ -33,7 +38,7 @@ extern bool testModeActive;
 // Core functions
 void setupTestMode();
 void handleTestMode();
-void processTestCommand(String command);
+void processTestCommand(TestCommand command);  // Trimmed and lowercased here
 
 // Internal test handlers (called from handleTestMode)
 void handleMicrophoneTest();
@@ -53,6 +58,8 @@ void testMicrophoneTone();
 void stopMicrophoneTest();
 void testWAVPlayback();
 void testMP3Playback();
+void testVoicePrompt();
+void testBellRing();
 
 // Debug test functions
 void testSineWave();
@@ -0,0 +1,240 @@
+/*
+ * Trace - Timing Spans (Chrome Trace / Perfetto)
+ *
+ * One ring per core; a slot is written with interrupts masked on that
+ * core, so a task switch or ISR can't interleave two writes and the other
+ * core never writes here. `head` counts every event ever recorded; the
+ * ring holds the last TRACE_EVENTS of them.
+ *
+ * Events keep the task handle, not its name: the name is looked up at
+ * export time with xTaskGetHandle() for the tasks we know, so a handle of
+ * a task that has since been deleted is never dereferenced. Export uses
+ * pid = core and tid = task, so Perfetto shows one row per task per core.
+ */
+
+#include "Trace.h"
+#include "PrintFormat.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define TRACE_INSTANT 0xFFFFFFFFu   // durationUs of a TRACE_MARK
+
+struct TraceEvent {
+  uint32_t startUs;
+  uint32_t durationUs;
+  const char* name;
+  TaskHandle_t task;                // NULL: recorded in an ISR
+};
+
+struct TraceRing {
+  TraceEvent events[TRACE_EVENTS];
+  uint32_t head;
+  uint32_t skipped;                 // Spans below TRACE_MIN_US
+};
+
+static TraceRing rings[portNUM_PROCESSORS];
+static volatile bool tracing = true;
+static volatile bool frozen = false;
+static uint32_t exports = 0;
+static uint32_t freezes = 0;
+
+// Tasks that may show up in a trace (names for the export)
+static const char* const knownTasks[] = {
+  "loopTask", "web", "log", "wifi", "recEncode", "recWrite", "player", "ringtone"
+};
+
+static void IRAM_ATTR record(const char* name, uint32_t startUs, uint32_t durationUs) {
+  UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+  TraceRing& ring = rings[xPortGetCoreID()];
+  TraceEvent& event = ring.events[ring.head % TRACE_EVENTS];
+  event.startUs = startUs;
+  event.durationUs = durationUs;
+  event.name = name;
+  event.task = xPortInIsrContext() ? NULL : xTaskGetCurrentTaskHandle();
+  ring.head++;
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+void IRAM_ATTR traceSpan(const char* name, uint32_t startUs) {
+  if (!tracing) return;
+  uint32_t duration = micros() - startUs;
+  if (duration < TRACE_MIN_US) {
+    rings[xPortGetCoreID()].skipped++;   // Statistics only, a lost increment doesn't matter
+    return;
+  }
+  record(name, startUs, duration);
+}
+
+void IRAM_ATTR traceMark(const char* name) {
+  if (!tracing) return;
+  record(name, micros(), TRACE_INSTANT);
+}
+
+// Thread id for a task handle: 0 = ISR, 1.. = order of first appearance
+static int taskId(TaskHandle_t* seen, int& seenCount, TaskHandle_t task) {
+  if (task == NULL) return 0;
+  for (int i = 0; i < seenCount; i++) {
+    if (seen[i] == task) return i + 1;
+  }
+  if (seenCount >= TRACE_MAX_TASKS) return TRACE_MAX_TASKS + 1;   // "other"
+  seen[seenCount++] = task;
+  return seenCount;
+}
+
+const char* traceTaskName(TaskHandle_t task) {
+  for (size_t i = 0; i < sizeof(knownTasks) / sizeof(knownTasks[0]); i++) {
+    if (xTaskGetHandle(knownTasks[i]) == task) return knownTasks[i];
+  }
+  return nullptr;
+}
+
+/*
+ * Write Trace
+ * Chrome Trace Event format: {"traceEvents":[...]} with complete ("X")
+ * and instant ("i") events, timestamps in microseconds since boot.
+ */
+void writeTrace(Print& out) {
+  tracing = false;
+  vTaskDelay(1);   // Let a write in progress on the other core finish
+  exports++;
+
+  TaskHandle_t seen[TRACE_MAX_TASKS];
+  int seenCount = 0;
+  bool first = true;
+
+  printFormat(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    const TraceRing& ring = rings[core];
+    uint32_t count = ring.head < TRACE_EVENTS ? ring.head : TRACE_EVENTS;
+    for (uint32_t i = ring.head - count; i != ring.head; i++) {
+      const TraceEvent& event = ring.events[i % TRACE_EVENTS];
+      int tid = taskId(seen, seenCount, event.task);
+      if (event.durationUs == TRACE_INSTANT) {
+        printFormat(out, "%s{\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%lu,\"name\":\"%s\"}",
+             first ? "" : ",\n", core, tid, (unsigned long)event.startUs, event.name);
+      } else {
+        printFormat(out, "%s{\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%lu,\"dur\":%lu,\"name\":\"%s\"}",
+             first ? "" : ",\n", core, tid, (unsigned long)event.startUs,
+             (unsigned long)event.durationUs, event.name);
+      }
+      first = false;
+    }
+  }
+
+  // Names for the rows
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    printFormat(out, "%s{\"ph\":\"M\",\"pid\":%d,\"name\":\"process_name\",\"args\":{\"name\":\"Core %d\"}}",
+         first ? "" : ",\n", core, core);
+    first = false;
+    printFormat(out, ",\n{\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"name\":\"thread_name\",\"args\":{\"name\":\"ISR\"}}", core);
+    for (int i = 0; i < seenCount; i++) {
+      const char* name = traceTaskName(seen[i]);
+      if (name) {
+        printFormat(out, ",\n{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+             core, i + 1, name);
+      } else {
+        printFormat(out, ",\n{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"task %d\"}}",
+             core, i + 1, i + 1);
+      }
+    }
+  }
+  printFormat(out, "\n]}\n");
+  frozen = false;
+  tracing = true;
+}
+
+void traceFreeze() {
+  if (frozen) return;
+  frozen = true;
+  tracing = false;
+  freezes++;
+}
+
+bool isTraceFrozen() {
+  return frozen;
+}
+
+/*
+ * Busiest Task
+ * Walks one core's ring back from the newest event. Spans are recorded
+ * when they end, so the walk stops at the first one that ended before
+ * fromUs. It doesn't lock: on a busy ring a slot may be overwritten while
+ * it is read, which at worst blames the wrong task once.
+ */
+bool traceBusiest(int core, uint32_t fromUs, uint32_t toUs, TaskHandle_t exclude, TraceBusy& out) {
+  const int maxTasks = 8;
+  TaskHandle_t tasks[maxTasks];
+  uint32_t busy[maxTasks];
+  const char* longest[maxTasks];
+  uint32_t longestUs[maxTasks];
+  bool isr[maxTasks];
+  int taskCount = 0;
+
+  const TraceRing& ring = rings[core];
+  uint32_t head = ring.head;
+  uint32_t count = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+  for (uint32_t i = 0; i < count; i++) {
+    const TraceEvent& event = ring.events[(head - 1 - i) % TRACE_EVENTS];
+    if (event.durationUs == TRACE_INSTANT) continue;
+    uint32_t endUs = event.startUs + event.durationUs;
+    if ((int32_t)(endUs - fromUs) <= 0) break;
+    if (event.task == exclude && event.task != NULL) continue;
+    uint32_t start = (int32_t)(event.startUs - fromUs) > 0 ? event.startUs : fromUs;
+    uint32_t end = (int32_t)(endUs - toUs) < 0 ? endUs : toUs;
+    if ((int32_t)(end - start) <= 0) continue;
+
+    int t = 0;
+    while (t < taskCount && !(tasks[t] == event.task && isr[t] == (event.task == NULL))) t++;
+    if (t == taskCount) {
+      if (taskCount == maxTasks) continue;
+      tasks[t] = event.task;
+      isr[t] = event.task == NULL;
+      busy[t] = 0;
+      longestUs[t] = 0;
+      taskCount++;
+    }
+    busy[t] += end - start;   // Nested spans count twice; capped below
+    if (end - start > longestUs[t]) {
+      longestUs[t] = end - start;
+      longest[t] = event.name;
+    }
+  }
+
+  if (taskCount == 0) return false;
+  int best = 0;
+  for (int t = 1; t < taskCount; t++) {
+    if (busy[t] > busy[best]) best = t;
+  }
+  const char* name = isr[best] ? "isr" : traceTaskName(tasks[best]);
+  out.task = name ? name : "other";
+  out.span = longest[best];
+  out.busyUs = busy[best] < toUs - fromUs ? busy[best] : toUs - fromUs;
+  return true;
+}
+
+void printTraceStats() {
+  Serial.printf("Trace: %s, %d events per core (%u bytes), spans under %d us skipped, %lu exports\n",
+                TRACE_ENABLED ? "compiled in" : "compiled out", TRACE_EVENTS,
+                (unsigned)sizeof(rings), TRACE_MIN_US, (unsigned long)exports);
+  Serial.printf("  %s, frozen %lu times since boot\n",
+                frozen ? "FROZEN (export to resume)" : "recording", (unsigned long)freezes);
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    const TraceRing& ring = rings[core];
+    uint32_t count = ring.head < TRACE_EVENTS ? ring.head : TRACE_EVENTS;
+    uint32_t covered = 0;
+    if (count > 0) {
+      covered = micros() - ring.events[(ring.head - count) % TRACE_EVENTS].startUs;
+    }
+    Serial.printf("  core %d: %lu recorded, %lu skipped (short), ring covers the last %lu ms\n", core,
+                  (unsigned long)ring.head, (unsigned long)ring.skipped, (unsigned long)(covered / 1000));
+  }
+
+  // Cost of one recorded span (TRACE_MIN_US forces the slow path)
+  const int spans = 100;
+  uint32_t start = micros();
+  for (int i = 0; i < spans; i++) {
+    traceSpan("trace_bench", micros() - TRACE_MIN_US);
+  }
+  uint32_t elapsed = micros() - start;
+  Serial.printf("  cost: %lu ns per recorded span\n", (unsigned long)(elapsed * 1000UL / spans));
+}
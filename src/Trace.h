@@ -0,0 +1,100 @@
+/*
+ * Trace.h - Timing Spans (Chrome Trace / Perfetto)
+ *
+ * A flight recorder for "why did the audio stutter just now?": code marks
+ * spans, each finished span is one 16-byte event in a ring per CPU core,
+ * and the last TRACE_EVENTS per core can be downloaded as Chrome Trace
+ * Event JSON and opened in https://ui.perfetto.dev (or chrome://tracing):
+ *
+ *   TRACE_SCOPE(espnow_rx);                  // Until the end of the block
+ *
+ *   TRACE_BEGIN(web_client);                 // Explicit begin/end
+ *   server.handleClient();
+ *   TRACE_END(web_client);
+ *
+ *   TRACE_SPAN(littlefs_write, startUs);     // Started at startUs (micros())
+ *   TRACE_MARK(i2s_underrun);                // Instant event
+ *
+ * Span names are identifiers; they show up in the trace as written.
+ *
+ * Recording costs about a microsecond: read the clock, mask interrupts on
+ * this core, write the slot. Each core only writes its own ring, so there
+ * is no lock shared between the cores. Spans shorter than TRACE_MIN_US
+ * aren't recorded, so idle loop passes don't push out the interesting
+ * part. Export:
+ *
+ *   GET /api/v1/trace   (save as .json)
+ *   test trace          (serial, between BEGIN/END lines)
+ *
+ * Recording pauses while an export runs. traceFreeze() stops it until the
+ * next export, so the moment of a problem isn't overwritten (see
+ * AudioMonitor.h). Build with -DTRACE_ENABLED=0 to compile every span out.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_EVENTS 1024        // Per core (16 bytes each)
+#define TRACE_MIN_US 20          // Shorter spans are skipped
+#define TRACE_MAX_TASKS 16       // Distinct tasks named in one export
+
+// Record a finished span / an instant event (use the macros instead)
+void traceSpan(const char* name, uint32_t startUs);
+void traceMark(const char* name);
+
+// Write the rings as Chrome Trace Event JSON (resumes a frozen trace)
+void writeTrace(Print& out);
+
+// Stop recording until the next export
+void traceFreeze();
+bool isTraceFrozen();
+
+// The task (other than `exclude`) whose spans covered most of fromUs..toUs
+// on one core. Returns false if no span overlaps.
+struct TraceBusy {
+  const char* task;              // Known task name, "isr" or "other"
+  const char* span;              // Its longest overlapping span
+  uint32_t busyUs;
+};
+bool traceBusiest(int core, uint32_t fromUs, uint32_t toUs, TaskHandle_t exclude, TraceBusy& out);
+
+// Name of a known task, or nullptr
+const char* traceTaskName(TaskHandle_t task);
+
+// Diagnostics (test mode)
+void printTraceStats();
+
+#if TRACE_ENABLED
+
+class TraceScope {
+public:
+  explicit TraceScope(const char* name) : name(name), startUs(micros()) {}
+  ~TraceScope() { traceSpan(name, startUs); }
+private:
+  const char* name;
+  uint32_t startUs;
+};
+
+#define TRACE_SCOPE(span) TraceScope span##TraceScope(#span)
+#define TRACE_BEGIN(span) const uint32_t span##TraceStart = micros()
+#define TRACE_END(span) traceSpan(#span, span##TraceStart)
+#define TRACE_SPAN(span, startUs) traceSpan(#span, startUs)
+#define TRACE_MARK(span) traceMark(#span)
+
+#else
+
+#define TRACE_SCOPE(span) ((void)0)
+#define TRACE_BEGIN(span) ((void)0)
+#define TRACE_END(span) ((void)0)
+#define TRACE_SPAN(span, startUs) ((void)0)
+#define TRACE_MARK(span) ((void)0)
+
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,142 @@
+/*
+ * VoicePrompt - Spoken Announcements from Short Clips
+ *
+ *   announceBusy(123) ──► ["number", "1", "2", "3", "is_busy"] ──► startFilePlaylist() ──► updatePrompt() ──► handset
+ *
+ * Concatenation and decoding happen in the file player's reader task: the
+ * clips are decoded into one continuous frame stream, so words join
+ * without the clicks or gaps of starting each file separately. The head
+ * cache holds the first block of every clip, which covers the 50ms
+ * prefill of the first word while LittleFS opens the file.
+ */
+
+#include "VoicePrompt.h"
+#include "FilePlayer.h"
+#include "Audio.h"
+#include "Network.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#define PROMPT_MAX_WORDS PLAYER_MAX_PLAYLIST
+
+static int clipsCached = 0;
+static bool promptActive = false;
+
+// ====== Statistics ======
+static uint32_t promptsPlayed = 0;
+static uint32_t promptFrames = 0;
+static uint32_t promptStalls = 0;       // Loop passes waiting for a frame
+
+/*
+ * Setup Prompts
+ */
+void setupPrompts() {
+  File directory = LittleFS.open(PROMPT_DIRECTORY);
+  if (!directory || !directory.isDirectory()) {
+    Serial.println("Prompts: no " PROMPT_DIRECTORY " directory, using tones only");
+    return;
+  }
+
+  char path[PLAYER_PATH_LENGTH];
+  File entry = directory.openNextFile();
+  while (entry) {
+    snprintf(path, sizeof(path), PROMPT_DIRECTORY "/%s", entry.name());
+    entry.close();
+    size_t length = strlen(path);
+    if (length > 4 && strcasecmp(path + length - 4, ".wav") == 0 && cacheFileHead(path)) {
+      clipsCached++;
+    }
+    entry = directory.openNextFile();
+  }
+  directory.close();
+
+  Serial.print("Prompts: ");
+  Serial.print(clipsCached);
+  Serial.println(" clips cached");
+}
+
+bool playPrompt(const char* const* clips, int count) {
+  if (clipsCached == 0 || count <= 0) return false;
+  if (count > PROMPT_MAX_WORDS) count = PROMPT_MAX_WORDS;
+
+  char paths[PROMPT_MAX_WORDS][PLAYER_PATH_LENGTH];
+  const char* list[PROMPT_MAX_WORDS];
+  for (int i = 0; i < count; i++) {
+    snprintf(paths[i], PLAYER_PATH_LENGTH, PROMPT_DIRECTORY "/%s.wav", clips[i]);
+    list[i] = paths[i];
+  }
+
+  promptActive = startFilePlaylist(list, count);
+  if (promptActive) promptsPlayed++;
+  return promptActive;
+}
+
+/*
+ * Announce Number
+ * "The number" + one clip per digit + the ending clip
+ */
+static bool announceNumber(int number, const char* ending) {
+  static const char* digitClips[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
+  const char* clips[PROMPT_MAX_WORDS];
+  int count = 0;
+
+  if (number >= 0) {
+    clips[count++] = "number";
+    char digits[12];
+    snprintf(digits, sizeof(digits), "%d", number);
+    for (int i = 0; digits[i] && count < PROMPT_MAX_WORDS - 1; i++) {
+      clips[count++] = digitClips[digits[i] - '0'];
+    }
+  }
+  clips[count++] = ending;
+  return playPrompt(clips, count);
+}
+
+bool announceBusy(int number) {
+  return announceNumber(number, "is_busy");
+}
+
+bool announceNotInService(int number) {
+  return announceNumber(number, "not_in_service");
+}
+
+bool updatePrompt() {
+  if (!promptActive) return false;
+
+  int16_t frame[AUDIO_SAMPLES_PER_PACKET];
+  if (readFilePlaybackFrame(frame)) {
+    writeAudioBuffer(frame, AUDIO_SAMPLES_PER_PACKET);
+    promptFrames++;
+    return true;
+  }
+  if (isFilePlaybackActive()) {
+    promptStalls++;   // Prefilling or reader behind
+    return true;
+  }
+  promptActive = false;
+  return false;
+}
+
+void stopPrompt() {
+  if (!promptActive) return;
+  promptActive = false;
+  stopFilePlayback();
+}
+
+/*
+ * Print Prompt Stats
+ */
+void printPromptStats() {
+  Serial.println();
+  Serial.println("========== VOICE PROMPT STATS ==========");
+  Serial.print("Clips cached: ");
+  Serial.println(clipsCached);
+  Serial.print("Announcements: ");
+  Serial.println(promptsPlayed);
+  Serial.print("Frames played: ");
+  Serial.print(promptFrames);
+  Serial.print(", stalls: ");
+  Serial.println(promptStalls);
+  Serial.println("========================================");
+  printFilePlayerStats();
+}
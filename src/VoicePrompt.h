@@ -0,0 +1,43 @@
+/*
+ * VoicePrompt.h - Spoken Announcements from Short Clips
+ *
+ * Builds sentences like "the number" + "one" + "two" + "three" + "is busy"
+ * from clips in /prompts on LittleFS and plays them on the handset,
+ * back to back with no gaps. The start of every clip is cached in RAM at
+ * boot, so an announcement starts within one frame instead of waiting
+ * for LittleFS.
+ *
+ * Clips (16kHz mono WAV, IMA-ADPCM recommended):
+ *   number.wav          "The number"
+ *   0.wav ... 9.wav     Digits
+ *   is_busy.wav         "is busy"
+ *   not_in_service.wav  "is not in service"
+ *
+ * Without the clips the phone simply keeps using the busy/error tones.
+ */
+
+#ifndef VOICE_PROMPT_H
+#define VOICE_PROMPT_H
+
+#define PROMPT_DIRECTORY "/prompts"
+
+// Cache the start of every clip in /prompts (called once from setup)
+void setupPrompts();
+
+// Play clips by name (without directory or ".wav"), gapless.
+// Returns false if no prompts are installed.
+bool playPrompt(const char* const* clips, int count);
+
+// "The number <digits> is busy" / "... is not in service"
+bool announceBusy(int number);
+bool announceNotInService(int number);
+
+// Feed the handset one frame. Returns false once the announcement has
+// finished (or none is playing) - the caller then plays its tone.
+bool updatePrompt();
+void stopPrompt();
+
+// Diagnostics (test mode)
+void printPromptStats();
+
+#endif // VOICE_PROMPT_H
@@ -0,0 +1,270 @@
+/*
+ * Voicemail - Answering Machine
+ *
+ * Answering (VOICEMAIL state, one 100-sample frame per loop):
+ *
+ *   GREETING: FilePlayer frame ──► sendAudioData()   (until end of file)
+ *   BEEP:     1kHz tone        ──► sendAudioData()   (400ms)
+ *   RECORD:   caller audio arrives in Network.cpp ──► recordRxAudio() ──► CallRecorder
+ *
+ * Flash I/O never happens here: the greeting is read ahead by the file
+ * player task and the message is written by the recorder's writer task.
+ * The loop only moves frames between queues.
+ *
+ * Playback (MESSAGES state):
+ *   New messages oldest first (or every message if none are new), each
+ *   preceded by a short beep, played on the handset. A message counts as
+ *   heard once it has played to the end.
+ */
+
+#include "Voicemail.h"
+#include "FilePlayer.h"
+#include "CallRecorder.h"
+#include "Network.h"
+#include "Audio.h"
+#include "Log.h"
+#include <Arduino.h>
+#include <math.h>
+
+#define BEEP_FREQUENCY 1000.0
+#define BEEP_AMPLITUDE 6000
+#define PLAYBACK_BEEP_MS 150
+#define PLAYBACK_GAP_MS 350
+
+enum AnswerPhase {
+  ANSWER_GREETING,
+  ANSWER_BEEP,
+  ANSWER_RECORDING
+};
+
+enum PlaybackPhase {
+  PLAYBACK_BEEP,
+  PLAYBACK_GAP,
+  PLAYBACK_MESSAGE,
+  PLAYBACK_DONE
+};
+
+static int ringsBeforeAnswer = 0;
+
+// ====== Answering State ======
+static bool answering = false;
+static AnswerPhase answerPhase = ANSWER_GREETING;
+static unsigned long phaseStartTime = 0;
+static int callerNumber = -1;
+static float beepPhase = 0.0;
+
+// ====== Playback State ======
+static uint32_t playlist[RECORDER_MAX_FILES];
+static int playlistCount = 0;
+static int playlistPosition = 0;
+static PlaybackPhase playbackPhase = PLAYBACK_DONE;
+static unsigned long playbackPhaseStart = 0;
+
+// ====== Statistics ======
+static uint32_t callsAnswered = 0;
+static uint32_t greetingFrames = 0;
+static uint32_t greetingStalls = 0;    // Loop passes with no greeting frame ready
+
+/*
+ * Generate Beep
+ * Continuous phase across frames so a multi-frame beep has no clicks.
+ */
+static void generateBeep(int16_t* frame, size_t samples) {
+  float increment = (2.0 * PI * BEEP_FREQUENCY) / 16000;
+  for (size_t i = 0; i < samples; i++) {
+    frame[i] = (int16_t)(sin(beepPhase) * BEEP_AMPLITUDE);
+    beepPhase += increment;
+    if (beepPhase >= 2.0 * PI) beepPhase -= 2.0 * PI;
+  }
+}
+
+/*
+ * Setup Voicemail
+ */
+void setupVoicemail(int rings) {
+  ringsBeforeAnswer = rings > 0 ? rings : 0;
+  if (ringsBeforeAnswer > 0) {
+    Serial.print("Voicemail: answering after ");
+    Serial.print(ringsBeforeAnswer);
+    Serial.println(" rings");
+  }
+}
+
+bool shouldAnswerVoicemail(unsigned long ringingMs) {
+  return ringsBeforeAnswer > 0 && ringingMs >= (unsigned long)ringsBeforeAnswer * VOICEMAIL_RING_CYCLE_MS;
+}
+
+/*
+ * Start Voicemail
+ * Accepts the call like a normal pick-up, so the caller simply sees IN_CALL.
+ */
+void startVoicemail(int caller) {
+  callerNumber = caller;
+  answering = true;
+  callsAnswered++;
+  sendCallAccept(caller);
+
+  LOG_INFO("Voicemail: answering call from #%d", caller);
+
+  phaseStartTime = millis();
+  if (startFilePlayback(VOICEMAIL_GREETING_PATH)) {
+    answerPhase = ANSWER_GREETING;
+  } else {
+    // No greeting uploaded - go straight to the beep
+    answerPhase = ANSWER_BEEP;
+  }
+}
+
+bool voicemailProcessFrame() {
+  if (!answering) return true;
+
+  int16_t frame[AUDIO_SAMPLES_PER_PACKET];
+  switch (answerPhase) {
+    case ANSWER_GREETING:
+      if (readFilePlaybackFrame(frame)) {
+        sendAudioData(frame, AUDIO_SAMPLES_PER_PACKET);
+        greetingFrames++;
+        break;
+      }
+      if (isFilePlaybackActive()) {
+        greetingStalls++;  // Prefilling or reader behind
+        break;
+      }
+      answerPhase = ANSWER_BEEP;
+      phaseStartTime = millis();
+      beepPhase = 0.0;
+      // Fall through and start the beep this frame
+
+    case ANSWER_BEEP:
+      generateBeep(frame, AUDIO_SAMPLES_PER_PACKET);
+      sendAudioData(frame, AUDIO_SAMPLES_PER_PACKET);
+      if (millis() - phaseStartTime >= VOICEMAIL_BEEP_MS) {
+        answerPhase = ANSWER_RECORDING;
+        phaseStartTime = millis();
+        startMessageRecording(callerNumber);
+      }
+      break;
+
+    case ANSWER_RECORDING:
+      // Caller audio is tapped in Network.cpp; only the time limit lives here
+      if (millis() - phaseStartTime >= VOICEMAIL_MAX_MESSAGE_MS) {
+        LOG_INFO("Voicemail: message time limit reached");
+        return false;
+      }
+      break;
+  }
+  return true;
+}
+
+void stopVoicemail() {
+  if (!answering) return;
+  answering = false;
+  stopFilePlayback();
+  stopRecording();
+  LOG_INFO("Voicemail: finished");
+}
+
+bool hasNewMessages() {
+  return getUnheardMessageCount() > 0;
+}
+
+/*
+ * Start Message Playback
+ * Builds the playlist up front so messages arriving meanwhile don't
+ * reshuffle it.
+ */
+void startMessagePlayback() {
+  RecordingInfo info;
+  playlistCount = 0;
+  bool onlyNew = hasNewMessages();
+  for (int i = 0; i < getRecordingCount() && playlistCount < RECORDER_MAX_FILES; i++) {
+    if (!getRecordingInfo(i, info) || info.kind != RECORDING_MESSAGE) continue;
+    if (onlyNew && info.heard) continue;
+    playlist[playlistCount++] = info.id;
+  }
+
+  LOG_INFO("Voicemail: %d %s", playlistCount, onlyNew ? "new messages" : "saved messages");
+
+  playlistPosition = 0;
+  playbackPhase = PLAYBACK_BEEP;
+  playbackPhaseStart = millis();
+  beepPhase = 0.0;
+}
+
+bool messagesProcessFrame() {
+  int16_t frame[AUDIO_SAMPLES_PER_PACKET];
+
+  switch (playbackPhase) {
+    case PLAYBACK_BEEP:
+      generateBeep(frame, AUDIO_SAMPLES_PER_PACKET);
+      writeAudioBuffer(frame, AUDIO_SAMPLES_PER_PACKET);
+      if (millis() - playbackPhaseStart >= PLAYBACK_BEEP_MS) {
+        playbackPhase = PLAYBACK_GAP;
+        playbackPhaseStart = millis();
+      }
+      break;
+
+    case PLAYBACK_GAP:
+      memset(frame, 0, sizeof(frame));
+      writeAudioBuffer(frame, AUDIO_SAMPLES_PER_PACKET);
+      if (millis() - playbackPhaseStart < PLAYBACK_GAP_MS) break;
+      if (playlistPosition >= playlistCount) {
+        playbackPhase = PLAYBACK_DONE;
+        break;
+      }
+      {
+        char path[32];
+        getRecordingPath(playlist[playlistPosition], path, sizeof(path));
+        if (startFilePlayback(path)) {
+          playbackPhase = PLAYBACK_MESSAGE;
+        } else {
+          // File evicted since the playlist was built
+          playlistPosition++;
+          playbackPhaseStart = millis();
+        }
+      }
+      break;
+
+    case PLAYBACK_MESSAGE:
+      if (readFilePlaybackFrame(frame)) {
+        writeAudioBuffer(frame, AUDIO_SAMPLES_PER_PACKET);
+        break;
+      }
+      if (isFilePlaybackActive()) break;  // Prefilling
+      markRecordingHeard(playlist[playlistPosition]);
+      playlistPosition++;
+      playbackPhase = PLAYBACK_BEEP;
+      playbackPhaseStart = millis();
+      break;
+
+    case PLAYBACK_DONE:
+      return false;
+  }
+  return true;
+}
+
+void stopMessagePlayback() {
+  if (playbackPhase == PLAYBACK_DONE) return;
+  playbackPhase = PLAYBACK_DONE;
+  stopFilePlayback();
+}
+
+/*
+ * Print Voicemail Stats
+ */
+void printVoicemailStats() {
+  Serial.println();
+  Serial.println("========== VOICEMAIL STATS ==========");
+  Serial.print("Rings before answer: ");
+  Serial.println(ringsBeforeAnswer > 0 ? String(ringsBeforeAnswer) : String("off"));
+  Serial.print("Calls answered: ");
+  Serial.println(callsAnswered);
+  Serial.print("New messages: ");
+  Serial.println(getUnheardMessageCount());
+  Serial.print("Greeting frames sent: ");
+  Serial.print(greetingFrames);
+  Serial.print(", stalls: ");
+  Serial.println(greetingStalls);
+  Serial.println("=====================================");
+  printFilePlayerStats();
+}
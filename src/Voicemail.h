@@ -0,0 +1,50 @@
+/*
+ * Voicemail.h - Answering Machine
+ *
+ * When an incoming call rings "voicemail_rings" times without being
+ * answered, the phone picks up by itself:
+ *
+ *   greeting (/greeting.wav, streamed) ──► beep ──► record the caller (max 60s)
+ *
+ * Messages are stored by the call recorder. While any are unheard, lifting
+ * the handset gives a stutter dial tone. Dial 901 to listen to them.
+ *
+ * Lifting the handset while the machine is answering takes over the call.
+ */
+
+#ifndef VOICEMAIL_H
+#define VOICEMAIL_H
+
+#define VOICEMAIL_GREETING_PATH "/greeting.wav"
+#define VOICEMAIL_RING_CYCLE_MS 6000       // One ring: 2s on + 4s off
+#define VOICEMAIL_MAX_MESSAGE_MS 60000     // Caller is cut off after this
+#define VOICEMAIL_BEEP_MS 400
+
+// Number of rings before answering (0 = voicemail off)
+void setupVoicemail(int rings);
+
+// True once an unanswered call has rung long enough (call while RINGING)
+bool shouldAnswerVoicemail(unsigned long ringingMs);
+
+// Answer the caller and start the greeting
+void startVoicemail(int callerNumber);
+
+// One frame of work while VOICEMAIL (greeting, beep or recording).
+// Returns false when the message time limit is reached.
+bool voicemailProcessFrame();
+
+// Leaving VOICEMAIL (caller hung up, handset lifted or time limit)
+void stopVoicemail();
+
+// True while unheard messages are waiting
+bool hasNewMessages();
+
+// Message playback on the handset (MESSAGES state, code 901)
+void startMessagePlayback();
+bool messagesProcessFrame();   // Returns false after the last message
+void stopMessagePlayback();
+
+// Diagnostics (test mode)
+void printVoicemailStats();
+
+#endif // VOICEMAIL_H
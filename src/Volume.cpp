@@ -0,0 +1,129 @@
+/*
+ * Volume - Volume Buttons
+ *
+ * Hardware:
+ * - VOL_UP_PIN and VOL_DOWN_PIN, push buttons to GND
+ * - Internal pull-up resistors, a press is a FALLING edge
+ *
+ * The interrupt handlers only count presses (debounced, like the rotary
+ * dial); handleVolumeButtons() turns them into level changes. The gain
+ * itself lives in the audio output stage (Audio.cpp), which ramps to the
+ * new level so a press never clicks.
+ */
+
+#include "Volume.h"
+#include "Audio.h"
+#include "Pins.h"
+#include "State.h"
+#include "Speakerphone.h"
+#include "Log.h"
+#include <Arduino.h>
+
+static PhoneConfig* volumeConfig = nullptr;
+
+// Pending presses (+1 per up, -1 per down), written by the ISRs
+static volatile int pendingSteps = 0;
+static volatile unsigned long lastUpPress = 0;
+static volatile unsigned long lastDownPress = 0;
+static portMUX_TYPE stepsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static unsigned long lastChangeTime = 0;
+static bool saveNeeded = false;
+static uint32_t presses = 0;
+static uint32_t saves = 0;
+
+void IRAM_ATTR onVolumeUpInterrupt() {
+  unsigned long now = millis();
+  if (now - lastUpPress < VOLUME_DEBOUNCE_MS) return;
+  lastUpPress = now;
+  portENTER_CRITICAL_ISR(&stepsMux);
+  pendingSteps++;
+  portEXIT_CRITICAL_ISR(&stepsMux);
+}
+
+void IRAM_ATTR onVolumeDownInterrupt() {
+  unsigned long now = millis();
+  if (now - lastDownPress < VOLUME_DEBOUNCE_MS) return;
+  lastDownPress = now;
+  portENTER_CRITICAL_ISR(&stepsMux);
+  pendingSteps--;
+  portEXIT_CRITICAL_ISR(&stepsMux);
+}
+
+/*
+ * Setup Volume
+ * Keeps a pointer to the config so changed levels can be saved
+ */
+void setupVolume(PhoneConfig& config) {
+  volumeConfig = &config;
+  config.handsetVolume = constrain(config.handsetVolume, 0, VOLUME_MAX);
+  config.ringerVolume = constrain(config.ringerVolume, 0, VOLUME_MAX);
+  setHandsetVolume(config.handsetVolume);
+  setRingerVolume(config.ringerVolume);
+
+  pinMode(VOL_UP_PIN, INPUT_PULLUP);
+  pinMode(VOL_DOWN_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(VOL_UP_PIN), onVolumeUpInterrupt, FALLING);
+  attachInterrupt(digitalPinToInterrupt(VOL_DOWN_PIN), onVolumeDownInterrupt, FALLING);
+
+  Serial.printf("Volume: handset %d, ringer %d (of %d)\n",
+                config.handsetVolume, config.ringerVolume, VOLUME_MAX);
+}
+
+/*
+ * Handle Volume Buttons
+ *
+ * The ringer is adjusted while the handset is on the cradle (IDLE,
+ * RINGING, VOICEMAIL, speakerphone), the handset in every other state.
+ */
+void handleVolumeButtons() {
+  if (!volumeConfig) return;
+
+  portENTER_CRITICAL(&stepsMux);
+  int steps = pendingSteps;
+  pendingSteps = 0;
+  portEXIT_CRITICAL(&stepsMux);
+
+  if (steps != 0) {
+    PhoneState state = getCurrentState();
+    bool ringer = state == IDLE || state == RINGING || state == VOICEMAIL || isSpeakerphoneActive();
+    int& level = ringer ? volumeConfig->ringerVolume : volumeConfig->handsetVolume;
+    int newLevel = constrain(level + steps, 0, VOLUME_MAX);
+    presses += abs(steps);
+
+    if (newLevel != level) {
+      level = newLevel;
+      if (ringer) {
+        setRingerVolume(level);
+      } else {
+        setHandsetVolume(level);
+      }
+      saveNeeded = true;
+      lastChangeTime = millis();
+      LOG_INFO("%s volume: %d/%d", ringer ? "Ringer" : "Handset", level, VOLUME_MAX);
+    }
+  }
+
+  // Rewriting config.json can stall for hundreds of ms while LittleFS
+  // collects garbage: never during a call, page or ring, only once idle
+  if (saveNeeded && getCurrentState() == IDLE && millis() - lastChangeTime >= VOLUME_SAVE_DELAY_MS) {
+    saveNeeded = false;
+    saves++;
+    saveConfiguration(*volumeConfig);
+  }
+}
+
+void printVolumeStats() {
+  Serial.println();
+  Serial.println("========== VOLUME ==========");
+  if (volumeConfig) {
+    Serial.printf("Handset: %d/%d\n", volumeConfig->handsetVolume, VOLUME_MAX);
+    Serial.printf("Ringer:  %d/%d\n", volumeConfig->ringerVolume, VOLUME_MAX);
+  }
+  Serial.printf("Button presses: %lu, config saves: %lu%s\n",
+                (unsigned long)presses, (unsigned long)saves, saveNeeded ? " (save pending)" : "");
+  Serial.printf("Buttons now: up %s, down %s\n",
+                digitalRead(VOL_UP_PIN) == LOW ? "pressed" : "released",
+                digitalRead(VOL_DOWN_PIN) == LOW ? "pressed" : "released");
+  Serial.println("============================");
+}
@@ -0,0 +1,32 @@
+/*
+ * Volume.h - Volume Buttons
+ *
+ * The VOL_UP / VOL_DOWN buttons change the volume of the speaker that is
+ * in use: the handset while it is lifted, otherwise the base ringer.
+ * Each press is one 3dB step (see VOLUME_MAX in Audio.h).
+ *
+ * Presses are caught by interrupts and applied from the main loop. The
+ * levels are saved to config.json ("handset_volume", "ringer_volume") a
+ * few seconds after the last press, so holding a button down doesn't
+ * wear out the flash, and only once the phone is back in IDLE, so the
+ * flash write never holds up call audio.
+ */
+
+#ifndef VOLUME_H
+#define VOLUME_H
+
+#include "Configuration.h"
+
+#define VOLUME_DEBOUNCE_MS 150
+#define VOLUME_SAVE_DELAY_MS 3000
+
+// Configure the buttons and apply the saved levels
+void setupVolume(PhoneConfig& config);
+
+// Apply pending presses and save the levels when they have settled
+void handleVolumeButtons();
+
+// Diagnostics (test mode)
+void printVolumeStats();
+
+#endif // VOLUME_H
@@ -0,0 +1,505 @@
+/*
+ * WebApi - JSON REST API
+ *
+ * Each request fills one static JsonDocument and serializes it twice,
+ * straight into Print adapters - no Strings, no response buffer:
+ *
+ *   pass 1: HashPrint      FNV-1a hash + length → ETag, Content-Length
+ *           (If-None-Match matches → 304, done)
+ *   pass 2: ResponsePrint  512-byte buffer → server.sendContent()
+ *
+ * Serializing is cheap next to sending, so hashing the body twice costs
+ * less than keeping it in RAM. Only slowly changing values are in
+ * status/peers/call so their ETags stay valid between polls.
+ */
+
+#include "WebApi.h"
+#include "State.h"
+#include "Configuration.h"
+#include "Network.h"
+#include "WebInterface.h"
+#include "Metrics.h"
+#include "RemoteControl.h"
+#include "Log.h"
+#include "Trace.h"
+#include "Profiler.h"
+#include "AudioMonitor.h"
+#include "MemoryMonitor.h"
+#include "Boot.h"
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+
+#define API_CHUNK_SIZE 512
+
+static WebServer* api = nullptr;
+
+// One request at a time (the server runs from a single task)
+static StaticJsonDocument<API_JSON_CAPACITY> doc;
+
+static uint32_t apiRequests = 0;
+static uint32_t apiNotModified = 0;
+static uint32_t apiOverflows = 0;
+static size_t apiLargestBody = 0;
+
+/*
+ * Hash Print
+ * Counts and hashes the serialized body (FNV-1a)
+ */
+class HashPrint : public Print {
+public:
+  uint32_t hash = 2166136261u;
+  size_t length = 0;
+
+  size_t write(uint8_t c) override {
+    hash = (hash ^ c) * 16777619u;
+    length++;
+    return 1;
+  }
+};
+
+/*
+ * Response Print
+ * Buffers the serialized body and sends it in API_CHUNK_SIZE pieces
+ */
+class ResponsePrint : public Print {
+public:
+  size_t write(uint8_t c) override {
+    buffer[used++] = (char)c;
+    if (used == sizeof(buffer)) finish();
+    return 1;
+  }
+
+  size_t write(const uint8_t* data, size_t size) override {
+    for (size_t i = 0; i < size; i++) write(data[i]);
+    return size;
+  }
+
+  void finish() {
+    if (used > 0) api->sendContent(buffer, used);
+    used = 0;
+  }
+
+private:
+  char buffer[API_CHUNK_SIZE];
+  size_t used = 0;
+};
+
+static void formatMac(const uint8_t* mac, char* out, size_t length) {
+  snprintf(out, length, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+/*
+ * Send JSON
+ * Sends the document with an ETag, or 304 if the client already has it
+ */
+static void sendJson() {
+  apiRequests++;
+  if (doc.overflowed()) apiOverflows++;
+
+  HashPrint hash;
+  serializeJson(doc, hash);
+  char etag[12];
+  snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)hash.hash);
+
+  api->sendHeader("ETag", etag);
+  api->sendHeader("Cache-Control", "no-cache");
+  if (api->hasHeader("If-None-Match") && strstr(api->header("If-None-Match").c_str(), etag)) {
+    apiNotModified++;
+    api->send(304);
+    return;
+  }
+
+  if (hash.length > apiLargestBody) apiLargestBody = hash.length;
+  api->setContentLength(hash.length);
+  api->send(200, "application/json", "");
+  ResponsePrint response;
+  serializeJson(doc, response);
+  response.finish();
+}
+
+/*
+ * GET /api/v1/status
+ */
+static void handleApiStatus() {
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  doc.clear();
+  char text[20];
+  doc["number"] = getPhoneNumber();
+  doc["state"] = getStateName(phone.state);
+  doc["state_since_ms"] = phone.stateChangedAt;
+  if (phone.callPeer >= 0) {
+    doc["call_peer"] = phone.callPeer;
+  } else {
+    doc["call_peer"] = nullptr;
+  }
+  doc["speakerphone"] = phone.speakerphone;
+  doc["recordings"] = phone.recordings;
+  doc["new_messages"] = phone.newMessages;
+
+  JsonObject network = doc.createNestedObject("network");
+  IPAddress ip = WiFi.localIP();
+  snprintf(text, sizeof(text), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  network["ip"] = text;   // Copied into the document
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  formatMac(mac, text, sizeof(text));
+  network["mac"] = text;
+  network["channel"] = WiFi.channel();
+  sendJson();
+}
+
+/*
+ * GET /api/v1/peers
+ */
+static void handleApiPeers() {
+  doc.clear();
+  PeerStatus peers[MAX_PEERS];
+  int count = getPeerDirectory(peers, MAX_PEERS);
+  JsonArray list = doc.createNestedArray("peers");
+  for (int i = 0; i < count; i++) {
+    char mac[18];
+    formatMac(peers[i].macAddress, mac, sizeof(mac));
+    JsonObject entry = list.createNestedObject();
+    entry["number"] = peers[i].number;
+    entry["mac"] = mac;
+    entry["last_seen_s"] = peers[i].lastSeen / 1000;
+    if (peers[i].rssi != 0) {
+      entry["rssi"] = peers[i].rssi;
+    } else {
+      entry["rssi"] = nullptr;
+    }
+  }
+  sendJson();
+}
+
+/*
+ * GET /api/v1/call
+ */
+static void handleApiCall() {
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  doc.clear();
+  PhoneState state = phone.state;
+  doc["state"] = getStateName(state);
+  doc["active"] = state == IN_CALL || state == CALLING || state == RINGING || state == VOICEMAIL;
+  if (phone.callPeer >= 0) {
+    doc["peer"] = phone.callPeer;
+  } else {
+    doc["peer"] = nullptr;
+  }
+  doc["since_ms"] = phone.stateChangedAt;
+  doc["speakerphone"] = phone.speakerphone;
+  doc["recording"] = phone.recording;
+
+  JsonArray conference = doc.createNestedArray("conference");
+  for (int i = 0; i < phone.conferenceCount; i++) {
+    conference.add(phone.conference[i]);
+  }
+
+  sendJson();
+}
+
+/*
+ * GET /api/v1/metrics
+ */
+static void handleApiMetrics() {
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  doc.clear();
+  doc["uptime_s"] = millis() / 1000;
+  doc["cpu_mhz"] = ESP.getCpuFreqMHz();
+
+  JsonObject heap = doc.createNestedObject("heap");
+  heap["free"] = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  heap["min_free"] = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+  heap["largest_block"] = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+  heap["psram_free"] = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+  JsonObject wifi = doc.createNestedObject("wifi");
+  wifi["connected"] = WiFi.isConnected();
+  wifi["rssi"] = WiFi.RSSI();
+  wifi["channel"] = WiFi.channel();
+
+  PeerStatus peers[MAX_PEERS];
+  doc["peers"] = getPeerDirectory(peers, MAX_PEERS);
+  doc["recordings"] = phone.recordings;
+  doc["new_messages"] = phone.newMessages;
+
+  // Deadline misses and audio copied in this call (or the last one), see
+  // AudioMonitor.h; they change mid-call, so they stay out of /api/v1/call
+  AudioMissCounts call, total;
+  getAudioMissCounts(call, total);
+  JsonObject audio = doc.createNestedObject("audio");
+  audio["late_frames"] = call.count[AUDIO_LATE_FRAME];
+  audio["overruns"] = call.count[AUDIO_OVERRUN];
+  audio["underruns"] = call.count[AUDIO_UNDERRUN];
+  audio["short_writes"] = call.count[AUDIO_SHORT_WRITE];
+  audio["short_reads"] = call.count[AUDIO_SHORT_READ];
+  AudioCopyCounts copies;
+  getAudioCopyCounts(copies);
+  audio["copied_bytes_per_s"] = copiedBytesPerSecond(copies);
+
+  JsonObject requests = doc.createNestedObject("api");
+  requests["requests"] = apiRequests;
+  requests["not_modified"] = apiNotModified;
+  sendJson();
+}
+
+/*
+ * Send Command Result
+ * Control endpoints: small JSON, never cached
+ */
+static void sendCommandResult(int code) {
+  apiRequests++;
+  api->sendHeader("Cache-Control", "no-store");
+  api->setContentLength(measureJson(doc));
+  api->send(code, "application/json", "");
+  ResponsePrint response;
+  serializeJson(doc, response);
+  response.finish();
+}
+
+// Queue a command unless the phone is obviously in the wrong state (409)
+static void queueCommand(RemoteCommandType type, int number, PhoneState state, bool allowed, const char* action) {
+  doc.clear();
+  doc["action"] = action;
+  doc["state"] = getStateName(state);
+  if (number >= 0) doc["number"] = number;
+  if (!allowed) {
+    doc["error"] = "not possible in this state";
+    sendCommandResult(409);
+  } else if (!queueRemoteCommand(type, number)) {
+    doc["error"] = "busy, try again";
+    sendCommandResult(503);
+  } else {
+    doc["queued"] = true;
+    sendCommandResult(202);
+  }
+}
+
+/*
+ * POST /api/v1/dial?number=123
+ */
+static void handleApiDial() {
+  int number = api->hasArg("number") ? api->arg("number").toInt() : 0;
+  if (number <= 0 || number > 999) {
+    doc.clear();
+    doc["error"] = "number must be 1-999";
+    sendCommandResult(400);
+    return;
+  }
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  PhoneState state = phone.state;
+  bool allowed = state == IDLE || state == OFF_HOOK || state == DIALING || state == IN_CALL;
+  queueCommand(REMOTE_DIAL, number, state, allowed, "dial");
+}
+
+/*
+ * POST /api/v1/answer
+ */
+static void handleApiAnswer() {
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  queueCommand(REMOTE_ANSWER, -1, phone.state, phone.state == RINGING || phone.state == VOICEMAIL, "answer");
+}
+
+/*
+ * POST /api/v1/hangup
+ */
+static void handleApiHangup() {
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  queueCommand(REMOTE_HANGUP, -1, phone.state, true, "hangup");
+}
+
+/*
+ * GET /api/v1/log
+ * The last LOG_TAIL_BYTES of log text, oldest line first
+ */
+static void handleApiLog() {
+  static char text[LOG_TAIL_BYTES];
+  apiRequests++;
+  size_t length = copyLogTail(text, sizeof(text));
+  api->sendHeader("Cache-Control", "no-store");
+  api->send_P(200, "text/plain", text, length);   // No String copy
+}
+
+/*
+ * GET /api/v1/trace
+ * Chrome Trace Event JSON of the trace rings, as a download for Perfetto
+ */
+static void handleApiTrace() {
+  apiRequests++;
+  api->sendHeader("Cache-Control", "no-store");
+  api->sendHeader("Content-Disposition", "attachment; filename=\"retrobell-trace.json\"");
+  api->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  api->send(200, "application/json", "");
+  ResponsePrint response;
+  writeTrace(response);
+  response.finish();
+  api->sendContent("", 0);   // Last chunk
+}
+
+static void addMemoryRegion(JsonObject out, const MemoryRegion& region) {
+  out["total"] = region.total;
+  out["free"] = region.free;
+  out["min_free"] = region.minFree;
+  out["largest_block"] = region.largestBlock;
+  out["fragmentation_permille"] = region.fragmentationPermille;
+}
+
+/*
+ * GET /api/v1/memory
+ * Latest MemoryMonitor sample (see MemoryMonitor.h)
+ */
+static void handleApiMemory() {
+  static MemoryReport report;
+  getMemoryReport(report);
+  doc.clear();
+  doc["sampled_ms"] = report.sampledAt;
+  addMemoryRegion(doc.createNestedObject("internal"), report.internal);
+  addMemoryRegion(doc.createNestedObject("psram"), report.psram);
+  doc["allocated_blocks"] = report.allocatedBlocks;
+
+  JsonArray tags = doc.createNestedArray("tags");
+  for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+    JsonObject tag = tags.createNestedObject();
+    tag["name"] = report.tags[t].name;
+    tag["bytes"] = report.tags[t].bytes;
+    tag["peak_bytes"] = report.tags[t].peakBytes;
+    tag["blocks"] = report.tags[t].blocks;
+    tag["failures"] = report.tags[t].failures;
+  }
+  doc["untagged_bytes"] = report.untaggedBytes;
+
+  JsonArray tasks = doc.createNestedArray("tasks");
+  for (int i = 0; i < report.taskCount; i++) {
+    JsonObject task = tasks.createNestedObject();
+    task["name"] = report.tasks[i].name;
+    task["stack_free"] = report.tasks[i].stackFree;
+  }
+
+  JsonArray alerts = doc.createNestedArray("alerts");
+  if (report.alerts & MEMORY_ALERT_HEAP) alerts.add("heap");
+  if (report.alerts & MEMORY_ALERT_BLOCK) alerts.add("fragmented");
+  if (report.alerts & MEMORY_ALERT_PSRAM) alerts.add("psram");
+  if (report.alerts & MEMORY_ALERT_STACK) alerts.add("stack");
+  doc["alerts_logged"] = report.alertCount;
+  sendJson();
+}
+
+static void addProfileSummary(JsonObject out, const ProfileSummary& summary) {
+  out["count"] = summary.count;
+  out["avg_us"] = summary.averageUs;
+  out["p50_us"] = summary.p50Us;
+  out["p99_us"] = summary.p99Us;
+  out["max_us"] = summary.maxUs;
+}
+
+/*
+ * GET /api/v1/profile
+ * Main loop profile (see Profiler.h). Bucket i of "period_buckets" and
+ * "jitter_buckets" starts at bucket_floor_us[i].
+ */
+static void handleApiProfile() {
+  static ProfileReport report;   // Too big for the web task stack
+  getProfileReport(report);
+  doc.clear();
+  doc["elapsed_ms"] = report.elapsedMs;
+
+  JsonArray sections = doc.createNestedArray("sections");
+  for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+    JsonObject section = sections.createNestedObject();
+    section["name"] = report.sections[i].name;
+    addProfileSummary(section, report.sections[i]);
+    section["share_permille"] = report.sections[i].sharePermille;
+  }
+  addProfileSummary(doc.createNestedObject("period"), report.period);
+  addProfileSummary(doc.createNestedObject("jitter"), report.jitter);
+
+  JsonArray floors = doc.createNestedArray("bucket_floor_us");
+  JsonArray periodBuckets = doc.createNestedArray("period_buckets");
+  JsonArray jitterBuckets = doc.createNestedArray("jitter_buckets");
+  for (int b = 0; b < PROFILE_BUCKETS; b++) {
+    floors.add(profileBucketFloorUs(b));
+    periodBuckets.add(report.periodBuckets[b]);
+    jitterBuckets.add(report.jitterBuckets[b]);
+  }
+
+  JsonArray worst = doc.createNestedArray("worst");
+  for (int w = 0; w < PROFILE_WORST && report.worst[w] >= 0; w++) {
+    worst.add(report.sections[report.worst[w]].name);
+  }
+  sendJson();
+}
+
+/*
+ * GET /api/v1/boot
+ * Boot stage timings (see Boot.h); times in microseconds since the app
+ * started, 0 = not there yet
+ */
+static void handleApiBoot() {
+  BootReport report;
+  getBootReport(report);
+  doc.clear();
+  doc["sequential"] = report.sequential;
+  doc["setup_us"] = report.setupUs;
+  doc["ready_us"] = report.readyUs;
+  doc["complete_us"] = report.completeUs;
+  doc["ready_serial_us"] = report.readySerialUs;
+  doc["total_serial_us"] = report.totalSerialUs;
+
+  JsonArray stages = doc.createNestedArray("stages");
+  for (int i = 0; i < report.stageCount; i++) {
+    const BootStageTiming& timing = report.stages[i];
+    JsonObject stage = stages.createNestedObject();
+    stage["name"] = timing.name;
+    stage["core"] = timing.core;
+    stage["start_us"] = timing.startUs;
+    stage["end_us"] = timing.endUs;
+    stage["wait_us"] = timing.waitUs;
+    stage["before_ready"] = timing.beforeReady;
+  }
+  sendJson();
+}
+
+/*
+ * GET /metrics
+ * Prometheus text format, chunked straight from the registry
+ */
+static void handlePrometheusMetrics() {
+  apiRequests++;
+  api->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  api->send(200, "text/plain; version=0.0.4", "");
+  ResponsePrint response;
+  writeMetrics(response);
+  response.finish();
+  api->sendContent("", 0);   // Last chunk
+}
+
+void setupWebApi(WebServer& server) {
+  api = &server;
+  server.on("/api/v1/status", HTTP_GET, handleApiStatus);
+  server.on("/api/v1/peers", HTTP_GET, handleApiPeers);
+  server.on("/api/v1/call", HTTP_GET, handleApiCall);
+  server.on("/api/v1/metrics", HTTP_GET, handleApiMetrics);
+  server.on("/api/v1/log", HTTP_GET, handleApiLog);
+  server.on("/api/v1/trace", HTTP_GET, handleApiTrace);
+  server.on("/api/v1/profile", HTTP_GET, handleApiProfile);
+  server.on("/api/v1/memory", HTTP_GET, handleApiMemory);
+  server.on("/api/v1/boot", HTTP_GET, handleApiBoot);
+  server.on("/metrics", HTTP_GET, handlePrometheusMetrics);
+  server.on("/api/v1/dial", HTTP_POST, handleApiDial);
+  server.on("/api/v1/answer", HTTP_POST, handleApiAnswer);
+  server.on("/api/v1/hangup", HTTP_POST, handleApiHangup);
+}
+
+void printWebApiStats() {
+  Serial.printf("API: %lu requests, %lu answered 304 Not Modified\n",
+                (unsigned long)apiRequests, (unsigned long)apiNotModified);
+  Serial.printf("  largest body %u of %u bytes JSON capacity, %lu overflows\n",
+                (unsigned)apiLargestBody, (unsigned)API_JSON_CAPACITY, (unsigned long)apiOverflows);
+}
@@ -0,0 +1,39 @@
+/*
+ * WebApi.h - JSON REST API
+ *
+ * Machine-readable status for monitoring a fleet of phones:
+ *
+ *   GET /api/v1/status    number, state, call peer, messages, network
+ *   GET /api/v1/peers     peer directory with last-seen time and RSSI
+ *   GET /api/v1/call      current call: state, peer, conference, recording
+ *   GET /api/v1/metrics   uptime, heap, Wi-Fi, counters, audio deadline
+ *                         misses and bytes copied in the call
+ *   GET /api/v1/log       recent log lines, plain text (see Log.h)
+ *   GET /api/v1/trace     timing spans as Chrome Trace JSON (see Trace.h)
+ *   GET /api/v1/profile   main loop section histograms (see Profiler.h)
+ *   GET /api/v1/memory    heap/PSRAM, tagged buffers, task stacks, alerts
+ *                         (see MemoryMonitor.h)
+ *   GET /api/v1/boot      boot stage timings, time to ready (see Boot.h)
+ *   GET /metrics          Prometheus text format (see Metrics.h)
+ *   POST /api/v1/dial?number=N, /api/v1/answer, /api/v1/hangup
+ *                         call control (see RemoteControl.h)
+ *
+ * Every response carries an ETag (hash of the body). A poller that sends
+ * it back in If-None-Match gets an empty 304 while nothing has changed.
+ * Times are milliseconds/seconds since boot ("uptime_s" in /metrics).
+ */
+
+#ifndef WEB_API_H
+#define WEB_API_H
+
+#include <WebServer.h>
+
+#define API_JSON_CAPACITY 4096   // One static document, reused per request (/profile is the largest)
+
+// Register the /api/v1 routes on the web server
+void setupWebApi(WebServer& server);
+
+// Diagnostics (test mode)
+void printWebApiStats();
+
+#endif // WEB_API_H
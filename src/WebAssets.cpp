@@ -0,0 +1,172 @@
+/*
+ * WebAssets - Static Web Dashboard
+ *
+ * The browser gets the gzip file byte for byte; the phone never
+ * compresses or decompresses anything. Each file is read from flash into
+ * one static WEB_ASSET_CHUNK buffer and written to the socket, so a
+ * request costs no heap and few write calls.
+ *
+ * Caching:
+ * - Names with a content hash (app.<8 hex>.js) never change content:
+ *   "max-age=31536000, immutable" - the browser doesn't even ask again
+ * - Everything else (index.html): "no-cache" - the browser asks every
+ *   time with If-None-Match and usually gets an empty 304
+ */
+
+#include "WebAssets.h"
+#include <LittleFS.h>
+#include <ctype.h>
+
+struct WebAsset {
+  char name[32];          // URI without the leading '/', e.g. "app.1a2b3c4d.js"
+  char etag[12];          // "xxxxxxxx" with quotes
+  uint32_t size;          // Compressed bytes
+  bool immutable;
+};
+
+static WebServer* assetServer = nullptr;
+static WebAsset assets[WEB_ASSET_MAX];
+static int assetCount = 0;
+static uint8_t chunk[WEB_ASSET_CHUNK];
+
+static uint32_t assetRequests = 0;
+static uint32_t assetNotModified = 0;
+static uint32_t assetBytes = 0;
+static uint32_t assetMaxUs = 0;
+
+// True for "name.<8 hex digits>.ext"
+static bool isFingerprinted(const char* name) {
+  const char* dot = strchr(name, '.');
+  if (dot == nullptr) return false;
+  for (int i = 1; i <= 8; i++) {
+    if (!isxdigit((unsigned char)dot[i])) return false;
+  }
+  return dot[9] == '.';
+}
+
+static const char* contentType(const char* name) {
+  const char* extension = strrchr(name, '.');
+  if (extension == nullptr) return "application/octet-stream";
+  if (strcmp(extension, ".html") == 0) return "text/html; charset=utf-8";
+  if (strcmp(extension, ".js") == 0) return "application/javascript";
+  if (strcmp(extension, ".css") == 0) return "text/css";
+  if (strcmp(extension, ".svg") == 0) return "image/svg+xml";
+  if (strcmp(extension, ".json") == 0) return "application/json";
+  if (strcmp(extension, ".ico") == 0) return "image/x-icon";
+  return "application/octet-stream";
+}
+
+/*
+ * Hash Asset
+ * FNV-1a over the compressed file (boot only)
+ */
+static uint32_t hashFile(File& file) {
+  uint32_t hash = 2166136261u;
+  size_t got;
+  while ((got = file.read(chunk, sizeof(chunk))) > 0) {
+    for (size_t i = 0; i < got; i++) {
+      hash = (hash ^ chunk[i]) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+void setupWebAssets(WebServer& server) {
+  assetServer = &server;
+  assetCount = 0;
+
+  File directory = LittleFS.open(WEB_ASSET_DIRECTORY);
+  if (!directory || !directory.isDirectory()) {
+    Serial.println("No web dashboard in " WEB_ASSET_DIRECTORY " - serving the built-in status page");
+    return;
+  }
+
+  File file = directory.openNextFile();
+  while (file) {
+    const char* name = file.name();
+    size_t length = strlen(name);
+    if (!file.isDirectory() && length > 3 && strcmp(name + length - 3, ".gz") == 0) {
+      if (assetCount < WEB_ASSET_MAX && length - 3 < sizeof(assets[0].name)) {
+        WebAsset& asset = assets[assetCount++];
+        memcpy(asset.name, name, length - 3);
+        asset.name[length - 3] = '\0';
+        asset.size = file.size();
+        asset.immutable = isFingerprinted(asset.name);
+        snprintf(asset.etag, sizeof(asset.etag), "\"%08lx\"", (unsigned long)hashFile(file));
+      } else {
+        Serial.print("Web asset skipped (too many files or name too long): ");
+        Serial.println(name);
+      }
+    }
+    file.close();
+    file = directory.openNextFile();
+  }
+  directory.close();
+
+  Serial.print("Web dashboard: ");
+  Serial.print(assetCount);
+  Serial.println(" files");
+}
+
+static const WebAsset* findAsset(const char* uri) {
+  if (*uri == '/') uri++;
+  if (*uri == '\0') uri = "index.html";
+  for (int i = 0; i < assetCount; i++) {
+    if (strcmp(assets[i].name, uri) == 0) return &assets[i];
+  }
+  return nullptr;
+}
+
+bool hasWebDashboard() {
+  return findAsset("/") != nullptr;
+}
+
+bool serveWebAsset(const char* uri) {
+  const WebAsset* asset = findAsset(uri);
+  if (asset == nullptr) return false;
+
+  uint32_t startUs = micros();
+  assetRequests++;
+  WebServer& server = *assetServer;
+  server.sendHeader("ETag", asset->etag);
+  server.sendHeader("Cache-Control", asset->immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  if (server.hasHeader("If-None-Match") && strstr(server.header("If-None-Match").c_str(), asset->etag)) {
+    assetNotModified++;
+    server.send(304);
+    return true;
+  }
+
+  char path[48];
+  snprintf(path, sizeof(path), WEB_ASSET_DIRECTORY "/%s.gz", asset->name);
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    server.send(500, "text/plain", "Web asset missing");
+    return true;
+  }
+
+  server.sendHeader("Content-Encoding", "gzip");
+  server.setContentLength(asset->size);
+  server.send(200, contentType(asset->name), "");
+
+  WiFiClient& client = server.client();
+  size_t got;
+  while (client.connected() && (got = file.read(chunk, sizeof(chunk))) > 0) {
+    client.write(chunk, got);
+    assetBytes += got;
+  }
+  file.close();
+
+  uint32_t elapsed = micros() - startUs;
+  if (elapsed > assetMaxUs) assetMaxUs = elapsed;
+  return true;
+}
+
+void printWebAssetStats() {
+  Serial.printf("Dashboard: %d files, %lu requests, %lu answered 304, %lu bytes sent, slowest %lu us\n",
+                assetCount, (unsigned long)assetRequests, (unsigned long)assetNotModified,
+                (unsigned long)assetBytes, (unsigned long)assetMaxUs);
+  for (int i = 0; i < assetCount; i++) {
+    Serial.printf("  /%s: %lu bytes gzip, %s\n", assets[i].name, (unsigned long)assets[i].size,
+                  assets[i].immutable ? "immutable" : "revalidated");
+  }
+}
@@ -0,0 +1,35 @@
+/*
+ * WebAssets.h - Static Web Dashboard
+ *
+ * Serves the pre-gzipped dashboard (built from web/ by tools/build_web.py
+ * into /www on LittleFS) as-is, with Content-Encoding: gzip:
+ *
+ *   /                  → /www/index.html.gz       Cache-Control: no-cache + ETag
+ *   /app.1a2b3c4d.js   → /www/app.1a2b3c4d.js.gz  cached for a year (name changes with content)
+ *
+ * ETags are hashed once at boot. Without a /www directory the phone
+ * falls back to the built-in status page.
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <WebServer.h>
+
+#define WEB_ASSET_DIRECTORY "/www"
+#define WEB_ASSET_MAX 8
+#define WEB_ASSET_CHUNK 4096     // Bytes per socket write
+
+// Index /www and hash the files (call once, after LittleFS is mounted)
+void setupWebAssets(WebServer& server);
+
+// True if the dashboard is installed
+bool hasWebDashboard();
+
+// Serve uri ("/" = index.html) if it is an asset. Returns false if not.
+bool serveWebAsset(const char* uri);
+
+// Diagnostics (test mode)
+void printWebAssetStats();
+
+#endif // WEB_ASSETS_H
@@ -0,0 +1,383 @@
+/*
+ * WebEvents - Live Status Updates (Server-Sent Events)
+ *
+ *   changeState() ──┐                              ┌─► client 0: next=41 ─► send(MSG_DONTWAIT)
+ *   peer watcher ───┼─► postEvent() ─► ring[16] ───┼─► client 1: next=44
+ *   metrics (5s) ───┘   (portMUX, any task)        └─► client 2: next=30 (fell behind → resync)
+ *
+ * A client copies one event at a time out of the ring into its own buffer
+ * and writes it with a non-blocking send(). If the socket is full the rest
+ * waits for the next handleWebEvents() call; if the ring has wrapped past
+ * the client's position, the missed events are counted and the client is
+ * told to resync. Memory is fixed: the ring plus one event per client.
+ *
+ * Streams are accepted on their own WiFiServer and never pass through
+ * the WebServer: a new connection gets a client slot at once, its request
+ * is read as it arrives (non-blocking, WEB_EVENT_REQUEST_MS at most), and
+ * a GET /events turns the slot into a stream. Nothing else is served here.
+ */
+
+#include "WebEvents.h"
+#include "Network.h"
+#include "WebInterface.h"
+#include "Log.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <stdarg.h>
+
+#define PEER_CHECK_MS 1000
+#define PEER_OFFLINE_MS 30000           // Three missed discovery broadcasts
+
+struct EventSlot {
+  uint32_t sequence;
+  uint16_t length;
+  char text[WEB_EVENT_SIZE];
+};
+
+enum EventClientState {
+  EVENT_CLIENT_FREE,
+  EVENT_CLIENT_REQUEST,                 // Connected, request not read yet
+  EVENT_CLIENT_STREAM
+};
+
+struct EventClient {
+  WiFiClient client;
+  EventClientState state;
+  char request[24];                     // Start of the request line
+  uint8_t requestLength;
+  uint8_t headerEnd;                    // Characters of "\r\n\r\n" seen
+  uint32_t next;                        // Sequence of the next event to send
+  char pending[WEB_EVENT_SIZE];         // Event being written
+  uint16_t pendingLength;
+  uint16_t pendingOffset;
+  unsigned long lastProgress;
+  uint32_t sent;
+  uint32_t dropped;
+};
+
+static WebServer* eventServer = nullptr;
+static WiFiServer eventListener(WEB_EVENT_PORT);
+
+static EventSlot events[WEB_EVENT_SLOTS];
+static uint32_t nextSequence = 1;
+static portMUX_TYPE eventMux = portMUX_INITIALIZER_UNLOCKED;
+
+static EventClient clients[WEB_EVENT_CLIENTS];
+static volatile int activeClients = 0;   // Streaming
+
+// Call tracking for call start/end events
+static int callPeer = -1;
+static unsigned long callStartedAt = 0;
+
+// Peer and metrics watchers (handleWebEvents only)
+static bool peerOnline[MAX_PEERS];
+static unsigned long lastPeerCheck = 0;
+static unsigned long lastMetrics = 0;
+static uint32_t lastHeapKb = 0;
+static int lastRssi = 0;
+static int lastRecordings = -1;
+static int lastMessages = -1;
+
+// Statistics
+static uint32_t eventsPosted = 0;
+static uint32_t eventsTooLong = 0;
+static uint32_t streamsOpened = 0;
+static uint32_t streamsRejected = 0;
+static uint32_t streamsStalled = 0;
+static uint32_t eventsDropped = 0;
+
+/*
+ * Post Event
+ * Formats an SSE frame and stores it in the ring. Safe from any task.
+ */
+static void postEvent(const char* type, const char* format, ...) {
+  if (activeClients == 0) return;   // Nobody listening
+
+  char text[WEB_EVENT_SIZE];
+  int length = snprintf(text, sizeof(text), "event: %s\ndata: ", type);
+  va_list args;
+  va_start(args, format);
+  length += vsnprintf(text + length, sizeof(text) - length, format, args);
+  va_end(args);
+  if (length + 2 >= (int)sizeof(text)) {
+    eventsTooLong++;
+    return;
+  }
+  text[length++] = '\n';
+  text[length++] = '\n';
+
+  portENTER_CRITICAL(&eventMux);
+  EventSlot& slot = events[nextSequence % WEB_EVENT_SLOTS];
+  slot.sequence = nextSequence++;
+  slot.length = length;
+  memcpy(slot.text, text, length);
+  eventsPosted++;
+  portEXIT_CRITICAL(&eventMux);
+}
+
+void notifyStateChange(PhoneState from, PhoneState to) {
+  postEvent("state", "{\"state\":\"%s\",\"from\":\"%s\"}", getStateName(to), getStateName(from));
+
+  if (to == IN_CALL && from != IN_CALL) {
+    callPeer = getCurrentCallPeer();
+    callStartedAt = millis();
+    postEvent("call", "{\"event\":\"start\",\"peer\":%d}", callPeer);
+  } else if (from == IN_CALL) {
+    postEvent("call", "{\"event\":\"end\",\"peer\":%d,\"duration_s\":%lu}",
+              callPeer, (millis() - callStartedAt) / 1000);
+    callPeer = -1;
+  }
+}
+
+static void closeClient(EventClient& c) {
+  c.client.stop();
+  c.client = WiFiClient();
+  if (c.state == EVENT_CLIENT_STREAM) activeClients--;
+  c.state = EVENT_CLIENT_FREE;
+}
+
+/*
+ * Accept Stream
+ * Gives a new connection a client slot; the request is read later
+ */
+static void acceptStream() {
+  WiFiClient incoming = eventListener.available();
+  if (!incoming) return;
+
+  for (int i = 0; i < WEB_EVENT_CLIENTS; i++) {
+    EventClient& c = clients[i];
+    if (c.state != EVENT_CLIENT_FREE) continue;
+    c.client = incoming;
+    c.client.setNoDelay(true);
+    c.state = EVENT_CLIENT_REQUEST;
+    c.requestLength = 0;
+    c.headerEnd = 0;
+    c.lastProgress = millis();
+    return;
+  }
+  streamsRejected++;
+  incoming.print("HTTP/1.1 503 Service Unavailable\r\n"
+                 "Connection: close\r\n\r\n"
+                 "Too many event streams\n");
+  incoming.stop();
+}
+
+/*
+ * Start Stream
+ * GET /events: answer with an open-ended event stream (no Content-Length).
+ * The pages load from port 80, hence the CORS header.
+ */
+static void startStream(EventClient& c) {
+  c.client.print("HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/event-stream\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Access-Control-Allow-Origin: *\r\n"
+                 "Connection: keep-alive\r\n\r\n"
+                 "retry: 3000\n\n");
+
+  // Start with the current state so the page is in sync
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  c.pendingLength = snprintf(c.pending, sizeof(c.pending),
+                             "event: state\ndata: {\"state\":\"%s\"}\n\n", getStateName(phone.state));
+  c.pendingOffset = 0;
+  c.lastProgress = millis();
+  c.sent = 0;
+  c.dropped = 0;
+  portENTER_CRITICAL(&eventMux);
+  c.next = nextSequence;
+  portEXIT_CRITICAL(&eventMux);
+  c.state = EVENT_CLIENT_STREAM;
+  activeClients++;
+  streamsOpened++;
+}
+
+/*
+ * Read Request
+ * Takes what has arrived of the request headers; once they are complete,
+ * starts the stream or turns the connection away
+ */
+static void readRequest(EventClient& c) {
+  while (c.client.available() > 0) {
+    int ch = c.client.read();
+    if (ch < 0) break;
+    if (c.requestLength < sizeof(c.request) - 1) c.request[c.requestLength++] = ch;
+    char expected = (c.headerEnd % 2 == 0) ? '\r' : '\n';
+    c.headerEnd = ch == expected ? c.headerEnd + 1 : (ch == '\r' ? 1 : 0);
+    if (c.headerEnd < 4) continue;
+
+    c.request[c.requestLength] = '\0';
+    const char* path = "GET /events";
+    size_t pathLength = strlen(path);
+    char next = c.request[pathLength];
+    if (strncmp(c.request, path, pathLength) == 0 && (next == ' ' || next == '?')) {
+      startStream(c);
+    } else {
+      c.client.print("HTTP/1.1 404 Not Found\r\n"
+                     "Connection: close\r\n\r\n");
+      closeClient(c);
+    }
+    return;
+  }
+
+  if (!c.client.connected() || millis() - c.lastProgress > WEB_EVENT_REQUEST_MS) {
+    closeClient(c);
+  }
+}
+
+/*
+ * GET /events on port 80
+ * Points the browser at the stream port and lets the connection go
+ */
+static void handleEventRedirect() {
+  eventServer->sendHeader("Location", "http://" + WiFi.localIP().toString() + ":" + String(WEB_EVENT_PORT) + "/events");
+  eventServer->send(307, "text/plain", "Event streams are on port " + String(WEB_EVENT_PORT) + "\n");
+}
+
+/*
+ * Pump Client
+ * Writes as much as the socket takes right now, never waits
+ */
+static void pumpClient(EventClient& c) {
+  for (int i = 0; i <= WEB_EVENT_SLOTS; i++) {
+    if (c.pendingOffset == c.pendingLength) {
+      // Take the next event out of the ring
+      uint32_t skipped = 0;
+      bool have = false;
+      portENTER_CRITICAL(&eventMux);
+      uint32_t oldest = nextSequence > WEB_EVENT_SLOTS ? nextSequence - WEB_EVENT_SLOTS : 1;
+      if (c.next < oldest) {
+        skipped = oldest - c.next;
+        c.next = oldest;
+      } else if (c.next != nextSequence) {
+        const EventSlot& slot = events[c.next % WEB_EVENT_SLOTS];
+        memcpy(c.pending, slot.text, slot.length);
+        c.pendingLength = slot.length;
+        c.next++;
+        have = true;
+      }
+      portEXIT_CRITICAL(&eventMux);
+
+      if (skipped > 0) {
+        c.dropped += skipped;
+        eventsDropped += skipped;
+        c.pendingLength = snprintf(c.pending, sizeof(c.pending),
+                                   "event: resync\ndata: {\"dropped\":%lu}\n\n", (unsigned long)skipped);
+      } else if (!have) {
+        return;   // Up to date
+      }
+      c.pendingOffset = 0;
+    }
+
+    ssize_t written = send(c.client.fd(), c.pending + c.pendingOffset,
+                           c.pendingLength - c.pendingOffset, MSG_DONTWAIT);
+    if (written < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      closeClient(c);   // Browser went away
+      return;
+    }
+    c.pendingOffset += written;
+    c.lastProgress = millis();
+    if (c.pendingOffset < c.pendingLength) break;   // Socket full
+    c.sent++;
+  }
+
+  // Stopped reading altogether
+  if (c.pendingOffset < c.pendingLength && millis() - c.lastProgress > WEB_EVENT_STALL_MS) {
+    streamsStalled++;
+    LOG_WARN("Event stream stalled - disconnecting");
+    closeClient(c);
+  }
+}
+
+/*
+ * Watch Peers
+ * A peer is online while its discovery broadcasts keep arriving
+ */
+static void watchPeers() {
+  PeerStatus peers[MAX_PEERS];
+  int count = getPeerDirectory(peers, MAX_PEERS);
+  for (int i = 0; i < count; i++) {
+    bool online = peers[i].lastSeen > 0 && millis() - peers[i].lastSeen < PEER_OFFLINE_MS;
+    if (online != peerOnline[i]) {
+      peerOnline[i] = online;
+      postEvent("peer", "{\"number\":%d,\"online\":%s,\"rssi\":%d}",
+                peers[i].number, online ? "true" : "false", peers[i].rssi);
+    }
+  }
+}
+
+/*
+ * Post Metrics
+ * Uptime plus whatever changed since the last metrics event
+ */
+static void postMetrics() {
+  PhoneSnapshot phone;
+  getPhoneSnapshot(phone);
+  char fields[96];
+  int length = snprintf(fields, sizeof(fields), "\"uptime_s\":%lu", millis() / 1000);
+
+  uint32_t heapKb = ESP.getFreeHeap() / 1024;
+  if (heapKb != lastHeapKb) {
+    lastHeapKb = heapKb;
+    length += snprintf(fields + length, sizeof(fields) - length, ",\"heap_kb\":%lu", (unsigned long)heapKb);
+  }
+  int rssi = WiFi.RSSI();
+  if (rssi != lastRssi) {
+    lastRssi = rssi;
+    length += snprintf(fields + length, sizeof(fields) - length, ",\"rssi\":%d", rssi);
+  }
+  int recordings = phone.recordings;
+  if (recordings != lastRecordings) {
+    lastRecordings = recordings;
+    length += snprintf(fields + length, sizeof(fields) - length, ",\"recordings\":%d", recordings);
+  }
+  int messages = phone.newMessages;
+  if (messages != lastMessages) {
+    lastMessages = messages;
+    snprintf(fields + length, sizeof(fields) - length, ",\"messages\":%d", messages);
+  }
+  postEvent("metrics", "{%s}", fields);
+}
+
+void handleWebEvents() {
+  acceptStream();
+  for (int i = 0; i < WEB_EVENT_CLIENTS; i++) {
+    if (clients[i].state == EVENT_CLIENT_REQUEST) readRequest(clients[i]);
+  }
+  if (activeClients == 0) return;
+
+  if (millis() - lastPeerCheck >= PEER_CHECK_MS) {
+    lastPeerCheck = millis();
+    watchPeers();
+  }
+  if (millis() - lastMetrics >= WEB_EVENT_METRICS_MS) {
+    lastMetrics = millis();
+    postMetrics();
+  }
+
+  for (int i = 0; i < WEB_EVENT_CLIENTS; i++) {
+    if (clients[i].state == EVENT_CLIENT_STREAM) pumpClient(clients[i]);
+  }
+}
+
+void setupWebEvents(WebServer& server) {
+  eventServer = &server;
+  server.on("/events", HTTP_GET, handleEventRedirect);
+  eventListener.setNoDelay(true);
+  eventListener.begin();
+}
+
+void printWebEventStats() {
+  Serial.printf("Events: %d/%d streams open, %lu opened, %lu rejected (full), %lu stalled\n",
+                activeClients, WEB_EVENT_CLIENTS, (unsigned long)streamsOpened,
+                (unsigned long)streamsRejected, (unsigned long)streamsStalled);
+  Serial.printf("  %lu events posted, %lu skipped by slow clients, %lu too long\n",
+                (unsigned long)eventsPosted, (unsigned long)eventsDropped, (unsigned long)eventsTooLong);
+  for (int i = 0; i < WEB_EVENT_CLIENTS; i++) {
+    if (clients[i].state != EVENT_CLIENT_STREAM) continue;
+    IPAddress ip = clients[i].client.remoteIP();
+    Serial.printf("  stream %d: %u.%u.%u.%u, %lu sent, %lu skipped\n", i, ip[0], ip[1], ip[2], ip[3],
+                  (unsigned long)clients[i].sent, (unsigned long)clients[i].dropped);
+  }
+}
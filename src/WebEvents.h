@@ -0,0 +1,51 @@
+/*
+ * WebEvents.h - Live Status Updates (Server-Sent Events)
+ *
+ * Browsers open GET /events on port WEB_EVENT_PORT (EventSource) and get
+ * pushed:
+ *
+ *   event: state     {"state":"RINGING","from":"IDLE"}
+ *   event: call      {"event":"start","peer":123} / {"event":"end","peer":123,"duration_s":42}
+ *   event: peer      {"number":123,"online":true,"rssi":-61}
+ *   event: metrics   {"uptime_s":600,"heap_kb":182}   (every 5s, changed fields only)
+ *   event: resync    {"dropped":4}                    (client fell behind - reload)
+ *
+ * Events go into one small ring buffer; every client has its own read
+ * position in it. Sockets are written without blocking: a client that
+ * can't keep up just skips ahead (resync), and one that stops reading
+ * entirely is disconnected. The phone never waits for a browser.
+ *
+ * The streams have their own listening socket: the WebServer on port 80
+ * serves one connection at a time and keeps waiting on a connection that
+ * is still open after its handler returns, so a stream there would stall
+ * every other request. GET /events on port 80 redirects here.
+ */
+
+#ifndef WEB_EVENTS_H
+#define WEB_EVENTS_H
+
+#include <WebServer.h>
+#include "State.h"
+
+#define WEB_EVENT_PORT 81               // Event streams (port 80 redirects /events here)
+#define WEB_EVENT_CLIENTS 3             // Open event streams at once
+#define WEB_EVENT_SLOTS 16              // Events buffered for slow clients
+#define WEB_EVENT_SIZE 160              // Longest event, including SSE framing
+#define WEB_EVENT_METRICS_MS 5000
+#define WEB_EVENT_STALL_MS 15000        // No progress for this long → disconnect
+#define WEB_EVENT_REQUEST_MS 2000       // A new connection must send its request by then
+
+// Listen on WEB_EVENT_PORT, redirect /events on the web server there
+void setupWebEvents(WebServer& server);
+
+// Record a state transition (called from changeState, any task)
+void notifyStateChange(PhoneState from, PhoneState to);
+
+// Accept streams, watch peers, emit metrics and write pending events
+// (call with the web server)
+void handleWebEvents();
+
+// Diagnostics (test mode)
+void printWebEventStats();
+
+#endif // WEB_EVENTS_H
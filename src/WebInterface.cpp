@@ -3,144 +3,646 @@
  * 
  * Simple HTTP server that displays phone status and debug information.
  * Useful for monitoring system state, viewing peer list, and troubleshooting.
+ *
+ * Pages are HTML templates in flash, streamed in WEB_CHUNK_SIZE chunks with
+ * only the dynamic fields formatted per request - no String building, no
+ * heap allocations in the page handlers.
+ *
+ *   main loop (core 1)                     web task (core 0, priority 1)
+ *   updateWebSnapshot() ──► snapshot ──►   handleClient() → handlers
+ *     + loop gap stats      (portMUX)      handleWebEvents()
+ *
+ * The server runs in its own task so a slow client or a big download
+ * only ever delays other web requests, never the loop's audio work. The
+ * handlers use the snapshot for anything the state machine owns; the
+ * peer directory and recording index have their own locks.
  */
 
 #include "WebInterface.h"
 #include "State.h"
 #include "Configuration.h"
 #include "Network.h"
+#include "Conference.h"
+#include "CallRecorder.h"
+#include "Speakerphone.h"
+#include "WebApi.h"
+#include "WebEvents.h"
+#include "MemoryMonitor.h"
+#include "AudioMonitor.h"
+#include "WebAssets.h"
+#include "RemoteControl.h"
+#include "Trace.h"
+#include <LittleFS.h>
 #include <WebServer.h>
 #include <WiFi.h>
 #include <esp_system.h>
+#include <esp_wifi.h>
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+
+#define WEB_CHUNK_SIZE 512   // One HTTP chunk; lives in a static buffer
+
+// Loop gaps during a call: one mic packet, and the whole I2S DMA queue
+// (8 x 64 samples) after which audio drops out
+#define LOOP_PACKET_US (AUDIO_SAMPLES_PER_PACKET * 1000000UL / 16000)
+#define LOOP_DEADLINE_US (8 * 64 * 1000000UL / 16000)
 
 // Web server instance on port 80
 WebServer server(80);
 
 /*
- * Get State Name as String
- * Converts PhoneState enum to human-readable string
+ * Page Writer
+ * 
+ * Collects output in a fixed buffer and sends it as one HTTP chunk
+ * whenever it fills up. Pages are streamed with chunked transfer encoding
+ * (no Content-Length needed) so nothing is ever built on the heap.
  */
-const char* getStateName(PhoneState state) {
-  switch (state) {
-    case IDLE: return "IDLE";
-    case OFF_HOOK: return "OFF_HOOK";
-    case DIALING: return "DIALING";
-    case CALLING: return "CALLING";
-    case RINGING: return "RINGING";
-    case IN_CALL: return "IN_CALL";
-    case CALL_FAILED: return "CALL_FAILED";
-    case CALL_BUSY: return "CALL_BUSY";
-    default: return "UNKNOWN";
+struct PageWriter {
+  char buffer[WEB_CHUNK_SIZE];
+  size_t length;
+  size_t total;
+};
+
+static void flushPage(PageWriter& page) {
+  if (page.length == 0) return;
+  server.sendContent(page.buffer, page.length);
+  page.total += page.length;
+  page.length = 0;
+}
+
+static void writeBytes(PageWriter& page, const char* data, size_t length) {
+  while (length > 0) {
+    size_t space = sizeof(page.buffer) - page.length;
+    size_t chunk = length < space ? length : space;
+    memcpy(page.buffer + page.length, data, chunk);
+    page.length += chunk;
+    data += chunk;
+    length -= chunk;
+    if (page.length == sizeof(page.buffer)) flushPage(page);
+  }
+}
+
+static void writeText(PageWriter& page, const char* text) {
+  writeBytes(page, text, strlen(text));
+}
+
+static void writeFormat(PageWriter& page, const char* format, ...) {
+  char field[128];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(field, sizeof(field), format, args);
+  va_end(args);
+  if (length > 0) writeBytes(page, field, min((size_t)length, sizeof(field) - 1));
+}
+
+// Text from outside (e.g. the SSID) with HTML special characters escaped
+static void writeEscaped(PageWriter& page, const char* text) {
+  for (; *text; text++) {
+    switch (*text) {
+      case '<': writeText(page, "&lt;"); break;
+      case '>': writeText(page, "&gt;"); break;
+      case '&': writeText(page, "&amp;"); break;
+      case '\'': writeText(page, "&#39;"); break;
+      case '"': writeText(page, "&quot;"); break;
+      default: writeBytes(page, text, 1); break;
+    }
   }
 }
 
+static void beginPage(PageWriter& page) {
+  page.length = 0;
+  page.total = 0;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+}
+
+static void endPage(PageWriter& page) {
+  flushPage(page);
+  server.sendContent("", 0);   // Terminating chunk
+}
+
+/*
+ * Stream Template
+ * 
+ * Copies a PROGMEM template to the page, replacing every %NAME% marker with
+ * the output of fieldWriter. Templates must not contain a literal '%'.
+ */
+static void streamTemplate(PageWriter& page, PGM_P templ,
+                           void (*fieldWriter)(PageWriter& page, const char* name)) {
+  const char* text = templ;
+  while (*text) {
+    const char* marker = strchr(text, '%');
+    if (!marker) {
+      writeText(page, text);
+      break;
+    }
+    writeBytes(page, text, marker - text);
+    const char* close = strchr(marker + 1, '%');
+    if (!close) break;   // Broken template - stop rather than loop
+
+    char name[16];
+    size_t nameLength = min((size_t)(close - marker - 1), sizeof(name) - 1);
+    memcpy(name, marker + 1, nameLength);
+    name[nameLength] = '\0';
+    fieldWriter(page, name);
+    text = close + 1;
+  }
+}
+
+// Heap counters around each request (see printWebStats)
+struct HeapSnapshot {
+  size_t freeBytes;
+  size_t allocatedBlocks;
+};
+
+static HeapSnapshot takeHeapSnapshot() {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  HeapSnapshot snapshot = {info.total_free_bytes, info.allocated_blocks};
+  return snapshot;
+}
+
+struct PageStats {
+  uint32_t requests;
+  uint32_t bytes;              // Last response
+  uint32_t lastUs;
+  uint32_t maxUs;
+  int32_t blocksDelta;         // Allocated blocks after - before, last request
+  int32_t maxBlocksDelta;      // Worst request (anything > 0 is a leak or a cache)
+  int32_t freeDelta;           // Free heap after - before, last request
+};
+
+static PageStats rootStats = {0, 0, 0, 0, 0, 0, 0};
+static PageStats recordingsStats = {0, 0, 0, 0, 0, 0, 0};
+
+// Web task and snapshot
+static TaskHandle_t webTask = NULL;
+static uint32_t webTaskMaxUs = 0;
+static PhoneSnapshot snapshot;
+static portMUX_TYPE snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long lastSnapshotAt = 0;
+
+// Main loop gaps while in a call (see updateWebSnapshot)
+static uint32_t lastLoopUs = 0;
+static uint32_t loopPasses = 0;
+static uint32_t loopMaxGapUs = 0;
+static uint32_t loopLatePasses = 0;
+static uint32_t loopDeadlineMisses = 0;
+
+static void recordPageStats(PageStats& stats, const HeapSnapshot& before, uint32_t startUs, size_t bytes) {
+  HeapSnapshot after = takeHeapSnapshot();
+  uint32_t elapsed = micros() - startUs;
+  stats.requests++;
+  stats.bytes = bytes;
+  stats.lastUs = elapsed;
+  if (elapsed > stats.maxUs) stats.maxUs = elapsed;
+  stats.blocksDelta = (int32_t)after.allocatedBlocks - (int32_t)before.allocatedBlocks;
+  if (stats.blocksDelta > stats.maxBlocksDelta) stats.maxBlocksDelta = stats.blocksDelta;
+  stats.freeDelta = (int32_t)after.freeBytes - (int32_t)before.freeBytes;
+}
+
+/*
+ * Status Page Template
+ * Static HTML lives in flash; only the %FIELDS% are generated per request.
+ */
+static const char STATUS_PAGE[] PROGMEM = R"rawliteral(<!DOCTYPE html><html><head>
+<meta charset='UTF-8'>
+<meta name='viewport' content='width=device-width, initial-scale=1.0'>
+<noscript><meta http-equiv='refresh' content='5'></noscript>
+<title>RetroBell Status</title>
+<style>
+body { font-family: Arial, sans-serif; margin: 20px; background: #f0f0f0; }
+.container { max-width: 800px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }
+h1 { color: #333; border-bottom: 2px solid #007bff; padding-bottom: 10px; }
+h2 { color: #555; margin-top: 20px; }
+.status { font-size: 24px; font-weight: bold; color: #007bff; padding: 10px; background: #e7f3ff; border-radius: 5px; }
+.info-row { display: flex; justify-content: space-between; padding: 8px; border-bottom: 1px solid #eee; }
+.label { font-weight: bold; color: #666; }
+.value { color: #333; }
+.peer { background: #f8f9fa; padding: 10px; margin: 5px 0; border-radius: 5px; border-left: 4px solid #28a745; }
+.footer { margin-top: 20px; text-align: center; color: #999; font-size: 12px; }
+</style>
+</head><body>
+<div class='container'>
+<h1>🔔 RetroBell Status</h1>
+<p style='color: #666; font-style: italic;'>Who you gonna call?</p>
+<h2>Current State</h2>
+<div class='status' id='state'>%STATE%</div>
+<h2>Phone Configuration</h2>
+<div class='info-row'><span class='label'>Phone Number:</span><span class='value'>%NUMBER%</span></div>
+<div class='info-row'><span class='label'>MAC Address:</span><span class='value'>%MAC%</span></div>
+<div class='info-row'><span class='label'>IP Address:</span><span class='value'>%IP%</span></div>
+<div class='info-row'><span class='label'>WiFi SSID:</span><span class='value'>%SSID%</span></div>
+<div class='info-row'><span class='label'>WiFi Channel:</span><span class='value'>%CHANNEL%</span></div>
+<div class='info-row'><span class='label'>Signal Strength:</span><span class='value'><span id='rssi'>%RSSI%</span> dBm</span></div>
+<h2>System Information</h2>
+<div class='info-row'><span class='label'>Uptime:</span><span class='value'><span id='uptime'>%UPTIME%</span> seconds</span></div>
+<div class='info-row'><span class='label'>Free Heap:</span><span class='value'><span id='heap'>%HEAP%</span> KB</span></div>
+<div class='info-row'><span class='label'>CPU Frequency:</span><span class='value'>%CPU% MHz</span></div>
+<div class='info-row'><span class='label'>Flash Size:</span><span class='value'>%FLASH% MB</span></div>
+<h2>Call Status</h2>
+%CALL%
+<h2>Recordings</h2>
+<div class='info-row'><span class='label'>Saved recordings:</span><span class='value'><a href='/recordings' id='recordings'>%RECORDINGS%</a></span></div>
+<div class='info-row'><span class='label'>New messages:</span><span class='value' id='messages'>%MESSAGES%</span></div>
+<h2>Discovered Peers</h2>
+<p style='color: #666; font-size: 14px;'>Phones discovered on the network:</p>
+%PEERS%
+<div class='footer'>
+Live updates from /events (port 81)<br>
+RetroBell &copy; 2025
+</div>
+</div>
+<script>
+if (window.EventSource) {
+  var events = new EventSource('http://' + location.hostname + ':81/events');
+  function set(id, value) { var e = document.getElementById(id); if (e && value !== undefined) e.textContent = value; }
+  function json(e) { return JSON.parse(e.data); }
+  events.addEventListener('state', function(e) { set('state', json(e).state); });
+  events.addEventListener('metrics', function(e) {
+    var m = json(e);
+    set('uptime', m.uptime_s); set('heap', m.heap_kb); set('rssi', m.rssi);
+    set('recordings', m.recordings); set('messages', m.messages);
+  });
+  events.addEventListener('peer', function(e) {
+    var p = json(e), row = document.getElementById('peer-' + p.number);
+    if (row) row.style.opacity = p.online ? 1 : 0.4; else if (p.online) location.reload();
+  });
+  events.addEventListener('call', function() { location.reload(); });
+  events.addEventListener('resync', function() { location.reload(); });
+}
+</script>
+</body></html>
+)rawliteral";
+
+// Snapshot taken at the start of each status page
+static PhoneSnapshot pageSnapshot;
+
+static void writeStatusField(PageWriter& page, const char* name) {
+  const PhoneSnapshot& phone = pageSnapshot;
+  if (strcmp(name, "STATE") == 0) {
+    writeText(page, getStateName(phone.state));
+  } else if (strcmp(name, "NUMBER") == 0) {
+    writeFormat(page, "%d", getPhoneNumber());
+  } else if (strcmp(name, "MAC") == 0) {
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    writeFormat(page, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  } else if (strcmp(name, "IP") == 0) {
+    IPAddress ip = WiFi.localIP();
+    writeFormat(page, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  } else if (strcmp(name, "SSID") == 0) {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+      writeEscaped(page, (const char*)ap.ssid);
+    }
+  } else if (strcmp(name, "CHANNEL") == 0) {
+    writeFormat(page, "%d", WiFi.channel());
+  } else if (strcmp(name, "RSSI") == 0) {
+    writeFormat(page, "%d", WiFi.RSSI());
+  } else if (strcmp(name, "UPTIME") == 0) {
+    writeFormat(page, "%lu", millis() / 1000);
+  } else if (strcmp(name, "HEAP") == 0) {
+    writeFormat(page, "%lu", (unsigned long)(ESP.getFreeHeap() / 1024));
+  } else if (strcmp(name, "CPU") == 0) {
+    writeFormat(page, "%lu", (unsigned long)ESP.getCpuFreqMHz());
+  } else if (strcmp(name, "FLASH") == 0) {
+    writeFormat(page, "%lu", (unsigned long)(ESP.getFlashChipSize() / (1024 * 1024)));
+  } else if (strcmp(name, "CALL") == 0) {
+    if (phone.callPeer >= 0) {
+      writeFormat(page, "<div class='info-row'><span class='label'>Connected to:</span><span class='value'>Phone #%d</span></div>", phone.callPeer);
+      if (phone.conferenceCount > 0) {
+        writeText(page, "<div class='info-row'><span class='label'>Conference:</span><span class='value'>");
+        for (int i = 0; i < phone.conferenceCount; i++) {
+          writeFormat(page, "#%d ", phone.conference[i]);
+        }
+        writeText(page, "</span></div>");
+      }
+    } else {
+      writeText(page, "<div class='info-row'><span class='label'>Call Status:</span><span class='value'>No active call</span></div>");
+    }
+  } else if (strcmp(name, "RECORDINGS") == 0) {
+    writeFormat(page, "%d", phone.recordings);
+  } else if (strcmp(name, "MESSAGES") == 0) {
+    writeFormat(page, "%d", phone.newMessages);
+  } else if (strcmp(name, "PEERS") == 0) {
+    PeerStatus peers[MAX_PEERS];
+    int count = getPeerDirectory(peers, MAX_PEERS);
+    if (count == 0) {
+      writeText(page, "<p style='color: #999; font-style: italic;'>No peers discovered yet</p>");
+    }
+    for (int i = 0; i < count; i++) {
+      const uint8_t* mac = peers[i].macAddress;
+      writeFormat(page, "<div class='info-row' id='peer-%d'><span class='label'>Phone #%d:</span><span class='value'>",
+                  peers[i].number, peers[i].number);
+      writeFormat(page, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+      if (peers[i].lastSeen > 0) {
+        writeFormat(page, ", seen %lus ago", (millis() - peers[i].lastSeen) / 1000);
+      }
+      if (peers[i].rssi != 0) {
+        writeFormat(page, ", %d dBm", peers[i].rssi);
+      }
+      writeText(page, "</span></div>");
+    }
+  }
+}
+
+// One page buffer, shared by the page handlers (the server handles one request at a time)
+static PageWriter page;
+
 /*
  * Root Page Handler
  * Displays main status page with phone info
  */
 void handleRoot() {
-  String html = "<!DOCTYPE html><html><head>";
-  html += "<meta charset='UTF-8'>";
-  html += "<meta name='viewport' content='width=device-width, initial-scale=1.0'>";
-  html += "<meta http-equiv='refresh' content='5'>"; // Auto-refresh every 5 seconds
-  html += "<title>RetroBell Status</title>";
-  html += "<style>";
-  html += "body { font-family: Arial, sans-serif; margin: 20px; background: #f0f0f0; }";
-  html += ".container { max-width: 800px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }";
-  html += "h1 { color: #333; border-bottom: 2px solid #007bff; padding-bottom: 10px; }";
-  html += "h2 { color: #555; margin-top: 20px; }";
-  html += ".status { font-size: 24px; font-weight: bold; color: #007bff; padding: 10px; background: #e7f3ff; border-radius: 5px; }";
-  html += ".info-row { display: flex; justify-content: space-between; padding: 8px; border-bottom: 1px solid #eee; }";
-  html += ".label { font-weight: bold; color: #666; }";
-  html += ".value { color: #333; }";
-  html += ".peer { background: #f8f9fa; padding: 10px; margin: 5px 0; border-radius: 5px; border-left: 4px solid #28a745; }";
-  html += ".footer { margin-top: 20px; text-align: center; color: #999; font-size: 12px; }";
-  html += "</style>";
-  html += "</head><body>";
-  html += "<div class='container'>";
+  HeapSnapshot before = takeHeapSnapshot();
+  uint32_t startUs = micros();
   
-  // Header
-  html += "<h1>🔔 RetroBell Status</h1>";
-  html += "<p style='color: #666; font-style: italic;'>Who you gonna call?</p>";
+  getPhoneSnapshot(pageSnapshot);
+  beginPage(page);
+  streamTemplate(page, STATUS_PAGE, writeStatusField);
+  endPage(page);
   
-  // Current State
-  html += "<h2>Current State</h2>";
-  html += "<div class='status'>" + String(getStateName(getCurrentState())) + "</div>";
+  recordPageStats(rootStats, before, startUs, page.total);
+}
+
+/*
+ * Recordings Page Handler
+ * Lists saved call recordings and voicemail messages with download links
+ */
+void handleRecordings() {
+  HeapSnapshot before = takeHeapSnapshot();
+  uint32_t startUs = micros();
   
-  // Phone Configuration
-  html += "<h2>Phone Configuration</h2>";
-  html += "<div class='info-row'><span class='label'>Phone Number:</span><span class='value'>" + String(getPhoneNumber()) + "</span></div>";
-  html += "<div class='info-row'><span class='label'>MAC Address:</span><span class='value'>" + WiFi.macAddress() + "</span></div>";
-  html += "<div class='info-row'><span class='label'>IP Address:</span><span class='value'>" + WiFi.localIP().toString() + "</span></div>";
-  html += "<div class='info-row'><span class='label'>WiFi SSID:</span><span class='value'>" + WiFi.SSID() + "</span></div>";
-  html += "<div class='info-row'><span class='label'>WiFi Channel:</span><span class='value'>" + String(WiFi.channel()) + "</span></div>";
-  html += "<div class='info-row'><span class='label'>Signal Strength:</span><span class='value'>" + String(WiFi.RSSI()) + " dBm</span></div>";
+  beginPage(page);
+  writeText(page, "<!DOCTYPE html><html><head>"
+                  "<meta charset='UTF-8'>"
+                  "<title>RetroBell Recordings</title>"
+                  "<style>body { font-family: Arial, sans-serif; margin: 20px; } td, th { padding: 6px 12px; text-align: left; }</style>"
+                  "</head><body>"
+                  "<h1>Recordings</h1>"
+                  "<p><a href='/'>Back to status</a></p>"
+                  "<table><tr><th>#</th><th>Type</th><th>Peer</th><th>Length</th><th>Size</th><th></th></tr>");
   
-  // System Info
-  html += "<h2>System Information</h2>";
-  html += "<div class='info-row'><span class='label'>Uptime:</span><span class='value'>" + String(millis() / 1000) + " seconds</span></div>";
-  html += "<div class='info-row'><span class='label'>Free Heap:</span><span class='value'>" + String(ESP.getFreeHeap() / 1024) + " KB</span></div>";
-  html += "<div class='info-row'><span class='label'>CPU Frequency:</span><span class='value'>" + String(ESP.getCpuFreqMHz()) + " MHz</span></div>";
-  html += "<div class='info-row'><span class='label'>Flash Size:</span><span class='value'>" + String(ESP.getFlashChipSize() / (1024 * 1024)) + " MB</span></div>";
+  // Newest first
+  RecordingInfo info;
+  for (int i = getRecordingCount() - 1; i >= 0; i--) {
+    if (!getRecordingInfo(i, info)) continue;
+    writeFormat(page, "<tr><td>%lu</td>", (unsigned long)info.id);
+    if (info.kind == RECORDING_MESSAGE) {
+      writeText(page, info.heard ? "<td>Message</td>" : "<td><b>New message</b></td>");
+    } else {
+      writeText(page, "<td>Call</td>");
+    }
+    if (info.peer >= 0) {
+      writeFormat(page, "<td>#%d</td>", info.peer);
+    } else {
+      writeText(page, "<td>?</td>");
+    }
+    writeFormat(page, "<td>%lu s</td><td>%lu KB</td>",
+                (unsigned long)(info.durationMs / 1000), (unsigned long)(info.bytes / 1024));
+    writeFormat(page, "<td><a href='/recording?id=%lu'>download</a></td></tr>", (unsigned long)info.id);
+  }
+  writeText(page, "</table></body></html>");
+  endPage(page);
   
-  // Call Info
-  html += "<h2>Call Status</h2>";
-  int callPeer = getCurrentCallPeer();
-  if (callPeer >= 0) {
-    html += "<div class='info-row'><span class='label'>Connected to:</span><span class='value'>Phone #" + String(callPeer) + "</span></div>";
+  recordPageStats(recordingsStats, before, startUs, page.total);
+}
+
+/*
+ * Parse Range Header
+ * Supports a single "bytes=start-end", "bytes=start-" or "bytes=-suffix".
+ * Returns false if the range is malformed or outside the file.
+ */
+static bool parseRange(const String& header, size_t fileSize, size_t& start, size_t& end) {
+  if (!header.startsWith("bytes=") || header.indexOf(',') >= 0 || fileSize == 0) {
+    return false;
+  }
+  int dash = header.indexOf('-');
+  if (dash < 0) return false;
+  
+  String first = header.substring(6, dash);
+  String last = header.substring(dash + 1);
+  if (first.length() == 0) {
+    // Suffix range: the last N bytes
+    size_t suffix = last.toInt();
+    if (suffix == 0) return false;
+    start = suffix >= fileSize ? 0 : fileSize - suffix;
+    end = fileSize - 1;
   } else {
-    html += "<div class='info-row'><span class='label'>Call Status:</span><span class='value'>No active call</span></div>";
+    start = first.toInt();
+    end = last.length() > 0 ? (size_t)last.toInt() : fileSize - 1;
+    if (end >= fileSize) end = fileSize - 1;
+  }
+  return start <= end && start < fileSize;
+}
+
+/*
+ * Recording Download Handler
+ * Streams /rec/<id>.wav in 1KB chunks. Honours Range requests (206) so
+ * browsers can seek in the audio player without fetching the whole file.
+ */
+void handleRecordingDownload() {
+  RecordingInfo info;
+  if (!server.hasArg("id") || !findRecording(server.arg("id").toInt(), info)) {
+    server.send(404, "text/plain", "Recording not found");
+    return;
   }
   
-  // Discovered Peers
-  html += "<h2>Discovered Peers</h2>";
-  html += "<p style='color: #666; font-size: 14px;'>Phones discovered on the network:</p>";
-  // Note: We'll need to add a function to get peer list from Network module
-  html += "<p style='color: #999; font-style: italic;'>Peer list display coming soon...</p>";
+  char path[32];
+  getRecordingPath(info.id, path, sizeof(path));
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    server.send(404, "text/plain", "Recording not found");
+    return;
+  }
   
-  // Footer
-  html += "<div class='footer'>";
-  html += "Page auto-refreshes every 5 seconds<br>";
-  html += "RetroBell &copy; 2025";
-  html += "</div>";
+  size_t fileSize = file.size();
+  size_t start = 0;
+  size_t end = fileSize - 1;
+  int code = 200;
   
-  html += "</div></body></html>";
+  server.sendHeader("Accept-Ranges", "bytes");
+  if (server.hasHeader("Range")) {
+    if (!parseRange(server.header("Range"), fileSize, start, end)) {
+      server.sendHeader("Content-Range", "bytes */" + String(fileSize));
+      server.send(416, "text/plain", "Range not satisfiable");
+      file.close();
+      return;
+    }
+    code = 206;
+    server.sendHeader("Content-Range", "bytes " + String(start) + "-" + String(end) + "/" + String(fileSize));
+  }
+  
+  size_t remaining = end - start + 1;
+  server.sendHeader("Content-Disposition", "inline; filename=\"call-" + String(info.id) + ".wav\"");
+  server.setContentLength(remaining);
+  server.send(code, "audio/wav", "");
   
-  server.send(200, "text/html", html);
+  file.seek(start);
+  uint8_t buffer[1024];
+  WiFiClient& client = server.client();
+  while (remaining > 0 && client.connected()) {
+    size_t chunk = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+    size_t got = file.read(buffer, chunk);
+    if (got == 0) break;
+    client.write(buffer, got);
+    remaining -= got;
+  }
+  file.close();
+}
+
+/*
+ * Print Web Stats
+ * Response size, time and heap counters for the streamed pages
+ */
+static void printPageStats(const char* name, const PageStats& stats) {
+  Serial.printf("%s: %lu requests, last %lu bytes in %lu us (max %lu us)\n", name,
+                (unsigned long)stats.requests, (unsigned long)stats.bytes,
+                (unsigned long)stats.lastUs, (unsigned long)stats.maxUs);
+  Serial.printf("  heap blocks %+ld (worst %+ld), free heap %+ld bytes\n",
+                (long)stats.blocksDelta, (long)stats.maxBlocksDelta, (long)stats.freeDelta);
+}
+
+void printWebStats() {
+  Serial.println();
+  Serial.println("========== WEB INTERFACE ==========");
+  printPageStats("Status page", rootStats);
+  printPageStats("Recordings", recordingsStats);
+  printWebApiStats();
+  printWebEventStats();
+  printWebAssetStats();
+  printRemoteControlStats();
+  Serial.println("Heap deltas are measured before/after each page (0 = no allocations left behind)");
+  Serial.printf("Web task: core %d, priority %d, %lu us longest pass, %u bytes stack unused\n",
+                WEB_TASK_CORE, WEB_TASK_PRIORITY, (unsigned long)webTaskMaxUs,
+                webTask ? (unsigned)uxTaskGetStackHighWaterMark(webTask) : 0);
+  Serial.printf("Main loop in calls: %lu passes, longest gap %lu us\n",
+                (unsigned long)loopPasses, (unsigned long)loopMaxGapUs);
+  Serial.printf("  %lu gaps > %lu us (one packet), %lu > %lu us (audio deadline missed)\n",
+                (unsigned long)loopLatePasses, (unsigned long)LOOP_PACKET_US,
+                (unsigned long)loopDeadlineMisses, (unsigned long)LOOP_DEADLINE_US);
+  Serial.println("===================================");
+}
+
+void resetWebStats() {
+  rootStats = PageStats();
+  recordingsStats = PageStats();
+  webTaskMaxUs = 0;
+  loopPasses = 0;
+  loopMaxGapUs = 0;
+  loopLatePasses = 0;
+  loopDeadlineMisses = 0;
 }
 
 /*
  * 404 Not Found Handler
  */
 void handleNotFound() {
+  if (server.method() == HTTP_GET && serveWebAsset(server.uri().c_str())) return;
+  
   String message = "404: Not Found\n\n";
   message += "URI: " + server.uri() + "\n";
   message += "Method: " + String((server.method() == HTTP_GET) ? "GET" : "POST") + "\n";
   server.send(404, "text/plain", message);
 }
 
+/*
+ * Publish Snapshot
+ * Main loop: copy what the handlers need out of the state machine
+ */
+static void publishSnapshot() {
+  PhoneSnapshot next;
+  next.state = getCurrentState();
+  next.stateChangedAt = getStateChangedAt();
+  next.callPeer = getCurrentCallPeer();
+  next.conferenceCount = isConferenceActive() ? getConferenceParticipants(next.conference, CONF_MAX_PARTICIPANTS) : 0;
+  next.speakerphone = isSpeakerphoneActive();
+  next.recording = isRecording();
+  next.recordings = getRecordingCount();
+  next.newMessages = getUnheardMessageCount();
+
+  portENTER_CRITICAL(&snapshotMux);
+  snapshot = next;
+  portEXIT_CRITICAL(&snapshotMux);
+}
+
+void getPhoneSnapshot(PhoneSnapshot& out) {
+  portENTER_CRITICAL(&snapshotMux);
+  out = snapshot;
+  portEXIT_CRITICAL(&snapshotMux);
+}
+
+void updateWebSnapshot() {
+  // Loop gaps only matter while call audio is streaming
+  uint32_t now = micros();
+  if (getCurrentState() == IN_CALL) {
+    if (lastLoopUs != 0) {
+      uint32_t gap = now - lastLoopUs;
+      loopPasses++;
+      if (gap > loopMaxGapUs) loopMaxGapUs = gap;
+      if (gap > LOOP_PACKET_US) loopLatePasses++;
+      if (gap > LOOP_DEADLINE_US) loopDeadlineMisses++;
+    }
+    lastLoopUs = now;
+  } else {
+    lastLoopUs = 0;
+  }
+
+  if (millis() - lastSnapshotAt >= WEB_SNAPSHOT_MS || getStateChangedAt() != snapshot.stateChangedAt) {
+    lastSnapshotAt = millis();
+    publishSnapshot();
+  }
+}
+
+/*
+ * Web Server Task
+ * Serves requests and event streams; sleeps a tick between passes
+ */
+static void webServerTask(void* parameter) {
+  for (;;) {
+    uint32_t start = micros();
+    server.handleClient();
+    TRACE_SPAN(web_client, start);
+    TRACE_BEGIN(web_events);
+    handleWebEvents();
+    TRACE_END(web_events);
+    uint32_t elapsed = micros() - start;
+    if (elapsed > webTaskMaxUs) webTaskMaxUs = elapsed;
+    updateMemoryMonitor();   // Every MEMORY_SAMPLE_MS (walks the heap, not counted above)
+    attributeAudioMisses();  // Blame audio deadline misses, off the audio path
+    vTaskDelay(1);
+  }
+}
+
 /*
  * Setup Web Interface
- * Initializes the web server and registers route handlers
+ * Initializes the web server, registers route handlers and starts the task
  */
 void setupWebInterface() {
   // Register route handlers
-  server.on("/", handleRoot);
+  setupWebAssets(server);
+  server.on("/", [] () {
+    if (!serveWebAsset("/")) handleRoot();   // Dashboard if installed, else the built-in page
+  });
+  server.on("/status", handleRoot);
+  server.on("/recordings", handleRecordings);
+  server.on("/recording", handleRecordingDownload);
+  setupWebApi(server);
+  setupWebEvents(server);
+  
+  // Headers we need to see beyond the defaults
+  const char* headerKeys[] = { "Range", "If-None-Match" };
+  server.collectHeaders(headerKeys, 2);
   server.onNotFound(handleNotFound);
   
   // Start the server
   server.begin();
+  publishSnapshot();
+  xTaskCreatePinnedToCore(webServerTask, "web", WEB_TASK_STACK, NULL, WEB_TASK_PRIORITY, &webTask, WEB_TASK_CORE);
   
   Serial.println("Web interface started!");
   Serial.print("Access at: http://");
   Serial.println(WiFi.localIP());
 }
 
-/*
- * Handle Web Interface
- * Process incoming HTTP requests
- * Must be called repeatedly in main loop
- */
-void handleWebInterface() {
-  server.handleClient();
-}
@@ -9,16 +9,48 @@
  * - Connected peer list
  * - Configuration info
  * - System stats (uptime, memory, etc.)
- * - Real-time status updates
+ * - Live updates pushed over /events (see WebEvents.h)
+ *
+ * The server runs in its own low-priority task on core 0, away from the
+ * main loop and its audio work. Handlers read a PhoneSnapshot that the
+ * main loop publishes, never the state machine's live variables.
  */
 
 #ifndef WEB_INTERFACE_H
 #define WEB_INTERFACE_H
 
-// Initialize web server on port 80
+#include "State.h"
+#include "Conference.h"
+
+#define WEB_TASK_STACK 6144
+#define WEB_TASK_PRIORITY 1              // Same as the other background tasks
+#define WEB_TASK_CORE 0                  // Main loop (audio) runs on core 1
+#define WEB_SNAPSHOT_MS 50               // Snapshot refresh (state changes publish at once)
+
+// Phone state as the web handlers see it
+struct PhoneSnapshot {
+  PhoneState state;
+  unsigned long stateChangedAt;
+  int callPeer;                          // -1 = none
+  int conference[CONF_MAX_PARTICIPANTS];
+  int conferenceCount;                   // 0 = no conference
+  bool speakerphone;
+  bool recording;
+  int recordings;
+  int newMessages;
+};
+
+// Start the web server task on port 80
 void setupWebInterface();
 
-// Handle incoming web requests (call in loop)
-void handleWebInterface();
+// Publish a snapshot of the phone's state for the web task (call in loop)
+void updateWebSnapshot();
+
+// Latest snapshot (web task)
+void getPhoneSnapshot(PhoneSnapshot& out);
+
+// Diagnostics (test mode): page sizes, times, heap counters, loop gaps
+void printWebStats();
+void resetWebStats();
 
 #endif // WEB_INTERFACE_H
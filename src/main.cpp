@@ -23,41 +23,64 @@
 #include "Configuration.h"
 #include "WebInterface.h"
 #include "TestMode.h"
+#include "Conference.h"
+#include "Paging.h"
+#include "ServiceCodes.h"
+#include "CallRecorder.h"
+#include "FilePlayer.h"
+#include "Voicemail.h"
+#include "Ringtone.h"
+#include "VoicePrompt.h"
+#include "Equalizer.h"
+#include "Volume.h"
+#include "Speakerphone.h"
+#include "Metrics.h"
+#include "RemoteControl.h"
+#include "HeapGuard.h"
+#include "Boot.h"
+#include "FramePool.h"
+#include "Log.h"
+#include "Trace.h"
+#include "Profiler.h"
 #include <Arduino.h>
 
 // Configuration
 PhoneConfig config;
 
+// Last number dialed, for the "number ... is busy / not in service" announcements
+static int lastDialedNumber = -1;
+
 // --- Function Prototypes ---
 // (None - all functions moved to appropriate modules)
 
 /*
- * Setup - Runs once at boot
+ * Boot Stages
  * 
- * Initializes all hardware and software components:
- * 1. Hardware setup (pins, audio, etc.)
- * 2. Load configuration from file
- * 3. Run first-time setup if needed (number not configured)
- * 4. Connect to Wi-Fi
- * 5. Initialize network discovery
+ * Startup as a dependency graph (see Boot.h). Inputs and audio come up on
+ * the setup task (core 1) while boot tasks on core 0 mount the filesystem
+ * and start the radio. The phone is ready to ring once
+ * "services" is done; the router connect (up to 10 seconds) and the web
+ * server finish in the background while loop() already runs.
  */
-void setup() {
-  Serial.begin(115200);
-  delay(1000); // Give serial monitor time to connect
-  Serial.println("\n\n=================================");
-  Serial.println("      RetroBell Starting Up");
-  Serial.println("=================================");
-
-  // Setup hardware components
+static void bootInputs() {
   setupHookSwitch();   // Initialize hook switch with pull-up resistor
   setupRotaryDial();   // Initialize rotary dial pins
-  setupAudio();        // Configure I2S and amplifiers
-  setupMicrophone();   // Configure ADC for microphone input
+}
 
-  // Setup configuration system
+static void bootAudio() {
+  setupAudio();        // I2S, amplifiers and the microphone (shares I2S0)
+}
+
+static void bootFilesystem() {
   setupConfiguration();    // Initialize LittleFS filesystem
   loadConfiguration(config); // Load phone number and Wi-Fi credentials
-  
+}
+
+static void bootRadio() {
+  startRadio();        // Wi-Fi driver and ESP-NOW; no router needed yet
+}
+
+static void bootSettings() {
   // Check if phone number is configured (-1 means not set up yet)
   if (config.phoneNumber == -1) {
     Serial.println("\n*** FIRST TIME SETUP ***");
@@ -65,16 +88,87 @@ void setup() {
     saveConfiguration(config); // Save the chosen number to config file
   }
   
-  setupWifi(config.wifiSsid.c_str(), config.wifiPassword.c_str()); // Connect to Wi-Fi router
+  setupLog(config);       // Deferred log output (Serial, web, optional file)
+  setupEqualizer(config); // Speaker EQ bands from config (before anything plays)
+  setupVolume(config);    // Volume buttons and saved speaker levels
+  setupSpeakerphone(config); // Voice switch thresholds
+}
+
+static void bootNetwork() {
   printMacAddress();   // Display MAC address for debugging
-  setupNetwork();      // Initialize ESP-NOW and start discovery
-  setupWebInterface(); // Start web server for debug interface
+  setupNetwork(config); // ESP-NOW callbacks, last router channel, start discovery
+  setupConference();   // Clear conference bridge state
+  setupPaging();       // Clear paging broadcast state
+}
+
+static void bootServices() {
+  setupFilePlayer();   // Background reader for greeting/message playback
+  setupCallRecorder(config.recordCalls, config.voicemailRings > 0, config.recordMaxKB * 1024); // Opt-in recording
+  setupVoicemail(config.voicemailRings); // Answering machine (0 rings = off)
+  setupRingtones(config); // Decode custom ringtones to the PCM cache in the background
+  setupPrompts();      // Cache the start of every voice prompt clip
+  setupRemoteControl(); // Dial/answer/hang up from the web API
   setupTestMode();     // Initialize test mode system
+  startDialing();      // On-hook dialing (speakerphone code)
+}
+
+static void bootWifi() {
+  setupWifi(config.wifiSsid.c_str(), config.wifiPassword.c_str()); // Connect to Wi-Fi router
+}
+
+static void bootWeb() {
+  setupWebInterface(); // Start web server for debug interface
+}
+
+enum BootStageId {
+  STAGE_INPUTS,
+  STAGE_AUDIO,
+  STAGE_FILESYSTEM,
+  STAGE_RADIO,
+  STAGE_SETTINGS,
+  STAGE_NETWORK,
+  STAGE_SERVICES,
+  STAGE_WIFI,                      // Background from here on
+  STAGE_WEB,
+  STAGE_COUNT
+};
+
+// Setup-task stages must come after the stages they wait for
+static const BootStage bootStages[STAGE_COUNT] = {
+  {"inputs",     bootInputs,     0, BOOT_IN_SETUP},
+  {"audio",      bootAudio,      0, BOOT_IN_SETUP},
+  {"filesystem", bootFilesystem, 0, 0},
+  {"radio",      bootRadio,      0, 0},
+  {"settings",   bootSettings,   BOOT_AFTER(STAGE_INPUTS) | BOOT_AFTER(STAGE_AUDIO) | BOOT_AFTER(STAGE_FILESYSTEM), BOOT_IN_SETUP},
+  {"network",    bootNetwork,    BOOT_AFTER(STAGE_RADIO) | BOOT_AFTER(STAGE_SETTINGS), BOOT_IN_SETUP},
+  {"services",   bootServices,   BOOT_AFTER(STAGE_SETTINGS), BOOT_IN_SETUP},
+  {"wifi",       bootWifi,       BOOT_AFTER(STAGE_NETWORK), 0},
+  {"web",        bootWeb,        BOOT_AFTER(STAGE_WIFI) | BOOT_AFTER(STAGE_SERVICES), 0}
+};
+
+// Ready to ring: hook, dial, audio, ESP-NOW and everything a call touches
+#define BOOT_READY (BOOT_AFTER(STAGE_WIFI) - 1)
+
+/*
+ * Setup - Runs once at boot
+ * 
+ * Runs the boot stages above. There is no wait for the serial monitor:
+ * `test boot` prints the boot report again at any time.
+ */
+void setup() {
+  startBootProfile();
+  Serial.begin(115200);
+  Serial.println("\n\n=================================");
+  Serial.println("      RetroBell Starting Up");
+  Serial.println("=================================");
+
+  runBootStages(bootStages, STAGE_COUNT, BOOT_READY);
 
   Serial.println("\n=================================");
   Serial.print("Phone #");
   Serial.print(config.phoneNumber);
-  Serial.println(" is ready!");
+  Serial.printf(" is ready to ring (%lu ms)\n", millis());
+  Serial.println("Wi-Fi and web interface starting in the background");
   Serial.println("=================================\n");
   changeState(IDLE);
 }
@@ -87,8 +181,12 @@ void setup() {
  * 2. Maintains audio tone generation
  * 3. Handles network discovery broadcasts
  * 4. Manages state transitions (IDLE -> OFF_HOOK -> DIALING -> CALLING -> IN_CALL)
+ *    and service codes (900 = paging, 901 = voicemail)
  */
 void loop() {
+  markLoopPass();                  // Loop latency histogram (/metrics)
+  TRACE_SCOPE(loop);               // Timing trace (/api/v1/trace)
+  
   // Handle test mode first (takes priority over normal operation)
   handleTestMode();
   
@@ -97,14 +195,57 @@ void loop() {
     return;
   }
   
+  // Per-section profile (test profile, /api/v1/profile); the microphone paces these states
+  PhoneState pacedState = getCurrentState();
+  profileLoopStart(pacedState == IN_CALL || pacedState == PAGING || pacedState == VOICEMAIL);
+  
   // Poll hardware inputs
   handleHookSwitch();              // Check if handset is lifted/replaced
+  profileMark(PROFILE_HOOK_SWITCH);
   handleRotaryDial();              // Check for rotary dial pulses
+  profileMark(PROFILE_ROTARY_DIAL);
+  handleVolumeButtons();           // Volume presses, save levels once settled
+  profileMark(PROFILE_VOLUME);
+  handleRemoteControl();           // Dial/answer/hang up requested from the web
+  profileMark(PROFILE_REMOTE_CONTROL);
   
   // Maintain ongoing services
   updateToneGeneration();          // Keep audio tones playing (dial tone, ringback, etc.)
+  profileMark(PROFILE_TONES);
   updateNetwork();                 // Send periodic discovery broadcasts
-  handleWebInterface();            // Process web server requests
+  profileMark(PROFILE_NETWORK);
+  updatePaging();                  // End received pages whose sender went quiet
+  profileMark(PROFILE_PAGING);
+  updateWebSnapshot();             // Publish state for the web server task
+  profileMark(PROFILE_WEB_SNAPSHOT);
+
+  // ====== On-Hook Dialing ======
+  // With the handset on the cradle only the speakerphone code does anything
+  if ((getCurrentState() == IDLE || getCurrentState() == RINGING) && isDialingComplete()) {
+    int code = getDialedNumber();
+    resetDialedNumber();
+    if (code == SERVICE_CODE_SPEAKERPHONE) {
+      startSpeakerphone();
+      if (getCurrentState() == RINGING) {
+        LOG_INFO("Answering incoming call on speakerphone");
+        sendCallAccept(getCurrentCallPeer());
+        changeState(IN_CALL);
+      } else {
+        changeState(OFF_HOOK); // Dial tone on the base speaker
+      }
+      return;
+    }
+    startDialing();
+  }
+
+  // Speakerphone: no hook to hang up with, so any digit ends a call attempt,
+  // a page, message playback or a busy/error tone
+  if (isSpeakerphoneActive() && getDialedDigit() >= 0 &&
+      getCurrentState() != OFF_HOOK && getCurrentState() != DIALING && getCurrentState() != IN_CALL) {
+    clearDialedDigit();
+    hangUp();
+    return;
+  }
 
   // ====== Dialing Logic ======
   // Check if user has completed dialing a phone number
@@ -118,11 +259,41 @@ void loop() {
     if (isDialingComplete()) {
       int targetNumber = getDialedNumber();
       
-      Serial.print("Calling number: ");
-      Serial.println(targetNumber);
+      if (targetNumber == SERVICE_CODE_PAGING) {
+        // Paging code - broadcast to every phone instead of calling one
+        startPaging();
+        changeState(PAGING);
+        resetDialedNumber();
+        return;
+      }
+      
+      if (targetNumber == SERVICE_CODE_SPEAKERPHONE) {
+        // Dialed again on speakerphone: hang up (with the handset lifted: nothing to do)
+        resetDialedNumber();
+        if (isSpeakerphoneActive()) {
+          hangUp();
+        } else {
+          changeState(OFF_HOOK);
+        }
+        return;
+      }
+      
+      if (targetNumber == SERVICE_CODE_VOICEMAIL) {
+        // Voicemail code - play messages on the handset
+        startMessagePlayback();
+        changeState(MESSAGES);
+        resetDialedNumber();
+        return;
+      }
+      
+      LOG_INFO("Calling number: %d", targetNumber);
+      lastDialedNumber = targetNumber;
       
       // Try to send call request
-      if (sendCallRequest(targetNumber)) {
+      if (isServiceCode(targetNumber)) {
+        // Unassigned service code
+        changeState(CALL_FAILED);
+      } else if (sendCallRequest(targetNumber)) {
         // Peer found, waiting for answer
         changeState(CALLING);
       } else {
@@ -132,29 +303,69 @@ void loop() {
       resetDialedNumber(); // Clear for next call
     }
   }
+  profileMark(PROFILE_DIALING);
 
   // ====== Main State Machine ======
   // Each state handles different phone behaviors
   static PhoneState lastState = IDLE; // Track state changes
+  static unsigned long ringingStartTime = 0; // For counting rings before voicemail answers
   PhoneState currentStateValue = getCurrentState();
   
   // Handle state entry actions (only run once when entering a state)
   if (currentStateValue != lastState) {
+    // Handle state exit actions
+    if (lastState == IN_CALL) {
+      stopRecording(); // Close the recording file (no-op if not recording)
+    } else if (lastState == VOICEMAIL) {
+      stopVoicemail(); // Stop greeting and close the message
+    } else if (lastState == MESSAGES) {
+      stopMessagePlayback();
+    } else if (lastState == RINGING) {
+      stopRingtone(); // Custom ringtone (the classic ring stops with stopTone)
+    } else if (lastState == CALL_FAILED || lastState == CALL_BUSY) {
+      stopPrompt();
+    }
     switch (currentStateValue) {
       case IDLE:
         // Just entered IDLE state - reset dialing system once
+        stopSpeakerphone();
         resetDialedNumber();
+        startDialing(); // Listen for the speakerphone code
         stopTone();
+        hangUpConference(-1); // Drop any conference legs or invites left over
         break;
       case OFF_HOOK:
         // Just entered OFF_HOOK state
         startDialing();
         break;
+      case RINGING:
+        ringingStartTime = millis();
+        startRingtone(getCurrentCallPeer()); // Falls back to the classic ring if none is cached
+        break;
+      case VOICEMAIL:
+      case MESSAGES:
+        stopTone();
+        break;
+      case CALL_FAILED:
+        // Announce first (if prompts are installed), then the error tone
+        stopTone();
+        announceNotInService(lastDialedNumber);
+        break;
+      case CALL_BUSY:
+        stopTone(); // Ringback may still be running
+        announceBusy(lastDialedNumber);
+        break;
+      case IN_CALL:
+        // Dialing during a call invites another phone into a conference
+        startDialing();
+        startCallRecording(getCurrentCallPeer()); // No-op unless record_calls is set
+        break;
       default:
         break;
     }
     lastState = currentStateValue;
   }
+  profileMark(PROFILE_STATE_ENTRY);
   
   // Handle continuous state actions (run every loop while in state)
   switch (currentStateValue) {
@@ -165,7 +376,12 @@ void loop() {
       
     case OFF_HOOK:
       // Handset is lifted - play dial tone to indicate ready to dial
-      playDialTone();
+      // (stuttered while voicemail messages are waiting)
+      if (hasNewMessages()) {
+        playStutterDialTone();
+      } else {
+        playDialTone();
+      }
       break;
       
     case DIALING:
@@ -180,33 +396,119 @@ void loop() {
       break;
       
     case RINGING:
-      // Incoming call - ring the base speaker
-      playRingTone();
+      // Incoming call - ring the base speaker with the caller's ringtone
+      if (!updateRingtone()) {
+        playRingTone();
+      }
       // If user picks up handset, HookSwitch.cpp will send call accept
+      // Nobody answered - let the answering machine take it
+      if (shouldAnswerVoicemail(millis() - ringingStartTime)) {
+        stopRingtone(); // Frees the file player for the greeting
+        startVoicemail(getCurrentCallPeer());
+        changeState(VOICEMAIL);
+      }
       break;
       
     case CALL_FAILED:
-      // Call failed (number not found) - play fast busy/error tone
-      playErrorTone();
+      // Call failed (number not found) - announcement, then fast busy/error tone
+      if (!updatePrompt()) {
+        playErrorTone();
+      }
       // User must hang up to return to IDLE
       break;
       
     case CALL_BUSY:
-      // Called phone is busy (already in a call) - play normal busy tone
-      playBusyTone();
+      // Called phone is busy (already in a call) - announcement, then normal busy tone
+      if (!updatePrompt()) {
+        playBusyTone();
+      }
       // User must hang up to return to IDLE
       break;
       
+    case PAGING:
+      stopTone();
+      // Stream microphone to every phone (decimated and ADPCM-encoded in Paging.cpp)
+      {
+        HEAP_GUARD_SCOPE(HEAP_GUARD_AUDIO);
+        int16_t pageBuffer[AUDIO_SAMPLES_PER_PACKET];
+        profileMark(PROFILE_STATE_MACHINE);
+        bool haveFrame = readMicrophoneBuffer(pageBuffer, AUDIO_SAMPLES_PER_PACKET);
+        profileMark(PROFILE_MIC_READ);
+        if (haveFrame) {
+          pagingProcessFrame(pageBuffer, AUDIO_SAMPLES_PER_PACKET);
+        }
+        profileMark(PROFILE_AUDIO_SEND);
+      }
+      // User must hang up to stop paging
+      break;
+      
+    case VOICEMAIL:
+      // Handset is on-hook; the microphone read only paces the loop at one frame per 6.25ms
+      {
+        int16_t paceBuffer[AUDIO_SAMPLES_PER_PACKET];
+        profileMark(PROFILE_STATE_MACHINE);
+        readMicrophoneBuffer(paceBuffer, AUDIO_SAMPLES_PER_PACKET);
+        profileMark(PROFILE_MIC_READ);
+        if (!voicemailProcessFrame()) {
+          // Message time limit - hang up on the caller
+          sendCallEnd(getCurrentCallPeer());
+          changeState(IDLE);
+        }
+      }
+      // Caller hanging up (Network.cpp) or handset lifted (HookSwitch.cpp) ends it
+      break;
+      
+    case MESSAGES:
+      // Beeps and messages on the handset; back to dial tone when done
+      if (!messagesProcessFrame()) {
+        changeState(OFF_HOOK);
+      }
+      break;
+      
     case IN_CALL:
       stopTone(); // Stop any tones when in call
       
       // Stream audio bidirectionally during call
-      // Read from microphone and send to peer
-      int16_t audioBuffer[AUDIO_SAMPLES_PER_PACKET];
-      if (readMicrophoneBuffer(audioBuffer, AUDIO_SAMPLES_PER_PACKET)) {
-        sendAudioData(audioBuffer, AUDIO_SAMPLES_PER_PACKET);
+      // The microphone is read straight into a pooled packet (FramePool.h),
+      // which the recorder and the radio then share without copying it.
+      // No heap on this path: see HeapGuard.h
+      {
+        HEAP_GUARD_SCOPE(HEAP_GUARD_AUDIO);
+        static int16_t dropBuffer[AUDIO_SAMPLES_PER_PACKET];   // Pool empty: keep the loop paced
+        AudioFrame* frame = newAudioFrame();
+        int16_t* audioBuffer = frame ? frame->samples() : dropBuffer;
+        profileMark(PROFILE_STATE_MACHINE);
+        if (readMicrophoneBuffer(audioBuffer, AUDIO_SAMPLES_PER_PACKET) && frame) {
+          profileMark(PROFILE_MIC_READ);
+          frame->count = AUDIO_SAMPLES_PER_PACKET;
+          speakerphoneTransmit(audioBuffer, AUDIO_SAMPLES_PER_PACKET); // Voice switch, in place (sole owner still)
+          recordTxFrame(frame);
+          if (isConferenceActive()) {
+            // Conference host: mix all legs and send each its own stream
+            conferenceProcessFrame(audioBuffer, AUDIO_SAMPLES_PER_PACKET);
+          } else {
+            sendAudioFrame(frame);
+          }
+          profileMark(PROFILE_AUDIO_SEND);
+        } else {
+          profileMark(PROFILE_MIC_READ);
+        }
+        releaseAudioFrame(frame);
       }
       // Receiving audio is handled automatically in Network.cpp callback
+      
+      // Dialing another number during the call adds it to a conference
+      if (isDialingComplete()) {
+        if (isSpeakerphoneActive() && getDialedNumber() == SERVICE_CODE_SPEAKERPHONE) {
+          hangUp();
+          break;
+        }
+        conferenceInvite(getDialedNumber());
+        resetDialedNumber();
+        startDialing();
+      }
+      updateConference();
       break;
   }
+  profileMark(PROFILE_STATE_MACHINE);
 }
@@ -0,0 +1,72 @@
+"""
+build_web.py - Pack the web dashboard into the LittleFS image
+
+Takes the sources in web/, gzips them and writes them to data/www/,
+which `pio run --target uploadfs` puts on the phone. JS and CSS get a
+content hash in their file name (app.1a2b3c4d.js) and index.html is
+rewritten to match, so the phone can let browsers cache them forever.
+index.html itself is always revalidated (ETag).
+
+Runs automatically before every PlatformIO build (extra_scripts in
+platformio.ini), or by hand:  python3 tools/build_web.py
+"""
+
+import gzip
+import hashlib
+import os
+import shutil
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "web")
+OUTPUT = os.path.join(ROOT, "data", "www")
+FINGERPRINTED = (".js", ".css")
+
+
+def compress(data):
+    # mtime=0: same input, same bytes, same ETag
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def build():
+    if os.path.isdir(OUTPUT):
+        shutil.rmtree(OUTPUT)
+    os.makedirs(OUTPUT)
+
+    renamed = {}
+    files = sorted(os.listdir(SOURCE))
+    for name in files:
+        if not name.endswith(FINGERPRINTED):
+            continue
+        with open(os.path.join(SOURCE, name), "rb") as source:
+            data = source.read()
+        stem, extension = os.path.splitext(name)
+        target = "%s.%s%s" % (stem, hashlib.sha1(data).hexdigest()[:8], extension)
+        renamed[name] = target
+        write(target, data)
+
+    for name in files:
+        if name.endswith(FINGERPRINTED):
+            continue
+        with open(os.path.join(SOURCE, name), "rb") as source:
+            data = source.read()
+        if name.endswith(".html"):
+            html = data.decode("utf-8")
+            for original, target in renamed.items():
+                html = html.replace('"%s"' % original, '"%s"' % target)
+            data = html.encode("utf-8")
+        write(name, data)
+
+
+def write(name, data):
+    packed = compress(data)
+    with open(os.path.join(OUTPUT, name + ".gz"), "wb") as target:
+        target.write(packed)
+    print("web: %-24s %6d -> %5d bytes" % (name, len(data), len(packed)))
+
+
+try:
+    Import("env")  # noqa: F821 - defined when run by PlatformIO
+except NameError:
+    pass
+
+build()
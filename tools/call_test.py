@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+call_test.py - Automated calls between two RetroBell phones
+
+Drives two phones through the web API and measures call setup:
+
+  python3 tools/call_test.py <caller-ip> <callee-ip> --calls 20
+
+Each round: dial the callee's number on the caller, wait for RINGING on
+the callee, answer it, wait for IN_CALL on both, hold the call for a
+moment, hang up both and wait for IDLE. The callee's number is read from
+its /api/v1/status. Both handsets can stay on the cradle.
+
+Reported per round and as min/median/max:
+  ring     dial request → callee RINGING
+  connect  answer request → caller and callee IN_CALL
+Times include the HTTP round trips and the state polling interval
+(--poll, default 20ms). Numbers under 3 digits wait for the dial timeout
+before they are sent, so give the test phones 3-digit numbers.
+Standard library only.
+"""
+
+import argparse
+import json
+import statistics
+import sys
+import time
+import urllib.error
+import urllib.request
+
+
+def request(ip, path, method="GET"):
+    req = urllib.request.Request("http://%s%s" % (ip, path), method=method, data=b"" if method == "POST" else None)
+    try:
+        with urllib.request.urlopen(req, timeout=5) as response:
+            return response.status, json.loads(response.read() or b"{}")
+    except urllib.error.HTTPError as error:
+        return error.code, json.loads(error.read() or b"{}")
+
+
+def state(ip):
+    return request(ip, "/api/v1/status")[1]["state"]
+
+
+def command(ip, action, query=""):
+    code, body = request(ip, "/api/v1/" + action + query, "POST")
+    if code != 202:
+        raise RuntimeError("%s %s on %s: %d %s" % (action, query, ip, code, body.get("error", "")))
+
+
+def wait_for(ips, wanted, timeout, poll):
+    """Wait until every phone in ips is in state wanted; returns seconds waited"""
+    start = time.monotonic()
+    pending = set(ips)
+    while pending:
+        for ip in list(pending):
+            if state(ip) == wanted:
+                pending.discard(ip)
+        if time.monotonic() - start > timeout:
+            raise RuntimeError("timeout waiting for %s on %s" % (wanted, ", ".join(sorted(pending))))
+        if pending:
+            time.sleep(poll)
+    return time.monotonic() - start
+
+
+def summary(name, values):
+    ms = [v * 1000 for v in values]
+    print("%-8s min %6.0f ms   median %6.0f ms   max %6.0f ms" % (name, min(ms), statistics.median(ms), max(ms)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("caller")
+    parser.add_argument("callee")
+    parser.add_argument("--calls", type=int, default=10)
+    parser.add_argument("--hold", type=float, default=2.0, help="seconds to stay in the call")
+    parser.add_argument("--poll", type=float, default=0.02, help="state polling interval in seconds")
+    args = parser.parse_args()
+
+    number = request(args.callee, "/api/v1/status")[1]["number"]
+    phones = [args.caller, args.callee]
+    for ip in phones:
+        if state(ip) != "IDLE":
+            command(ip, "hangup")
+    wait_for(phones, "IDLE", 10, args.poll)
+
+    ring, connect, failures = [], [], 0
+    for round_number in range(1, args.calls + 1):
+        try:
+            start = time.monotonic()
+            command(args.caller, "dial", "?number=%d" % number)
+            wait_for([args.callee], "RINGING", 10, args.poll)
+            ring_time = time.monotonic() - start
+
+            start = time.monotonic()
+            command(args.callee, "answer")
+            wait_for(phones, "IN_CALL", 10, args.poll)
+            connect_time = time.monotonic() - start
+
+            ring.append(ring_time)
+            connect.append(connect_time)
+            print("call %3d: ring %5.0f ms, connect %5.0f ms" % (round_number, ring_time * 1000, connect_time * 1000))
+            time.sleep(args.hold)
+        except RuntimeError as error:
+            failures += 1
+            print("call %3d: FAILED - %s" % (round_number, error))
+        for ip in phones:
+            command(ip, "hangup")
+        wait_for(phones, "IDLE", 10, args.poll)
+
+    print()
+    print("%d calls, %d failed" % (args.calls, failures))
+    if ring:
+        summary("ring", ring)
+        summary("connect", connect)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+web_load.py - HTTP load generator for the RetroBell web interface
+
+Hammers a phone's web server from several threads while you make a call,
+to check that web traffic never disturbs call audio:
+
+  1. Serial monitor: test enter, test web reset, test exit
+  2. Start a call on the phone
+  3. python3 tools/web_load.py <phone-ip> --seconds 60
+  4. Hang up, then: test enter, test web stats
+     "audio deadline missed" should stay at 0
+
+Besides the pages and API endpoints it opens event streams that are
+never read (the phone must drop them, not wait for them). Standard
+library only.
+"""
+
+import argparse
+import socket
+import threading
+import time
+import urllib.request
+
+PATHS = ["/", "/api/v1/status", "/api/v1/peers", "/api/v1/call", "/api/v1/metrics", "/recordings"]
+EVENT_PORT = 81   # WEB_EVENT_PORT
+
+
+class Counters:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.errors = 0
+        self.bytes = 0
+        self.latencies = []
+
+    def add(self, latency, size):
+        with self.lock:
+            self.requests += 1
+            self.bytes += size
+            self.latencies.append(latency)
+
+    def error(self):
+        with self.lock:
+            self.errors += 1
+
+
+def worker(base, deadline, counters, index):
+    path_index = index
+    while time.time() < deadline:
+        path = PATHS[path_index % len(PATHS)]
+        path_index += 1
+        start = time.time()
+        try:
+            with urllib.request.urlopen(base + path, timeout=10) as response:
+                size = len(response.read())
+            counters.add(time.time() - start, size)
+        except Exception:
+            counters.error()
+
+
+def stalled_stream(host, deadline):
+    """Open /events and never read from it"""
+    try:
+        sock = socket.create_connection((host, EVENT_PORT), timeout=5)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1024)
+        sock.sendall(b"GET /events HTTP/1.1\r\nHost: " + host.encode() + b"\r\n\r\n")
+        while time.time() < deadline:
+            time.sleep(1)
+        sock.close()
+    except OSError:
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load the RetroBell web server")
+    parser.add_argument("host", help="Phone IP address")
+    parser.add_argument("--seconds", type=int, default=30)
+    parser.add_argument("--threads", type=int, default=4)
+    parser.add_argument("--stalled-streams", type=int, default=1)
+    args = parser.parse_args()
+
+    base = "http://" + args.host
+    deadline = time.time() + args.seconds
+    counters = Counters()
+    threads = [threading.Thread(target=worker, args=(base, deadline, counters, i)) for i in range(args.threads)]
+    threads += [threading.Thread(target=stalled_stream, args=(args.host, deadline)) for _ in range(args.stalled_streams)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    latencies = sorted(counters.latencies)
+    print("Requests: %d (%d errors), %.1f KB" % (counters.requests, counters.errors, counters.bytes / 1024))
+    if latencies:
+        print("Latency: median %.0f ms, 95%% %.0f ms, max %.0f ms" % (
+            latencies[len(latencies) // 2] * 1000,
+            latencies[int(len(latencies) * 0.95)] * 1000,
+            latencies[-1] * 1000))
+    print("Now check 'test web stats' on the phone (audio deadline missed should be 0)")
+
+
+if __name__ == "__main__":
+    main()
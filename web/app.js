@@ -0,0 +1,182 @@
+// RetroBell dashboard - the page itself is static and cached; everything
+// that changes comes from the small /api/v1 JSON endpoints. /events says
+// when to fetch again, so nothing is polled while the phone is idle.
+
+const PEER_OFFLINE_S = 30;   // Same as the phone: three missed discovery broadcasts
+
+const $ = (id) => document.getElementById(id);
+const text = (id, value) => { $(id).textContent = value; };
+let uptime = 0;
+
+// cache: 'no-cache' revalidates with the ETag: unchanged data is a bodyless 304
+async function load(path) {
+  const response = await fetch(path, { cache: 'no-cache' });
+  if (!response.ok) throw new Error(path + ': ' + response.status);
+  return response.json();
+}
+
+function duration(seconds) {
+  if (seconds < 60) return seconds + ' s';
+  if (seconds < 3600) return Math.floor(seconds / 60) + ' min ' + (seconds % 60) + ' s';
+  return Math.floor(seconds / 3600) + ' h ' + Math.floor((seconds % 3600) / 60) + ' min';
+}
+
+async function refreshStatus() {
+  const status = await load('/api/v1/status');
+  text('number', '#' + status.number);
+  text('state', status.state);
+  $('state').className = 'state ' + status.state;
+  text('new-messages', status.new_messages);
+  text('recordings', status.recordings);
+  text('network', status.network.ip + ' / ' + status.network.mac);
+}
+
+async function refreshCall() {
+  const call = await load('/api/v1/call');
+  text('call-peer', call.peer === null ? 'No active call' : 'Phone #' + call.peer);
+  text('call-conference', call.conference.length ? call.conference.map((n) => '#' + n).join(' ') : '-');
+  text('call-since', call.active ? duration(Math.max(0, uptime - Math.floor(call.since_ms / 1000))) : '-');
+  text('call-speakerphone', call.speakerphone ? 'on' : 'off');
+  text('call-recording', call.recording ? 'yes' : 'no');
+}
+
+async function refreshPeers() {
+  const { peers } = await load('/api/v1/peers');
+  const body = $('peers');
+  body.replaceChildren();
+  for (const peer of peers) {
+    const ago = uptime - peer.last_seen_s;
+    const row = body.insertRow();
+    row.className = ago > PEER_OFFLINE_S ? 'offline' : '';
+    row.insertCell().textContent = '#' + peer.number;
+    row.insertCell().textContent = peer.mac;
+    row.insertCell().textContent = duration(Math.max(0, ago)) + ' ago';
+    row.insertCell().textContent = peer.rssi === null ? '-' : peer.rssi + ' dBm';
+  }
+  if (!peers.length) {
+    body.insertRow().insertCell().textContent = 'No peers discovered yet';
+  }
+}
+
+async function refreshMetrics() {
+  const metrics = await load('/api/v1/metrics');
+  uptime = metrics.uptime_s;
+  text('uptime', duration(uptime));
+  text('heap', Math.round(metrics.heap.free / 1024) + ' KB (lowest ' + Math.round(metrics.heap.min_free / 1024) +
+       ' KB, largest block ' + Math.round(metrics.heap.largest_block / 1024) + ' KB)');
+  text('wifi', metrics.wifi.rssi + ' dBm, channel ' + metrics.wifi.channel);
+  text('cpu', metrics.cpu_mhz + ' MHz');
+  const audio = metrics.audio;
+  text('call-audio', audio.late_frames + ' late, ' + audio.overruns + ' overruns, ' + audio.underruns + ' underruns, ' +
+       (audio.short_writes + audio.short_reads) + ' short I/O');
+  text('call-copied', audio.copied_bytes_per_s ? (audio.copied_bytes_per_s / 1024).toFixed(1) + ' KB/s' : '-');
+}
+
+// Call control: the phone answers 202 once the command is queued for the
+// main loop, 409 when the current state doesn't allow it. The state change
+// itself arrives as a normal 'state' event.
+async function command(action, query = '') {
+  const response = await fetch('/api/v1/' + action + query, { method: 'POST' });
+  const result = await response.json().catch(() => ({}));
+  text('control-result', response.status === 202 ? action + ' sent' : (result.error || action + ' failed (' + response.status + ')'));
+}
+
+function setupControls() {
+  $('controls').addEventListener('submit', (e) => {
+    e.preventDefault();
+    command('dial', '?number=' + Number($('dial-number').value));
+  });
+  $('answer').addEventListener('click', () => command('answer'));
+  $('hangup').addEventListener('click', () => command('hangup'));
+  $('log-section').addEventListener('toggle', refreshLog);
+  $('profile-section').addEventListener('toggle', refreshProfile);
+  $('memory-section').addEventListener('toggle', refreshMemory);
+}
+
+// Only fetched while the Log section is open
+async function refreshLog() {
+  if (!$('log-section').open) return;
+  const response = await fetch('/api/v1/log', { cache: 'no-store' });
+  const log = $('log');
+  const atBottom = log.scrollTop + log.clientHeight >= log.scrollHeight - 4;
+  log.textContent = await response.text();
+  if (atBottom) log.scrollTop = log.scrollHeight;
+}
+
+function region(r) {
+  if (!r.total) return 'not fitted';
+  return Math.round(r.free / 1024) + ' of ' + Math.round(r.total / 1024) + ' KB free (lowest ' +
+    Math.round(r.min_free / 1024) + ' KB), largest block ' + Math.round(r.largest_block / 1024) + ' KB, ' +
+    (r.fragmentation_permille / 10).toFixed(1) + ' % fragmented';
+}
+
+// Alerts always show in the summary; the details only while open
+async function refreshMemory() {
+  const memory = await load('/api/v1/memory');
+  text('memory-alerts', memory.alerts.length ? '⚠ ' + memory.alerts.join(', ') : '');
+  if (!$('memory-section').open) return;
+  text('memory-internal', region(memory.internal));
+  text('memory-psram', region(memory.psram));
+  text('memory-tags', memory.tags.map((t) => t.name + ' ' + Math.round(t.bytes / 1024) + ' KB').join(', '));
+  text('memory-untagged', Math.round(memory.untagged_bytes / 1024) + ' KB');
+  const body = $('memory-tasks');
+  body.replaceChildren();
+  for (const task of memory.tasks) {
+    const row = body.insertRow();
+    row.className = task.stack_free < 512 ? 'worst' : '';
+    row.insertCell().textContent = task.name;
+    row.insertCell().textContent = task.stack_free + ' bytes';
+  }
+}
+
+// Only fetched while the Loop profile section is open; times in microseconds
+async function refreshProfile() {
+  if (!$('profile-section').open) return;
+  const profile = await load('/api/v1/profile');
+  const body = $('profile');
+  body.replaceChildren();
+  for (const section of profile.sections) {
+    if (!section.count) continue;
+    const row = body.insertRow();
+    row.className = profile.worst.includes(section.name) ? 'worst' : '';
+    for (const value of [section.name, section.count, section.avg_us, section.p99_us, section.max_us]) {
+      row.insertCell().textContent = value;
+    }
+    row.insertCell().textContent = (section.share_permille / 10).toFixed(1) + ' %';
+  }
+  text('profile-period', profile.period.count
+    ? 'Audio pass period: avg ' + profile.period.avg_us + ' µs, p99 ' + profile.period.p99_us + ' µs, max ' +
+      profile.period.max_us + ' µs (6250 expected); jitter p99 ' + profile.jitter.p99_us + ' µs'
+    : 'Audio pass period: no call yet');
+}
+
+function refreshAll() {
+  return refreshMetrics().then(() => Promise.all([refreshStatus(), refreshCall(), refreshPeers(), refreshMemory()]));
+}
+
+function connectEvents() {
+  // Streams have their own port (WEB_EVENT_PORT) so they never hold up the API
+  const events = new EventSource(location.protocol + '//' + location.hostname + ':81/events');
+  events.onopen = () => { text('link', 'live'); $('link').className = 'live'; };
+  events.onerror = () => { text('link', 'reconnecting…'); $('link').className = ''; };
+  events.addEventListener('state', () => { refreshStatus(); refreshCall(); refreshLog(); });
+  events.addEventListener('call', refreshCall);
+  events.addEventListener('peer', refreshPeers);
+  events.addEventListener('resync', refreshAll);
+  events.addEventListener('metrics', (e) => {
+    const m = JSON.parse(e.data);
+    if (m.recordings !== undefined || m.messages !== undefined) refreshStatus();
+    refreshMetrics();
+    refreshLog();
+    refreshProfile();
+    refreshMemory();
+  });
+}
+
+setupControls();
+refreshAll().catch((error) => text('link', error.message));
+if (window.EventSource) {
+  connectEvents();
+} else {
+  setInterval(refreshAll, 10000);
+}